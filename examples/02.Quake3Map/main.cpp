@@ -99,6 +99,10 @@ int main()
 	method in the irr::video::IVideoDriver class). Note that this
 	optimization with the Octree is only useful when drawing huge meshes
 	consisting of lots of geometry.
+	Quake 3 levels also contain precomputed visibility information, which
+	irr::scene::ISceneManager::addQuake3LevelSceneNode() uses to draw only
+	the parts of the level which can be seen from the room the camera is in.
+	Inside of buildings, this draws much less than the Octree.
 	*/
 	scene::IAnimatedMesh* mesh = smgr->getMesh("20kdm2.bsp");
 	scene::ISceneNode* node = 0;
@@ -106,6 +110,7 @@ int main()
 	if (mesh)
 		node = smgr->addOctreeSceneNode(mesh->getMesh(0), 0, -1, 1024);
 //		node = smgr->addMeshSceneNode(mesh->getMesh(0));
+//		node = smgr->addQuake3LevelSceneNode((scene::IQ3LevelMesh*)mesh);
 
 	/*
 	Because the level was not modelled around the origin (0,0,0), we
@@ -81,6 +81,12 @@ namespace scene
 		//! Volume Light Scene Node
 		ESNT_VOLUME_LIGHT  = MAKE_IRR_ID('v','o','l','l'),
 
+		//! Paged Terrain Scene Node
+		ESNT_PAGED_TERRAIN = MAKE_IRR_ID('p','t','e','r'),
+
+		//! Quake3 Level Scene Node
+		ESNT_Q3_LEVEL = MAKE_IRR_ID('q','3','l','v'),
+
 		//! Maya Camera Scene Node
 		/** Legacy, for loading version <= 1.4.x .irr files */
 		ESNT_CAMERA_MAYA    = MAKE_IRR_ID('c','a','m','M'),
@@ -29,6 +29,16 @@ namespace scene
 		ETPS_129 = 129
 	};
 
+	//! How terrain heights are interpolated between the samples of the heightmap
+	enum E_TERRAIN_HEIGHT_SAMPLING
+	{
+		//! Heights of the triangles drawn at full detail, like ITerrainSceneNode::getHeight()
+		ETHS_TRIANGLE = 0,
+
+		//! Bilinear interpolation of the four samples around a position, normals change smoothly
+		ETHS_BILINEAR
+	};
+
 } // end namespace scene
 } // end namespace irr
 
@@ -0,0 +1,86 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+#define __I_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+
+#include "ISceneManager.h"
+#include "ILightManager.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! A light manager which switches on only the lights near each scene node.
+	/** The view frustum of the active camera is split into a grid of clusters:
+	tiles on the screen, and slices in depth which get thicker with the
+	distance to the camera. After the lights are rendered, each point and
+	spot light is added to the clusters its sphere of influence overlaps.
+	Before a scene node is rendered, the lights of the clusters overlapping the
+	node's bounding box are checked against the box, and only the lights
+	touching it are switched on, so a scene can have more lights than the
+	driver supports at once, as long as each node is reached by a few of them.
+	Directional lights and lights which are no ILightSceneNode are always on.
+
+	All lights in the light list are rendered while a light manager is set, so
+	the light list index of a light is also its index in
+	video::IVideoDriver::getDynamicLight(). Shader callbacks can use
+	getNodeLights() for the lights of the node being rendered, or upload the
+	cluster lists for lighting per pixel.
+
+	Create it with ISceneManager::createClusteredLightManager() and activate
+	it with ISceneManager::setLightManager(). */
+	class IClusteredLightManager : public ILightManager
+	{
+	public:
+
+		//! Set the number of clusters across the screen width, height and depth
+		virtual void setClusterCount(const core::vector3d<u32>& count) = 0;
+
+		//! Get the number of clusters across the screen width, height and depth
+		virtual const core::vector3d<u32>& getClusterCount() const = 0;
+
+		//! Set the largest number of lights switched on for a node.
+		/** When more lights touch a node, the ones closest to the node are
+		used. 0, the default, uses video::IVideoDriver::getMaximalDynamicLightAmount(),
+		or no limit for drivers which return 0 there. */
+		virtual void setMaxNodeLights(u32 count) = 0;
+
+		//! Get the largest number of lights switched on for a node, 0 for the driver limit
+		virtual u32 getMaxNodeLights() const = 0;
+
+		//! Get the index of the cluster containing a point in view space
+		/** Clusters are numbered x + y*width + z*width*height, with x from the
+		left and y from the top of the screen, and z from the camera.
+		\return Index of the cluster, or -1 if the point is outside of the
+		view frustum. */
+		virtual s32 getClusterIndex(const core::vector3df& viewPos) const = 0;
+
+		//! Get the lights of a cluster
+		/** \param cluster Index of the cluster.
+		\param count Receives the number of lights.
+		\return Light list indices of the lights. */
+		virtual const u32* getClusterLights(u32 cluster, u32& count) const = 0;
+
+		//! Get the lights of all clusters as one array, for uploading to shaders
+		/** Has two entries per cluster: the first index into
+		getClusterLightIndices() and the number of lights of the cluster. */
+		virtual const core::array<u32>& getClusterOffsets() const = 0;
+
+		//! Get the light list indices of the lights of all clusters
+		virtual const core::array<u32>& getClusterLightIndices() const = 0;
+
+		//! Get the factors to find the depth slice of a view space depth in a shader
+		/** The slice of depth z is floor(log(z) * scale + bias). */
+		virtual void getDepthSliceFactors(f32& scale, f32& bias) const = 0;
+
+		//! Get the light list indices of the lights switched on for the node being rendered
+		virtual const core::array<u32>& getNodeLights() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
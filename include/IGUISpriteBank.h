@@ -90,6 +90,18 @@ public:
 	//! Clears sprites, rectangles and textures
 	virtual void clear() = 0;
 
+	//! Copies the textures of the sprite bank into shared atlas textures
+	/** Sprites which used different textures can then be drawn with a
+	single draw2DImageBatch, e.g. all glyphs of a font. The rectangles and
+	the texture numbers of the sprite frames are changed to point into the
+	atlas, each texture index of the bank is set to the atlas holding its
+	texture. Textures which can't be locked for reading, have compressed
+	formats or were resized by the driver stay as they are.
+	\param pageSize Size of the atlas textures. Textures larger than this
+	stay as they are.
+	\return Number of textures which were copied into an atlas. */
+	virtual u32 packTextures(const core::dimension2d<u32>& pageSize = core::dimension2d<u32>(1024, 1024)) = 0;
+
 	//! Draws a sprite in 2d with position and color
 	/**
 	\param index Index of SGUISprite to draw
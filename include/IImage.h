@@ -27,6 +27,22 @@ enum E_TEXTURE_TYPE
 	ETT_CUBEMAP
 };
 
+//! Filters for IImage::copyToResampling
+enum E_IMAGE_FILTER
+{
+	//! Average of the source pixels covered by a target pixel, like copyToScalingBoxFilter.
+	EIF_BOX,
+
+	//! Linear interpolation, a tent filter when shrinking.
+	EIF_BILINEAR,
+
+	//! Mitchell-Netravali cubic with B=C=1/3, sharp with little ringing.
+	EIF_MITCHELL,
+
+	//! Lanczos windowed sinc with 3 lobes, sharpest but with some ringing at edges.
+	EIF_LANCZOS
+};
+
 //! Interface for software image data.
 /** Image loaders create these images from files. IVideoDrivers convert
 these images into their (hardware) textures.
@@ -232,20 +248,7 @@ public:
 				}
 				else
 				{
-					u32 dataSize = 0;
-					u32 width = Size.Width;
-					u32 height = Size.Height;
-
-					do
-					{
-						if (width > 1)
-							width >>= 1;
-
-						if (height > 1)
-							height >>= 1;
-
-						dataSize += getDataSizeFromFormat(Format, width, height);
-					} while (width != 1 || height != 1);
+					const u32 dataSize = getMipMapsDataSizeFromFormat(Format, Size.Width, Size.Height);
 
 					MipMapsData = Allocator.allocate(dataSize);
 					memcpy(MipMapsData, data, dataSize);
@@ -273,6 +276,9 @@ public:
 	virtual void copyToScaling(IImage* target) =0;
 
 	//! copies this surface into another
+	/** Images of the same size can also be copied from and into the DXT
+	formats, which decodes or encodes the whole image. Mip maps are not
+	copied. */
 	virtual void copyTo(IImage* target, const core::position2d<s32>& pos=core::position2d<s32>(0,0)) =0;
 
 	//! copies this surface into another
@@ -286,6 +292,31 @@ public:
 	//! copies this surface into another, scaling it to fit, applying a box filter
 	virtual void copyToScalingBoxFilter(IImage* target, s32 bias = 0, bool blend = false) = 0;
 
+	//! Copies the image into the target, resampling it to fit with a filter
+	/** Filters the rows and then the columns of the image, so it is much
+	faster than copyToScalingBoxFilter and works with any size in both
+	directions. Large images are spread over the worker threads. Images in
+	other formats than ECF_A1R5G5B5, ECF_R5G6B5, ECF_R8G8B8, ECF_A8R8G8B8
+	and the floating point formats are copied with copyToScaling.
+	\param target Image receiving the resampled image in its whole size.
+	\param filter Filter to use.
+	\param gammaCorrect Filter the colors in linear space, assuming the image
+	is in sRGB. Keeps dark and bright details more even when shrinking. Alpha
+	is always filtered as it is. */
+	virtual void copyToResampling(IImage* target, E_IMAGE_FILTER filter = EIF_MITCHELL, bool gammaCorrect = false) = 0;
+
+	//! Generates all mip map levels of the image and sets them as its mip map data
+	/** Each level is resampled from the one above it, down to 1x1 pixel, so
+	the whole chain costs about a third of filtering the image once.
+	\param filter Filter to use. EIF_BOX averages 2x2 pixels for even sizes.
+	\param gammaCorrect Filter the colors in linear space, see copyToResampling.
+	\param premultipliedAlpha Weight the colors with their alpha while
+	filtering, so the colors of transparent pixels don't bleed into the
+	visible ones.
+	\return False if the image is compressed or its format is not supported
+	by copyToResampling, in which case the image is not changed. */
+	virtual bool generateMipMaps(E_IMAGE_FILTER filter = EIF_BOX, bool gammaCorrect = false, bool premultipliedAlpha = false) = 0;
+
 	//! fills the surface with given color
 	virtual void fill(const SColor &color) =0;
 
@@ -412,6 +443,25 @@ public:
 		return imageSize;
 	}
 
+	//! calculate the size in bytes of all mip map levels below an image of selected format, width and height.
+	static u32 getMipMapsDataSizeFromFormat(ECOLOR_FORMAT format, u32 width, u32 height)
+	{
+		u32 dataSize = 0;
+
+		do
+		{
+			if (width > 1)
+				width >>= 1;
+
+			if (height > 1)
+				height >>= 1;
+
+			dataSize += getDataSizeFromFormat(format, width, height);
+		} while (width != 1 || height != 1);
+
+		return dataSize;
+	}
+
 	//! check if this is compressed color format
 	static bool isCompressedFormat(const ECOLOR_FORMAT format)
 	{
@@ -55,6 +55,33 @@ public:
 
 		return image;
 	}
+
+	//! Reads the size and color format of the image in a file
+	/** Loaders which implement this and loadImageInto can decode an image
+	row by row into memory of the caller, without a temporary image.
+	\param file File handle, read from its current position.
+	\param size Receives the size of the image.
+	\param format Receives the color format loadImage would create.
+	\return False if the file can't be read or the loader can't decode it
+	with loadImageInto. */
+	virtual bool getImageInfo(io::IReadFile* file, core::dimension2d<u32>& size, ECOLOR_FORMAT& format) const
+	{
+		return false;
+	}
+
+	//! Decodes the image in a file into memory of the caller
+	/** \param file File handle, read from its current position.
+	\param target Memory for the whole image, with the size getImageInfo
+	returns. Rows are written from top to bottom.
+	\param format Color format written to target. Any format the color
+	converter can create from the format of the file is supported.
+	\param pitch Size of a row of target in bytes.
+	\return False if the image could not be decoded. Target can then be
+	partially written. */
+	virtual bool loadImageInto(io::IReadFile* file, void* target, ECOLOR_FORMAT format, u32 pitch) const
+	{
+		return false;
+	}
 };
 
 
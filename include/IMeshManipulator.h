@@ -19,6 +19,45 @@ namespace scene
 {
 
 	struct SMesh;
+	struct SLODMesh;
+
+	//! Ways to calculate the tangents and binormals of a mesh
+	enum E_TANGENT_ALGORITHM
+	{
+		//! Irrlicht's own tangents, from the texture coordinates of each triangle
+		ETA_IRRLICHT = 0,
+
+		//! Tangents as MikkTSpace calculates them, which most normal map bakers use
+		/** The triangle tangents are projected into the plane of the vertex
+		normal and weighted by the triangle angle. All vertices with equal
+		position, normal and texture coordinates get the same tangent. The
+		binormal is the cross product of normal and tangent, negated for
+		mirrored texture coordinates. MikkTSpace would split a vertex used with
+		both orientations, here the orientation of the larger angle is used. */
+		ETA_MIKKTSPACE
+	};
+
+	//! Efficiency of a mesh for the post transform vertex cache.
+	/** Calculated by IMeshManipulator::getVertexCacheStatistics() with a
+	simulated FIFO cache. */
+	struct SVertexCacheStatistics
+	{
+		SVertexCacheStatistics() : ACMR(0.f), ATVR(0.f), TriangleCount(0), VertexCount(0) {}
+
+		//! Average cache miss ratio, transformed vertices per triangle.
+		/** 3 is the worst case, around 0.6 is possible for regular grids. */
+		f32 ACMR;
+
+		//! Average transform to vertex ratio, transformed vertices per used vertex.
+		/** 1 is the optimum, each vertex is transformed only once. */
+		f32 ATVR;
+
+		//! Number of triangles of all mesh buffers
+		u32 TriangleCount;
+
+		//! Number of vertices referenced by the triangles
+		u32 VertexCount;
+	};
 
 	//! An interface for easy manipulation of meshes.
 	/** Scale, set alpha value, flip surfaces, and so on. This exists for
@@ -71,36 +110,48 @@ namespace scene
 		//! Recalculates all normals of the mesh.
 		/** \param mesh: Mesh on which the operation is performed.
 		\param smooth: If the normals shall be smoothed.
-		\param angleWeighted: If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision. */
+		\param angleWeighted: If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision.
+		\param weldPositions: If set, smoothed normals are shared by all
+		vertices at the same position, even if other attributes differ. So
+		texture seams don't show up in the lighting, but split vertices of
+		hard edges are rounded as well. */
 		virtual void recalculateNormals(IMesh* mesh, bool smooth = false,
-				bool angleWeighted = false) const=0;
+				bool angleWeighted = false, bool weldPositions = false) const=0;
 
 		//! Recalculates all normals of the mesh buffer.
 		/** \param buffer: Mesh buffer on which the operation is performed.
 		\param smooth: If the normals shall be smoothed.
-		\param angleWeighted: If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision. */
+		\param angleWeighted: If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision.
+		\param weldPositions: If set, smoothed normals are shared by all
+		vertices at the same position, even if other attributes differ. */
 		virtual void recalculateNormals(IMeshBuffer* buffer,
-				bool smooth = false, bool angleWeighted = false) const=0;
+				bool smooth = false, bool angleWeighted = false, bool weldPositions = false) const=0;
 
 		//! Recalculates tangents, requires a tangent mesh
 		/** \param mesh Mesh on which the operation is performed.
 		\param recalculateNormals If the normals shall be recalculated, otherwise original normals of the mesh are used unchanged.
 		\param smooth If the normals shall be smoothed.
 		\param angleWeighted If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision.
+		\param algorithm How tangents and binormals are calculated. With
+		ETA_MIKKTSPACE smooth and angleWeighted only affect the normals.
 		*/
 		virtual void recalculateTangents(IMesh* mesh,
 				bool recalculateNormals=false, bool smooth=false,
-				bool angleWeighted=false) const=0;
+				bool angleWeighted=false,
+				E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const=0;
 
 		//! Recalculates tangents, requires a tangent mesh buffer
 		/** \param buffer Meshbuffer on which the operation is performed.
 		\param recalculateNormals If the normals shall be recalculated, otherwise original normals of the buffer are used unchanged.
 		\param smooth If the normals shall be smoothed.
 		\param angleWeighted If the normals shall be smoothed in relation to their angles. More expensive, but also higher precision.
+		\param algorithm How tangents and binormals are calculated. With
+		ETA_MIKKTSPACE smooth and angleWeighted only affect the normals.
 		*/
 		virtual void recalculateTangents(IMeshBuffer* buffer,
 				bool recalculateNormals=false, bool smooth=false,
-				bool angleWeighted=false) const=0;
+				bool angleWeighted=false,
+				E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const=0;
 
 		//! Scales the actual mesh, not a scene node.
 		/** \param mesh Mesh on which the operation is performed.
@@ -224,13 +275,15 @@ namespace scene
 		meshbuffer's faces if this flag is set.
 		\param angleWeighted Improved smoothing calculation used
 		\param recalculateTangents Whether are actually calculated, or just the mesh with proper type is created.
+		\param algorithm How tangents and binormals are calculated.
 		\return Mesh consisting only of S3DVertexTangents vertices. If
 		you no longer need the cloned mesh, you should call
 		IMesh::drop(). See IReferenceCounted::drop() for more
 		information. */
 		virtual IMesh* createMeshWithTangents(IMesh* mesh,
 				bool recalculateNormals=false, bool smooth=false,
-				bool angleWeighted=false, bool recalculateTangents=true) const=0;
+				bool angleWeighted=false, bool recalculateTangents=true,
+				E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const=0;
 
 		//! Creates a copy of the mesh, which will only consist of S3DVertex2TCoord vertices.
 		/** \param mesh Input mesh
@@ -258,6 +311,9 @@ namespace scene
 
 		//! Creates a copy of a mesh with vertices welded
 		/** \param mesh Input mesh
+		Vertices are merged when position and normal are within the
+		tolerance and all other attributes are equal. Triangles which
+		become degenerate are removed.
 		\param tolerance The threshold for vertex comparisons.
 		\return Mesh without redundant vertices. If you no longer need
 		the cloned mesh, you should call IMesh::drop(). See
@@ -295,6 +351,77 @@ namespace scene
 		\return A new mesh optimized for the vertex cache. */
 		virtual IMesh* createForsythOptimizedMesh(const IMesh *mesh) const = 0;
 
+		//! Creates a simplified copy of a mesh.
+		/** Uses edge collapses driven by quadric error metrics. Vertices are
+		only removed, never moved, so texture coordinates, colors and normals
+		stay valid. Open borders and texture or normal seams are preserved.
+		Each mesh buffer is simplified on its own and keeps its vertex type
+		and material.
+
+		The function is thread-safe.
+
+		\param mesh Source mesh for the operation.
+		\param triangleRatio Fraction of the triangles which should remain,
+		e.g. 0.5 for half of the triangles.
+		\param maxError If larger than 0, simplification stops before a
+		collapse would create a larger error than this, even when the
+		triangle count is not yet reached. Measured like outError.
+		\param outError Receives the error of the worst collapse: the root of
+		the mean squared distance of the kept vertex to the planes of the
+		triangles merged into it, weighted by their area. In object space
+		units. This estimates how far the surface moved, it is not a bound
+		on the distance between the simplified and the source surface.
+		Can be 0.
+		\return New mesh with less triangles. If you no longer need the mesh,
+		you should call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual IMesh* createSimplifiedMesh(IMesh* mesh, f32 triangleRatio,
+			f32 maxError=0.f, f32* outError=0) const = 0;
+
+		//! Creates a mesh with several levels of detail.
+		/** Level 0 is the source mesh itself, each further level is created
+		with createSimplifiedMesh() from the previous one. Levels which would
+		not reduce the triangle count anymore are left out. When added to an
+		IMeshSceneNode, the node selects the level based on the projected
+		error, see SLODMesh.
+		\param mesh Source mesh, used as full detail level.
+		\param levelCount Maximal number of levels including the source mesh.
+		\param triangleRatio Fraction of triangles of the previous level each
+		level keeps.
+		\return New mesh with the levels. If you no longer need the mesh, you
+		should call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual SLODMesh* createLODMesh(IMesh* mesh, u32 levelCount=4, f32 triangleRatio=0.5f) const = 0;
+
+		//! Creates a copy of a mesh optimized for rendering.
+		/** Runs all steps of a mesh optimization pipeline on each mesh buffer:
+		- Bitwise identical vertices are merged, found by hashing.
+		- Triangles are reordered for the post transform vertex cache, with
+		the Tipsify algorithm of Sander, Nehab and Barczak, "Fast Triangle
+		Reordering for Vertex Locality and Reduced Overdraw".
+		- The triangles are split into clusters which are sorted front to
+		back from the outside of the mesh, so less pixels get overdrawn.
+		- Vertices are sorted in the order of their first use, for linear
+		vertex fetch. Unused vertices are removed.
+
+		Use getVertexCacheStatistics() to compare the result with the source
+		mesh. The function is thread-safe.
+		\param mesh Source mesh for the operation.
+		\param overdrawThreshold How much worse the ACMR may get to allow
+		smaller clusters for overdraw sorting, 1.05 allows 5%. Values below 1
+		disable the overdraw optimization.
+		\param cacheSize Size of the vertex cache optimized for. 16 is a safe
+		value for most hardware.
+		\return New optimized mesh. If you no longer need the mesh, you should
+		call IMesh::drop(). See IReferenceCounted::drop() for more information. */
+		virtual IMesh* createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold=1.05f, u32 cacheSize=16) const = 0;
+
+		//! Simulates the post transform vertex cache for the mesh.
+		/** \param mesh Mesh to examine, each mesh buffer starts with an empty cache.
+		\param cacheSize Number of vertices in the simulated FIFO cache.
+		\return Statistics of the cache efficiency. */
+		virtual SVertexCacheStatistics getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize=16) const = 0;
+
 		//! Optimize the mesh with an algorithm tuned for heightmaps.
 		/**
 		This differs from usual simplification methods in two ways:
@@ -0,0 +1,89 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+#define __I_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+#include "dimension2d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! A scene node for terrains too large to be kept in memory at once.
+	/** The heightmap is a RAW file, read in square chunks of samples around
+	the active camera. Chunks are loaded on a background thread, heights and
+	normals are calculated there as well. Chunks out of the load distance stay
+	in memory until the memory budget is needed for other chunks, the farthest
+	ones are evicted first.
+
+	The vertices are in heightmap samples, so the node is scaled to get the
+	size of the terrain: a scale of (10,1,10) puts samples 10 units apart.
+	Chunks far from the camera use fewer vertices, the gaps between chunks of
+	different detail are hidden by skirts hanging down from the chunk borders.
+	*/
+	class IPagedTerrainSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		IPagedTerrainSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0.0f, 0.0f, 0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f, 0.0f, 0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f))
+			: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+		//! Get the height of the terrain at a position in world space.
+		/** \return Height, or -FLT_MAX if the chunk there is not loaded
+		or the position is not on the terrain. */
+		virtual f32 getHeight(f32 x, f32 z) const =0;
+
+		//! Set the distance around the camera in which chunks are loaded.
+		/** \param distance Distance in world units, measured to the
+		nearest point of a chunk. */
+		virtual void setLoadDistance(f32 distance) =0;
+
+		//! Get the distance around the camera in which chunks are loaded.
+		virtual f32 getLoadDistance() const =0;
+
+		//! Set the memory the chunks may use.
+		/** Chunks are evicted, the farthest first, when chunks nearer
+		to the camera need the memory. No chunks are loaded beyond the
+		budget, even if they are in the load distance.
+		\param bytes Memory for vertices and indices of all chunks. */
+		virtual void setMemoryBudget(u32 bytes) =0;
+
+		//! Get the memory the chunks may use.
+		virtual u32 getMemoryBudget() const =0;
+
+		//! Get the memory used by loaded chunks and chunks being loaded.
+		virtual u32 getMemoryUsage() const =0;
+
+		//! Get the number of chunks along the X and Z axis of the heightmap.
+		virtual core::dimension2du getChunkCount() const =0;
+
+		//! Get the number of chunks which are loaded.
+		virtual u32 getLoadedChunkCount() const =0;
+
+		//! Check if a chunk is loaded.
+		/** \param x Chunk along the X axis.
+		\param z Chunk along the Z axis. */
+		virtual bool isChunkLoaded(u32 x, u32 z) const =0;
+
+		//! Load the chunks around a position and wait until they are loaded.
+		/** Usually chunks are loaded in the background around the active
+		camera, when the node is registered for rendering. This can be used
+		to have the terrain complete at a start position, for example behind
+		a loading screen.
+		\param position Position in world space. */
+		virtual void loadChunksAround(const core::vector3df& position) =0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -13,6 +13,8 @@ namespace irr
 namespace scene
 {
 
+class IParticleStoreAffector;
+
 //! Types of built in particle affectors
 enum E_PARTICLE_AFFECTOR_TYPE
 {
@@ -60,6 +62,11 @@ public:
 	//! Get emitter type
 	virtual E_PARTICLE_AFFECTOR_TYPE getType() const = 0;
 
+	//! Get the interface which affects the particle arrays of a particle system directly
+	/** Only implemented by the affectors of the engine.
+	\return 0 if the affector only supports affect(). */
+	virtual IParticleStoreAffector* getStoreAffector() { return 0; }
+
 protected:
 	bool Enabled;
 };
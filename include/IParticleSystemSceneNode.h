@@ -65,7 +65,14 @@ enum EParticleBehavior
 	//! On emitting global particles interpolate the positions randomly between the last and current node transformations.
 	//! This can be set to avoid gaps caused by fast node movement or low framerates, but will be somewhat
 	//! slower to calculate.
-	EPB_EMITTER_FRAME_INTERPOLATION = 32
+	EPB_EMITTER_FRAME_INTERPOLATION = 32,
+
+	//! Simulate the particles on a worker thread, in parallel with other particle systems using this flag.
+	//! The simulation starts after all scene nodes are animated and is finished before the first of them is
+	//! registered for rendering. Emitter and affectors must not be shared with other particle systems and
+	//! affectors written by users must be thread safe. Systems with an animated mesh scene node emitter
+	//! are always simulated on the main thread.
+	EPB_PARALLEL_SIMULATION = 64
 };
 
 class IParticleSystemSceneNode : public ISceneNode
@@ -99,6 +99,7 @@ namespace scene
 	class IBillboardSceneNode;
 	class IBillboardTextSceneNode;
 	class ICameraSceneNode;
+	class IClusteredLightManager;
 	class IDummyTransformationSceneNode;
 	class ILightManager;
 	class ILightSceneNode;
@@ -110,7 +111,9 @@ namespace scene
 	class IMeshSceneNode;
 	class IMeshWriter;
 	class IMetaTriangleSelector;
+	class IPagedTerrainSceneNode;
 	class IParticleSystemSceneNode;
+	class IQ3LevelMesh;
 	class ISceneCollisionManager;
 	class ISceneLoader;
 	class ISceneNode;
@@ -123,6 +126,8 @@ namespace scene
 	class ITextSceneNode;
 	class ITriangleSelector;
 	class IVolumeLightSceneNode;
+	class CBillboardBatch;
+	class CParticleSystemSceneNode;
 
 	namespace quake3
 	{
@@ -899,6 +904,56 @@ namespace scene
 			s32 maxLOD=5, E_TERRAIN_PATCH_SIZE patchSize=ETPS_17, s32 smoothFactor=0,
 			bool addAlsoIfHeightmapEmpty = false) = 0;
 
+		//! Adds a paged terrain scene node to the scene graph.
+		/** Paged terrains stream the heightmap in chunks around the
+		camera, so heightmaps larger than memory can be used. See
+		IPagedTerrainSceneNode for details.
+		\param heightMapFileName: The RAW file with the heights. Rows
+		along the X axis follow each other, each row has width samples
+		along the Z axis.
+		\param width: Number of samples in a row. The number of rows
+		is calculated from the file size.
+		\param bitsPerPixel: Size of the samples, 8, 16 or 32 bits.
+		Heights are scaled like in ITerrainSceneNode::loadHeightMapRAW().
+		\param signedData: Whether the samples are signed, ignored for floats.
+		\param floatVals: Whether the samples are 32 bit floats.
+		\param parent: Parent of the scene node. Can be 0 if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param position: The position of this node.
+		\param rotation: The rotation of this node.
+		\param scale: The scale of this node. A scale of (10,1,10) puts the
+		samples 10 units apart.
+		\param vertexColor: The color of all vertices.
+		\param chunkSize: Number of samples between the borders of a chunk,
+		a power of two from 16 to 128.
+		\return Pointer to the created scene node. Can be null if the file
+		could not be opened or is too small. This pointer should not be
+		dropped. See IReferenceCounted::drop() for more information. */
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			const io::path& heightMapFileName, u32 width,
+			s32 bitsPerPixel=16, bool signedData=false, bool floatVals=false,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			video::SColor vertexColor = video::SColor(255,255,255,255),
+			u32 chunkSize=64) = 0;
+
+		//! Adds a paged terrain scene node to the scene graph.
+		/** Just like the other addPagedTerrainSceneNode() method, but
+		takes an IReadFile pointer as parameter for the heightmap. The
+		node grabs the file and reads it on a background thread, so it
+		must not be used elsewhere afterwards. */
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			io::IReadFile* heightMapFile, u32 width,
+			s32 bitsPerPixel=16, bool signedData=false, bool floatVals=false,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			video::SColor vertexColor = video::SColor(255,255,255,255),
+			u32 chunkSize=64) = 0;
+
 		//! Adds a quake3 scene node to the scene graph.
 		/** A Quake3 Scene renders multiple meshes for a specific HighLanguage Shader (Quake3 Style )
 		\return Pointer to the quake3 scene node if successful, otherwise NULL.
@@ -907,6 +962,21 @@ namespace scene
 												ISceneNode* parent=0, s32 id=-1
 												) = 0;
 
+		//! Adds a scene node drawing the geometry of a Quake3 level.
+		/** Draws the mesh quake3::E_Q3_MESH_GEOMETRY of the level. The
+		BSP tree and the visibility data of the .bsp file are used to draw
+		only the faces which may be seen from the cluster the camera is in.
+		This is usually much less than an octree scene node draws inside
+		of buildings. Levels without visibility data are drawn completely.
+		\param mesh: Level loaded from a .bsp file.
+		\param parent: Parent of the scene node. Can be NULL if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\return Pointer to the created scene node. Can be null if the
+		node could not be created, e.g. when .bsp files are not supported.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IMeshSceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) = 0;
+
 
 		//! Adds an empty scene node to the scene graph.
 		/** Can be used for doing advanced transformations
@@ -1658,6 +1728,17 @@ namespace scene
 			current callbacks manager and restore the default behavior. */
 		virtual void setLightManager(ILightManager* lightManager) = 0;
 
+		//! Creates a light manager which switches on only the lights near each scene node.
+		/** It splits the view frustum into clusters and assigns each node the
+		lights overlapping its bounding box, see IClusteredLightManager.
+		Activate it with setLightManager().
+		\param clusterCount Number of clusters across the screen width,
+		height and depth.
+		\return The light manager. If you no longer need it, you should call
+		IReferenceCounted::drop(). */
+		virtual IClusteredLightManager* createClusteredLightManager(
+			const core::vector3d<u32>& clusterCount=core::vector3d<u32>(16,8,24)) = 0;
+
 		//! Get current render pass.
 		virtual E_SCENE_NODE_RENDER_PASS getCurrentRenderPass() const =0;
 
@@ -1679,6 +1760,18 @@ namespace scene
 		\return True if node is not visible in the current scene, else
 		false. */
 		virtual bool isCulled(const ISceneNode* node) const =0;
+
+		//! Get the particle systems waiting for their simulation on the worker threads
+		/** Only implemented by the scene manager of the engine, its particle
+		systems queue themselves there while they are animated.
+		\return 0 if particle systems are simulated one after another. */
+		virtual core::array<CParticleSystemSceneNode*>* getParticleSimulationQueue() { return 0; }
+
+		//! Get the batch collecting the quads of the billboards being rendered
+		/** Only implemented by the scene manager of the engine, its billboard
+		scene nodes add their quads there while it is active.
+		\return 0 if billboards draw themselves. */
+		virtual CBillboardBatch* getBillboardBatch() { return 0; }
 	};
 
 
@@ -28,6 +28,10 @@ namespace scene
 		virtual void setShadowMesh(const IMesh* mesh) = 0;
 
 		//! Updates the shadow volumes for current light positions.
+		/** The mesh is only copied again when the change ids of its mesh
+		buffers change, so call IMeshBuffer::setDirty() after changing the
+		vertices or indices of the shadow mesh. Volumes of lights which did
+		not move relative to the node are not recreated. */
 		virtual void updateShadowVolumes() = 0;
 	};
 
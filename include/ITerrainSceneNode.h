@@ -14,6 +14,7 @@
 #include "ISceneNode.h"
 #include "IDynamicMeshBuffer.h"
 #include "irrArray.h"
+#include "line3d.h"
 
 namespace irr
 {
@@ -111,6 +112,33 @@ namespace scene
 		//! Get height of a point of the terrain.
 		virtual f32 getHeight(f32 x, f32 y) const =0;
 
+		//! Get the heights and normals of the terrain at many points.
+		/** Much faster than calling getHeight() for each point. The
+		transformation of the terrain is set up once for all points, and the
+		heights are read from a compact copy of the heightmap.
+		\param positions Points in world space, their Y coordinate is ignored.
+		\param count Number of points.
+		\param outHeights Receives the height of the terrain at each point,
+		-FLT_MAX for points outside of the terrain.
+		\param outNormals If not 0, receives the normalized surface normal at
+		each point in world space.
+		\param sampling How heights are interpolated between the samples. */
+		virtual void getHeights(const core::vector3df* positions, u32 count, f32* outHeights,
+			core::vector3df* outNormals=0, E_TERRAIN_HEIGHT_SAMPLING sampling=ETHS_TRIANGLE) const =0;
+
+		//! Get the first intersection of a line with the terrain.
+		/** Walks along the heightmap cells the line crosses, and skips
+		patches which the line passes above or below, without creating any
+		triangles. The terrain is tested at full detail, unlike the triangles
+		of a triangle selector created with a coarser LOD.
+		\param line Line in world space.
+		\param outIntersection Receives the intersection nearest to the start of the line.
+		\param outNormal If not 0, receives the normal of the terrain at the
+		intersection in world space.
+		\return True if the line intersects the terrain. */
+		virtual bool getIntersectionWithLine(const core::line3df& line,
+			core::vector3df& outIntersection, core::vector3df* outNormal=0) const =0;
+
 		//! Sets the movement camera threshold.
 		/** It is used to determine when to recalculate
 		indices for the scene node. The default value is 10.0f. */
@@ -125,6 +153,15 @@ namespace scene
 		/** \param bVal: Boolean value representing whether or not to update selector dynamically. */
 		virtual void setDynamicSelectorUpdate(bool bVal) =0;
 
+		//! Enable smooth transitions between the levels of detail of the patches.
+		/** Vertices which a patch loses in the next coarser LOD are moved
+		towards their place on the coarser surface while the camera moves
+		away, and are there before the patch changes its LOD. So patches do
+		not pop when their LOD changes. The vertices are moved on the CPU each
+		time the camera moves, so the vertex buffer is no longer static.
+		\param enable True to enable morphing, it is disabled by default. */
+		virtual void setLODMorphing(bool enable) =0;
+
 		//! Override the default generation of distance thresholds.
 		/** For determining the LOD a patch is rendered at. If any LOD
 		is overridden, then the scene node will no longer apply scaling
@@ -71,6 +71,20 @@ enum E_TEXTURE_CREATION_FLAG
 	Currently only used in combination with OpenGL drivers.	*/
 	ETCF_ALLOW_MEMORY_COPY = 0x00000080,
 
+	//! Filter the mip map levels of textures in linear space
+	/** For textures with colors in sRGB, which get too dark in the smaller
+	levels otherwise. The levels of textures loaded from files are then
+	generated on the CPU, see IVideoDriver::setMipMapCacheDirectory. Only
+	used together with ETCF_CREATE_MIP_MAPS. */
+	ETCF_MIP_MAPS_GAMMA_CORRECT = 0x00000100,
+
+	//! Weight the colors with their alpha when filtering mip map levels
+	/** So the colors of transparent texels don't bleed into the visible
+	ones, like dark fringes around leaves. The levels of textures loaded
+	from files are then generated on the CPU. Only used together with
+	ETCF_CREATE_MIP_MAPS. */
+	ETCF_MIP_MAPS_PREMULTIPLIED_ALPHA = 0x00000200,
+
 	/** This flag is never used, it only forces the compiler to compile
 	these enumeration values to 32 bit. */
 	ETCF_FORCE_32_BIT_DO_NOT_USE = 0x7fffffff
@@ -1042,6 +1042,27 @@ namespace video
 			video::SColor leftDownEdge = video::SColor(255,0,0,0),
 			video::SColor rightDownEdge = video::SColor(255,0,0,0)) =0;
 
+		//! Darkens the parts of the rendered scene a light does not reach.
+		/** To draw a shadow map shadow, do this: Set a render target
+		which has only a depth texture, created with
+		addRenderTargetTexture() and format ECF_D32, and draw the shadow
+		casters with the view and projection of the light: orthogonal
+		for directional lights, perspective for spot lights. Then draw
+		all geometry with the camera and use this method, while the view
+		and projection of the camera are still set.
+		Each pixel is transformed into the shadow map and compared with
+		the depth stored there, so the costs only depend on the screen
+		size. Only the Burning's Video driver supports this so far.
+		\param shadowMap Depth texture rendered from the light.
+		\param lightViewProjection Projection matrix multiplied with the
+		view matrix of the light when the shadow map was rendered.
+		\param shadowColor Color blended over the shadowed pixels, with
+		its alpha.
+		\param bias Depth difference which is not counted as shadow, to
+		avoid surfaces shadowing themselves. */
+		virtual void drawShadowMap(ITexture* shadowMap, const core::matrix4& lightViewProjection,
+			video::SColor shadowColor = video::SColor(150,0,0,0), f32 bias = 0.001f) =0;
+
 		//! Draws a mesh buffer
 		/** \param mb Buffer to draw */
 		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb) =0;
@@ -1184,6 +1205,18 @@ namespace video
 		\return The current texture creation flag enabled mode. */
 		virtual bool getTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag) const =0;
 
+		//! Sets a directory to cache the mip map levels of textures in
+		/** Textures loaded from files get their mip map levels generated
+		on the CPU when the driver can't create them itself, when one of
+		the flags ETCF_MIP_MAPS_GAMMA_CORRECT or
+		ETCF_MIP_MAPS_PREMULTIPLIED_ALPHA is set, or when this cache is
+		used. The levels are written into the directory, keyed by a hash
+		of the image and the flags, and read from there when the same
+		image is loaded again, also in later runs.
+		\param directory Existing directory for the cache files. An empty
+		path disables the cache, which is the default. */
+		virtual void setMipMapCacheDirectory(const io::path& directory) =0;
+
 		//! Creates a software images from a file.
 		/** No hardware texture will be created for those images. This
 		method is useful for example if you want to read a heightmap
@@ -134,6 +134,28 @@ while it runs and enabling it will slow down the engine. */
 #undef _IRR_COMPILE_WITH_PROFILING_
 #endif
 
+//! Define _IRR_COMPILE_WITH_SSE2_ to use SSE2 intrinsics in some cpu heavy inner loops
+/** This is enabled automatically when the compiler generates SSE2 code anyway
+(all x86-64 targets, -msse2 or /arch:SSE2). All those loops also have a plain C++ version,
+so you can disable it when you need bit exact results across platforms. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _IRR_COMPILE_WITH_SSE2_
+#endif
+#ifdef NO_IRR_COMPILE_WITH_SSE2_
+#undef _IRR_COMPILE_WITH_SSE2_
+#endif
+
+//! Define _IRR_COMPILE_WITH_WORKER_THREADS_ to spread some cpu heavy loops over all processor cores
+/** The engine then starts one worker thread less than there are cores, on first use.
+Uses pthreads or Win32 threads, so on Linux you might have to link with -lpthread.
+Results do not depend on the number of threads. */
+#if defined(_IRR_WINDOWS_API_) || defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+#define _IRR_COMPILE_WITH_WORKER_THREADS_
+#endif
+#ifdef NO_IRR_COMPILE_WITH_WORKER_THREADS_
+#undef _IRR_COMPILE_WITH_WORKER_THREADS_
+#endif
+
 //! Define _IRR_COMPILE_WITH_DIRECT3D_9_ to compile the Irrlicht engine with DIRECT3D9.
 /** If you only want to use the software device or opengl you can disable those defines.
 This switch is mostly disabled because people do not get the g++ compiler compile
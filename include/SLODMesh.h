@@ -0,0 +1,226 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __S_LOD_MESH_H_INCLUDED__
+#define __S_LOD_MESH_H_INCLUDED__
+
+#include "IAnimatedMesh.h"
+#include "IMesh.h"
+#include "aabbox3d.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! A static mesh with several levels of detail.
+	/** Level 0 is the full detail mesh, every further level has less triangles.
+	Each level stores the estimated geometric error in object space it has
+	compared to the full detail mesh. IMeshSceneNode uses this to pick the coarsest level
+	whose error projected to the screen stays below MaxScreenError pixels.
+	Such meshes are usually created by IMeshManipulator::createLODMesh(). All
+	levels should have the same number of mesh buffers with the same materials.
+	As animated mesh it has only one frame, the detail level of getMesh() selects
+	the level. */
+	struct SLODMesh : public IAnimatedMesh
+	{
+		//! constructor
+		SLODMesh() : IAnimatedMesh(), MaxScreenError(1.f), Hysteresis(0.2f)
+		{
+			#ifdef _DEBUG
+			setDebugName("SLODMesh");
+			#endif
+		}
+
+		//! destructor
+		virtual ~SLODMesh()
+		{
+			// drop meshes
+			for (u32 i=0; i<Levels.size(); ++i)
+				Levels[i]->drop();
+		}
+
+		//! Adds the next coarser level
+		/** \param mesh Mesh of the level
+		\param error Estimated distance of the mesh surface to the full
+		detail mesh, in object space, e.g. the error returned by
+		IMeshManipulator::createSimplifiedMesh(). Has to be increasing with
+		the levels. */
+		void addLevel(IMesh* mesh, f32 error)
+		{
+			if (mesh)
+			{
+				mesh->grab();
+				Levels.push_back(mesh);
+				Errors.push_back(error);
+			}
+		}
+
+		//! Get the number of levels
+		u32 getLevelCount() const
+		{
+			return Levels.size();
+		}
+
+		//! Get the mesh of a level, 0 is the full detail mesh
+		IMesh* getLevel(u32 level) const
+		{
+			if (level >= Levels.size())
+				return 0;
+
+			return Levels[level];
+		}
+
+		//! Get the object space error of a level
+		f32 getLevelError(u32 level) const
+		{
+			if (level >= Errors.size())
+				return 0.f;
+
+			return Errors[level];
+		}
+
+		//! Gets the frame count of the animated mesh.
+		/** \return Always 1, the levels are no frames. */
+		virtual u32 getFrameCount() const
+		{
+			return 1;
+		}
+
+		//! Gets the default animation speed of the animated mesh.
+		/** \return Always 0, the mesh is not animated. */
+		virtual f32 getAnimationSpeed() const
+		{
+			return 0.f;
+		}
+
+		//! Not used, the mesh is not animated.
+		virtual void setAnimationSpeed(f32 fps)
+		{
+		}
+
+		//! Returns the mesh of a detail level.
+		/** \param frame: Ignored, there is only one frame.
+		\param detailLevel: Level of detail. 0 is the lowest, 255 the highest
+		level of detail. The range is split evenly over all levels.
+		\param startFrameLoop: Ignored
+		\param endFrameLoop: Ignored
+		\return The mesh of the level. */
+		virtual IMesh* getMesh(s32 frame, s32 detailLevel=255, s32 startFrameLoop=-1, s32 endFrameLoop=-1)
+		{
+			if (Levels.empty())
+				return 0;
+
+			const s32 detail = core::s32_clamp(detailLevel, 0, 255);
+			return Levels[((255 - detail) * Levels.size()) >> 8];
+		}
+
+		//! Returns an axis aligned bounding box of the mesh.
+		/** \return A bounding box of this mesh is returned. */
+		virtual const core::aabbox3d<f32>& getBoundingBox() const
+		{
+			return Box;
+		}
+
+		//! set user axis aligned bounding box
+		virtual void setBoundingBox(const core::aabbox3df& box)
+		{
+			Box = box;
+		}
+
+		//! Recalculates the bounding box.
+		void recalculateBoundingBox()
+		{
+			Box.reset(0,0,0);
+
+			if (Levels.empty())
+				return;
+
+			Box = Levels[0]->getBoundingBox();
+
+			for (u32 i=1; i<Levels.size(); ++i)
+				Box.addInternalBox(Levels[i]->getBoundingBox());
+		}
+
+		//! Returns the type of the animated mesh.
+		virtual E_ANIMATED_MESH_TYPE getMeshType() const
+		{
+			return EAMT_LOD;
+		}
+
+		//! returns amount of mesh buffers of the full detail level.
+		virtual u32 getMeshBufferCount() const
+		{
+			if (Levels.empty())
+				return 0;
+
+			return Levels[0]->getMeshBufferCount();
+		}
+
+		//! returns pointer to a mesh buffer of the full detail level
+		virtual IMeshBuffer* getMeshBuffer(u32 nr) const
+		{
+			if (Levels.empty())
+				return 0;
+
+			return Levels[0]->getMeshBuffer(nr);
+		}
+
+		//! Returns pointer to a mesh buffer of the full detail level which fits a material
+		/** \param material: material to search for
+		\return Returns the pointer to the mesh buffer or
+		NULL if there is no such mesh buffer. */
+		virtual IMeshBuffer* getMeshBuffer( const video::SMaterial &material) const
+		{
+			if (Levels.empty())
+				return 0;
+
+			return Levels[0]->getMeshBuffer(material);
+		}
+
+		//! Set a material flag for all meshbuffers of all levels.
+		virtual void setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue)
+		{
+			for (u32 i=0; i<Levels.size(); ++i)
+				Levels[i]->setMaterialFlag(flag, newvalue);
+		}
+
+		//! set the hardware mapping hint, for driver
+		virtual void setHardwareMappingHint( E_HARDWARE_MAPPING newMappingHint, E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX )
+		{
+			for (u32 i=0; i<Levels.size(); ++i)
+				Levels[i]->setHardwareMappingHint(newMappingHint, buffer);
+		}
+
+		//! flags the meshbuffer as changed, reloads hardware buffers
+		virtual void setDirty(E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX)
+		{
+			for (u32 i=0; i<Levels.size(); ++i)
+				Levels[i]->setDirty(buffer);
+		}
+
+		//! The meshes of all levels, full detail first
+		core::array<IMesh*> Levels;
+
+		//! Object space error of each level
+		core::array<f32> Errors;
+
+		//! The bounding box of this mesh
+		core::aabbox3d<f32> Box;
+
+		//! Maximal error in pixels a scene node accepts when selecting a level
+		f32 MaxScreenError;
+
+		//! Fraction of MaxScreenError by which a coarser level has to be better before it is used.
+		/** Avoids switching back and forth when the camera moves around the threshold distance. */
+		f32 Hysteresis;
+	};
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
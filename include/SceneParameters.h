@@ -174,6 +174,25 @@ namespace scene
 	**/
 	const c8* const DEBUG_NORMAL_COLOR = "DEBUG_Normal_Color";
 
+	//! Name of the parameter for creating levels of detail for loaded static meshes.
+	/** When set to a number larger than 1, ISceneManager::getMesh() replaces
+	each loaded static mesh by an SLODMesh with up to this many levels. Animated
+	and skinned meshes are not changed. IMeshSceneNode then selects the level
+	from the distance to the camera. Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::MESH_LOD_LEVELS, 4);
+	\endcode
+	**/
+	const c8* const MESH_LOD_LEVELS = "IRR_MeshLODLevels";
+
+	//! Name of the parameter for the fraction of triangles kept by each level of detail.
+	/** Only used together with MESH_LOD_LEVELS, the default is 0.5. Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::MESH_LOD_TRIANGLE_RATIO, 0.25f);
+	\endcode
+	**/
+	const c8* const MESH_LOD_TRIANGLE_RATIO = "IRR_MeshLODTriangleRatio";
+
 
 } // end namespace scene
 } // end namespace irr
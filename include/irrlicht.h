@@ -118,6 +118,7 @@
 #include "IColladaMeshWriter.h"
 #include "IMetaTriangleSelector.h"
 #include "IOSOperator.h"
+#include "IPagedTerrainSceneNode.h"
 #include "IParticleSystemSceneNode.h" // also includes all emitters and attractors
 #include "IQ3LevelMesh.h"
 #include "IQ3Shader.h"
@@ -161,6 +162,7 @@
 #include "IXMLReader.h"
 #include "IXMLWriter.h"
 #include "ILightManager.h"
+#include "IClusteredLightManager.h"
 #include "Keycodes.h"
 #include "line2d.h"
 #include "line3d.h"
@@ -177,6 +179,7 @@
 #include "SIrrCreationParameters.h"
 #include "SKeyMap.h"
 #include "SLight.h"
+#include "SLODMesh.h"
 #include "SMaterial.h"
 #include "SMesh.h"
 #include "SMeshBuffer.h"
@@ -227,6 +227,7 @@ CAnimatedMeshMD2::CAnimatedMeshMD2()
 	IMesh::setDebugName("CAnimatedMeshMD2 IMesh");
 	#endif
 	InterpolationBuffer = new SMeshBuffer;
+	PoseBuffers.push_back(InterpolationBuffer);
 }
 
 
@@ -234,8 +235,8 @@ CAnimatedMeshMD2::CAnimatedMeshMD2()
 CAnimatedMeshMD2::~CAnimatedMeshMD2()
 {
 	delete [] FrameList;
-	if (InterpolationBuffer)
-		InterpolationBuffer->drop();
+	for (u32 i=0; i<PoseBuffers.size(); ++i)
+		PoseBuffers[i]->drop();
 }
 
 
@@ -321,52 +322,91 @@ void CAnimatedMeshMD2::updateInterpolationBuffer(s32 frame, s32 startFrameLoop,
 		div = frame * MD2_FRAME_SHIFT_RECIPROCAL;
 	}
 
-	if ( firstFrame != InterpolationFirstFrame || secondFrame != InterpolationSecondFrame || div != InterpolationFrameDiv )
-	{
-		InterpolationFirstFrame = firstFrame;
-		InterpolationSecondFrame = secondFrame;
-		InterpolationFrameDiv = div;
+	if ( firstFrame == InterpolationFirstFrame && secondFrame == InterpolationSecondFrame && div == InterpolationFrameDiv )
+		return;
+
+	InterpolationFirstFrame = firstFrame;
+	InterpolationSecondFrame = secondFrame;
+	InterpolationFrameDiv = div;
 
-		video::S3DVertex* target = static_cast<video::S3DVertex*>(InterpolationBuffer->getVertices());
-		SMD2Vert* first = FrameList[firstFrame].pointer();
-		SMD2Vert* second = FrameList[secondFrame].pointer();
+	if (Frames.getFrameCount() != FrameCount)
+		decodeFrames();
+
+	// several nodes showing the same pose in one frame only interpolate once
+	bool cached;
+	SMeshBuffer* buffer = getPoseBuffer(PoseCache.getSlot(firstFrame, secondFrame, div, cached));
+	if (buffer != InterpolationBuffer)
+	{
+		buffer->Material = InterpolationBuffer->Material;
+		InterpolationBuffer = buffer;
+	}
 
+	if (!cached && buffer->Vertices.size() >= Frames.getVertexCount())
+	{
 		// interpolate both frames
-		const u32 count = FrameList[firstFrame].size();
-		for (u32 i=0; i<count; ++i)
+		Frames.interpolate(firstFrame, secondFrame, div, buffer->Vertices.pointer(), sizeof(video::S3DVertex));
+
+		//update bounding box
+		buffer->setBoundingBox(BoxList[secondFrame].getInterpolated(BoxList[firstFrame], div));
+		buffer->setDirty(EBT_VERTEX);
+	}
+}
+
+
+//! decodes FrameList into Frames
+void CAnimatedMeshMD2::decodeFrames()
+{
+	const u32 vertexCount = FrameCount ? FrameList[0].size() : 0;
+	Frames.setup(FrameCount, vertexCount);
+
+	for (u32 f=0; f<FrameCount; ++f)
+	{
+		const SKeyFrameTransform& transform = FrameTransforms[f];
+		const SMD2Vert* v = FrameList[f].const_pointer();
+		const u32 count = core::min_(vertexCount, FrameList[f].size());
+
+		for (u32 i=0; i<count; ++i, ++v)
 		{
-			const core::vector3df one = core::vector3df(f32(first->Pos.X) * FrameTransforms[firstFrame].scale.X + FrameTransforms[firstFrame].translate.X,
-					f32(first->Pos.Y) * FrameTransforms[firstFrame].scale.Y + FrameTransforms[firstFrame].translate.Y,
-					f32(first->Pos.Z) * FrameTransforms[firstFrame].scale.Z + FrameTransforms[firstFrame].translate.Z);
-			const core::vector3df two = core::vector3df(f32(second->Pos.X) * FrameTransforms[secondFrame].scale.X + FrameTransforms[secondFrame].translate.X,
-					f32(second->Pos.Y) * FrameTransforms[secondFrame].scale.Y + FrameTransforms[secondFrame].translate.Y,
-					f32(second->Pos.Z) * FrameTransforms[secondFrame].scale.Z + FrameTransforms[secondFrame].translate.Z);
-			target->Pos = two.getInterpolated(one, div);
-			const core::vector3df n1(
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][0],
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][2],
-					Q2_VERTEX_NORMAL_TABLE[first->NormalIdx][1]);
-			const core::vector3df n2(
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][0],
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][2],
-					Q2_VERTEX_NORMAL_TABLE[second->NormalIdx][1]);
-			target->Normal = n2.getInterpolated(n1, div);
-			++target;
-			++first;
-			++second;
+			const core::vector3df pos(f32(v->Pos.X) * transform.scale.X + transform.translate.X,
+					f32(v->Pos.Y) * transform.scale.Y + transform.translate.Y,
+					f32(v->Pos.Z) * transform.scale.Z + transform.translate.Z);
+			const core::vector3df normal(
+					Q2_VERTEX_NORMAL_TABLE[v->NormalIdx][0],
+					Q2_VERTEX_NORMAL_TABLE[v->NormalIdx][2],
+					Q2_VERTEX_NORMAL_TABLE[v->NormalIdx][1]);
+			Frames.setVertex(f, i, pos, normal);
 		}
+	}
 
-		//update bounding box
-		InterpolationBuffer->setBoundingBox(BoxList[secondFrame].getInterpolated(BoxList[firstFrame], div));
-		InterpolationBuffer->setDirty();
+	PoseCache.clear();
+}
+
+
+//! returns the buffer for a slot of the pose cache, creates it if necessary
+SMeshBuffer* CAnimatedMeshMD2::getPoseBuffer(u32 slot)
+{
+	while (PoseBuffers.size() <= slot)
+	{
+		// static data is taken from the buffer filled by the loader
+		const SMeshBuffer* source = PoseBuffers[0];
+		SMeshBuffer* buffer = new SMeshBuffer();
+		buffer->Vertices = source->Vertices;
+		buffer->Indices = source->Indices;
+		buffer->Material = source->Material;
+		buffer->BoundingBox = source->BoundingBox;
+		buffer->setHardwareMappingHint(source->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+		buffer->setHardwareMappingHint(source->getHardwareMappingHint_Index(), EBT_INDEX);
+		PoseBuffers.push_back(buffer);
 	}
+	return PoseBuffers[slot];
 }
 
 
 //! sets a flag of all contained materials to a new value
 void CAnimatedMeshMD2::setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue)
 {
-	InterpolationBuffer->Material.setFlag(flag, newvalue);
+	for (u32 i=0; i<PoseBuffers.size(); ++i)
+		PoseBuffers[i]->Material.setFlag(flag, newvalue);
 }
 
 
@@ -374,14 +414,16 @@ void CAnimatedMeshMD2::setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalu
 void CAnimatedMeshMD2::setHardwareMappingHint(E_HARDWARE_MAPPING newMappingHint,
 		E_BUFFER_TYPE buffer)
 {
-	InterpolationBuffer->setHardwareMappingHint(newMappingHint, buffer);
+	for (u32 i=0; i<PoseBuffers.size(); ++i)
+		PoseBuffers[i]->setHardwareMappingHint(newMappingHint, buffer);
 }
 
 
 //! flags the meshbuffer as changed, reloads hardware buffers
 void CAnimatedMeshMD2::setDirty(E_BUFFER_TYPE buffer)
 {
-	InterpolationBuffer->setDirty(buffer);
+	for (u32 i=0; i<PoseBuffers.size(); ++i)
+		PoseBuffers[i]->setDirty(buffer);
 }
 
 
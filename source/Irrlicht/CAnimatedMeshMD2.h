@@ -8,6 +8,7 @@
 #include "IAnimatedMeshMD2.h"
 #include "IMesh.h"
 #include "CMeshBuffer.h"
+#include "CMorphTargetFrames.h"
 #include "IReadFile.h"
 #include "S3DVertex.h"
 #include "irrArray.h"
@@ -100,6 +101,8 @@ namespace scene
 		//
 
 		//! the buffer that contains the most recent animation
+		/** The loader fills texture coordinates, colors and indices, which
+		are copied to further pose buffers on first use. */
 		SMeshBuffer* InterpolationBuffer;
 
 		//! Frames used to calculate InterpolationBuffer
@@ -148,7 +151,22 @@ namespace scene
 		//! updates the interpolation buffer
 		void updateInterpolationBuffer(s32 frame, s32 startFrame, s32 endFrame);
 
+		//! decodes FrameList into Frames
+		void decodeFrames();
+
+		//! returns the buffer for a slot of the pose cache, creates it if necessary
+		SMeshBuffer* getPoseBuffer(u32 slot);
+
 		f32 FramesPerSecond;
+
+		//! keyframes with decompressed positions and normals
+		CMorphTargetFrames Frames;
+
+		//! recently used poses, shared by all scene nodes using this mesh
+		CMorphPoseCache PoseCache;
+
+		//! vertex data for each slot of PoseCache, InterpolationBuffer points to one of them
+		core::array<SMeshBuffer*> PoseBuffers;
 	};
 
 } // end namespace scene
@@ -57,6 +57,7 @@ CAnimatedMeshMD3::CAnimatedMeshMD3()
 
 	Mesh = new SMD3Mesh();
 	MeshIPol = new SMesh();
+	PoseMeshes.push_back(MeshIPol);
 	setInterpolationShift(0, 0);
 }
 
@@ -66,8 +67,8 @@ CAnimatedMeshMD3::~CAnimatedMeshMD3()
 {
 	if (Mesh)
 		Mesh->drop();
-	if (MeshIPol)
-		MeshIPol->drop();
+	for (u32 i=0; i<PoseMeshes.size(); ++i)
+		PoseMeshes[i]->drop();
 }
 
 
@@ -109,7 +110,8 @@ IMeshBuffer* CAnimatedMeshMD3::getMeshBuffer(const video::SMaterial &material) c
 
 void CAnimatedMeshMD3::setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue)
 {
-	MeshIPol->setMaterialFlag(flag, newvalue);
+	for (u32 i=0; i<PoseMeshes.size(); ++i)
+		PoseMeshes[i]->setMaterialFlag(flag, newvalue);
 }
 
 
@@ -117,14 +119,16 @@ void CAnimatedMeshMD3::setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalu
 void CAnimatedMeshMD3::setHardwareMappingHint(E_HARDWARE_MAPPING newMappingHint,
 		E_BUFFER_TYPE buffer)
 {
-	MeshIPol->setHardwareMappingHint(newMappingHint, buffer);
+	for (u32 i=0; i<PoseMeshes.size(); ++i)
+		PoseMeshes[i]->setHardwareMappingHint(newMappingHint, buffer);
 }
 
 
 //! flags the meshbuffer as changed, reloads hardware buffers
 void CAnimatedMeshMD3::setDirty(E_BUFFER_TYPE buffer)
 {
-	MeshIPol->setDirty(buffer);
+	for (u32 i=0; i<PoseMeshes.size(); ++i)
+		PoseMeshes[i]->setDirty(buffer);
 }
 
 
@@ -192,14 +196,27 @@ IMesh* CAnimatedMeshMD3::getMesh(s32 frame, s32 detailLevel, s32 startFrameLoop,
 		frameB = core::s32_min(frameA + 1, endFrameLoop);
 	}
 
+	// several nodes showing the same pose in one frame only interpolate once
+	bool cached;
+	SMesh* pose = getPoseMesh(PoseCache.getSlot(frameA, frameB, iPol, cached));
+	if (pose != MeshIPol)
+	{
+		for (u32 i = 0; i != pose->getMeshBufferCount(); ++i)
+			pose->getMeshBuffer(i)->getMaterial() = MeshIPol->getMeshBuffer(i)->getMaterial();
+		MeshIPol = pose;
+	}
+
 	// build current vertex
-	for (u32 i = 0; i!= Mesh->Buffer.size(); ++i)
+	if (!cached)
 	{
-		buildVertexArray(frameA, frameB, iPol,
-					Mesh->Buffer[i],
-					(SMeshBufferLightMap*) MeshIPol->getMeshBuffer(i));
+		for (u32 i = 0; i != Frames.size(); ++i)
+		{
+			buildVertexArray(frameA, frameB, iPol,
+						Frames[i],
+						(SMeshBufferLightMap*) MeshIPol->getMeshBuffer(i));
+		}
+		MeshIPol->recalculateBoundingBox();
 	}
-	MeshIPol->recalculateBoundingBox();
 
 	// build current tags
 	buildTagArray(frameA, frameB, iPol);
@@ -250,37 +267,70 @@ IMeshBuffer * CAnimatedMeshMD3::createMeshBuffer(const SMD3MeshBuffer* source,
 }
 
 
-//! build final mesh's vertices from frames frameA and frameB with linear interpolation.
-void CAnimatedMeshMD3::buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
-					const SMD3MeshBuffer* source,
-					SMeshBufferLightMap* dest)
+//! decompress the keyframes of a MD3 MeshBuffer
+void CAnimatedMeshMD3::decodeFrames(const SMD3MeshBuffer* source, CMorphTargetFrames& dest) const
 {
-	const u32 frameOffsetA = frameA * source->MeshHeader.numVertices;
-	const u32 frameOffsetB = frameB * source->MeshHeader.numVertices;
+	const u32 vertexCount = source->MeshHeader.numVertices;
+	const u32 frameCount = Mesh->MD3Header.numFrames;
 	const f32 scale = (1.f/ 64.f);
 
-	for (s32 i = 0; i != source->MeshHeader.numVertices; ++i)
+	dest.setup(frameCount, vertexCount);
+
+	for (u32 f = 0; f != frameCount; ++f)
 	{
-		video::S3DVertex2TCoords &v = dest->Vertices [ i ];
+		const SMD3Vertex* v = &source->Vertices[f * vertexCount];
+		for (u32 i = 0; i != vertexCount; ++i, ++v)
+		{
+			const core::vector3df n(quake3::getMD3Normal(v->normal[0], v->normal[1]));
+			dest.setVertex(f, i,
+				core::vector3df(scale * v->position[0], scale * v->position[2], scale * v->position[1]),
+				core::vector3df(n.X, n.Z, n.Y));
+		}
+	}
+}
 
-		const SMD3Vertex &vA = source->Vertices [ frameOffsetA + i ];
-		const SMD3Vertex &vB = source->Vertices [ frameOffsetB + i ];
 
-		// position
-		v.Pos.X = scale * (vA.position[0] + interpolate * (vB.position[0] - vA.position[0]));
-		v.Pos.Y = scale * (vA.position[2] + interpolate * (vB.position[2] - vA.position[2]));
-		v.Pos.Z = scale * (vA.position[1] + interpolate * (vB.position[1] - vA.position[1]));
+//! returns the mesh for a slot of the pose cache, creates it if necessary
+SMesh* CAnimatedMeshMD3::getPoseMesh(u32 slot)
+{
+	while (PoseMeshes.size() <= slot)
+	{
+		// static data is taken from the mesh built at load time
+		const SMesh* source = PoseMeshes[0];
+		SMesh* pose = new SMesh();
+		for (u32 i = 0; i != source->getMeshBufferCount(); ++i)
+		{
+			const SMeshBufferLightMap* sb = (const SMeshBufferLightMap*) source->getMeshBuffer(i);
+			SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
+			buffer->Vertices = sb->Vertices;
+			buffer->Indices = sb->Indices;
+			buffer->Material = sb->Material;
+			buffer->BoundingBox = sb->BoundingBox;
+			buffer->setHardwareMappingHint(sb->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+			buffer->setHardwareMappingHint(sb->getHardwareMappingHint_Index(), EBT_INDEX);
+			pose->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+		pose->BoundingBox = source->BoundingBox;
+		PoseMeshes.push_back(pose);
+	}
+	return PoseMeshes[slot];
+}
 
-		// normal
-		const core::vector3df nA(quake3::getMD3Normal(vA.normal[0], vA.normal[1]));
-		const core::vector3df nB(quake3::getMD3Normal(vB.normal[0], vB.normal[1]));
 
-		v.Normal.X = nA.X + interpolate * (nB.X - nA.X);
-		v.Normal.Y = nA.Z + interpolate * (nB.Z - nA.Z);
-		v.Normal.Z = nA.Y + interpolate * (nB.Y - nA.Y);
-	}
+//! build final mesh's vertices from frames frameA and frameB with linear interpolation.
+void CAnimatedMeshMD3::buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
+					const CMorphTargetFrames& source,
+					SMeshBufferLightMap* dest)
+{
+	if (dest->Vertices.size() < source.getVertexCount())
+		return;
+
+	source.interpolate(frameA, frameB, interpolate,
+			dest->Vertices.pointer(), sizeof(video::S3DVertex2TCoords));
 
 	dest->recalculateBoundingBox();
+	dest->setDirty(EBT_VERTEX);
 }
 
 
@@ -424,13 +474,17 @@ bool CAnimatedMeshMD3::loadModelFile(u32 modelIndex, io::IReadFile* file,
 	}
 
 	// Init Mesh Interpolation
+	Frames.set_used(Mesh->Buffer.size());
 	for (i = 0; i != Mesh->Buffer.size(); ++i)
 	{
 		IMeshBuffer * buffer = createMeshBuffer(Mesh->Buffer[i], fs, driver);
 		MeshIPol->addMeshBuffer(buffer);
 		buffer->drop();
+
+		decodeFrames(Mesh->Buffer[i], Frames[i]);
 	}
 	MeshIPol->recalculateBoundingBox();
+	PoseCache.clear();
 
 	// Init Tag Interpolation
 	for (i = 0; i != (u32)Mesh->MD3Header.numTags; ++i)
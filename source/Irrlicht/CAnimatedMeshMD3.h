@@ -13,6 +13,7 @@
 #include "SMesh.h"
 #include "SMeshBuffer.h"
 #include "IQ3Shader.h"
+#include "CMorphTargetFrames.h"
 
 namespace irr
 {
@@ -116,11 +117,24 @@ namespace scene
 		SMesh* MeshIPol;
 		SMD3QuaternionTagList TagListIPol;
 
+		//! keyframes of each mesh buffer with decompressed positions and normals
+		core::array<CMorphTargetFrames> Frames;
+
+		//! recently used poses, shared by all scene nodes using this mesh
+		CMorphPoseCache PoseCache;
+
+		//! interpolated mesh for each slot of PoseCache, MeshIPol points to one of them
+		core::array<SMesh*> PoseMeshes;
+
 		IMeshBuffer* createMeshBuffer(const SMD3MeshBuffer* source,
 				io::IFileSystem* fs, video::IVideoDriver* driver);
 
+		void decodeFrames(const SMD3MeshBuffer* source, CMorphTargetFrames& dest) const;
+
+		SMesh* getPoseMesh(u32 slot);
+
 		void buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
-					const SMD3MeshBuffer* source,
+					const CMorphTargetFrames& source,
 					SMeshBufferLightMap* dest);
 
 		void buildTagArray(u32 frameA, u32 frameB, f32 interpolate);
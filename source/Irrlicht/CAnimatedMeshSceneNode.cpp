@@ -187,7 +187,12 @@ void CAnimatedMeshSceneNode::OnRegisterSceneNode()
 
 IMesh * CAnimatedMeshSceneNode::getMeshForCurrentFrame()
 {
-	if(Mesh->getMeshType() != EAMT_SKINNED)
+	if(Mesh->getMeshType() == EAMT_LOD)
+	{
+		// the detail level is no frame blend here, always use full detail
+		return Mesh->getMesh(0);
+	}
+	else if(Mesh->getMeshType() != EAMT_SKINNED)
 	{
 		s32 frameNr = (s32) getFrameNr();
 		s32 frameBlend = (s32) (core::fract ( getFrameNr() ) * 1000.f);
@@ -0,0 +1,108 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CBillboardBatch.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Quads drawn with one call, so 16 bit indices can address all their vertices
+static const u32 MaxBatchQuads = 16384;
+
+
+//! constructor
+CBillboardBatch::CBillboardBatch()
+	: Driver(0)
+{
+}
+
+
+//! Start collecting the billboards of a render pass
+void CBillboardBatch::begin(video::IVideoDriver* driver, const ICameraSceneNode* camera)
+{
+	if (!driver || !camera)
+		return;
+
+	Driver = driver;
+	calculateCameraAxes(camera, Horizontal, Vertical, View);
+}
+
+
+//! Draw the remaining quads and stop collecting billboards
+void CBillboardBatch::end()
+{
+	flush();
+	Driver = 0;
+}
+
+
+//! Draw the quads collected so far
+void CBillboardBatch::flush()
+{
+	if (Vertices.empty())
+		return;
+
+	const u32 quadCount = Vertices.size() / 4;
+	for (u32 i=Indices.size()/6; i<quadCount; ++i)
+	{
+		const u16 v = (u16)(i*4);
+		Indices.push_back(v);
+		Indices.push_back(v+2);
+		Indices.push_back(v+1);
+		Indices.push_back(v);
+		Indices.push_back(v+3);
+		Indices.push_back(v+2);
+	}
+
+	Driver->setTransform(video::ETS_WORLD, core::IdentityMatrix);
+	Driver->setMaterial(Material);
+	Driver->drawIndexedTriangleList(Vertices.const_pointer(), Vertices.size(),
+		Indices.const_pointer(), quadCount*2);
+
+	Vertices.set_used(0);
+}
+
+
+//! Add the quad of a billboard
+void CBillboardBatch::addQuad(const video::SMaterial& material, const video::S3DVertex* vertices)
+{
+	if (!Vertices.empty() && (Vertices.size() == MaxBatchQuads*4 || material != Material))
+		flush();
+	if (Vertices.empty())
+		Material = material;
+
+	for (u32 i=0; i<4; ++i)
+		Vertices.push_back(vertices[i]);
+}
+
+
+//! Calculate the axes of billboards facing a camera
+void CBillboardBatch::calculateCameraAxes(const ICameraSceneNode* camera, core::vector3df& horizontal,
+	core::vector3df& vertical, core::vector3df& view)
+{
+	const core::vector3df& up = camera->getUpVector();
+	view = camera->getTarget() - camera->getAbsolutePosition();
+	view.normalize();
+
+	horizontal = up.crossProduct(view);
+	if ( horizontal.getLength() == 0 )
+	{
+		horizontal.set(up.Y,up.X,up.Z);
+	}
+	horizontal.normalize();
+
+	// pointing down!
+	vertical = horizontal.crossProduct(view);
+	vertical.normalize();
+
+	view *= -1.0f;
+}
+
+} // end namespace scene
+} // end namespace irr
+
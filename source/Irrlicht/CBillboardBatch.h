@@ -0,0 +1,90 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_BILLBOARD_BATCH_H_INCLUDED__
+#define __C_BILLBOARD_BATCH_H_INCLUDED__
+
+#include "S3DVertex.h"
+#include "SMaterial.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace video
+{
+	class IVideoDriver;
+}
+namespace scene
+{
+	class ICameraSceneNode;
+
+	//! Collects the quads of billboards into few draw calls.
+	/** Each scene manager activates its batch while it renders the solid and
+	transparent nodes, billboards find it with ISceneManager::getBillboardBatch. Billboards rendered then only add their quad, which is
+	drawn together with the quads of the following billboards with the same
+	material. The lists of the scene manager are already sorted, by texture
+	for solid nodes and by distance for transparent ones, so the order in
+	which billboards are drawn stays the same. */
+	class CBillboardBatch
+	{
+	public:
+
+		//! constructor
+		CBillboardBatch();
+
+		//! Start collecting the billboards of a render pass
+		/** Makes this batch active and calculates the camera axes shared by
+		all billboards. Does nothing without camera. */
+		void begin(video::IVideoDriver* driver, const ICameraSceneNode* camera);
+
+		//! Draw the remaining quads and stop collecting billboards
+		void end();
+
+		//! Draw the quads collected so far
+		/** Has to be called before anything else is drawn. */
+		void flush();
+
+		//! Add the quad of a billboard
+		/** Flushes first when the material differs from that of the quads
+		already collected. */
+		void addQuad(const video::SMaterial& material, const video::S3DVertex* vertices);
+
+		//! Axes of billboards facing the camera
+		/** \param horizontal Right vector of the billboard, normalized
+		\param vertical Down vector of the billboard, normalized
+		\param view Normal of the billboard, pointing to the camera */
+		void getCameraAxes(core::vector3df& horizontal, core::vector3df& vertical,
+			core::vector3df& view) const
+		{
+			horizontal = Horizontal;
+			vertical = Vertical;
+			view = View;
+		}
+
+		//! Calculate the axes of billboards facing a camera
+		static void calculateCameraAxes(const ICameraSceneNode* camera, core::vector3df& horizontal,
+			core::vector3df& vertical, core::vector3df& view);
+
+		//! Whether billboards shall add their quads, between begin() and end()
+		bool isActive() const
+		{
+			return Driver != 0;
+		}
+
+	private:
+
+		video::IVideoDriver* Driver;
+		video::SMaterial Material;
+		core::array<video::S3DVertex> Vertices;
+		core::array<u16> Indices;
+		core::vector3df Horizontal;
+		core::vector3df Vertical;
+		core::vector3df View;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -6,6 +6,7 @@
 #include "IVideoDriver.h"
 #include "ISceneManager.h"
 #include "ICameraSceneNode.h"
+#include "CBillboardBatch.h"
 #include "os.h"
 
 namespace irr
@@ -65,32 +66,25 @@ void CBillboardSceneNode::render()
 	if (!camera || !driver)
 		return;
 
-	// make billboard look to camera
+	// make billboard look to camera, a batch has the axes of the camera already
+	CBillboardBatch* batch = SceneManager->getBillboardBatch();
+	if (batch && !batch->isActive())
+		batch = 0;
 
 	core::vector3df pos = getAbsolutePosition();
 
-	core::vector3df campos = camera->getAbsolutePosition();
-	core::vector3df target = camera->getTarget();
-	core::vector3df up = camera->getUpVector();
-	core::vector3df view = target - campos;
-	view.normalize();
+	core::vector3df horizontal;
+	core::vector3df vertical;
+	core::vector3df view;
+	if (batch)
+		batch->getCameraAxes(horizontal, vertical, view);
+	else
+		CBillboardBatch::calculateCameraAxes(camera, horizontal, vertical, view);
 
-	core::vector3df horizontal = up.crossProduct(view);
-	if ( horizontal.getLength() == 0 )
-	{
-		horizontal.set(up.Y,up.X,up.Z);
-	}
-	horizontal.normalize();
 	core::vector3df topHorizontal = horizontal * 0.5f * TopEdgeWidth;
 	horizontal *= 0.5f * Size.Width;
-
-	// pointing down!
-	core::vector3df vertical = horizontal.crossProduct(view);
-	vertical.normalize();
 	vertical *= 0.5f * Size.Height;
 
-	view *= -1.0f;
-
 	for (s32 i=0; i<4; ++i)
 		vertices[i].Normal = view;
 
@@ -107,6 +101,16 @@ void CBillboardSceneNode::render()
 
 	// draw
 
+	if (batch)
+	{
+		if (!(DebugDataVisible & scene::EDS_BBOX))
+		{
+			batch->addQuad(Material, vertices);
+			return;
+		}
+		batch->flush();
+	}
+
 	if (DebugDataVisible & scene::EDS_BBOX)
 	{
 		driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
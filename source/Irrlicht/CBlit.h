@@ -6,6 +6,12 @@
 #define _C_BLIT_H_INCLUDED_
 
 #include "SoftwareDriver2_helper.h"
+#include "CWorkerPool.h"
+#include "CColorConverter.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
 
 namespace irr
 {
@@ -33,7 +39,11 @@ namespace irr
 		float x_stretch;
 		float y_stretch;
 
-		SBlitJob() : stretch(false) {}
+		//! row of the whole blit this job starts at, to find the source rows of a stretched blit
+		u32 firstRow;
+
+		SBlitJob() : argb(0), src(0), dst(0), width(0), height(0), srcPitch(0), dstPitch(0),
+			srcPixelMul(0), dstPixelMul(0), stretch(false), x_stretch(1.f), y_stretch(1.f), firstRow(0) {}
 	};
 
 	// Bitfields Cohen Sutherland
@@ -463,6 +473,157 @@ static void RenderLine16_Blend(video::IImage *t,
 }
 
 
+#ifdef _IRR_COMPILE_WITH_SSE2_
+/*!
+	Pixel = ( dest * ( 256 - alpha ) + source * alpha ) >> 8
+	for 2 pixels with 16 bit per channel, alpha [0;256] per channel.
+	Same result as PixelBlend32 for the color channels.
+*/
+static inline __m128i PixelLerp16x8_SSE2 ( const __m128i dest, const __m128i source, const __m128i alpha )
+{
+	const __m128i invAlpha = _mm_sub_epi16( _mm_set1_epi16( 256 ), alpha );
+	return _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( dest, invAlpha ),
+						_mm_mullo_epi16( source, alpha ) ), 8 );
+}
+
+/*!
+	Alpha of 2 pixels with 16 bit per channel in all their channels
+	add highbit alpha ( alpha > 127 ? + 1 )
+*/
+static inline __m128i extractAlpha16x8_SSE2 ( const __m128i c )
+{
+	const __m128i alpha = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c, _MM_SHUFFLE(3,3,3,3) ), _MM_SHUFFLE(3,3,3,3) );
+	return _mm_add_epi16( alpha, _mm_srli_epi16( alpha, 7 ) );
+}
+
+/*!
+	PixelBlend32 ( dest, source ) for 4 pixels
+*/
+static inline __m128i PixelBlend32x4_SSE2 ( const __m128i dest, const __m128i source )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+
+	const __m128i srcLo = _mm_unpacklo_epi8( source, zero );
+	const __m128i srcHi = _mm_unpackhi_epi8( source, zero );
+	const __m128i lo = PixelLerp16x8_SSE2( _mm_unpacklo_epi8( dest, zero ), srcLo, extractAlpha16x8_SSE2( srcLo ) );
+	const __m128i hi = PixelLerp16x8_SSE2( _mm_unpackhi_epi8( dest, zero ), srcHi, extractAlpha16x8_SSE2( srcHi ) );
+
+	// alpha of the source, transparent source pixels keep the dest pixel
+	const __m128i srcAlpha = _mm_and_si128( source, alphaMask );
+	const __m128i keep = _mm_and_si128( _mm_cmpeq_epi32( srcAlpha, zero ), _mm_and_si128( dest, alphaMask ) );
+
+	return _mm_or_si128( _mm_andnot_si128( alphaMask, _mm_packus_epi16( lo, hi ) ),
+						_mm_or_si128( srcAlpha, keep ) );
+}
+
+/*!
+	PixelMul32_2 ( source, color ) for 4 pixels, color unpacked to 16 bit per channel
+*/
+static inline __m128i PixelMul32x4_SSE2 ( const __m128i source, const __m128i color16 )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( source, zero ), color16 ), 8 );
+	const __m128i hi = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( source, zero ), color16 ), 8 );
+	return _mm_packus_epi16( lo, hi );
+}
+#endif
+
+/*!
+	dest = PixelBlend32 ( dest, source ) for a row of pixels
+*/
+static void blendRow32( u32 * dst, const u32 * src, const u32 count )
+{
+	u32 i = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		const __m128i s = _mm_loadu_si128( (const __m128i*) (src + i) );
+		const __m128i srcAlpha = _mm_and_si128( s, alphaMask );
+
+		// fully transparent or opaque blocks are common in gui images
+		if ( 0xFFFF == _mm_movemask_epi8( _mm_cmpeq_epi32( srcAlpha, zero ) ) )
+			continue;
+		if ( 0xFFFF == _mm_movemask_epi8( _mm_cmpeq_epi32( srcAlpha, alphaMask ) ) )
+		{
+			_mm_storeu_si128( (__m128i*) (dst + i), s );
+			continue;
+		}
+
+		const __m128i d = _mm_loadu_si128( (const __m128i*) (dst + i) );
+		_mm_storeu_si128( (__m128i*) (dst + i), PixelBlend32x4_SSE2( d, s ) );
+	}
+#endif
+	for ( ; i != count; ++i )
+		dst[i] = PixelBlend32( dst[i], src[i] );
+}
+
+/*!
+	dest = PixelBlend32 ( dest, PixelMul32_2 ( source, color ) ) for a row of pixels
+*/
+static void blendColorRow32( u32 * dst, const u32 * src, const u32 count, const u32 color )
+{
+	u32 i = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i color16 = _mm_unpacklo_epi8( _mm_set1_epi32( color ), _mm_setzero_si128() );
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		const __m128i s = PixelMul32x4_SSE2( _mm_loadu_si128( (const __m128i*) (src + i) ), color16 );
+		const __m128i d = _mm_loadu_si128( (const __m128i*) (dst + i) );
+		_mm_storeu_si128( (__m128i*) (dst + i), PixelBlend32x4_SSE2( d, s ) );
+	}
+#endif
+	for ( ; i != count; ++i )
+		dst[i] = PixelBlend32( dst[i], PixelMul32_2( src[i], color ) );
+}
+
+/*!
+	dest = color blended over dest with the alpha of color, for a row of pixels
+*/
+static void blendColorAlphaRow32( u32 * dst, const u32 count, const u32 color )
+{
+	const u32 alpha = extractAlpha( color );
+	u32 i = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32( 0xFF000000 );
+	const __m128i color16 = _mm_unpacklo_epi8( _mm_set1_epi32( color ), zero );
+	const __m128i alpha16 = _mm_set1_epi16( (s16) alpha );
+	const __m128i colorAlpha = _mm_set1_epi32( color & 0xFF000000 );
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		const __m128i d = _mm_loadu_si128( (const __m128i*) (dst + i) );
+		const __m128i lo = PixelLerp16x8_SSE2( _mm_unpacklo_epi8( d, zero ), color16, alpha16 );
+		const __m128i hi = PixelLerp16x8_SSE2( _mm_unpackhi_epi8( d, zero ), color16, alpha16 );
+		_mm_storeu_si128( (__m128i*) (dst + i),
+			_mm_or_si128( _mm_andnot_si128( alphaMask, _mm_packus_epi16( lo, hi ) ), colorAlpha ) );
+	}
+#endif
+	for ( ; i != count; ++i )
+		dst[i] = ( color & 0xFF000000 ) | PixelBlend32( dst[i], color, alpha );
+}
+
+/*!
+	dest = color for a row of pixels
+*/
+static void fillRow32( u32 * dst, const u32 count, const u32 color )
+{
+	u32 i = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i c = _mm_set1_epi32( color );
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		_mm_storeu_si128( (__m128i*) (dst + i), c );
+		_mm_storeu_si128( (__m128i*) (dst + i + 4), c );
+	}
+#endif
+	for ( ; i != count; ++i )
+		dst[i] = color;
+}
+
+
 /*!
 */
 static void executeBlit_TextureCopy_x_to_x( const SBlitJob * job )
@@ -478,7 +639,7 @@ static void executeBlit_TextureCopy_x_to_x( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u32*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -521,7 +682,7 @@ static void executeBlit_TextureCopy_32_to_16( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u32*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -567,7 +728,7 @@ static void executeBlit_TextureCopy_24_to_16( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u8*)(job->src) + job->srcPitch*src_y;
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -612,7 +773,7 @@ static void executeBlit_TextureCopy_16_to_32( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u16*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -627,10 +788,7 @@ static void executeBlit_TextureCopy_16_to_32( const SBlitJob * job )
 	{
 		for ( u32 dy = 0; dy != h; ++dy )
 		{
-			for ( u32 dx = 0; dx != w; ++dx )
-			{
-				dst[dx] = video::A1R5G5B5toA8R8G8B8( src[dx] );
-			}
+			video::CColorConverter::convert_A1R5G5B5toA8R8G8B8( src, w, dst );
 
 			src = (u16*) ( (u8*) (src) + job->srcPitch );
 			dst = (u32*) ( (u8*) (dst) + job->dstPitch );
@@ -652,7 +810,7 @@ static void executeBlit_TextureCopy_16_to_24( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u16*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -702,7 +860,7 @@ static void executeBlit_TextureCopy_24_to_32( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (const u8*)job->src+(job->srcPitch*src_y);
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -715,15 +873,9 @@ static void executeBlit_TextureCopy_24_to_32( const SBlitJob * job )
 	}
 	else
 	{
-		for ( s32 dy = 0; dy != job->height; ++dy )
+		for ( u32 dy = 0; dy != h; ++dy )
 		{
-			const u8* s = src;
-
-			for ( s32 dx = 0; dx != job->width; ++dx )
-			{
-				dst[dx] = 0xFF000000 | s[0] << 16 | s[1] << 8 | s[2];
-				s += 3;
-			}
+			video::CColorConverter::convert_R8G8B8toA8R8G8B8( src, w, dst );
 
 			src = src + job->srcPitch;
 			dst = (u32*) ( (u8*) (dst) + job->dstPitch );
@@ -745,7 +897,7 @@ static void executeBlit_TextureCopy_32_to_24( const SBlitJob * job )
 
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u32*) ( (u8*) (job->src) + job->srcPitch*src_y);
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -763,13 +915,7 @@ static void executeBlit_TextureCopy_32_to_24( const SBlitJob * job )
 	{
 		for ( u32 dy = 0; dy != h; ++dy )
 		{
-			for ( u32 dx = 0; dx != w; ++dx )
-			{
-				u8 * writeTo = &dst[dx * 3];
-				*writeTo++ = (src[dx] >> 16)& 0xFF;
-				*writeTo++ = (src[dx] >> 8) & 0xFF;
-				*writeTo++ = src[dx] & 0xFF;
-			}
+			video::CColorConverter::convert_A8R8G8B8toR8G8B8( src, w, dst );
 
 			src = (u32*) ( (u8*) (src) + job->srcPitch );
 			dst += job->dstPitch;
@@ -795,7 +941,7 @@ static void executeBlit_TextureBlend_16_to_16( const SBlitJob * job )
 		const u32 off = core::if_c_a_else_b(w&1, (u32)((w-1)*wscale), 0);
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u32*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < rdx; ++dx )
@@ -847,7 +993,7 @@ static void executeBlit_TextureBlend_32_to_32( const SBlitJob * job )
 		const float hscale = 1.f/job->y_stretch;
 		for ( u32 dy = 0; dy < h; ++dy )
 		{
-			const u32 src_y = (u32)(dy*hscale);
+			const u32 src_y = (u32)((dy+job->firstRow)*hscale);
 			src = (u32*) ( (u8*) (job->src) + job->srcPitch*src_y );
 
 			for ( u32 dx = 0; dx < w; ++dx )
@@ -863,10 +1009,7 @@ static void executeBlit_TextureBlend_32_to_32( const SBlitJob * job )
 	{
 		for ( u32 dy = 0; dy != h; ++dy )
 		{
-			for ( u32 dx = 0; dx != w; ++dx )
-			{
-				dst[dx] = PixelBlend32( dst[dx], src[dx] );
-			}
+			blendRow32( dst, src, w );
 			src = (u32*) ( (u8*) (src) + job->srcPitch );
 			dst = (u32*) ( (u8*) (dst) + job->dstPitch );
 		}
@@ -905,10 +1048,7 @@ static void executeBlit_TextureBlendColor_32_to_32( const SBlitJob * job )
 
 	for ( s32 dy = 0; dy != job->height; ++dy )
 	{
-		for ( s32 dx = 0; dx != job->width; ++dx )
-		{
-			dst[dx] = PixelBlend32( dst[dx], PixelMul32_2( src[dx], job->argb ) );
-		}
+		blendColorRow32( dst, src, job->width, job->argb );
 		src = (u32*) ( (u8*) (src) + job->srcPitch );
 		dst = (u32*) ( (u8*) (dst) + job->dstPitch );
 	}
@@ -936,7 +1076,7 @@ static void executeBlit_Color_32_to_32( const SBlitJob * job )
 
 	for ( s32 dy = 0; dy != job->height; ++dy )
 	{
-		memset32( dst, job->argb, job->srcPitch );
+		fillRow32( dst, job->width, job->argb );
 		dst = (u32*) ( (u8*) (dst) + job->dstPitch );
 	}
 }
@@ -968,15 +1108,9 @@ static void executeBlit_ColorAlpha_32_to_32( const SBlitJob * job )
 {
 	u32 *dst = (u32*) job->dst;
 
-	const u32 alpha = extractAlpha( job->argb );
-	const u32 src = job->argb;
-
 	for ( s32 dy = 0; dy != job->height; ++dy )
 	{
-		for ( s32 dx = 0; dx != job->width; ++dx )
-		{
-			dst[dx] = (job->argb & 0xFF000000 ) | PixelBlend32( dst[dx], src, alpha );
-		}
+		blendColorAlphaRow32( dst, job->width, job->argb );
 		dst = (u32*) ( (u8*) (dst) + job->dstPitch );
 	}
 }
@@ -1050,6 +1184,43 @@ static inline tExecuteBlit getBlitter2( eBlitter operation,const video::IImage *
 }
 
 
+//! Pixels per range when large blits are spread over the worker threads
+const u32 BlitGrainPixels = 16384;
+
+//! Runs a blit job on bands of its rows
+struct SBlitRowsJob
+{
+	SBlitRowsJob(tExecuteBlit blitter, const SBlitJob& job) : Blitter(blitter), Job(job) {}
+
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		SBlitJob band = Job;
+		band.height = end - begin;
+		band.firstRow = Job.firstRow + begin;
+		// stretched blits find their source rows with firstRow
+		if ( Job.src && !Job.stretch )
+			band.src = (void*) ( (u8*) Job.src + begin * Job.srcPitch );
+		band.dst = (void*) ( (u8*) Job.dst + begin * Job.dstPitch );
+		Blitter( &band );
+	}
+
+	tExecuteBlit Blitter;
+	const SBlitJob& Job;
+};
+
+/*!
+	Runs a blit job, large ones are split into bands of rows for the worker threads
+*/
+static void executeBlit( tExecuteBlit blitter, const SBlitJob& job )
+{
+	if ( job.width <= 0 || job.height <= 0 )
+		return;
+
+	SBlitRowsJob rows( blitter, job );
+	CWorkerPool::getInstance().parallelFor( job.height, core::max_( BlitGrainPixels / job.width, 1u ), rows );
+}
+
+
 // bounce clipping to texture
 inline void setClip ( AbsRectangle &out, const core::rect<s32> *clip,
 					const video::IImage * tex, s32 passnative )
@@ -1094,7 +1265,12 @@ static s32 Blit(eBlitter operation,
 		u32 argb)
 {
 	tExecuteBlit blitter = getBlitter2( operation, dest, source );
-	if ( 0 == blitter )
+
+	// copies between formats without a blitter go through the color converter
+	const bool convert = 0 == blitter && BLITTER_TEXTURE == operation && source && dest &&
+		video::CColorConverter::canConvert_viaFormat( source->getColorFormat(), dest->getColorFormat() );
+
+	if ( 0 == blitter && !convert )
 	{
 		return 0;
 	}
@@ -1143,7 +1319,15 @@ static s32 Blit(eBlitter operation,
 	job.dstPixelMul = dest->getBytesPerPixel();
 	job.dst = (void*) ( (u8*) dest->getData() + ( job.Dest.y0 * job.dstPitch ) + ( job.Dest.x0 * job.dstPixelMul ) );
 
-	blitter( &job );
+	if ( convert )
+	{
+		video::CColorConverter::convert_viaFormat( job.src, source->getColorFormat(), job.srcPitch,
+			job.dst, dest->getColorFormat(), job.dstPitch, job.width, job.height );
+	}
+	else
+	{
+		executeBlit( blitter, job );
+	}
 
 	return 1;
 }
@@ -1191,7 +1375,7 @@ static s32 StretchBlit(eBlitter operation,
 	job.dstPixelMul = dest->getBytesPerPixel();
 	job.dst = (void*) ( (u8*) dest->getData() + ( job.Dest.y0 * job.dstPitch ) + ( job.Dest.x0 * job.dstPixelMul ) );
 
-	blitter( &job );
+	executeBlit( blitter, job );
 
 	return 1;
 }
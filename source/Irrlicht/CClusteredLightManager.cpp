@@ -0,0 +1,409 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CClusteredLightManager.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "ILightSceneNode.h"
+#include "IVideoDriver.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! Squared distance of a point to a box, 0 inside of the box
+	f32 getDistanceSQ(const core::aabbox3df& box, const core::vector3df& p)
+	{
+		const f32 dx = core::max_(box.MinEdge.X - p.X, 0.f, p.X - box.MaxEdge.X);
+		const f32 dy = core::max_(box.MinEdge.Y - p.Y, 0.f, p.Y - box.MaxEdge.Y);
+		const f32 dz = core::max_(box.MinEdge.Z - p.Z, 0.f, p.Z - box.MaxEdge.Z);
+		return dx*dx + dy*dy + dz*dz;
+	}
+}
+
+
+//! constructor
+CClusteredLightManager::CClusteredLightManager(ISceneManager* sceneManager, const core::vector3d<u32>& clusterCount)
+	: SceneManager(sceneManager), LightList(0), CurrentRenderPass(ESNRP_NONE),
+	MaxNodeLights(0), Active(false), Near(1.f), Far(2.f), DepthScale(0.f), DepthBias(0.f), Stamp(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CClusteredLightManager");
+	#endif
+
+	setClusterCount(clusterCount);
+}
+
+
+void CClusteredLightManager::OnPreRender(core::array<ISceneNode*>& lightList)
+{
+	LightList = &lightList;
+	Active = false;
+}
+
+
+void CClusteredLightManager::OnPostRender()
+{
+	// leave the driver lights as the light nodes set them
+	if (Active)
+	{
+		NodeLights.set_used(0);
+		for (u32 i=0; i<Lights.size(); ++i)
+			NodeLights.push_back(i);
+		switchLights();
+	}
+	Active = false;
+	LightList = 0;
+}
+
+
+void CClusteredLightManager::OnRenderPassPreRender(E_SCENE_NODE_RENDER_PASS renderPass)
+{
+	CurrentRenderPass = renderPass;
+}
+
+
+void CClusteredLightManager::OnRenderPassPostRender(E_SCENE_NODE_RENDER_PASS renderPass)
+{
+	// the light nodes have just added their lights to the driver
+	if (renderPass == ESNRP_LIGHT)
+		buildClusters();
+}
+
+
+void CClusteredLightManager::OnNodePreRender(ISceneNode* node)
+{
+	if (!Active)
+		return;
+
+	++Stamp;
+	NodeLights.set_used(0);
+	Candidates.set_used(0);
+
+	// lights of the clusters overlapping the node, which touch its box
+	const core::aabbox3df box(node->getTransformedBoundingBox());
+	core::aabbox3df viewBox(box);
+	View.transformBoxEx(viewBox);
+	u32 minCluster[3];
+	u32 maxCluster[3];
+	if (getClusterRange(viewBox, minCluster, maxCluster))
+	{
+		for (u32 z=minCluster[2]; z<=maxCluster[2]; ++z)
+		{
+			for (u32 y=minCluster[1]; y<=maxCluster[1]; ++y)
+			{
+				for (u32 x=minCluster[0]; x<=maxCluster[0]; ++x)
+				{
+					const u32 cluster = x + (y + z*ClusterCount.Y)*ClusterCount.X;
+					const u32 first = ClusterOffsets[2*cluster];
+					const u32 last = first + ClusterOffsets[2*cluster+1];
+					for (u32 i=first; i<last; ++i)
+					{
+						const u32 light = ClusterLightIndices[i];
+						if (CandidateStamps[light] == Stamp)
+							continue;
+						CandidateStamps[light] = Stamp;
+
+						const f32 distance = getDistanceSQ(box, Lights[light].Position);
+						if (distance <= Lights[light].Radius * Lights[light].Radius)
+						{
+							SLightDistance candidate;
+							candidate.Distance = distance;
+							candidate.Light = light;
+							Candidates.push_back(candidate);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (u32 i=0; i<Lights.size(); ++i)
+	{
+		if (Lights[i].AlwaysOn)
+			NodeLights.push_back(i);
+	}
+
+	// the closest lights if there are too many
+	u32 maxLights = MaxNodeLights ? MaxNodeLights : SceneManager->getVideoDriver()->getMaximalDynamicLightAmount();
+	if (!maxLights)
+		maxLights = 0xffffffff;
+	if (NodeLights.size() + Candidates.size() > maxLights)
+		core::heapsort(Candidates.pointer(), Candidates.size());
+	for (u32 i=0; i<Candidates.size() && NodeLights.size()<maxLights; ++i)
+		NodeLights.push_back(Candidates[i].Light);
+
+	switchLights();
+}
+
+
+void CClusteredLightManager::OnNodePostRender(ISceneNode* node)
+{
+}
+
+
+//! Switch on the lights in NodeLights and off all others
+void CClusteredLightManager::switchLights()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	++Stamp;
+	for (u32 i=0; i<NodeLights.size(); ++i)
+		NodeStamps[NodeLights[i]] = Stamp;
+
+	for (u32 i=0; i<OnLights.size(); ++i)
+	{
+		if (NodeStamps[OnLights[i]] != Stamp)
+		{
+			driver->turnLightOn(OnLights[i], false);
+			LightIsOn[OnLights[i]] = false;
+		}
+	}
+
+	for (u32 i=0; i<NodeLights.size(); ++i)
+	{
+		if (!LightIsOn[NodeLights[i]])
+		{
+			driver->turnLightOn(NodeLights[i], true);
+			LightIsOn[NodeLights[i]] = true;
+		}
+	}
+
+	OnLights = NodeLights;
+}
+
+
+//! Sort the lights into the clusters of the active camera
+void CClusteredLightManager::buildClusters()
+{
+	Active = false;
+	const u32 clusterCount = ClusterCount.X * ClusterCount.Y * ClusterCount.Z;
+	ClusterOffsets.set_used(2 * clusterCount);
+	for (u32 i=0; i<ClusterOffsets.size(); ++i)
+		ClusterOffsets[i] = 0;
+	ClusterLightIndices.set_used(0);
+	Lights.set_used(0);
+
+	// light list indices have to match the driver lights
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	if (!LightList || !camera || driver->getDynamicLightCount() != LightList->size())
+		return;
+
+	View = camera->getViewMatrix();
+	Projection = camera->getProjectionMatrix();
+	Near = core::max_(camera->getNearValue(), 0.001f);
+	Far = core::max_(camera->getFarValue(), Near * 1.001f);
+	DepthScale = ClusterCount.Z / logf(Far / Near);
+	DepthBias = -logf(Near) * DepthScale;
+
+	const u32 lightCount = LightList->size();
+	Lights.set_used(lightCount);
+	CandidateStamps.set_used(lightCount);
+	NodeStamps.set_used(lightCount);
+	LightIsOn.set_used(lightCount);
+	core::array<u32> ranges(lightCount * 6);
+	ranges.set_used(lightCount * 6);
+
+	// count the lights of each cluster
+	for (u32 i=0; i<lightCount; ++i)
+	{
+		ISceneNode* node = (*LightList)[i];
+		SLightInfo& info = Lights[i];
+		info.AlwaysOn = true;
+		info.Radius = 0.f;
+		CandidateStamps[i] = 0;
+		NodeStamps[i] = 0;
+		LightIsOn[i] = true;
+		if (node->getType() != ESNT_LIGHT)
+			continue;
+
+		const video::SLight& light = static_cast<ILightSceneNode*>(node)->getLightData();
+		if (light.Type == video::ELT_DIRECTIONAL)
+			continue;
+		info.AlwaysOn = false;
+		info.Position = light.Position;
+		info.Radius = light.Radius;
+
+		core::vector3df center(light.Position);
+		View.transformVect(center);
+		const core::aabbox3df viewBox(center - core::vector3df(light.Radius), center + core::vector3df(light.Radius));
+		u32* range = &ranges[6*i];
+		if (!getClusterRange(viewBox, range, range+3))
+		{
+			range[0] = 1;
+			range[3] = 0;
+			continue;
+		}
+
+		for (u32 z=range[2]; z<=range[5]; ++z)
+			for (u32 y=range[1]; y<=range[4]; ++y)
+				for (u32 x=range[0]; x<=range[3]; ++x)
+					++ClusterOffsets[2*(x + (y + z*ClusterCount.Y)*ClusterCount.X) + 1];
+	}
+
+	u32 total = 0;
+	for (u32 i=0; i<clusterCount; ++i)
+	{
+		ClusterOffsets[2*i] = total;
+		total += ClusterOffsets[2*i+1];
+		ClusterOffsets[2*i+1] = 0;
+	}
+
+	// fill the light lists, in light list order
+	ClusterLightIndices.set_used(total);
+	for (u32 i=0; i<lightCount; ++i)
+	{
+		if (Lights[i].AlwaysOn)
+			continue;
+		const u32* range = &ranges[6*i];
+		for (u32 z=range[2]; z<=range[5]; ++z)
+			for (u32 y=range[1]; y<=range[4]; ++y)
+				for (u32 x=range[0]; x<=range[3]; ++x)
+				{
+					u32* offset = &ClusterOffsets[2*(x + (y + z*ClusterCount.Y)*ClusterCount.X)];
+					ClusterLightIndices[offset[0] + offset[1]++] = i;
+				}
+	}
+
+	// all lights are on after the light pass
+	OnLights.set_used(lightCount);
+	for (u32 i=0; i<lightCount; ++i)
+		OnLights[i] = i;
+	Active = true;
+}
+
+
+//! Get the clusters overlapping a box in view space
+bool CClusteredLightManager::getClusterRange(const core::aabbox3df& viewBox, u32* minCluster, u32* maxCluster) const
+{
+	const f32 z0 = core::max_(viewBox.MinEdge.Z, Near);
+	const f32 z1 = core::min_(viewBox.MaxEdge.Z, Far);
+	if (z0 > z1)
+		return false;
+
+	// the part of the box in front of the near plane projects into the
+	// rectangle around its projected corners
+	core::rectf screen(1.f, 1.f, -1.f, -1.f);
+	for (u32 i=0; i<8; ++i)
+	{
+		const core::vector3df corner((i & 1) ? viewBox.MaxEdge.X : viewBox.MinEdge.X,
+			(i & 2) ? viewBox.MaxEdge.Y : viewBox.MinEdge.Y, (i & 4) ? z1 : z0);
+		f32 clip[4];
+		Projection.transformVect(clip, corner);
+		const f32 w = clip[3] > 0.f ? 1.f / clip[3] : 1.f;
+		screen.UpperLeftCorner.X = core::min_(screen.UpperLeftCorner.X, clip[0] * w);
+		screen.UpperLeftCorner.Y = core::min_(screen.UpperLeftCorner.Y, clip[1] * w);
+		screen.LowerRightCorner.X = core::max_(screen.LowerRightCorner.X, clip[0] * w);
+		screen.LowerRightCorner.Y = core::max_(screen.LowerRightCorner.Y, clip[1] * w);
+	}
+	if (screen.UpperLeftCorner.X > 1.f || screen.LowerRightCorner.X < -1.f ||
+		screen.UpperLeftCorner.Y > 1.f || screen.LowerRightCorner.Y < -1.f)
+		return false;
+
+	// x from the left, y from the top of the screen
+	minCluster[0] = (u32)core::clamp((s32)floorf((screen.UpperLeftCorner.X + 1.f) * 0.5f * ClusterCount.X), 0, (s32)ClusterCount.X - 1);
+	maxCluster[0] = (u32)core::clamp((s32)floorf((screen.LowerRightCorner.X + 1.f) * 0.5f * ClusterCount.X), 0, (s32)ClusterCount.X - 1);
+	minCluster[1] = (u32)core::clamp((s32)floorf((1.f - screen.LowerRightCorner.Y) * 0.5f * ClusterCount.Y), 0, (s32)ClusterCount.Y - 1);
+	maxCluster[1] = (u32)core::clamp((s32)floorf((1.f - screen.UpperLeftCorner.Y) * 0.5f * ClusterCount.Y), 0, (s32)ClusterCount.Y - 1);
+	minCluster[2] = getDepthSlice(z0);
+	maxCluster[2] = getDepthSlice(z1);
+	return true;
+}
+
+
+//! Get the depth slice of a view space depth
+u32 CClusteredLightManager::getDepthSlice(f32 z) const
+{
+	return (u32)core::clamp((s32)floorf(logf(z) * DepthScale + DepthBias), 0, (s32)ClusterCount.Z - 1);
+}
+
+
+void CClusteredLightManager::setClusterCount(const core::vector3d<u32>& count)
+{
+	ClusterCount.set(core::max_(count.X, 1u), core::max_(count.Y, 1u), core::max_(count.Z, 1u));
+	Active = false;
+}
+
+
+const core::vector3d<u32>& CClusteredLightManager::getClusterCount() const
+{
+	return ClusterCount;
+}
+
+
+void CClusteredLightManager::setMaxNodeLights(u32 count)
+{
+	MaxNodeLights = count;
+}
+
+
+u32 CClusteredLightManager::getMaxNodeLights() const
+{
+	return MaxNodeLights;
+}
+
+
+s32 CClusteredLightManager::getClusterIndex(const core::vector3df& viewPos) const
+{
+	if (ClusterOffsets.empty() || viewPos.Z < Near || viewPos.Z > Far)
+		return -1;
+
+	f32 clip[4];
+	Projection.transformVect(clip, viewPos);
+	const f32 w = clip[3] > 0.f ? 1.f / clip[3] : 1.f;
+	const f32 x = clip[0] * w;
+	const f32 y = clip[1] * w;
+	if (x < -1.f || x > 1.f || y < -1.f || y > 1.f)
+		return -1;
+
+	const u32 cx = (u32)core::clamp((s32)floorf((x + 1.f) * 0.5f * ClusterCount.X), 0, (s32)ClusterCount.X - 1);
+	const u32 cy = (u32)core::clamp((s32)floorf((1.f - y) * 0.5f * ClusterCount.Y), 0, (s32)ClusterCount.Y - 1);
+	return cx + (cy + getDepthSlice(viewPos.Z)*ClusterCount.Y)*ClusterCount.X;
+}
+
+
+const u32* CClusteredLightManager::getClusterLights(u32 cluster, u32& count) const
+{
+	if (2*cluster >= ClusterOffsets.size())
+	{
+		count = 0;
+		return 0;
+	}
+	count = ClusterOffsets[2*cluster+1];
+	return ClusterLightIndices.const_pointer() + ClusterOffsets[2*cluster];
+}
+
+
+const core::array<u32>& CClusteredLightManager::getClusterOffsets() const
+{
+	return ClusterOffsets;
+}
+
+
+const core::array<u32>& CClusteredLightManager::getClusterLightIndices() const
+{
+	return ClusterLightIndices;
+}
+
+
+void CClusteredLightManager::getDepthSliceFactors(f32& scale, f32& bias) const
+{
+	scale = DepthScale;
+	bias = DepthBias;
+}
+
+
+const core::array<u32>& CClusteredLightManager::getNodeLights() const
+{
+	return NodeLights;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,109 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+#define __C_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+
+#include "IClusteredLightManager.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneManager;
+
+	//! A light manager which switches on only the lights near each scene node.
+	class CClusteredLightManager : public IClusteredLightManager
+	{
+	public:
+
+		//! constructor
+		CClusteredLightManager(ISceneManager* sceneManager, const core::vector3d<u32>& clusterCount);
+
+		virtual void OnPreRender(core::array<ISceneNode*>& lightList) _IRR_OVERRIDE_;
+		virtual void OnPostRender() _IRR_OVERRIDE_;
+		virtual void OnRenderPassPreRender(E_SCENE_NODE_RENDER_PASS renderPass) _IRR_OVERRIDE_;
+		virtual void OnRenderPassPostRender(E_SCENE_NODE_RENDER_PASS renderPass) _IRR_OVERRIDE_;
+		virtual void OnNodePreRender(ISceneNode* node) _IRR_OVERRIDE_;
+		virtual void OnNodePostRender(ISceneNode* node) _IRR_OVERRIDE_;
+
+		virtual void setClusterCount(const core::vector3d<u32>& count) _IRR_OVERRIDE_;
+		virtual const core::vector3d<u32>& getClusterCount() const _IRR_OVERRIDE_;
+		virtual void setMaxNodeLights(u32 count) _IRR_OVERRIDE_;
+		virtual u32 getMaxNodeLights() const _IRR_OVERRIDE_;
+		virtual s32 getClusterIndex(const core::vector3df& viewPos) const _IRR_OVERRIDE_;
+		virtual const u32* getClusterLights(u32 cluster, u32& count) const _IRR_OVERRIDE_;
+		virtual const core::array<u32>& getClusterOffsets() const _IRR_OVERRIDE_;
+		virtual const core::array<u32>& getClusterLightIndices() const _IRR_OVERRIDE_;
+		virtual void getDepthSliceFactors(f32& scale, f32& bias) const _IRR_OVERRIDE_;
+		virtual const core::array<u32>& getNodeLights() const _IRR_OVERRIDE_;
+
+	private:
+
+		struct SLightInfo
+		{
+			core::vector3df Position;
+			f32 Radius;
+			//! directional lights and unknown light nodes
+			bool AlwaysOn;
+		};
+
+		struct SLightDistance
+		{
+			f32 Distance;
+			u32 Light;
+
+			bool operator<(const SLightDistance& other) const
+			{
+				return Distance < other.Distance;
+			}
+		};
+
+		//! Sort the lights into the clusters of the active camera
+		void buildClusters();
+
+		//! Get the clusters overlapping a box in view space
+		/** \return False if the box is outside of the view frustum */
+		bool getClusterRange(const core::aabbox3df& viewBox, u32* minCluster, u32* maxCluster) const;
+
+		//! Get the depth slice of a view space depth
+		u32 getDepthSlice(f32 z) const;
+
+		//! Switch on the lights in NodeLights and off all others
+		void switchLights();
+
+		ISceneManager* SceneManager;
+		core::array<ISceneNode*>* LightList;
+		E_SCENE_NODE_RENDER_PASS CurrentRenderPass;
+		core::vector3d<u32> ClusterCount;
+		u32 MaxNodeLights;
+		//! lights are managed in this frame
+		bool Active;
+
+		core::matrix4 View;
+		core::matrix4 Projection;
+		f32 Near;
+		f32 Far;
+		f32 DepthScale;
+		f32 DepthBias;
+
+		core::array<SLightInfo> Lights;
+		core::array<u32> ClusterOffsets;
+		core::array<u32> ClusterLightIndices;
+		core::array<u32> NodeLights;
+		//! lights which are on in the driver
+		core::array<u32> OnLights;
+		core::array<bool> LightIsOn;
+		//! last node each light was a candidate for, and last switch it was wanted in
+		core::array<u32> CandidateStamps;
+		core::array<u32> NodeStamps;
+		u32 Stamp;
+		core::array<SLightDistance> Candidates;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
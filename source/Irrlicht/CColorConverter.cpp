@@ -6,12 +6,234 @@
 #include "SColor.h"
 #include "os.h"
 #include "irrString.h"
+#include "irrMath.h"
+#include "irrArray.h"
+#include <string.h>
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
 
 namespace irr
 {
 namespace video
 {
 
+namespace
+{
+	//! Packs the lower 3 bytes of 4 pixels into 12 bytes
+	inline void packRows24(const u32* p, u8* d)
+	{
+		const u32 w[3] = {
+			(p[0] & 0x00FFFFFF) | (p[1] << 24),
+			((p[1] >> 8) & 0xFFFF) | (p[2] << 16),
+			((p[2] >> 16) & 0xFF) | (p[3] << 8) };
+		memcpy(d, w, 12);
+	}
+
+	//! Unpacks 12 bytes into the lower 3 bytes of 4 pixels
+	inline void unpackRows24(const u8* s, u32* p)
+	{
+		u32 w[3];
+		memcpy(w, s, 12);
+		p[0] = w[0] & 0x00FFFFFF;
+		p[1] = (w[0] >> 24) | ((w[1] & 0xFFFF) << 8);
+		p[2] = (w[1] >> 16) | ((w[2] & 0xFF) << 16);
+		p[3] = w[2] >> 8;
+	}
+
+	//! Number of channels of a float format, 0 for other formats
+	u32 getFloatChannels(ECOLOR_FORMAT format, bool& half)
+	{
+		half = format == ECF_R16F || format == ECF_G16R16F || format == ECF_A16B16G16R16F;
+		switch (format)
+		{
+			case ECF_R16F:
+			case ECF_R32F:
+				return 1;
+			case ECF_G16R16F:
+			case ECF_G32R32F:
+				return 2;
+			case ECF_A16B16G16R16F:
+			case ECF_A32B32G32R32F:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	inline f32 halfToFloat(u16 h)
+	{
+		const u32 sign = (u32)(h & 0x8000) << 16;
+		const u32 exponent = (h >> 10) & 0x1F;
+		const u32 mantissa = h & 0x3FF;
+
+		if (exponent == 0x1F)
+			return core::FR(sign | 0x7F800000 | (mantissa << 13));
+		if (exponent)
+			return core::FR(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		// denormal
+		const f32 f = mantissa * (1.f / 16777216.f);
+		return sign ? -f : f;
+	}
+
+	inline u16 floatToHalf(f32 f)
+	{
+		const u32 bits = core::IR(f);
+		const u16 sign = (u16)((bits >> 16) & 0x8000);
+		const s32 exponent = (s32)((bits >> 23) & 0xFF) - 127 + 15;
+		u32 mantissa = bits & 0x7FFFFF;
+
+		if (((bits >> 23) & 0xFF) == 0xFF)
+			return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+		if (exponent >= 0x1F)
+			return sign | 0x7C00;
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+				return sign;
+			mantissa |= 0x800000;
+			const u32 shift = 14 - exponent;
+			return sign | (u16)((mantissa + (1 << (shift - 1))) >> shift);
+		}
+		// rounding may carry into the exponent, which is still right
+		return sign | (u16)((((u32)exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1));
+	}
+
+	//! Converts floats with the channels R, G, B, A to A8R8G8B8, missing colors are 0 and alpha 1
+	void convertFloatToA8R8G8B8(const f32* sB, u32 channels, s32 sN, u32* dB)
+	{
+		s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		if (channels == 4)
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(255.f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			for (; x + 4 <= sN; x += 4, sB += 16)
+			{
+				__m128i c[4];
+				for (u32 i=0; i<4; ++i)
+				{
+					// max first, so NaN becomes 0 like in the loop below
+					const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(sB + i * 4), zero), one);
+					c[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+					// R, G, B, A to B, G, R, A
+					c[i] = _mm_shuffle_epi32(c[i], _MM_SHUFFLE(3,0,1,2));
+				}
+				const __m128i lo = _mm_packs_epi32(c[0], c[1]);
+				const __m128i hi = _mm_packs_epi32(c[2], c[3]);
+				_mm_storeu_si128((__m128i*)(dB + x), _mm_packus_epi16(lo, hi));
+			}
+		}
+#endif
+		for (; x < sN; ++x, sB += channels)
+		{
+			u32 c[4] = { 0, 0, 0, 255 };
+			for (u32 i=0; i<channels; ++i)
+			{
+				f32 v = sB[i] > 0.f ? sB[i] : 0.f;
+				v = v < 1.f ? v : 1.f;
+				c[i] = (u32)(v * 255.f + 0.5f);
+			}
+			dB[x] = (c[3] << 24) | (c[0] << 16) | (c[1] << 8) | c[2];
+		}
+	}
+
+	//! Converts A8R8G8B8 to floats with the first channels of R, G, B, A
+	void convertA8R8G8B8toFloat(const u32* sB, s32 sN, f32* dB, u32 channels)
+	{
+		const f32 scale = 1.f / 255.f;
+		s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		if (channels == 4)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 scale4 = _mm_set1_ps(scale);
+			for (; x + 4 <= sN; x += 4, dB += 16)
+			{
+				const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+				const __m128i lo = _mm_unpacklo_epi8(c, zero);
+				const __m128i hi = _mm_unpackhi_epi8(c, zero);
+				const __m128i p[4] = { _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+					_mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero) };
+				for (u32 i=0; i<4; ++i)
+				{
+					// B, G, R, A to R, G, B, A
+					const __m128i v = _mm_shuffle_epi32(p[i], _MM_SHUFFLE(3,0,1,2));
+					_mm_storeu_ps(dB + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(v), scale4));
+				}
+			}
+		}
+#endif
+		for (; x < sN; ++x, dB += channels)
+		{
+			const u32 c = sB[x];
+			const u32 v[4] = { (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, c >> 24 };
+			for (u32 i=0; i<channels; ++i)
+				dB[i] = v[i] * scale;
+		}
+	}
+
+	//! Pixels converted at once through a buffer on the stack
+	const s32 BlockPixels = 256;
+
+	//! Converts any float format to A8R8G8B8
+	void convertFloatFormatToA8R8G8B8(const void* sP, ECOLOR_FORMAT sF, s32 sN, u32* dB)
+	{
+		bool half;
+		const u32 channels = getFloatChannels(sF, half);
+		if (!half)
+		{
+			convertFloatToA8R8G8B8((const f32*)sP, channels, sN, dB);
+			return;
+		}
+
+		const u16* sB = (const u16*)sP;
+		f32 block[BlockPixels * 4];
+		for (s32 x=0; x<sN; x+=BlockPixels)
+		{
+			const s32 n = core::min_(sN - x, BlockPixels);
+			for (s32 i=0; i<n * (s32)channels; ++i)
+				block[i] = halfToFloat(sB[i]);
+			convertFloatToA8R8G8B8(block, channels, n, dB + x);
+			sB += n * channels;
+		}
+	}
+
+	//! Converts A8R8G8B8 to any float format
+	void convertA8R8G8B8toFloatFormat(const u32* sB, s32 sN, void* dP, ECOLOR_FORMAT dF)
+	{
+		bool half;
+		const u32 channels = getFloatChannels(dF, half);
+		if (!half)
+		{
+			convertA8R8G8B8toFloat(sB, sN, (f32*)dP, channels);
+			return;
+		}
+
+		u16* dB = (u16*)dP;
+		f32 block[BlockPixels * 4];
+		for (s32 x=0; x<sN; x+=BlockPixels)
+		{
+			const s32 n = core::min_(sN - x, BlockPixels);
+			convertA8R8G8B8toFloat(sB + x, n, block, channels);
+			for (s32 i=0; i<n * (s32)channels; ++i)
+				dB[i] = floatToHalf(block[i]);
+			dB += n * channels;
+		}
+	}
+
+	//! Checks if convert_viaFormat works with a format
+	bool isConvertibleFormat(ECOLOR_FORMAT format)
+	{
+		bool half;
+		return format == ECF_A1R5G5B5 || format == ECF_R5G6B5 || format == ECF_R8G8B8 ||
+			format == ECF_A8R8G8B8 || getFloatChannels(format, half) != 0;
+	}
+} // end anonymous namespace
+
 //! converts a monochrome bitmap to A1R5G5B5 data
 void CColorConverter::convert1BitTo16Bit(const u8* in, s16* out, s32 width, s32 height, s32 linepad, bool flip)
 {
@@ -245,12 +467,7 @@ void CColorConverter::convert24BitTo24Bit(const u8* in, u8* out, s32 width, s32
 			out -= lineWidth;
 		if (bgr)
 		{
-			for (s32 x=0; x<lineWidth; x+=3)
-			{
-				out[x+0] = in[x+2];
-				out[x+1] = in[x+1];
-				out[x+2] = in[x+0];
-			}
+			convert_R8G8B8toB8G8R8(in, width, out);
 		}
 		else
 		{
@@ -363,8 +580,28 @@ void CColorConverter::convert_A1R5G5B5toA8R8G8B8(const void* sP, s32 sN, void* d
 	u16* sB = (u16*)sP;
 	u32* dB = (u32*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
-		*dB++ = A1R5G5B5toA8R8G8B8(*sB++);
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	for (; x + 8 <= sN; x += 8)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+		__m128i r = _mm_and_si128(_mm_srli_epi16(c, 10), mask5);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask5);
+		__m128i b = _mm_and_si128(c, mask5);
+		// extend to 8 bit with the high bits, as A1R5G5B5toA8R8G8B8
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		const __m128i a = _mm_srai_epi16(c, 15);
+		const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+		const __m128i ra = _mm_or_si128(r, _mm_slli_epi16(a, 8));
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_unpacklo_epi16(bg, ra));
+		_mm_storeu_si128((__m128i*)(dB + x + 4), _mm_unpackhi_epi16(bg, ra));
+	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = A1R5G5B5toA8R8G8B8(sB[x]);
 }
 
 void CColorConverter::convert_A1R5G5B5toA1R5G5B5(const void* sP, s32 sN, void* dP)
@@ -377,8 +614,19 @@ void CColorConverter::convert_A1R5G5B5toR5G6B5(const void* sP, s32 sN, void* dP)
 	u16* sB = (u16*)sP;
 	u16* dB = (u16*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
-		*dB++ = A1R5G5B5toR5G6B5(*sB++);
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskRG = _mm_set1_epi16(0x7FE0);
+	const __m128i maskB = _mm_set1_epi16(0x1F);
+	for (; x + 8 <= sN; x += 8)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_or_si128(
+			_mm_slli_epi16(_mm_and_si128(c, maskRG), 1), _mm_and_si128(c, maskB)));
+	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = A1R5G5B5toR5G6B5(sB[x]);
 }
 
 void CColorConverter::convert_A8R8G8B8toR8G8B8(const void* sP, s32 sN, void* dP)
@@ -386,7 +634,19 @@ void CColorConverter::convert_A8R8G8B8toR8G8B8(const void* sP, s32 sN, void* dP)
 	u8* sB = (u8*)sP;
 	u8* dB = (u8*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifndef __BIG_ENDIAN__
+	// 4 pixels into 3 words
+	for (; x + 4 <= sN; x += 4, sB += 16, dB += 12)
+	{
+		u32 p[4];
+		memcpy(p, sB, 16);
+		for (u32 i=0; i<4; ++i)
+			p[i] = (p[i] & 0x0000FF00) | ((p[i] >> 16) & 0xFF) | ((p[i] & 0xFF) << 16);
+		packRows24(p, dB);
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		// sB[3] is alpha
 		dB[0] = sB[2];
@@ -403,7 +663,17 @@ void CColorConverter::convert_A8R8G8B8toB8G8R8(const void* sP, s32 sN, void* dP)
 	u8* sB = (u8*)sP;
 	u8* dB = (u8*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifndef __BIG_ENDIAN__
+	// 4 pixels into 3 words
+	for (; x + 4 <= sN; x += 4, sB += 16, dB += 12)
+	{
+		u32 p[4];
+		memcpy(p, sB, 16);
+		packRows24(p, dB);
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		// sB[3] is alpha
 		dB[0] = sB[0];
@@ -425,8 +695,29 @@ void CColorConverter::convert_A8R8G8B8toA1R5G5B5(const void* sP, s32 sN, void* d
 	u32* sB = (u32*)sP;
 	u16* dB = (u16*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
-		*dB++ = A8R8G8B8toA1R5G5B5(*sB++);
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskA = _mm_set1_epi32(0x80000000);
+	const __m128i maskR = _mm_set1_epi32(0x00F80000);
+	const __m128i maskG = _mm_set1_epi32(0x0000F800);
+	const __m128i maskB = _mm_set1_epi32(0x000000F8);
+	for (; x + 8 <= sN; x += 8)
+	{
+		__m128i c[2];
+		for (u32 i=0; i<2; ++i)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(sB + x + i * 4));
+			c[i] = _mm_or_si128(
+				_mm_or_si128(_mm_srli_epi32(_mm_and_si128(v, maskA), 16), _mm_srli_epi32(_mm_and_si128(v, maskR), 9)),
+				_mm_or_si128(_mm_srli_epi32(_mm_and_si128(v, maskG), 6), _mm_srli_epi32(_mm_and_si128(v, maskB), 3)));
+			// sign extend, so the signed pack keeps the alpha bit
+			c[i] = _mm_srai_epi32(_mm_slli_epi32(c[i], 16), 16);
+		}
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_packs_epi32(c[0], c[1]));
+	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = A8R8G8B8toA1R5G5B5(sB[x]);
 }
 
 void CColorConverter::convert_A8R8G8B8toA1B5G5R5(const void* sP, s32 sN, void* dP)
@@ -453,7 +744,26 @@ void CColorConverter::convert_A8R8G8B8toR5G6B5(const void* sP, s32 sN, void* dP)
 	u8 * sB = (u8 *)sP;
 	u16* dB = (u16*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskR = _mm_set1_epi32(0x00F80000);
+	const __m128i maskG = _mm_set1_epi32(0x0000FC00);
+	const __m128i maskB = _mm_set1_epi32(0x000000F8);
+	for (; x + 8 <= sN; x += 8, sB += 32, dB += 8)
+	{
+		__m128i c[2];
+		for (u32 i=0; i<2; ++i)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(sB + i * 16));
+			c[i] = _mm_or_si128(_mm_srli_epi32(_mm_and_si128(v, maskR), 8),
+				_mm_or_si128(_mm_srli_epi32(_mm_and_si128(v, maskG), 5), _mm_srli_epi32(_mm_and_si128(v, maskB), 3)));
+			// sign extend, so the signed pack keeps the high red bit
+			c[i] = _mm_srai_epi32(_mm_slli_epi32(c[i], 16), 16);
+		}
+		_mm_storeu_si128((__m128i*)dB, _mm_packs_epi32(c[0], c[1]));
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		s32 r = sB[2] >> 3;
 		s32 g = sB[1] >> 2;
@@ -494,7 +804,17 @@ void CColorConverter::convert_R8G8B8toA8R8G8B8(const void* sP, s32 sN, void* dP)
 	u8*  sB = (u8* )sP;
 	u32* dB = (u32*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifndef __BIG_ENDIAN__
+	// 3 words into 4 pixels
+	for (; x + 4 <= sN; x += 4, sB += 12, dB += 4)
+	{
+		unpackRows24(sB, dB);
+		for (u32 i=0; i<4; ++i)
+			dB[i] = 0xff000000 | (dB[i] & 0x0000FF00) | ((dB[i] >> 16) & 0xFF) | ((dB[i] & 0xFF) << 16);
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		*dB = 0xff000000 | (sB[0]<<16) | (sB[1]<<8) | sB[2];
 
@@ -526,7 +846,17 @@ void CColorConverter::convert_B8G8R8toA8R8G8B8(const void* sP, s32 sN, void* dP)
 	u8*  sB = (u8* )sP;
 	u32* dB = (u32*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifndef __BIG_ENDIAN__
+	// 3 words into 4 pixels
+	for (; x + 4 <= sN; x += 4, sB += 12, dB += 4)
+	{
+		unpackRows24(sB, dB);
+		for (u32 i=0; i<4; ++i)
+			dB[i] |= 0xff000000;
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		*dB = 0xff000000 | (sB[2]<<16) | (sB[1]<<8) | sB[0];
 
@@ -540,7 +870,18 @@ void CColorConverter::convert_B8G8R8A8toA8R8G8B8(const void* sP, s32 sN, void* d
 	u8* sB = (u8*)sP;
 	u8* dB = (u8*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	for (; x + 4 <= sN; x += 4, sB += 16, dB += 16)
+	{
+		// reverse the bytes of each pixel: swap the bytes of the 16 bit halves, then the halves
+		__m128i v = _mm_loadu_si128((const __m128i*)sB);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1));
+		_mm_storeu_si128((__m128i*)dB, v);
+	}
+#endif
+	for (; x < sN; ++x)
 	{
 		dB[0] = sB[3];
 		dB[1] = sB[2];
@@ -558,11 +899,19 @@ void CColorConverter::convert_A8R8G8B8toA8B8G8R8(const void* sP, s32 sN, void* d
 	const u32* sB = (const u32*)sP;
 	u32* dB = (u32*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskAG = _mm_set1_epi32(0xff00ff00);
+	const __m128i maskB = _mm_set1_epi32(0x000000ff);
+	for (; x + 4 <= sN; x += 4)
 	{
-		*dB++ = (*sB & 0xff00ff00) | ((*sB & 0x00ff0000) >> 16) | ((*sB & 0x000000ff) << 16);
-		++sB;
+		const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_or_si128(_mm_and_si128(c, maskAG),
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(c, 16), maskB), _mm_slli_epi32(_mm_and_si128(c, maskB), 16))));
 	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = (sB[x] & 0xff00ff00) | ((sB[x] & 0x00ff0000) >> 16) | ((sB[x] & 0x000000ff) << 16);
 }
 
 void CColorConverter::convert_R8G8B8toR5G6B5(const void* sP, s32 sN, void* dP)
@@ -625,8 +974,25 @@ void CColorConverter::convert_R5G6B5toA8R8G8B8(const void* sP, s32 sN, void* dP)
 	u16* sB = (u16*)sP;
 	u32* dB = (u32*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
-		*dB++ = R5G6B5toA8R8G8B8(*sB++);
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskHigh = _mm_set1_epi16(0xF8);
+	const __m128i maskG = _mm_set1_epi16(0xFC);
+	const __m128i alpha = _mm_set1_epi16((s16)0xFF00);
+	for (; x + 8 <= sN; x += 8)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+		const __m128i r = _mm_and_si128(_mm_srli_epi16(c, 8), maskHigh);
+		const __m128i g = _mm_and_si128(_mm_srli_epi16(c, 3), maskG);
+		const __m128i b = _mm_and_si128(_mm_slli_epi16(c, 3), maskHigh);
+		const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+		const __m128i ra = _mm_or_si128(r, alpha);
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_unpacklo_epi16(bg, ra));
+		_mm_storeu_si128((__m128i*)(dB + x + 4), _mm_unpackhi_epi16(bg, ra));
+	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = R5G6B5toA8R8G8B8(sB[x]);
 }
 
 void CColorConverter::convert_R5G6B5toA1R5G5B5(const void* sP, s32 sN, void* dP)
@@ -634,14 +1000,116 @@ void CColorConverter::convert_R5G6B5toA1R5G5B5(const void* sP, s32 sN, void* dP)
 	u16* sB = (u16*)sP;
 	u16* dB = (u16*)dP;
 
-	for (s32 x = 0; x < sN; ++x)
-		*dB++ = R5G6B5toA1R5G5B5(*sB++);
+	s32 x = 0;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i maskRG = _mm_set1_epi16((s16)0xFFC0);
+	const __m128i maskB = _mm_set1_epi16(0x1F);
+	const __m128i alpha = _mm_set1_epi16((s16)0x8000);
+	for (; x + 8 <= sN; x += 8)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)(sB + x));
+		_mm_storeu_si128((__m128i*)(dB + x), _mm_or_si128(alpha, _mm_or_si128(
+			_mm_srli_epi16(_mm_and_si128(c, maskRG), 1), _mm_and_si128(c, maskB))));
+	}
+#endif
+	for (; x < sN; ++x)
+		dB[x] = R5G6B5toA1R5G5B5(sB[x]);
+}
+
+void CColorConverter::convert_R8G8B8toB8G8R8(const void* sP, s32 sN, void* dP)
+{
+	u8* sB = (u8*)sP;
+	u8* dB = (u8*)dP;
+
+	s32 x = 0;
+#ifndef __BIG_ENDIAN__
+	for (; x + 4 <= sN; x += 4, sB += 12, dB += 12)
+	{
+		u32 p[4];
+		unpackRows24(sB, p);
+		for (u32 i=0; i<4; ++i)
+			p[i] = (p[i] & 0x0000FF00) | ((p[i] >> 16) & 0xFF) | ((p[i] & 0xFF) << 16);
+		packRows24(p, dB);
+	}
+#endif
+	for (; x < sN; ++x)
+	{
+		const u8 r = sB[0];
+		dB[1] = sB[1];
+		dB[0] = sB[2];
+		dB[2] = r;
+
+		sB += 3;
+		dB += 3;
+	}
+}
+
+void CColorConverter::convert_A32B32G32R32FtoA8R8G8B8(const void* sP, s32 sN, void* dP)
+{
+	convertFloatToA8R8G8B8((const f32*)sP, 4, sN, (u32*)dP);
+}
+
+void CColorConverter::convert_A8R8G8B8toA32B32G32R32F(const void* sP, s32 sN, void* dP)
+{
+	convertA8R8G8B8toFloat((const u32*)sP, sN, (f32*)dP, 4);
+}
+
+void CColorConverter::convert_A16B16G16R16FtoA8R8G8B8(const void* sP, s32 sN, void* dP)
+{
+	convertFloatFormatToA8R8G8B8(sP, ECF_A16B16G16R16F, sN, (u32*)dP);
+}
+
+void CColorConverter::convert_A8R8G8B8toA16B16G16R16F(const void* sP, s32 sN, void* dP)
+{
+	convertA8R8G8B8toFloatFormat((const u32*)sP, sN, dP, ECF_A16B16G16R16F);
 }
 
 
 void CColorConverter::convert_viaFormat(const void* sP, ECOLOR_FORMAT sF, s32 sN,
 				void* dP, ECOLOR_FORMAT dF)
 {
+	if (sF == dF && sF != ECF_UNKNOWN && !IImage::isCompressedFormat(sF))
+	{
+		memcpy(dP, sP, IImage::getDataSizeFromFormat(sF, sN, 1));
+		return;
+	}
+
+	bool half;
+	const bool floatSource = getFloatChannels(sF, half) != 0;
+	const bool floatTarget = getFloatChannels(dF, half) != 0;
+	if (floatSource || floatTarget)
+	{
+		if (!isConvertibleFormat(sF) || !isConvertibleFormat(dF))
+			return;
+
+		// everything else goes through A8R8G8B8 in blocks
+		const u8* sB = (const u8*)sP;
+		u8* dB = (u8*)dP;
+		const u32 sBytes = IImage::getBitsPerPixelFromFormat(sF) / 8;
+		const u32 dBytes = IImage::getBitsPerPixelFromFormat(dF) / 8;
+		u32 block[BlockPixels];
+		for (s32 x=0; x<sN; x+=BlockPixels)
+		{
+			const s32 n = core::min_(sN - x, BlockPixels);
+			const u32* argb = block;
+			if (floatSource)
+				convertFloatFormatToA8R8G8B8(sB, sF, n, block);
+			else if (sF == ECF_A8R8G8B8)
+				argb = (const u32*)sB;
+			else
+				convert_viaFormat(sB, sF, n, block, ECF_A8R8G8B8);
+
+			if (floatTarget)
+				convertA8R8G8B8toFloatFormat(argb, n, dB, dF);
+			else
+				convert_viaFormat(argb, ECF_A8R8G8B8, n, dB, dF);
+
+			sB += n * sBytes;
+			dB += n * dBytes;
+		}
+		return;
+	}
+
 	switch (sF)
 	{
 		case ECF_A1R5G5B5:
@@ -732,5 +1200,60 @@ void CColorConverter::convert_viaFormat(const void* sP, ECOLOR_FORMAT sF, s32 sN
 }
 
 
+bool CColorConverter::canConvert_viaFormat(ECOLOR_FORMAT sF, ECOLOR_FORMAT dF)
+{
+	if (IImage::isCompressedFormat(sF) || IImage::isCompressedFormat(dF))
+		return false;
+
+	if (sF == dF)
+		return sF != ECF_UNKNOWN;
+
+	return isConvertibleFormat(sF) && isConvertibleFormat(dF);
+}
+
+
+bool CColorConverter::convert_viaFormat(const void* sP, ECOLOR_FORMAT sF, u32 sPitch,
+				void* dP, ECOLOR_FORMAT dF, u32 dPitch, u32 width, u32 height)
+{
+	if (!canConvert_viaFormat(sF, dF))
+		return false;
+
+	// rows without padding are converted as one long row
+	if (sPitch == IImage::getDataSizeFromFormat(sF, width, 1) &&
+		dPitch == IImage::getDataSizeFromFormat(dF, width, 1))
+	{
+		convert_viaFormat(sP, sF, width * height, dP, dF);
+		return true;
+	}
+
+	const u8* sB = (const u8*)sP;
+	u8* dB = (u8*)dP;
+	for (u32 y=0; y<height; ++y)
+	{
+		convert_viaFormat(sB, sF, width, dB, dF);
+		sB += sPitch;
+		dB += dPitch;
+	}
+	return true;
+}
+
+
+bool CColorConverter::convertMipMaps(const IImage* source, IImage* target)
+{
+	const ECOLOR_FORMAT sF = source->getColorFormat();
+	const ECOLOR_FORMAT dF = target->getColorFormat();
+	const core::dimension2d<u32>& size = target->getDimension();
+
+	if (!source->getMipMapsData() || source->getDimension() != size || !canConvert_viaFormat(sF, dF))
+		return false;
+
+	// the levels follow each other without padding, so they convert like one row
+	core::array<u8> data;
+	data.set_used(IImage::getMipMapsDataSizeFromFormat(dF, size.Width, size.Height));
+	convert_viaFormat(source->getMipMapsData(), sF, data.size() / (IImage::getBitsPerPixelFromFormat(dF) / 8), data.pointer(), dF);
+	target->setMipMapsData(data.pointer(), false, false);
+	return true;
+}
+
 } // end namespace video
 } // end namespace irr
@@ -75,6 +75,7 @@ public:
 	static void convert_R8G8B8toA8R8G8B8(const void* sP, s32 sN, void* dP);
 	static void convert_R8G8B8toA1R5G5B5(const void* sP, s32 sN, void* dP);
 	static void convert_R8G8B8toR5G6B5(const void* sP, s32 sN, void* dP);
+	static void convert_R8G8B8toB8G8R8(const void* sP, s32 sN, void* dP);
 	static void convert_B8G8R8toA8R8G8B8(const void* sP, s32 sN, void* dP);
 	static void convert_B8G8R8A8toA8R8G8B8(const void* sP, s32 sN, void* dP);
 	static void convert_A8R8G8B8toA8B8G8R8(const void* sP, s32 sN, void* dP);
@@ -84,8 +85,31 @@ public:
 	static void convert_R5G6B5toB8G8R8(const void* sP, s32 sN, void* dP);
 	static void convert_R5G6B5toA8R8G8B8(const void* sP, s32 sN, void* dP);
 	static void convert_R5G6B5toA1R5G5B5(const void* sP, s32 sN, void* dP);
+
+	//! Float colors are clamped to [0,1], missing channels become 0 and alpha 1
+	static void convert_A32B32G32R32FtoA8R8G8B8(const void* sP, s32 sN, void* dP);
+	static void convert_A8R8G8B8toA32B32G32R32F(const void* sP, s32 sN, void* dP);
+	static void convert_A16B16G16R16FtoA8R8G8B8(const void* sP, s32 sN, void* dP);
+	static void convert_A8R8G8B8toA16B16G16R16F(const void* sP, s32 sN, void* dP);
+
+	//! Converts sN pixels between any of the 8 bit and floating point formats
+	/** Pairs without a direct function go through A8R8G8B8. Unsupported pairs
+	leave dP untouched, check canConvert_viaFormat first. */
 	static void convert_viaFormat(const void* sP, ECOLOR_FORMAT sF, s32 sN,
 				void* dP, ECOLOR_FORMAT dF);
+
+	//! Converts a rectangle of pixels, rows start every sPitch and dPitch bytes
+	/** \return False if the pair of formats is not supported. */
+	static bool convert_viaFormat(const void* sP, ECOLOR_FORMAT sF, u32 sPitch,
+				void* dP, ECOLOR_FORMAT dF, u32 dPitch, u32 width, u32 height);
+
+	//! Checks if convert_viaFormat supports a pair of formats
+	static bool canConvert_viaFormat(ECOLOR_FORMAT sF, ECOLOR_FORMAT dF);
+
+	//! Converts the mip map data of source into mip map data of target
+	/** \return False if source has no mip maps, the images differ in size
+	or the pair of formats is not supported. */
+	static bool convertMipMaps(const IImage* source, IImage* target);
 };
 
 
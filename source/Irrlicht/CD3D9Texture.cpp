@@ -9,6 +9,7 @@
 #include "CD3D9Texture.h"
 #include "CD3D9Driver.h"
 #include "os.h"
+#include "CColorConverter.h"
 
 namespace irr
 {
@@ -49,9 +50,12 @@ CD3D9Texture::CD3D9Texture(const io::path& name, const core::array<IImage*>& ima
 			tmpImage[i] = Driver->createImage(ColorFormat, Size);
 
 			if (image[i]->getDimension() == Size)
+			{
 				image[i]->copyTo(tmpImage[i]);
+				CColorConverter::convertMipMaps(image[i], tmpImage[i]);
+			}
 			else
-				image[i]->copyToScaling(tmpImage[i]);
+				image[i]->copyToResampling(tmpImage[i], EIF_MITCHELL);
 		}
 	}
 
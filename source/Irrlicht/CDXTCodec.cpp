@@ -0,0 +1,556 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CDXTCodec.h"
+#include "CColorConverter.h"
+#include "CWorkerPool.h"
+#include "irrMath.h"
+#include "irrArray.h"
+#include <string.h>
+
+namespace irr
+{
+namespace video
+{
+
+namespace
+{
+	//! pixels converted per job, fewer are not worth a thread
+	const u32 ConvertGrainPixels = 16384;
+
+	//! Expands a R5G6B5 color to an opaque A8R8G8B8 color
+	inline u32 expand565(u32 c)
+	{
+		const u32 r = (c >> 11) & 0x1F;
+		const u32 g = (c >> 5) & 0x3F;
+		const u32 b = c & 0x1F;
+		return 0xFF000000 | (r << 3 | r >> 2) << 16 | (g << 2 | g >> 4) << 8 | (b << 3 | b >> 2);
+	}
+
+	//! Rounds a color with channels in [0,255] to R5G6B5
+	inline u32 quantize565(const f32* c)
+	{
+		const u32 r = (u32)core::clamp(core::round32(c[0] * (31.f / 255.f)), 0, 31);
+		const u32 g = (u32)core::clamp(core::round32(c[1] * (63.f / 255.f)), 0, 63);
+		const u32 b = (u32)core::clamp(core::round32(c[2] * (31.f / 255.f)), 0, 31);
+		return r << 11 | g << 5 | b;
+	}
+
+	//! Mixes two A8R8G8B8 colors channel by channel
+	inline u32 mixColors(u32 a, u32 b, u32 weightA, u32 weightB)
+	{
+		u32 result = 0;
+		for (u32 shift=0; shift<32; shift+=8)
+			result |= ((((a >> shift) & 0xFF) * weightA + ((b >> shift) & 0xFF) * weightB) / (weightA + weightB)) << shift;
+		return result;
+	}
+
+	//! Squared distance of two colors, alpha is ignored
+	inline u32 colorDistance(u32 a, u32 b)
+	{
+		const s32 dr = (s32)((a >> 16) & 0xFF) - (s32)((b >> 16) & 0xFF);
+		const s32 dg = (s32)((a >> 8) & 0xFF) - (s32)((b >> 8) & 0xFF);
+		const s32 db = (s32)(a & 0xFF) - (s32)(b & 0xFF);
+		return dr * dr + dg * dg + db * db;
+	}
+
+	//! Gets the palette of a color block
+	/** With c0 <= c1 DXT1 blocks have 3 colors and transparent black, the
+	color blocks of the other formats always have 4 colors. */
+	void getBlockColors(u32 c0, u32 c1, bool fourColors, u32* colors)
+	{
+		colors[0] = expand565(c0);
+		colors[1] = expand565(c1);
+		if (c0 > c1 || fourColors)
+		{
+			colors[2] = mixColors(colors[0], colors[1], 2, 1);
+			colors[3] = mixColors(colors[0], colors[1], 1, 2);
+		}
+		else
+		{
+			colors[2] = mixColors(colors[0], colors[1], 1, 1);
+			colors[3] = 0;
+		}
+	}
+
+	//! Gets the 8 alpha values of a DXT5 alpha block
+	void getBlockAlphas(u32 a0, u32 a1, u32* alphas)
+	{
+		alphas[0] = a0;
+		alphas[1] = a1;
+		if (a0 > a1)
+		{
+			for (u32 i=1; i<7; ++i)
+				alphas[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		}
+		else
+		{
+			for (u32 i=1; i<5; ++i)
+				alphas[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+			alphas[6] = 0;
+			alphas[7] = 255;
+		}
+	}
+
+	//! Decodes a color block
+	void decodeColors(const u8* block, bool fourColors, u32* pixels)
+	{
+		u32 colors[4];
+		getBlockColors(block[0] | block[1] << 8, block[2] | block[3] << 8, fourColors, colors);
+
+		const u32 indices = block[4] | block[5] << 8 | block[6] << 16 | (u32)block[7] << 24;
+		for (u32 i=0; i<16; ++i)
+			pixels[i] = colors[(indices >> (2 * i)) & 3];
+	}
+
+	//! Finds the nearest palette color of each pixel, returns the summed error
+	u32 fitIndices(const u32* pixels, const u32* colors, u32 colorCount, u32 transparent, u32& indices)
+	{
+		u32 error = 0;
+		indices = 0;
+		for (u32 i=0; i<16; ++i)
+		{
+			u32 best = 3;
+			if (!(transparent & (1 << i)))
+			{
+				u32 bestError = 0xFFFFFFFF;
+				for (u32 c=0; c<colorCount; ++c)
+				{
+					const u32 e = colorDistance(pixels[i], colors[c]);
+					if (e < bestError)
+					{
+						bestError = e;
+						best = c;
+					}
+				}
+				error += bestError;
+			}
+			indices |= best << (2 * i);
+		}
+		return error;
+	}
+
+	//! Orders two end points for the kind of block and fits the indices
+	/** Blocks with transparent pixels need c0 <= c1, the others c0 > c1 for 4
+	colors. Equal end points only use index 0, which is the same color in
+	both kinds of blocks. \return Summed error of the opaque pixels */
+	u32 fitBlock(const u32* pixels, u32 transparent, u32& c0, u32& c1, u32& indices)
+	{
+		if (transparent ? c0 > c1 : c0 < c1)
+			core::swap(c0, c1);
+
+		u32 colors[4];
+		getBlockColors(c0, c1, false, colors);
+		return fitIndices(pixels, colors, c0 > c1 ? 4 : (transparent ? 3 : 1), transparent, indices);
+	}
+
+	//! Encodes the colors of 16 pixels into a color block
+	/** \param transparent Bit mask of the pixels which get the transparent
+	color of DXT1 */
+	void encodeColors(const u32* pixels, u32 transparent, u8* block)
+	{
+		f32 color[16][3];
+		f32 mean[3] = { 0.f, 0.f, 0.f };
+		u32 count = 0;
+		for (u32 i=0; i<16; ++i)
+		{
+			color[i][0] = (f32)((pixels[i] >> 16) & 0xFF);
+			color[i][1] = (f32)((pixels[i] >> 8) & 0xFF);
+			color[i][2] = (f32)(pixels[i] & 0xFF);
+			if (transparent & (1 << i))
+				continue;
+			for (u32 c=0; c<3; ++c)
+				mean[c] += color[i][c];
+			++count;
+		}
+
+		u32 c0 = 0;
+		u32 c1 = 0;
+		u32 indices = 0xFFFFFFFF;
+		if (count)
+		{
+			for (u32 c=0; c<3; ++c)
+				mean[c] /= count;
+
+			// covariance rr, rg, rb, gg, gb, bb
+			f32 cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+			for (u32 i=0; i<16; ++i)
+			{
+				if (transparent & (1 << i))
+					continue;
+				const f32 r = color[i][0] - mean[0];
+				const f32 g = color[i][1] - mean[1];
+				const f32 b = color[i][2] - mean[2];
+				cov[0] += r * r;
+				cov[1] += r * g;
+				cov[2] += r * b;
+				cov[3] += g * g;
+				cov[4] += g * b;
+				cov[5] += b * b;
+			}
+
+			// principal axis by power iteration, starting with the row of the largest variance
+			f32 axis[3];
+			if (cov[0] >= cov[3] && cov[0] >= cov[5])
+			{
+				axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2];
+			}
+			else if (cov[3] >= cov[5])
+			{
+				axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+			}
+			else
+			{
+				axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+			}
+			for (u32 k=0; k<4; ++k)
+			{
+				const f32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+				const f32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+				const f32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+				const f32 m = core::max_(core::abs_(x), core::abs_(y), core::abs_(z));
+				if (m <= 0.f)
+					break;
+				axis[0] = x / m;
+				axis[1] = y / m;
+				axis[2] = z / m;
+			}
+
+			// the pixels furthest along the axis are the end points
+			s32 lo = -1;
+			s32 hi = -1;
+			f32 loDot = 0.f;
+			f32 hiDot = 0.f;
+			for (u32 i=0; i<16; ++i)
+			{
+				if (transparent & (1 << i))
+					continue;
+				const f32 dot = color[i][0] * axis[0] + color[i][1] * axis[1] + color[i][2] * axis[2];
+				if (lo < 0 || dot < loDot)
+				{
+					lo = i;
+					loDot = dot;
+				}
+				if (hi < 0 || dot > hiDot)
+				{
+					hi = i;
+					hiDot = dot;
+				}
+			}
+			c0 = quantize565(color[hi]);
+			c1 = quantize565(color[lo]);
+			u32 error = fitBlock(pixels, transparent, c0, c1, indices);
+
+			// least squares end points for these indices
+			static const f32 weights4[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+			static const f32 weights3[4] = { 1.f, 0.f, 0.5f, 0.f };
+			const f32* weights = c0 > c1 ? weights4 : weights3;
+			f32 aa = 0.f;
+			f32 ab = 0.f;
+			f32 bb = 0.f;
+			f32 ap[3] = { 0.f, 0.f, 0.f };
+			f32 bp[3] = { 0.f, 0.f, 0.f };
+			for (u32 i=0; i<16 && error; ++i)
+			{
+				if (transparent & (1 << i))
+					continue;
+				const f32 t = weights[(indices >> (2 * i)) & 3];
+				const f32 s = 1.f - t;
+				aa += t * t;
+				ab += t * s;
+				bb += s * s;
+				for (u32 c=0; c<3; ++c)
+				{
+					ap[c] += t * color[i][c];
+					bp[c] += s * color[i][c];
+				}
+			}
+
+			const f32 det = aa * bb - ab * ab;
+			if (error && det > 0.001f)
+			{
+				f32 e0[3];
+				f32 e1[3];
+				for (u32 c=0; c<3; ++c)
+				{
+					e0[c] = (ap[c] * bb - bp[c] * ab) / det;
+					e1[c] = (bp[c] * aa - ap[c] * ab) / det;
+				}
+				u32 r0 = quantize565(e0);
+				u32 r1 = quantize565(e1);
+				u32 refined;
+				const u32 refinedError = fitBlock(pixels, transparent, r0, r1, refined);
+				if (refinedError < error)
+				{
+					c0 = r0;
+					c1 = r1;
+					indices = refined;
+				}
+			}
+		}
+
+		block[0] = (u8)c0;
+		block[1] = (u8)(c0 >> 8);
+		block[2] = (u8)c1;
+		block[3] = (u8)(c1 >> 8);
+		block[4] = (u8)indices;
+		block[5] = (u8)(indices >> 8);
+		block[6] = (u8)(indices >> 16);
+		block[7] = (u8)(indices >> 24);
+	}
+
+	//! Encodes the alpha of 16 pixels into a DXT5 alpha block
+	void encodeAlpha(const u32* pixels, u8* block)
+	{
+		u32 lo = 255;
+		u32 hi = 0;
+		for (u32 i=0; i<16; ++i)
+		{
+			const u32 a = pixels[i] >> 24;
+			lo = core::min_(lo, a);
+			hi = core::max_(hi, a);
+		}
+
+		// 8 alpha values between the extremes, a single value only needs index 0
+		u64 indices = 0;
+		if (hi > lo)
+		{
+			u32 alphas[8];
+			getBlockAlphas(hi, lo, alphas);
+			for (u32 i=0; i<16; ++i)
+			{
+				const s32 a = pixels[i] >> 24;
+				u32 best = 0;
+				for (u32 k=1; k<8; ++k)
+				{
+					if (core::abs_(a - (s32)alphas[k]) < core::abs_(a - (s32)alphas[best]))
+						best = k;
+				}
+				indices |= (u64)best << (3 * i);
+			}
+		}
+
+		block[0] = (u8)hi;
+		block[1] = (u8)lo;
+		for (u32 i=0; i<6; ++i)
+			block[2 + i] = (u8)(indices >> (8 * i));
+	}
+
+	//! Converts rows of blocks from and to a DXT format
+	struct SConvertJob
+	{
+		SConvertJob(const IImage* source, IImage* target, core::array<u32>& scratch)
+			: Source(source), Target(target), Scratch(scratch) {}
+
+		void operator()(u32 begin, u32 end, u32 worker) const
+		{
+			const ECOLOR_FORMAT sF = Source->getColorFormat();
+			const ECOLOR_FORMAT dF = Target->getColorFormat();
+			const core::dimension2d<u32>& size = Source->getDimension();
+			const u32 stripWidth = (size.Width + 3) & ~3;
+
+			// 4 rows of A8R8G8B8 pixels
+			u32* strip = &Scratch[worker * stripWidth * 4];
+			u32 pixels[16];
+
+			for (u32 by=begin; by<end; ++by)
+			{
+				const u32 rows = core::min_(size.Height - by * 4, 4u);
+
+				if (CDXTCodec::isFormatSupported(sF))
+				{
+					const u32 blockSize = IImage::getDataSizeFromFormat(sF, 4, 4);
+					const u8* block = (const u8*)Source->getData() + by * IImage::getDataSizeFromFormat(sF, size.Width, 4);
+					for (u32 x=0; x<stripWidth; x+=4, block+=blockSize)
+					{
+						CDXTCodec::decodeBlock(block, sF, pixels);
+						for (u32 r=0; r<4; ++r)
+							memcpy(strip + r * stripWidth + x, pixels + r * 4, 16);
+					}
+				}
+				else
+				{
+					const u8* row = (const u8*)Source->getData() + by * 4 * Source->getPitch();
+					for (u32 r=0; r<4; ++r)
+					{
+						u32* line = strip + r * stripWidth;
+						if (r < rows)
+						{
+							CColorConverter::convert_viaFormat(row, sF, size.Width, line, ECF_A8R8G8B8);
+							for (u32 x=size.Width; x<stripWidth; ++x)
+								line[x] = line[size.Width - 1];
+							row += Source->getPitch();
+						}
+						else
+							memcpy(line, line - stripWidth, stripWidth * 4);
+					}
+				}
+
+				if (CDXTCodec::isFormatSupported(dF))
+				{
+					const u32 blockSize = IImage::getDataSizeFromFormat(dF, 4, 4);
+					u8* block = (u8*)Target->getData() + by * IImage::getDataSizeFromFormat(dF, size.Width, 4);
+					for (u32 x=0; x<stripWidth; x+=4, block+=blockSize)
+					{
+						for (u32 r=0; r<4; ++r)
+							memcpy(pixels + r * 4, strip + r * stripWidth + x, 16);
+						CDXTCodec::encodeBlock(pixels, dF, block);
+					}
+				}
+				else
+				{
+					u8* row = (u8*)Target->getData() + by * 4 * Target->getPitch();
+					for (u32 r=0; r<rows; ++r, row+=Target->getPitch())
+						CColorConverter::convert_viaFormat(strip + r * stripWidth, ECF_A8R8G8B8, size.Width, row, dF);
+				}
+			}
+		}
+
+		const IImage* Source;
+		IImage* Target;
+		core::array<u32>& Scratch;
+	};
+
+} // end anonymous namespace
+
+
+bool CDXTCodec::isFormatSupported(ECOLOR_FORMAT format)
+{
+	switch (format)
+	{
+		case ECF_DXT1:
+		case ECF_DXT2:
+		case ECF_DXT3:
+		case ECF_DXT4:
+		case ECF_DXT5:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+void CDXTCodec::decodeBlock(const void* block, ECOLOR_FORMAT format, u32* pixels)
+{
+	const u8* b = (const u8*)block;
+
+	switch (format)
+	{
+		case ECF_DXT1:
+			decodeColors(b, false, pixels);
+			break;
+		case ECF_DXT2:
+		case ECF_DXT3:
+			// 4 bit alpha per pixel
+			decodeColors(b + 8, true, pixels);
+			for (u32 i=0; i<16; ++i)
+			{
+				const u32 a = (b[i >> 1] >> (4 * (i & 1))) & 0xF;
+				pixels[i] = (pixels[i] & 0x00FFFFFF) | (a * 17) << 24;
+			}
+			break;
+		case ECF_DXT4:
+		case ECF_DXT5:
+		{
+			// 3 bit indices into 8 alpha values
+			decodeColors(b + 8, true, pixels);
+			u32 alphas[8];
+			getBlockAlphas(b[0], b[1], alphas);
+			u64 indices = 0;
+			for (u32 i=0; i<6; ++i)
+				indices |= (u64)b[2 + i] << (8 * i);
+			for (u32 i=0; i<16; ++i)
+				pixels[i] = (pixels[i] & 0x00FFFFFF) | alphas[(indices >> (3 * i)) & 7] << 24;
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+
+void CDXTCodec::encodeBlock(const u32* pixels, ECOLOR_FORMAT format, void* block)
+{
+	u8* b = (u8*)block;
+
+	switch (format)
+	{
+		case ECF_DXT1:
+		{
+			u32 transparent = 0;
+			for (u32 i=0; i<16; ++i)
+			{
+				if ((pixels[i] >> 24) < 128)
+					transparent |= 1 << i;
+			}
+			encodeColors(pixels, transparent, b);
+			break;
+		}
+		case ECF_DXT2:
+		case ECF_DXT3:
+			for (u32 i=0; i<8; ++i)
+			{
+				const u32 a0 = ((pixels[2 * i] >> 24) * 15 + 127) / 255;
+				const u32 a1 = ((pixels[2 * i + 1] >> 24) * 15 + 127) / 255;
+				b[i] = (u8)(a0 | a1 << 4);
+			}
+			encodeColors(pixels, 0, b + 8);
+			break;
+		case ECF_DXT4:
+		case ECF_DXT5:
+			encodeAlpha(pixels, b);
+			encodeColors(pixels, 0, b + 8);
+			break;
+		default:
+			break;
+	}
+}
+
+
+bool CDXTCodec::canConvert(ECOLOR_FORMAT sF, ECOLOR_FORMAT dF)
+{
+	const bool sourceBlocks = isFormatSupported(sF);
+	const bool targetBlocks = isFormatSupported(dF);
+
+	// other pairs are for the color converter
+	if (!sourceBlocks && !targetBlocks)
+		return false;
+
+	return (sourceBlocks || CColorConverter::canConvert_viaFormat(sF, ECF_A8R8G8B8)) &&
+		(targetBlocks || CColorConverter::canConvert_viaFormat(ECF_A8R8G8B8, dF));
+}
+
+
+bool CDXTCodec::convert(const IImage* source, IImage* target)
+{
+	const ECOLOR_FORMAT sF = source->getColorFormat();
+	const ECOLOR_FORMAT dF = target->getColorFormat();
+	const core::dimension2d<u32>& size = source->getDimension();
+
+	if (target->getDimension() != size || !canConvert(sF, dF))
+		return false;
+
+	if (sF == dF)
+	{
+		memcpy(target->getData(), source->getData(), source->getImageDataSizeInBytes());
+		return true;
+	}
+
+	if (!size.Width || !size.Height)
+		return true;
+
+	CWorkerPool& pool = CWorkerPool::getInstance();
+	const u32 stripWidth = (size.Width + 3) & ~3;
+
+	core::array<u32> scratch;
+	scratch.set_used(pool.getWorkerCount() * stripWidth * 4);
+
+	SConvertJob job(source, target, scratch);
+	pool.parallelFor((size.Height + 3) / 4, core::max_(ConvertGrainPixels / (stripWidth * 4), 1u), job);
+
+	return true;
+}
+
+} // end namespace video
+} // end namespace irr
@@ -0,0 +1,51 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_DXT_CODEC_H_INCLUDED__
+#define __C_DXT_CODEC_H_INCLUDED__
+
+#include "IImage.h"
+
+namespace irr
+{
+namespace video
+{
+
+//! Decodes and encodes the block compressed formats ECF_DXT1 to ECF_DXT5
+/** Each block of 4x4 pixels is stored in 8 bytes (DXT1) or 16 bytes. The
+encoder fits the colors of a block to a line along their principal axis and
+improves the end points once with least squares, which is good enough to
+compress textures while loading them. DXT2 and DXT4 are treated like DXT3
+and DXT5, their colors are not divided by alpha. */
+class CDXTCodec
+{
+public:
+
+	//! Checks if format is one of the DXT formats
+	static bool isFormatSupported(ECOLOR_FORMAT format);
+
+	//! Decodes a block into 16 A8R8G8B8 pixels, row by row
+	static void decodeBlock(const void* block, ECOLOR_FORMAT format, u32* pixels);
+
+	//! Encodes 16 A8R8G8B8 pixels, row by row, into a block
+	/** DXT1 makes pixels with alpha below 128 transparent. */
+	static void encodeBlock(const u32* pixels, ECOLOR_FORMAT format, void* block);
+
+	//! Converts a whole image from or to a DXT format
+	/** The other format can be any format the color converter converts from
+	and to A8R8G8B8. Incomplete blocks at the right and bottom are filled
+	with the last column and row. Large images are split between the worker
+	threads. Mip maps are not converted.
+	\return False if the images differ in size or the pair of formats is not
+	supported, in which case target is not changed. */
+	static bool convert(const IImage* source, IImage* target);
+
+	//! Checks if convert supports a pair of formats
+	static bool canConvert(ECOLOR_FORMAT sF, ECOLOR_FORMAT dF);
+};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
@@ -8,12 +8,36 @@
 #include "IGUIEnvironment.h"
 #include "IVideoDriver.h"
 #include "ITexture.h"
+#include "CColorConverter.h"
+#include "CSkylinePacker.h"
 
 namespace irr
 {
 namespace gui
 {
 
+namespace
+{
+// place of a texture in an atlas
+struct SAtlasEntry
+{
+	SAtlasEntry(video::ITexture* texture) : Texture(texture), Atlas(0), Page(0), Packed(false) {}
+
+	// the highest textures first pack tightest
+	bool operator<(const SAtlasEntry& other) const
+	{
+		return Texture->getSize().Height > other.Texture->getSize().Height;
+	}
+
+	video::ITexture* Texture;
+	video::ITexture* Atlas;
+	core::position2d<u32> Pos;
+	u32 Page;
+	bool Packed;
+};
+
+} // end anonymous namespace
+
 CGUISpriteBank::CGUISpriteBank(IGUIEnvironment* env) :
 	Environment(env), Driver(0)
 {
@@ -108,6 +132,196 @@ void CGUISpriteBank::clear()
 	Rectangles.clear();
 }
 
+//! copies the textures into shared atlas textures
+u32 CGUISpriteBank::packTextures(const core::dimension2d<u32>& pageSize)
+{
+	if (!Driver)
+		return 0;
+
+	// each texture once, also when several indices use it
+	core::array<SAtlasEntry> entries;
+	for (u32 i=0; i<Textures.size(); ++i)
+	{
+		video::ITexture* texture = Textures[i];
+		if (!texture || texture->getSize() != texture->getOriginalSize() ||
+			!video::CColorConverter::canConvert_viaFormat(texture->getColorFormat(), video::ECF_A8R8G8B8))
+			continue;
+
+		bool known = false;
+		for (u32 e=0; e<entries.size() && !known; ++e)
+			known = (entries[e].Texture == texture);
+		if (!known)
+			entries.push_back(SAtlasEntry(texture));
+	}
+	if (entries.size() < 2)
+		return 0;
+
+	entries.sort();
+
+	// one pixel between the textures, so filtering doesn't mix them
+	core::CSkylinePacker packer(pageSize, 1);
+	core::array<u32> pageTextureCount;
+	for (u32 e=0; e<entries.size(); ++e)
+	{
+		entries[e].Packed = packer.insert(entries[e].Texture->getSize(), entries[e].Page, entries[e].Pos);
+		if (!entries[e].Packed)
+			continue;
+
+		while (pageTextureCount.size() <= entries[e].Page)
+			pageTextureCount.push_back(0);
+		++pageTextureCount[entries[e].Page];
+	}
+
+	const bool allowNonPower2 = Driver->getTextureCreationFlag(video::ETCF_ALLOW_NON_POWER_2);
+	const bool createMipMaps = Driver->getTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS);
+	Driver->setTextureCreationFlag(video::ETCF_ALLOW_NON_POWER_2, true);
+	Driver->setTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS, false);
+
+	u32 packed = 0;
+	for (u32 p=0; p<packer.getPageCount(); ++p)
+	{
+		video::ITexture* atlas = 0;
+
+		// a page with a single texture saves nothing
+		if (pageTextureCount[p] > 1)
+		{
+			const core::dimension2d<u32> size(pageSize.Width,
+				core::dimension2d<u32>(1, packer.getUsedHeight(p)).getOptimalSize(true, false, true, pageSize.Height).Height);
+			video::IImage* image = Driver->createImage(video::ECF_A8R8G8B8, size);
+			image->fill(video::SColor(0,0,0,0));
+
+			const io::path* name = 0;
+			for (u32 e=0; e<entries.size(); ++e)
+			{
+				if (!entries[e].Packed || entries[e].Page != p)
+					continue;
+
+				video::ITexture* texture = entries[e].Texture;
+				const void* data = texture->lock(video::ETLM_READ_ONLY);
+				if (!data)
+				{
+					entries[e].Packed = false;
+					continue;
+				}
+				u8* target = (u8*)image->getData() + entries[e].Pos.Y * image->getPitch() + entries[e].Pos.X * 4;
+				video::CColorConverter::convert_viaFormat(data, texture->getColorFormat(), texture->getPitch(),
+					target, video::ECF_A8R8G8B8, image->getPitch(), texture->getSize().Width, texture->getSize().Height);
+				texture->unlock();
+
+				if (!name)
+					name = &texture->getName().getPath();
+			}
+
+			if (name)
+			{
+				io::path atlasName(*name);
+				atlasName += "#atlas";
+				atlasName += Driver->getTextureCount();
+				atlas = Driver->addTexture(atlasName, image);
+			}
+			image->drop();
+		}
+
+		for (u32 e=0; e<entries.size(); ++e)
+		{
+			if (!entries[e].Packed || entries[e].Page != p)
+				continue;
+			entries[e].Atlas = atlas;
+			entries[e].Packed = (atlas != 0);
+			if (atlas)
+				++packed;
+		}
+	}
+
+	Driver->setTextureCreationFlag(video::ETCF_ALLOW_NON_POWER_2, allowNonPower2);
+	Driver->setTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS, createMipMaps);
+
+	if (!packed)
+		return 0;
+
+	// entry of each texture index, and the first index using the same atlas
+	core::array<s32> textureEntry(Textures.size());
+	core::array<u32> textureNumber(Textures.size());
+	for (u32 i=0; i<Textures.size(); ++i)
+	{
+		s32 entry = -1;
+		for (u32 e=0; e<entries.size() && entry < 0; ++e)
+		{
+			if (entries[e].Packed && entries[e].Texture == Textures[i])
+				entry = e;
+		}
+		textureEntry.push_back(entry);
+
+		u32 number = i;
+		for (u32 j=0; j<i && entry >= 0; ++j)
+		{
+			if (textureEntry[j] >= 0 && entries[textureEntry[j]].Atlas == entries[entry].Atlas)
+			{
+				number = j;
+				break;
+			}
+		}
+		textureNumber.push_back(number);
+	}
+
+	// which entry moved a rectangle: -1 none yet, -2 used by a texture which stays
+	core::array<s32> rectangleEntry(Rectangles.size());
+	rectangleEntry.set_used(Rectangles.size());
+	for (u32 r=0; r<rectangleEntry.size(); ++r)
+		rectangleEntry[r] = -1;
+	for (u32 s=0; s<Sprites.size(); ++s)
+	{
+		for (u32 f=0; f<Sprites[s].Frames.size(); ++f)
+		{
+			const SGUISpriteFrame& frame = Sprites[s].Frames[f];
+			if (frame.rectNumber < Rectangles.size() &&
+				(frame.textureNumber >= Textures.size() || textureEntry[frame.textureNumber] < 0))
+				rectangleEntry[frame.rectNumber] = -2;
+		}
+	}
+
+	// move the rectangles into the atlas, a rectangle also used with another texture is copied
+	for (u32 s=0; s<Sprites.size(); ++s)
+	{
+		for (u32 f=0; f<Sprites[s].Frames.size(); ++f)
+		{
+			SGUISpriteFrame& frame = Sprites[s].Frames[f];
+			if (frame.textureNumber >= Textures.size() || frame.rectNumber >= Rectangles.size())
+				continue;
+			const s32 entry = textureEntry[frame.textureNumber];
+			if (entry < 0)
+				continue;
+
+			const core::position2di offset(entries[entry].Pos.X, entries[entry].Pos.Y);
+			const s32 owner = rectangleEntry[frame.rectNumber];
+			if (owner == -1)
+			{
+				Rectangles[frame.rectNumber] += offset;
+				rectangleEntry[frame.rectNumber] = entry;
+			}
+			else if (owner != entry)
+			{
+				core::rect<s32> r(Rectangles[frame.rectNumber]);
+				if (owner >= 0)
+					r -= core::position2di(entries[owner].Pos.X, entries[owner].Pos.Y);
+				r += offset;
+				frame.rectNumber = Rectangles.size();
+				Rectangles.push_back(r);
+				rectangleEntry.push_back(entry);
+			}
+			frame.textureNumber = textureNumber[frame.textureNumber];
+		}
+	}
+
+	for (u32 i=0; i<Textures.size(); ++i)
+	{
+		if (textureEntry[i] >= 0)
+			setTexture(i, entries[textureEntry[i]].Atlas);
+	}
+
+	return packed;
+}
+
 //! Add the texture and use it for a single non-animated sprite.
 s32 CGUISpriteBank::addTextureAsSprite(video::ITexture* texture)
 {
@@ -46,6 +46,9 @@ public:
 	//! clears sprites, rectangles and textures
 	virtual void clear() _IRR_OVERRIDE_;
 
+	//! copies the textures into shared atlas textures
+	virtual u32 packTextures(const core::dimension2d<u32>& pageSize) _IRR_OVERRIDE_;
+
 	//! Draws a sprite in 2d with position and color
 	virtual void draw2DSprite(u32 index, const core::position2di& pos, const core::rect<s32>* clip=0,
 				const video::SColor& color= video::SColor(255,255,255,255),
@@ -6,6 +6,8 @@
 #include "irrString.h"
 #include "CColorConverter.h"
 #include "CBlit.h"
+#include "CImageResampler.h"
+#include "CDXTCodec.h"
 #include "os.h"
 
 namespace irr
@@ -125,8 +127,12 @@ SColor CImage::getPixel(u32 x, u32 y) const
 //! copies this surface into another at given position
 void CImage::copyTo(IImage* target, const core::position2d<s32>& pos)
 {
-	if (IImage::isCompressedFormat(Format))
+	if (IImage::isCompressedFormat(Format) || IImage::isCompressedFormat(target->getColorFormat()))
 	{
+		// compressed images are only decoded and encoded as a whole
+		if (pos == core::position2d<s32>(0,0) && CDXTCodec::convert(this, target))
+			return;
+
 		os::Printer::log("IImage::copyTo method doesn't work with compressed images.", ELL_WARNING);
 		return;
 	}
@@ -286,6 +292,59 @@ void CImage::copyToScalingBoxFilter(IImage* target, s32 bias, bool blend)
 }
 
 
+//! copies this surface into another, resampling it to fit with a filter
+void CImage::copyToResampling(IImage* target, E_IMAGE_FILTER filter, bool gammaCorrect)
+{
+	if (IImage::isCompressedFormat(Format))
+	{
+		os::Printer::log("IImage::copyToResampling method doesn't work with compressed images.", ELL_WARNING);
+		return;
+	}
+
+	if (!target)
+		return;
+
+	if (!CImageResampler::resample(this, target, filter, gammaCorrect, false))
+		copyToScaling(target);
+}
+
+
+//! generates all mip map levels, each from the level above
+bool CImage::generateMipMaps(E_IMAGE_FILTER filter, bool gammaCorrect, bool premultipliedAlpha)
+{
+	if (IImage::isCompressedFormat(Format) || !CImageResampler::isFormatSupported(Format) ||
+		!Size.Width || !Size.Height)
+		return false;
+
+	u8* data = Allocator.allocate(getMipMapsDataSizeFromFormat(Format, Size.Width, Size.Height));
+	u8* levelData = data;
+	core::dimension2d<u32> size(Size);
+	CImage* previous = 0;
+
+	do
+	{
+		if (size.Width > 1)
+			size.Width >>= 1;
+
+		if (size.Height > 1)
+			size.Height >>= 1;
+
+		CImage* level = new CImage(Format, size, levelData, true, false);
+		CImageResampler::resample(previous ? previous : this, level, filter, gammaCorrect, premultipliedAlpha);
+		if (previous)
+			previous->drop();
+		previous = level;
+
+		levelData += getDataSizeFromFormat(Format, size.Width, size.Height);
+	} while (size.Width != 1 || size.Height != 1);
+
+	previous->drop();
+
+	setMipMapsData(data, true, true);
+	return true;
+}
+
+
 //! fills the surface with given color
 void CImage::fill(const SColor &color)
 {
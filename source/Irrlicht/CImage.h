@@ -55,6 +55,12 @@ public:
 	//! copies this surface into another, scaling it to fit, applying a box filter
 	virtual void copyToScalingBoxFilter(IImage* target, s32 bias = 0, bool blend = false) _IRR_OVERRIDE_;
 
+	//! copies this surface into another, resampling it to fit with a filter
+	virtual void copyToResampling(IImage* target, E_IMAGE_FILTER filter = EIF_MITCHELL, bool gammaCorrect = false) _IRR_OVERRIDE_;
+
+	//! generates all mip map levels, each from the level above
+	virtual bool generateMipMaps(E_IMAGE_FILTER filter = EIF_BOX, bool gammaCorrect = false, bool premultipliedAlpha = false) _IRR_OVERRIDE_;
+
 	//! fills the surface with given color
 	virtual void fill(const SColor &color) _IRR_OVERRIDE_;
 
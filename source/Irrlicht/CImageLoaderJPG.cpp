@@ -8,6 +8,7 @@
 
 #include "IReadFile.h"
 #include "CImage.h"
+#include "CColorConverter.h"
 #include "os.h"
 #include "irrString.h"
 
@@ -58,6 +59,16 @@ bool CImageLoaderJPG::isALoadableFileExtension(const io::path& filename) const
         jmp_buf setjmp_buffer;
     };
 
+    // source reading the file in chunks
+    struct irr_jpeg_source_mgr
+    {
+        // public jpeg source fields
+        struct jpeg_source_mgr pub;
+
+        io::IReadFile* file;
+        JOCTET buffer[4096];
+    };
+
 void CImageLoaderJPG::init_source (j_decompress_ptr cinfo)
 {
 	// DO NOTHING
@@ -67,7 +78,17 @@ void CImageLoaderJPG::init_source (j_decompress_ptr cinfo)
 
 boolean CImageLoaderJPG::fill_input_buffer (j_decompress_ptr cinfo)
 {
-	// DO NOTHING
+	irr_jpeg_source_mgr* src = (irr_jpeg_source_mgr*)cinfo->src;
+	size_t count = src->file->read(src->buffer, sizeof(src->buffer));
+	if (count == 0)
+	{
+		// insert a fake EOI marker for truncated files, like the stdio source of jpeglib
+		src->buffer[0] = (JOCTET)0xFF;
+		src->buffer[1] = (JOCTET)JPEG_EOI;
+		count = 2;
+	}
+	src->pub.next_input_byte = src->buffer;
+	src->pub.bytes_in_buffer = count;
 	return TRUE;
 }
 
@@ -78,6 +99,11 @@ void CImageLoaderJPG::skip_input_data (j_decompress_ptr cinfo, long count)
 	jpeg_source_mgr * src = cinfo->src;
 	if(count > 0)
 	{
+		while (count > (long)src->bytes_in_buffer)
+		{
+			count -= (long)src->bytes_in_buffer;
+			fill_input_buffer(cinfo);
+		}
 		src->bytes_in_buffer -= count;
 		src->next_input_byte += count;
 	}
@@ -133,6 +159,44 @@ bool CImageLoaderJPG::isALoadableFileFormat(io::IReadFile* file) const
 	#endif
 }
 
+#ifdef _IRR_COMPILE_WITH_LIBJPEG_
+bool CImageLoaderJPG::readHeader(j_decompress_ptr cinfo, io::IReadFile* file)
+{
+	// specify data source, allocated in the pool of cinfo like the stdio source
+	irr_jpeg_source_mgr* src = (irr_jpeg_source_mgr*)(*cinfo->mem->alloc_small)
+		((j_common_ptr)cinfo, JPOOL_PERMANENT, sizeof(irr_jpeg_source_mgr));
+	src->file = file;
+	src->pub.bytes_in_buffer = 0;
+	src->pub.next_input_byte = 0;
+	src->pub.init_source = init_source;
+	src->pub.fill_input_buffer = fill_input_buffer;
+	src->pub.skip_input_data = skip_input_data;
+	src->pub.resync_to_restart = jpeg_resync_to_restart;
+	src->pub.term_source = term_source;
+	cinfo->src = &src->pub;
+
+	// read file parameters with jpeg_read_header()
+	jpeg_read_header(cinfo, TRUE);
+
+	bool useCMYK=false;
+	if (cinfo->jpeg_color_space==JCS_CMYK)
+	{
+		cinfo->out_color_space=JCS_CMYK;
+		cinfo->out_color_components=4;
+		useCMYK=true;
+	}
+	else
+	{
+		cinfo->out_color_space=JCS_RGB;
+		cinfo->out_color_components=3;
+	}
+	cinfo->output_gamma=2.2;
+	cinfo->do_fancy_upsampling=FALSE;
+
+	return useCMYK;
+}
+#endif // _IRR_COMPILE_WITH_LIBJPEG_
+
 //! creates a surface from the file
 IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 {
@@ -144,11 +208,75 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	if (!file)
 		return 0;
 
+	const long pos = file->getPos();
+	core::dimension2d<u32> size;
+	ECOLOR_FORMAT format;
+	if (!getImageInfo(file, size, format) || !file->seek(pos))
+		return 0;
+
+	IImage* image = new CImage(format, size);
+	if (!loadImageInto(file, image->getData(), format, image->getPitch()))
+	{
+		image->drop();
+		return 0;
+	}
+
+	return image;
+
+	#endif
+}
+
+
+//! reads the size and color format of the image in the file
+bool CImageLoaderJPG::getImageInfo(io::IReadFile* file, core::dimension2d<u32>& size, ECOLOR_FORMAT& format) const
+{
+	#ifndef _IRR_COMPILE_WITH_LIBJPEG_
+	return false;
+	#else
+
+	if (!file)
+		return false;
+
 	Filename = file->getFileName();
 
-	u8 **rowPtr=0;
-	u8* input = new u8[file->getSize()];
-	file->read(input, file->getSize());
+	struct jpeg_decompress_struct cinfo;
+	struct irr_jpeg_error_mgr jerr;
+
+	cinfo.err = jpeg_std_error(&jerr.pub);
+	cinfo.err->error_exit = error_exit;
+	cinfo.err->output_message = output_message;
+
+	if (setjmp(jerr.setjmp_buffer))
+	{
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	readHeader(&cinfo, file);
+	jpeg_calc_output_dimensions(&cinfo);
+
+	size.set(cinfo.output_width, cinfo.output_height);
+	format = ECF_R8G8B8;
+
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+
+	#endif
+}
+
+
+//! decodes the image in the file row by row into target
+bool CImageLoaderJPG::loadImageInto(io::IReadFile* file, void* target, ECOLOR_FORMAT format, u32 pitch) const
+{
+	#ifndef _IRR_COMPILE_WITH_LIBJPEG_
+	return false;
+	#else
+
+	if (!file || !target || !CColorConverter::canConvert_viaFormat(ECF_R8G8B8, format))
+		return false;
+
+	Filename = file->getFileName();
 
 	// allocate and initialize JPEG decompression object
 	struct jpeg_decompress_struct cinfo;
@@ -170,119 +298,65 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	{
 		// If we get here, the JPEG code has signaled an error.
 		// We need to clean up the JPEG object and return.
-
+		// The row buffer is allocated from the pool of cinfo.
 		jpeg_destroy_decompress(&cinfo);
-
-		delete [] input;
-		delete [] rowPtr;
-
-		// return null pointer
-		return 0;
+		return false;
 	}
 
 	// Now we can initialize the JPEG decompression object.
 	jpeg_create_decompress(&cinfo);
 
-	// specify data source
-	jpeg_source_mgr jsrc;
-
-	// Set up data pointer
-	jsrc.bytes_in_buffer = file->getSize();
-	jsrc.next_input_byte = (JOCTET*)input;
-	cinfo.src = &jsrc;
-
-	jsrc.init_source = init_source;
-	jsrc.fill_input_buffer = fill_input_buffer;
-	jsrc.skip_input_data = skip_input_data;
-	jsrc.resync_to_restart = jpeg_resync_to_restart;
-	jsrc.term_source = term_source;
-
-	// Decodes JPG input from whatever source
-	// Does everything AFTER jpeg_create_decompress
-	// and BEFORE jpeg_destroy_decompress
-	// Caller is responsible for arranging these + setting up cinfo
-
-	// read file parameters with jpeg_read_header()
-	jpeg_read_header(&cinfo, TRUE);
-
-	bool useCMYK=false;
-	if (cinfo.jpeg_color_space==JCS_CMYK)
-	{
-		cinfo.out_color_space=JCS_CMYK;
-		cinfo.out_color_components=4;
-		useCMYK=true;
-	}
-	else
-	{
-		cinfo.out_color_space=JCS_RGB;
-		cinfo.out_color_components=3;
-	}
-	cinfo.output_gamma=2.2;
-	cinfo.do_fancy_upsampling=FALSE;
+	const bool useCMYK = readHeader(&cinfo, file);
 
 	// Start decompressor
 	jpeg_start_decompress(&cinfo);
 
-	// Get image data
-	u16 rowspan = cinfo.image_width * cinfo.out_color_components;
-	u32 width = cinfo.image_width;
-	u32 height = cinfo.image_height;
+	const u32 width = cinfo.output_width;
 
-	// Allocate memory for buffer
-	u8* output = new u8[rowspan * height];
+	// RGB rows go straight into target, others are converted from a single row
+	JSAMPROW row = 0;
+	if (useCMYK || format != ECF_R8G8B8)
+		row = (JSAMPROW)(*cinfo.mem->alloc_small)((j_common_ptr)&cinfo, JPOOL_IMAGE,
+			width * cinfo.out_color_components);
 
 	// Here we use the library's state variable cinfo.output_scanline as the
 	// loop counter, so that we don't have to keep track ourselves.
-	// Create array of row pointers for lib
-	rowPtr = new u8* [height];
-
-	for( u32 i = 0; i < height; i++ )
-		rowPtr[i] = &output[ i * rowspan ];
-
-	u32 rowsRead = 0;
-
+	u8* dest = (u8*)target;
 	while( cinfo.output_scanline < cinfo.output_height )
-		rowsRead += jpeg_read_scanlines( &cinfo, &rowPtr[rowsRead], cinfo.output_height - rowsRead );
-
-	delete [] rowPtr;
-	// Finish decompression
-
-	jpeg_finish_decompress(&cinfo);
-
-	// Release JPEG decompression object
-	// This is an important step since it will release a good deal of memory.
-	jpeg_destroy_decompress(&cinfo);
-
-	// convert image
-	IImage* image = 0;
-	if (useCMYK)
 	{
-		image = new CImage(ECF_R8G8B8,
-				core::dimension2d<u32>(width, height));
-		const u32 size = 3*width*height;
-		u8* data = (u8*)image->getData();
-		if (data)
+		JSAMPROW line = row ? row : (JSAMPROW)dest;
+		jpeg_read_scanlines(&cinfo, &line, 1);
+
+		if (useCMYK)
 		{
-			for (u32 i=0,j=0; i<size; i+=3, j+=4)
+			// convert in place, the RGB pixels are smaller
+			for (u32 i=0,j=0; i<3*width; i+=3, j+=4)
 			{
 				// Also works without K, but has more contrast with K multiplied in
-//				data[i+0] = output[j+2];
-//				data[i+1] = output[j+1];
-//				data[i+2] = output[j+0];
-				data[i+0] = (char)(output[j+2]*(output[j+3]/255.f));
-				data[i+1] = (char)(output[j+1]*(output[j+3]/255.f));
-				data[i+2] = (char)(output[j+0]*(output[j+3]/255.f));
+//				row[i+0] = row[j+2];
+//				row[i+1] = row[j+1];
+//				row[i+2] = row[j+0];
+				const f32 k = row[j+3]/255.f;
+				const u8 c = row[j+0];
+				row[i+0] = (char)(row[j+2]*k);
+				row[i+1] = (char)(row[j+1]*k);
+				row[i+2] = (char)(c*k);
 			}
 		}
-		delete [] output;
+		if (row)
+			CColorConverter::convert_viaFormat(row, ECF_R8G8B8, width, dest, format);
+
+		dest += pitch;
 	}
-	else
-		image = new CImage(ECF_R8G8B8,
-				core::dimension2d<u32>(width, height), output);
 
-	delete [] input;
+	// Finish decompression
+	jpeg_finish_decompress(&cinfo);
 
-	return image;
+	// Release JPEG decompression object
+	// This is an important step since it will release a good deal of memory.
+	jpeg_destroy_decompress(&cinfo);
+
+	return true;
 
 	#endif
 }
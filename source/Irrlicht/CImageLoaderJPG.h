@@ -51,6 +51,12 @@ public:
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const _IRR_OVERRIDE_;
 
+	//! reads the size and color format of the image in the file
+	virtual bool getImageInfo(io::IReadFile* file, core::dimension2d<u32>& size, ECOLOR_FORMAT& format) const _IRR_OVERRIDE_;
+
+	//! decodes the image in the file row by row into target
+	virtual bool loadImageInto(io::IReadFile* file, void* target, ECOLOR_FORMAT format, u32 pitch) const _IRR_OVERRIDE_;
+
 private:
 
 #ifdef _IRR_COMPILE_WITH_LIBJPEG_
@@ -100,6 +106,10 @@ private:
 	data has been read. Often a no-op. */
 	static void term_source (j_decompress_ptr cinfo);
 
+	/* Reads the header and selects RGB output, or CMYK for CMYK files.
+	Returns true for CMYK. Needs a setjmp of the caller. */
+	static bool readHeader(j_decompress_ptr cinfo, io::IReadFile* file);
+
 	// Copy filename to have it around for error-messages
 	static io::path Filename;
 
@@ -15,6 +15,7 @@
 #endif // _IRR_COMPILE_WITH_LIBPNG_
 
 #include "CImage.h"
+#include "CColorConverter.h"
 #include "CReadFile.h"
 #include "os.h"
 
@@ -85,187 +86,209 @@ bool CImageLoaderPng::isALoadableFileFormat(io::IReadFile* file) const
 }
 
 
-// load in the image data
-IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
-{
 #ifdef _IRR_COMPILE_WITH_LIBPNG_
-	if (!file)
-		return 0;
-
-	video::IImage* image = 0;
-	//Used to point to image rows
-	u8** RowPointers = 0;
-
-	png_byte buffer[8];
-	// Read the first few bytes of the PNG file
-	if( file->read(buffer, 8) != 8 )
-	{
-		os::Printer::log("LOAD PNG: can't read file\n", file->getFileName(), ELL_ERROR);
-		return 0;
-	}
+namespace
+{
 
-	// Check if it really is a PNG file
-	if( png_sig_cmp(buffer, 0, 8) )
-	{
-		os::Printer::log("LOAD PNG: not really a png\n", file->getFileName(), ELL_ERROR);
-		return 0;
-	}
+// Owns the png structs while a file is read
+struct SPngReader
+{
+	SPngReader() : png_ptr(0), info_ptr(0), Rows(0), Row(0), Width(0), Height(0),
+		Format(ECF_UNKNOWN), Interlaced(false) {}
 
-	// Allocate the png read struct
-	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
-		NULL, (png_error_ptr)png_cpexcept_error, (png_error_ptr)png_cpexcept_warn);
-	if (!png_ptr)
+	~SPngReader()
 	{
-		os::Printer::log("LOAD PNG: Internal PNG create read struct failure\n", file->getFileName(), ELL_ERROR);
-		return 0;
+		if (png_ptr)
+			png_destroy_read_struct(&png_ptr, info_ptr ? &info_ptr : NULL, NULL);
+		delete [] Rows;
+		delete [] Row;
 	}
 
-	// Allocate the png info struct
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (!info_ptr)
+	// checks the signature and allocates the png structs
+	bool create(io::IReadFile* file)
 	{
-		os::Printer::log("LOAD PNG: Internal PNG create info struct failure\n", file->getFileName(), ELL_ERROR);
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
-		return 0;
+		png_byte buffer[8];
+		// Read the first few bytes of the PNG file
+		if( file->read(buffer, 8) != 8 )
+		{
+			os::Printer::log("LOAD PNG: can't read file\n", file->getFileName(), ELL_ERROR);
+			return false;
+		}
+
+		// Check if it really is a PNG file
+		if( png_sig_cmp(buffer, 0, 8) )
+		{
+			os::Printer::log("LOAD PNG: not really a png\n", file->getFileName(), ELL_ERROR);
+			return false;
+		}
+
+		// Allocate the png read struct
+		png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+			NULL, (png_error_ptr)png_cpexcept_error, (png_error_ptr)png_cpexcept_warn);
+		if (!png_ptr)
+		{
+			os::Printer::log("LOAD PNG: Internal PNG create read struct failure\n", file->getFileName(), ELL_ERROR);
+			return false;
+		}
+
+		// Allocate the png info struct
+		info_ptr = png_create_info_struct(png_ptr);
+		if (!info_ptr)
+		{
+			os::Printer::log("LOAD PNG: Internal PNG create info struct failure\n", file->getFileName(), ELL_ERROR);
+			return false;
+		}
+
+		// changed by zola so we don't need to have public FILE pointers
+		png_set_read_fn(png_ptr, file, user_read_data_fcn);
+
+		png_set_sig_bytes(png_ptr, 8); // Tell png that we read the signature
+		return true;
 	}
 
-	// for proper error handling
-	if (setjmp(png_jmpbuf(png_ptr)))
+	// reads the info section and sets up the transformations to 8 bit BGR(A)
+	// needs a setjmp of the caller for error handling
+	void readInfo()
 	{
-		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-		delete [] RowPointers;
-		return 0;
-	}
+		png_read_info(png_ptr, info_ptr); // Read the info section of the png file
+
+		s32 BitDepth;
+		s32 ColorType;
+		s32 InterlaceType;
+		{
+			// Use temporary variables to avoid passing cast pointers
+			png_uint_32 w,h;
+			// Extract info
+			png_get_IHDR(png_ptr, info_ptr,
+				&w, &h,
+				&BitDepth, &ColorType, &InterlaceType, NULL, NULL);
+			Width=w;
+			Height=h;
+		}
+		Interlaced = (InterlaceType != PNG_INTERLACE_NONE);
+
+		// Convert palette color to true color
+		if (ColorType==PNG_COLOR_TYPE_PALETTE)
+			png_set_palette_to_rgb(png_ptr);
+
+		// Convert low bit colors to 8 bit colors
+		if (BitDepth < 8)
+		{
+			if (ColorType==PNG_COLOR_TYPE_GRAY || ColorType==PNG_COLOR_TYPE_GRAY_ALPHA)
+				png_set_expand_gray_1_2_4_to_8(png_ptr);
+			else
+				png_set_packing(png_ptr);
+		}
+
+		if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+			png_set_tRNS_to_alpha(png_ptr);
+
+		// Convert high bit colors to 8 bit colors
+		if (BitDepth == 16)
+			png_set_strip_16(png_ptr);
+
+		// Convert gray color to true color
+		if (ColorType==PNG_COLOR_TYPE_GRAY || ColorType==PNG_COLOR_TYPE_GRAY_ALPHA)
+			png_set_gray_to_rgb(png_ptr);
 
-	// changed by zola so we don't need to have public FILE pointers
-	png_set_read_fn(png_ptr, file, user_read_data_fcn);
+		int intent;
+		const double screen_gamma = 2.2;
 
-	png_set_sig_bytes(png_ptr, 8); // Tell png that we read the signature
+		if (png_get_sRGB(png_ptr, info_ptr, &intent))
+			png_set_gamma(png_ptr, screen_gamma, 0.45455);
+		else
+		{
+			double image_gamma;
+			if (png_get_gAMA(png_ptr, info_ptr, &image_gamma))
+				png_set_gamma(png_ptr, screen_gamma, image_gamma);
+			else
+				png_set_gamma(png_ptr, screen_gamma, 0.45455);
+		}
+
+		// Update the changes in between, as we need to get the new color type
+		// for proper processing of the RGBA type
+		png_read_update_info(png_ptr, info_ptr);
+		{
+			// Use temporary variables to avoid passing cast pointers
+			png_uint_32 w,h;
+			// Extract info
+			png_get_IHDR(png_ptr, info_ptr,
+				&w, &h,
+				&BitDepth, &ColorType, NULL, NULL, NULL);
+			Width=w;
+			Height=h;
+		}
+
+		// Convert RGBA to BGRA
+		if (ColorType==PNG_COLOR_TYPE_RGB_ALPHA)
+		{
+#ifdef __BIG_ENDIAN__
+			png_set_swap_alpha(png_ptr);
+#else
+			png_set_bgr(png_ptr);
+#endif
+		}
 
-	png_read_info(png_ptr, info_ptr); // Read the info section of the png file
+		Format = (ColorType==PNG_COLOR_TYPE_RGB_ALPHA) ? ECF_A8R8G8B8 : ECF_R8G8B8;
+	}
 
+	png_structp png_ptr;
+	png_infop info_ptr;
+	// row pointers and row buffer, allocated after the setjmp of the caller
+	u8** Rows;
+	u8* Row;
 	u32 Width;
 	u32 Height;
-	s32 BitDepth;
-	s32 ColorType;
-	{
-		// Use temporary variables to avoid passing cast pointers
-		png_uint_32 w,h;
-		// Extract info
-		png_get_IHDR(png_ptr, info_ptr,
-			&w, &h,
-			&BitDepth, &ColorType, NULL, NULL, NULL);
-		Width=w;
-		Height=h;
-	}
-
-	// Convert palette color to true color
-	if (ColorType==PNG_COLOR_TYPE_PALETTE)
-		png_set_palette_to_rgb(png_ptr);
-
-	// Convert low bit colors to 8 bit colors
-	if (BitDepth < 8)
-	{
-		if (ColorType==PNG_COLOR_TYPE_GRAY || ColorType==PNG_COLOR_TYPE_GRAY_ALPHA)
-			png_set_expand_gray_1_2_4_to_8(png_ptr);
-		else
-			png_set_packing(png_ptr);
-	}
+	ECOLOR_FORMAT Format;
+	bool Interlaced;
+};
 
-	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
-		png_set_tRNS_to_alpha(png_ptr);
-
-	// Convert high bit colors to 8 bit colors
-	if (BitDepth == 16)
-		png_set_strip_16(png_ptr);
+} // end anonymous namespace
+#endif // _IRR_COMPILE_WITH_LIBPNG_
 
-	// Convert gray color to true color
-	if (ColorType==PNG_COLOR_TYPE_GRAY || ColorType==PNG_COLOR_TYPE_GRAY_ALPHA)
-		png_set_gray_to_rgb(png_ptr);
 
-	int intent;
-	const double screen_gamma = 2.2;
+// load in the image data
+IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
+{
+#ifdef _IRR_COMPILE_WITH_LIBPNG_
+	if (!file)
+		return 0;
 
-	if (png_get_sRGB(png_ptr, info_ptr, &intent))
-		png_set_gamma(png_ptr, screen_gamma, 0.45455);
-	else
-	{
-		double image_gamma;
-		if (png_get_gAMA(png_ptr, info_ptr, &image_gamma))
-			png_set_gamma(png_ptr, screen_gamma, image_gamma);
-		else
-			png_set_gamma(png_ptr, screen_gamma, 0.45455);
-	}
+	SPngReader reader;
+	if (!reader.create(file))
+		return 0;
 
-	// Update the changes in between, as we need to get the new color type
-	// for proper processing of the RGBA type
-	png_read_update_info(png_ptr, info_ptr);
-	{
-		// Use temporary variables to avoid passing cast pointers
-		png_uint_32 w,h;
-		// Extract info
-		png_get_IHDR(png_ptr, info_ptr,
-			&w, &h,
-			&BitDepth, &ColorType, NULL, NULL, NULL);
-		Width=w;
-		Height=h;
-	}
+	// for proper error handling
+	if (setjmp(png_jmpbuf(reader.png_ptr)))
+		return 0;
 
-	// Convert RGBA to BGRA
-	if (ColorType==PNG_COLOR_TYPE_RGB_ALPHA)
-	{
-#ifdef __BIG_ENDIAN__
-		png_set_swap_alpha(png_ptr);
-#else
-		png_set_bgr(png_ptr);
-#endif
-	}
+	reader.readInfo();
 
 	// Create the image structure to be filled by png data
-	if (ColorType==PNG_COLOR_TYPE_RGB_ALPHA)
-		image = new CImage(ECF_A8R8G8B8, core::dimension2d<u32>(Width, Height));
-	else
-		image = new CImage(ECF_R8G8B8, core::dimension2d<u32>(Width, Height));
-	if (!image)
-	{
-		os::Printer::log("LOAD PNG: Internal PNG create image struct failure\n", file->getFileName(), ELL_ERROR);
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
-		return 0;
-	}
+	video::IImage* image = new CImage(reader.Format, core::dimension2d<u32>(reader.Width, reader.Height));
 
 	// Create array of pointers to rows in image data
-	RowPointers = new png_bytep[Height];
-	if (!RowPointers)
-	{
-		os::Printer::log("LOAD PNG: Internal PNG create row pointers failure\n", file->getFileName(), ELL_ERROR);
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
-		delete image;
-		return 0;
-	}
+	reader.Rows = new png_bytep[reader.Height];
 
 	// Fill array of pointers to rows in image data
 	unsigned char* data = (unsigned char*)image->getData();
-	for (u32 i=0; i<Height; ++i)
+	for (u32 i=0; i<reader.Height; ++i)
 	{
-		RowPointers[i]=data;
+		reader.Rows[i]=data;
 		data += image->getPitch();
 	}
 
 	// for proper error handling
-	if (setjmp(png_jmpbuf(png_ptr)))
+	if (setjmp(png_jmpbuf(reader.png_ptr)))
 	{
-		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-		delete [] RowPointers;
-		delete image;
+		image->drop();
 		return 0;
 	}
 
 	// Read data using the library function that handles all transformations including interlacing
-	png_read_image(png_ptr, RowPointers);
+	png_read_image(reader.png_ptr, reader.Rows);
 
-	png_read_end(png_ptr, NULL);
-	delete [] RowPointers;
-	png_destroy_read_struct(&png_ptr,&info_ptr, 0); // Clean up memory
+	png_read_end(reader.png_ptr, NULL);
 
 	return image;
 #else
@@ -274,6 +297,83 @@ IImage* CImageLoaderPng::loadImage(io::IReadFile* file) const
 }
 
 
+//! reads the size and color format of the image
+bool CImageLoaderPng::getImageInfo(io::IReadFile* file, core::dimension2d<u32>& size, ECOLOR_FORMAT& format) const
+{
+#ifdef _IRR_COMPILE_WITH_LIBPNG_
+	if (!file)
+		return false;
+
+	SPngReader reader;
+	if (!reader.create(file))
+		return false;
+
+	if (setjmp(png_jmpbuf(reader.png_ptr)))
+		return false;
+
+	reader.readInfo();
+
+	// the passes of interlaced images need the whole image, use loadImage
+	if (reader.Interlaced)
+		return false;
+
+	size.set(reader.Width, reader.Height);
+	format = reader.Format;
+	return true;
+#else
+	return false;
+#endif // _IRR_COMPILE_WITH_LIBPNG_
+}
+
+
+//! decodes the image row by row into target
+bool CImageLoaderPng::loadImageInto(io::IReadFile* file, void* target, ECOLOR_FORMAT format, u32 pitch) const
+{
+#ifdef _IRR_COMPILE_WITH_LIBPNG_
+	if (!file || !target)
+		return false;
+
+	SPngReader reader;
+	if (!reader.create(file))
+		return false;
+
+	if (setjmp(png_jmpbuf(reader.png_ptr)))
+		return false;
+
+	reader.readInfo();
+
+	if (reader.Interlaced || !CColorConverter::canConvert_viaFormat(reader.Format, format))
+		return false;
+
+	// rows in the format of the file go straight into target, others
+	// are converted from a single row
+	const bool convert = (format != reader.Format);
+	if (convert)
+	{
+		reader.Row = new u8[reader.Width * IImage::getBitsPerPixelFromFormat(reader.Format) / 8];
+	}
+
+	u8* dest = (u8*)target;
+	for (u32 y=0; y<reader.Height; ++y)
+	{
+		if (convert)
+		{
+			png_read_row(reader.png_ptr, reader.Row, NULL);
+			CColorConverter::convert_viaFormat(reader.Row, reader.Format, reader.Width, dest, format);
+		}
+		else
+			png_read_row(reader.png_ptr, dest, NULL);
+		dest += pitch;
+	}
+
+	png_read_end(reader.png_ptr, NULL);
+	return true;
+#else
+	return false;
+#endif // _IRR_COMPILE_WITH_LIBPNG_
+}
+
+
 IImageLoader* createImageLoaderPNG()
 {
 	return new CImageLoaderPng();
@@ -34,6 +34,12 @@ public:
 
 	//! creates a surface from the file
 	virtual IImage* loadImage(io::IReadFile* file) const _IRR_OVERRIDE_;
+
+	//! reads the size and color format of the image in the file
+	virtual bool getImageInfo(io::IReadFile* file, core::dimension2d<u32>& size, ECOLOR_FORMAT& format) const _IRR_OVERRIDE_;
+
+	//! decodes the image in the file row by row into target
+	virtual bool loadImageInto(io::IReadFile* file, void* target, ECOLOR_FORMAT format, u32 pitch) const _IRR_OVERRIDE_;
 };
 
 
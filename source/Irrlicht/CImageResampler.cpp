@@ -0,0 +1,445 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CImageResampler.h"
+#include "CColorConverter.h"
+#include "CWorkerPool.h"
+#include "irrMath.h"
+#include <math.h>
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace video
+{
+
+namespace
+{
+	//! Fixed point bits of the filter weights
+	const u32 WeightBits = 14;
+	//! Fixed point bits of the channels while filtering
+	const u32 ChannelBits = 6;
+	//! Channel value 255 while filtering
+	const s32 ChannelMax = 255 << ChannelBits;
+	//! Target pixels per range when the passes are spread over the worker threads
+	const u32 ResampleGrainPixels = 16384;
+
+	//! Radius of a filter in source pixels, when not shrinking
+	f32 getFilterRadius(E_IMAGE_FILTER filter)
+	{
+		switch (filter)
+		{
+			case EIF_BILINEAR:
+				return 1.f;
+			case EIF_MITCHELL:
+				return 2.f;
+			case EIF_LANCZOS:
+				return 3.f;
+			default:
+				return 0.5f;
+		}
+	}
+
+	//! Weight of a filter at distance x from its center
+	f32 getFilterWeight(E_IMAGE_FILTER filter, f32 x)
+	{
+		switch (filter)
+		{
+			case EIF_BILINEAR:
+				x = fabsf(x);
+				return x < 1.f ? 1.f - x : 0.f;
+			case EIF_MITCHELL:
+			{
+				const f32 B = 1.f / 3.f;
+				const f32 C = 1.f / 3.f;
+				x = fabsf(x);
+				if (x < 1.f)
+					return ((12.f - 9.f*B - 6.f*C)*x*x*x + (-18.f + 12.f*B + 6.f*C)*x*x + (6.f - 2.f*B)) / 6.f;
+				if (x < 2.f)
+					return ((-B - 6.f*C)*x*x*x + (6.f*B + 30.f*C)*x*x + (-12.f*B - 48.f*C)*x + (8.f*B + 24.f*C)) / 6.f;
+				return 0.f;
+			}
+			case EIF_LANCZOS:
+			{
+				x = fabsf(x);
+				if (x < 1e-5f)
+					return 1.f;
+				if (x >= 3.f)
+					return 0.f;
+				const f32 px = core::PI * x;
+				return 3.f * sinf(px) * sinf(px / 3.f) / (px * px);
+			}
+			default:
+				// half open, so each source pixel belongs to one target pixel when enlarging
+				return (x >= -0.5f && x < 0.5f) ? 1.f : 0.f;
+		}
+	}
+
+	//! Fixed point weights of the source pixels for each target pixel along one axis
+	/** All target pixels use the same even number of taps, so the inner loops
+	can work on pairs. The taps may reach one pixel behind the source, where
+	the passes keep a zero pixel. */
+	struct SFilterWeights
+	{
+		SFilterWeights(E_IMAGE_FILTER filter, u32 sourceSize, u32 targetSize);
+
+		//! Pair of weights for _mm_madd_epi16
+		u32 getPair(u32 target, u32 tap) const
+		{
+			const s16* w = &Weights[target * Taps + tap];
+			return (u16)w[0] | ((u32)(u16)w[1] << 16);
+		}
+
+		//! First source pixel of each target pixel
+		core::array<u32> First;
+		//! Taps weights for each target pixel, adding up to 1 << WeightBits
+		core::array<s16> Weights;
+		u32 Taps;
+	};
+
+	SFilterWeights::SFilterWeights(E_IMAGE_FILTER filter, u32 sourceSize, u32 targetSize)
+	{
+		const f32 scale = (f32)sourceSize / (f32)targetSize;
+		// widen the filter when shrinking, so it covers all source pixels
+		const f32 filterScale = core::max_(scale, 1.f);
+		const f32 support = getFilterRadius(filter) * filterScale;
+
+		// widest window of all target pixels
+		Taps = 1;
+		for (u32 i=0; i<targetSize; ++i)
+		{
+			const f32 center = (i + 0.5f) * scale - 0.5f;
+			Taps = core::max_(Taps, (u32)(core::floor32(center + support) - core::ceil32(center - support) + 1));
+		}
+		Taps = core::min_(Taps, sourceSize);
+		Taps = (Taps + 1) & ~1u;
+
+		First.set_used(targetSize);
+		Weights.set_used(targetSize * Taps);
+
+		core::array<f32> weights;
+		weights.set_used(Taps);
+
+		for (u32 i=0; i<targetSize; ++i)
+		{
+			const f32 center = (i + 0.5f) * scale - 0.5f;
+			const s32 low = core::ceil32(center - support);
+			const s32 high = core::floor32(center + support);
+			const s32 last = (s32)sourceSize - 1;
+
+			First[i] = core::min_((u32)core::s32_clamp(low, 0, last), sourceSize + 1 - Taps);
+
+			for (u32 k=0; k<Taps; ++k)
+				weights[k] = 0.f;
+
+			// pixels outside of the image repeat the border pixels
+			f32 sum = 0.f;
+			for (s32 j=low; j<=high; ++j)
+			{
+				const f32 weight = getFilterWeight(filter, (j - center) / filterScale);
+				weights[core::s32_clamp(j, 0, last) - First[i]] += weight;
+				sum += weight;
+			}
+			if (sum == 0.f)
+			{
+				weights[core::s32_clamp(core::round32(center), 0, last) - First[i]] = 1.f;
+				sum = 1.f;
+			}
+
+			// the largest weight takes the rounding error, so the weights add up exactly
+			s16* w = &Weights[i * Taps];
+			s32 total = 0;
+			u32 largest = 0;
+			for (u32 k=0; k<Taps; ++k)
+			{
+				w[k] = (s16)core::round32(weights[k] / sum * (1 << WeightBits));
+				total += w[k];
+				if (w[k] > w[largest])
+					largest = k;
+			}
+			w[largest] += (s16)((1 << WeightBits) - total);
+		}
+	}
+
+	//! Data shared by the passes
+	struct SResampleData
+	{
+		const IImage* Source;
+		IImage* Target;
+		const SFilterWeights* Columns;
+		const SFilterWeights* Rows;
+		//! Source rows filtered horizontally, 4 channels per pixel
+		s16* Filtered;
+		//! Pixels per row in Filtered, even
+		u32 FilteredWidth;
+		//! 8 bit sRGB to linear and back, 0 when not gamma correct
+		const s16* ToLinear;
+		const u8* ToSRGB;
+		//! Colors are weighted with their alpha while filtering
+		bool PremultipliedAlpha;
+		//! Scratch memory of each worker
+		core::array<u32> Scratch;
+		core::array<s16> ScratchRows;
+	};
+
+	//! Filters source rows horizontally into the filtered rows
+	struct SFilterColumnsJob
+	{
+		SFilterColumnsJob(SResampleData& data) : Data(data) {}
+
+		void operator()(u32 begin, u32 end, u32 worker) const
+		{
+			const u32 sourceWidth = Data.Source->getDimension().Width;
+			const u32 targetWidth = Data.Target->getDimension().Width;
+			const ECOLOR_FORMAT format = Data.Source->getColorFormat();
+			const SFilterWeights& weights = *Data.Columns;
+
+			u32* argb = &Data.Scratch[worker * core::max_(sourceWidth, Data.FilteredWidth)];
+			// the pixel behind the row stays 0
+			s16* row = &Data.ScratchRows[worker * (sourceWidth + 1) * 4];
+
+			for (u32 y=begin; y<end; ++y)
+			{
+				const u8* source = (const u8*)Data.Source->getData() + y * Data.Source->getPitch();
+				const u32* pixels = (const u32*)source;
+				if (format != ECF_A8R8G8B8)
+				{
+					CColorConverter::convert_viaFormat(source, format, sourceWidth, argb, ECF_A8R8G8B8);
+					pixels = argb;
+				}
+
+				for (u32 x=0; x<sourceWidth; ++x)
+				{
+					const u32 c = pixels[x];
+					s16* p = row + x * 4;
+					if (Data.ToLinear)
+					{
+						p[0] = Data.ToLinear[c & 0xFF];
+						p[1] = Data.ToLinear[(c >> 8) & 0xFF];
+						p[2] = Data.ToLinear[(c >> 16) & 0xFF];
+					}
+					else
+					{
+						p[0] = (s16)((c & 0xFF) << ChannelBits);
+						p[1] = (s16)(((c >> 8) & 0xFF) << ChannelBits);
+						p[2] = (s16)(((c >> 16) & 0xFF) << ChannelBits);
+					}
+					p[3] = (s16)((c >> 24) << ChannelBits);
+					if (Data.PremultipliedAlpha)
+					{
+						const s32 alpha = c >> 24;
+						for (u32 j=0; j<3; ++j)
+							p[j] = (s16)((p[j] * alpha + 127) / 255);
+					}
+				}
+
+				s16* out = Data.Filtered + y * Data.FilteredWidth * 4;
+				for (u32 x=0; x<targetWidth; ++x)
+				{
+					const s16* p = row + weights.First[x] * 4;
+#ifdef _IRR_COMPILE_WITH_SSE2_
+					__m128i sum = _mm_set1_epi32(1 << (WeightBits - 1));
+					for (u32 t=0; t<weights.Taps; t+=2, p+=8)
+					{
+						// interleave the channels of two pixels, so each 32 bit lane sums one channel
+						const __m128i v = _mm_loadu_si128((const __m128i*)p);
+						const __m128i pair = _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+						sum = _mm_add_epi32(sum, _mm_madd_epi16(pair, _mm_set1_epi32(weights.getPair(x, t))));
+					}
+					sum = _mm_srai_epi32(sum, WeightBits);
+					_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packs_epi32(sum, sum));
+#else
+					const s16* w = &weights.Weights[x * weights.Taps];
+					s32 sum[4] = { 0, 0, 0, 0 };
+					for (u32 t=0; t<weights.Taps; ++t, p+=4)
+					{
+						for (u32 c=0; c<4; ++c)
+							sum[c] += p[c] * w[t];
+					}
+					for (u32 c=0; c<4; ++c)
+						out[x * 4 + c] = (s16)core::s32_clamp((sum[c] + (1 << (WeightBits - 1))) >> WeightBits, -32768, 32767);
+#endif
+				}
+				for (u32 x=targetWidth; x<Data.FilteredWidth; ++x)
+					out[x * 4] = out[x * 4 + 1] = out[x * 4 + 2] = out[x * 4 + 3] = 0;
+			}
+		}
+
+		SResampleData& Data;
+	};
+
+	//! Filters the filtered rows vertically into target rows
+	struct SFilterRowsJob
+	{
+		SFilterRowsJob(SResampleData& data) : Data(data) {}
+
+		void operator()(u32 begin, u32 end, u32 worker) const
+		{
+			const u32 sourceWidth = Data.Source->getDimension().Width;
+			const u32 targetWidth = Data.Target->getDimension().Width;
+			const u32 rowSize = Data.FilteredWidth * 4;
+			const ECOLOR_FORMAT format = Data.Target->getColorFormat();
+			const SFilterWeights& weights = *Data.Rows;
+
+			u32* argb = &Data.Scratch[worker * core::max_(sourceWidth, Data.FilteredWidth)];
+
+			for (u32 y=begin; y<end; ++y)
+			{
+				const s16* rows = Data.Filtered + weights.First[y] * rowSize;
+
+				// two pixels at a time
+				for (u32 i=0; i<rowSize; i+=8)
+				{
+					s32 sum[8];
+#ifdef _IRR_COMPILE_WITH_SSE2_
+					__m128i lo = _mm_setzero_si128();
+					__m128i hi = _mm_setzero_si128();
+					const s16* p = rows + i;
+					for (u32 t=0; t<weights.Taps; t+=2, p+=rowSize*2)
+					{
+						const __m128i a = _mm_loadu_si128((const __m128i*)p);
+						const __m128i b = _mm_loadu_si128((const __m128i*)(p + rowSize));
+						const __m128i w = _mm_set1_epi32(weights.getPair(y, t));
+						lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+						hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+					}
+					if (!Data.ToSRGB && !Data.PremultipliedAlpha)
+					{
+						// back to 8 bit in one shift
+						const __m128i round = _mm_set1_epi32(1 << (WeightBits + ChannelBits - 1));
+						lo = _mm_srai_epi32(_mm_add_epi32(lo, round), WeightBits + ChannelBits);
+						hi = _mm_srai_epi32(_mm_add_epi32(hi, round), WeightBits + ChannelBits);
+						const __m128i c = _mm_packs_epi32(lo, hi);
+						_mm_storel_epi64((__m128i*)(argb + i / 4), _mm_packus_epi16(c, c));
+						continue;
+					}
+					_mm_storeu_si128((__m128i*)sum, lo);
+					_mm_storeu_si128((__m128i*)(sum + 4), hi);
+#else
+					const s16* w = &weights.Weights[y * weights.Taps];
+					for (u32 c=0; c<8; ++c)
+					{
+						sum[c] = 0;
+						const s16* p = rows + i + c;
+						for (u32 t=0; t<weights.Taps; ++t, p+=rowSize)
+							sum[c] += *p * w[t];
+					}
+					if (!Data.ToSRGB && !Data.PremultipliedAlpha)
+					{
+						u8* c = (u8*)(argb + i / 4);
+						for (u32 j=0; j<8; ++j)
+							c[j] = (u8)core::s32_clamp((sum[j] + (1 << (WeightBits + ChannelBits - 1))) >> (WeightBits + ChannelBits), 0, 255);
+						continue;
+					}
+#endif
+					// gamma correct or premultiplied colors, alpha as it is
+					for (u32 k=0; k<2; ++k)
+					{
+						const s32* s = sum + k * 4;
+						const s32 alpha = core::s32_clamp((s[3] + (1 << (WeightBits - 1))) >> WeightBits, 0, ChannelMax);
+						s32 c[4];
+						for (u32 j=0; j<3; ++j)
+						{
+							s32 v = core::s32_clamp((s[j] + (1 << (WeightBits - 1))) >> WeightBits, 0, ChannelMax);
+							if (Data.PremultipliedAlpha)
+								v = alpha ? core::min_((v * ChannelMax + alpha / 2) / alpha, ChannelMax) : 0;
+							c[j] = Data.ToSRGB ? Data.ToSRGB[v] : (v + (1 << (ChannelBits - 1))) >> ChannelBits;
+						}
+						c[3] = (alpha + (1 << (ChannelBits - 1))) >> ChannelBits;
+						argb[i / 4 + k] = c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+					}
+				}
+
+				u8* target = (u8*)Data.Target->getData() + y * Data.Target->getPitch();
+				CColorConverter::convert_viaFormat(argb, ECF_A8R8G8B8, targetWidth, target, format);
+			}
+		}
+
+		SResampleData& Data;
+	};
+} // end anonymous namespace
+
+
+//! Checks if images of a color format can be resampled
+bool CImageResampler::isFormatSupported(ECOLOR_FORMAT format)
+{
+	// the rows are filtered in A8R8G8B8
+	return CColorConverter::canConvert_viaFormat(format, ECF_A8R8G8B8) &&
+		CColorConverter::canConvert_viaFormat(ECF_A8R8G8B8, format);
+}
+
+
+//! Resamples source into the whole target
+bool CImageResampler::resample(const IImage* source, IImage* target, E_IMAGE_FILTER filter, bool gammaCorrect, bool premultipliedAlpha)
+{
+	if (!isFormatSupported(source->getColorFormat()) || !isFormatSupported(target->getColorFormat()))
+		return false;
+
+	const core::dimension2d<u32>& sourceSize = source->getDimension();
+	const core::dimension2d<u32>& targetSize = target->getDimension();
+	if (!sourceSize.Width || !sourceSize.Height || !targetSize.Width || !targetSize.Height)
+		return true;
+
+	const SFilterWeights columns(filter, sourceSize.Width, targetSize.Width);
+	const SFilterWeights rows(filter, sourceSize.Height, targetSize.Height);
+
+	SResampleData data;
+	data.Source = source;
+	data.Target = target;
+	data.Columns = &columns;
+	data.Rows = &rows;
+	data.FilteredWidth = (targetSize.Width + 1) & ~1u;
+
+	// one more row which stays 0, the taps may reach it
+	core::array<s16> filtered;
+	filtered.set_used((sourceSize.Height + 1) * data.FilteredWidth * 4);
+	memset(&filtered[sourceSize.Height * data.FilteredWidth * 4], 0, data.FilteredWidth * 4 * sizeof(s16));
+	data.Filtered = filtered.pointer();
+
+	core::array<s16> toLinear;
+	core::array<u8> toSRGB;
+	data.ToLinear = 0;
+	data.ToSRGB = 0;
+	data.PremultipliedAlpha = premultipliedAlpha;
+	if (gammaCorrect)
+	{
+		toLinear.set_used(256);
+		for (u32 i=0; i<256; ++i)
+		{
+			const f32 c = i / 255.f;
+			const f32 l = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			toLinear[i] = (s16)core::round32(l * ChannelMax);
+		}
+		toSRGB.set_used(ChannelMax + 1);
+		for (s32 i=0; i<=ChannelMax; ++i)
+		{
+			const f32 l = (f32)i / ChannelMax;
+			const f32 c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.f / 2.4f) - 0.055f;
+			toSRGB[i] = (u8)core::s32_clamp(core::round32(c * 255.f), 0, 255);
+		}
+		data.ToLinear = toLinear.pointer();
+		data.ToSRGB = toSRGB.pointer();
+	}
+
+	CWorkerPool& pool = CWorkerPool::getInstance();
+	const u32 workers = pool.getWorkerCount();
+	data.Scratch.set_used(workers * core::max_(sourceSize.Width, data.FilteredWidth));
+	data.ScratchRows.set_used(workers * (sourceSize.Width + 1) * 4);
+	for (u32 i=0; i<workers; ++i)
+		memset(&data.ScratchRows[(i * (sourceSize.Width + 1) + sourceSize.Width) * 4], 0, 4 * sizeof(s16));
+
+	SFilterColumnsJob columnsJob(data);
+	pool.parallelFor(sourceSize.Height, core::max_(ResampleGrainPixels / targetSize.Width, 1u), columnsJob);
+
+	SFilterRowsJob rowsJob(data);
+	pool.parallelFor(targetSize.Height, core::max_(ResampleGrainPixels / targetSize.Width, 1u), rowsJob);
+
+	return true;
+}
+
+} // end namespace video
+} // end namespace irr
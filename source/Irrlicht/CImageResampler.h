@@ -0,0 +1,38 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_IMAGE_RESAMPLER_H_INCLUDED__
+#define __C_IMAGE_RESAMPLER_H_INCLUDED__
+
+#include "IImage.h"
+
+namespace irr
+{
+namespace video
+{
+
+//! Resamples images with a separable filter
+/** The rows are filtered into a buffer with 16 bit per channel, then the
+columns of that buffer into the target. The filter weights of all target
+columns and rows are computed once per image, in fixed point with 14 bits,
+so the inner loops only multiply and add integers. */
+class CImageResampler
+{
+public:
+
+	//! Resamples source into the whole target
+	/** \param premultipliedAlpha Multiplies the colors with their alpha
+	before filtering and divides them by the filtered alpha afterwards.
+	\return False if the color format of source or target is not supported,
+	in which case target is not changed. */
+	static bool resample(const IImage* source, IImage* target, E_IMAGE_FILTER filter, bool gammaCorrect, bool premultipliedAlpha);
+
+	//! Checks if images of a color format can be resampled
+	static bool isFormatSupported(ECOLOR_FORMAT format);
+};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
@@ -13,6 +13,7 @@
 #include "CLogger.h"
 #include "irrString.h"
 #include "IRandomizer.h"
+#include "CWorkerPool.h"
 
 namespace irr
 {
@@ -24,6 +25,8 @@ CIrrDeviceStub::CIrrDeviceStub(const SIrrlichtCreationParameters& params)
 	InputReceivingSceneManager(0), VideoModeList(0), ContextManager(0),
 	CreationParams(params), Close(false)
 {
+	CWorkerPool::grabInstance();
+
 	Timer = new CTimer(params.UsePerformanceTimer);
 	if (os::Printer::Logger)
 	{
@@ -90,6 +93,9 @@ CIrrDeviceStub::~CIrrDeviceStub()
 
 	if (Logger->drop())
 		os::Printer::Logger = 0;
+
+	// after everything using the threads is gone
+	CWorkerPool::dropInstance();
 }
 
 
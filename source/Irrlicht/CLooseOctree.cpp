@@ -0,0 +1,397 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CLooseOctree.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! Half of the largest extent of a box
+	f32 getHalfSize(const core::aabbox3df& box)
+	{
+		const core::vector3df extent = box.getExtent();
+		return 0.5f * core::max_(extent.X, extent.Y, extent.Z);
+	}
+
+	//! Coordinate of a point along an axis, 0 for X, 1 for Y and 2 for Z
+	f32 getCoordinate(const core::vector3df& point, u32 axis)
+	{
+		return axis == 0 ? point.X : (axis == 1 ? point.Y : point.Z);
+	}
+
+	//! Check if a point is in a cube
+	bool isInCell(const core::vector3df& point, const core::vector3df& center, f32 halfSize)
+	{
+		return fabsf(point.X - center.X) <= halfSize &&
+			fabsf(point.Y - center.Y) <= halfSize &&
+			fabsf(point.Z - center.Z) <= halfSize;
+	}
+}
+
+
+//! Constructor
+CLooseOctree::CLooseOctree(const core::aabbox3df& bounds, u32 maxDepth)
+	: MaxDepth(maxDepth), NodeCount(0), ItemCount(0)
+{
+	allocateNode(bounds.getCenter(), core::max_(getHalfSize(bounds), 0.0001f), 0, -1);
+}
+
+
+s32 CLooseOctree::allocateNode(const core::vector3df& center, f32 halfSize, u32 depth, s32 parent)
+{
+	s32 index;
+	if (FreeNodes.empty())
+	{
+		index = Nodes.size();
+		Nodes.push_back(SNode());
+	}
+	else
+	{
+		index = FreeNodes.getLast();
+		FreeNodes.erase(FreeNodes.size() - 1);
+	}
+
+	SNode& node = Nodes[index];
+	node.Center = center;
+	node.HalfSize = halfSize;
+	node.Depth = depth;
+	node.Parent = parent;
+	for (u32 i=0; i<8; ++i)
+		node.Children[i] = -1;
+	node.FirstItem = -1;
+	++NodeCount;
+	return index;
+}
+
+
+//! Find or create the node an item belongs to
+s32 CLooseOctree::findNode(const core::aabbox3df& box)
+{
+	const core::vector3df center = box.getCenter();
+	const f32 halfSize = getHalfSize(box);
+
+	// items outside of the root cell stay in the root
+	s32 node = 0;
+	if (!isInCell(center, Nodes[0].Center, Nodes[0].HalfSize))
+		return node;
+
+	// descend while the item fits into the cells of the next depth
+	while (Nodes[node].Depth < MaxDepth && halfSize <= Nodes[node].HalfSize * 0.5f)
+	{
+		const core::vector3df& c = Nodes[node].Center;
+		const u32 child = (center.X >= c.X ? 1 : 0) | (center.Y >= c.Y ? 2 : 0) | (center.Z >= c.Z ? 4 : 0);
+		if (Nodes[node].Children[child] < 0)
+		{
+			const f32 childHalfSize = Nodes[node].HalfSize * 0.5f;
+			const core::vector3df childCenter(
+				c.X + ((child & 1) ? childHalfSize : -childHalfSize),
+				c.Y + ((child & 2) ? childHalfSize : -childHalfSize),
+				c.Z + ((child & 4) ? childHalfSize : -childHalfSize));
+			const s32 created = allocateNode(childCenter, childHalfSize, Nodes[node].Depth + 1, node);
+			Nodes[node].Children[child] = created;
+		}
+		node = Nodes[node].Children[child];
+	}
+	return node;
+}
+
+
+//! Add an item to the list of a node
+void CLooseOctree::link(u32 item, s32 node)
+{
+	SItem& it = Items[item];
+	it.Node = node;
+	it.Prev = -1;
+	it.Next = Nodes[node].FirstItem;
+	if (it.Next >= 0)
+		Items[it.Next].Prev = item;
+	Nodes[node].FirstItem = item;
+}
+
+
+//! Remove an item from its node, and remove nodes which became empty
+void CLooseOctree::unlink(u32 item)
+{
+	SItem& it = Items[item];
+	if (it.Prev >= 0)
+		Items[it.Prev].Next = it.Next;
+	else
+		Nodes[it.Node].FirstItem = it.Next;
+	if (it.Next >= 0)
+		Items[it.Next].Prev = it.Prev;
+
+	s32 node = it.Node;
+	it.Node = -1;
+	while (node > 0 && Nodes[node].FirstItem < 0)
+	{
+		for (u32 i=0; i<8; ++i)
+		{
+			if (Nodes[node].Children[i] >= 0)
+				return;
+		}
+
+		const s32 parent = Nodes[node].Parent;
+		for (u32 i=0; i<8; ++i)
+		{
+			if (Nodes[parent].Children[i] == node)
+				Nodes[parent].Children[i] = -1;
+		}
+		FreeNodes.push_back(node);
+		--NodeCount;
+		node = parent;
+	}
+}
+
+
+//! Add an item
+u32 CLooseOctree::insert(const core::aabbox3df& box, u32 userData)
+{
+	u32 item;
+	if (FreeItems.empty())
+	{
+		item = Items.size();
+		Items.push_back(SItem());
+	}
+	else
+	{
+		item = FreeItems.getLast();
+		FreeItems.erase(FreeItems.size() - 1);
+	}
+
+	Items[item].Box = box;
+	Items[item].UserData = userData;
+	link(item, findNode(box));
+	++ItemCount;
+	return item;
+}
+
+
+//! Remove an item
+void CLooseOctree::remove(u32 item)
+{
+	unlink(item);
+	FreeItems.push_back(item);
+	--ItemCount;
+}
+
+
+//! Change the bounding box of an item
+void CLooseOctree::update(u32 item, const core::aabbox3df& box)
+{
+	// stays in its node if findNode would find the same node
+	const SNode& node = Nodes[Items[item].Node];
+	const core::vector3df center = box.getCenter();
+	const f32 halfSize = getHalfSize(box);
+	bool stays;
+	if (node.Depth == 0)
+		stays = !isInCell(center, node.Center, node.HalfSize) || MaxDepth == 0 || halfSize > node.HalfSize * 0.5f;
+	else
+		stays = isInCell(center, node.Center, node.HalfSize) && halfSize <= node.HalfSize &&
+			(node.Depth == MaxDepth || halfSize > node.HalfSize * 0.5f);
+
+	Items[item].Box = box;
+	if (!stays)
+	{
+		unlink(item);
+		link(item, findNode(box));
+	}
+}
+
+
+//! Remove all items
+void CLooseOctree::clear()
+{
+	const core::vector3df center = Nodes[0].Center;
+	const f32 halfSize = Nodes[0].HalfSize;
+	Nodes.set_used(0);
+	Items.set_used(0);
+	FreeNodes.set_used(0);
+	FreeItems.set_used(0);
+	NodeCount = 0;
+	ItemCount = 0;
+	allocateNode(center, halfSize, 0, -1);
+}
+
+
+//! Append the user values of all items intersecting a box
+void CLooseOctree::getItems(const core::aabbox3df& box, core::array<u32>& outUserData) const
+{
+	getItems(0, box, outUserData);
+}
+
+
+void CLooseOctree::getItems(s32 node, const core::aabbox3df& box, core::array<u32>& outUserData) const
+{
+	const SNode& n = Nodes[node];
+	for (s32 i=n.FirstItem; i>=0; i=Items[i].Next)
+	{
+		if (Items[i].Box.intersectsWithBox(box))
+			outUserData.push_back(Items[i].UserData);
+	}
+
+	for (u32 i=0; i<8; ++i)
+	{
+		if (n.Children[i] >= 0 && getLooseBox(Nodes[n.Children[i]]).intersectsWithBox(box))
+			getItems(n.Children[i], box, outUserData);
+	}
+}
+
+
+//! Append the user values of all items in a view frustum
+void CLooseOctree::getItems(const SViewFrustum& frustum, core::array<u32>& outUserData) const
+{
+	getItems(0, frustum, false, outUserData);
+}
+
+
+void CLooseOctree::getItems(s32 node, const SViewFrustum& frustum, bool inside, core::array<u32>& outUserData) const
+{
+	const SNode& n = Nodes[node];
+
+	// the root may have items outside of its cell
+	if (!inside && node)
+	{
+		inside = true;
+		const core::aabbox3df box(getLooseBox(n));
+		for (u32 i=0; i!=SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			const core::EIntersectionRelation3D r = box.classifyPlaneRelation(frustum.planes[i]);
+			if (r == core::ISREL3D_FRONT)
+				return;
+			if (r == core::ISREL3D_CLIPPED)
+				inside = false;
+		}
+	}
+
+	for (s32 i=n.FirstItem; i>=0; i=Items[i].Next)
+	{
+		bool visible = true;
+		for (u32 p=0; p!=SViewFrustum::VF_PLANE_COUNT && !inside; ++p)
+		{
+			if (Items[i].Box.classifyPlaneRelation(frustum.planes[p]) == core::ISREL3D_FRONT)
+			{
+				visible = false;
+				break;
+			}
+		}
+		if (visible)
+			outUserData.push_back(Items[i].UserData);
+	}
+
+	for (u32 i=0; i<8; ++i)
+	{
+		if (n.Children[i] >= 0)
+			getItems(n.Children[i], frustum, inside, outUserData);
+	}
+}
+
+
+//! Append the user values of all items a line may intersect
+void CLooseOctree::getItems(const core::line3df& line, core::array<u32>& outUserData) const
+{
+	getItems(0, line, outUserData);
+}
+
+
+void CLooseOctree::getItems(s32 node, const core::line3df& line, core::array<u32>& outUserData) const
+{
+	const SNode& n = Nodes[node];
+	for (s32 i=n.FirstItem; i>=0; i=Items[i].Next)
+	{
+		if (Items[i].Box.intersectsWithLine(line))
+			outUserData.push_back(Items[i].UserData);
+	}
+
+	for (u32 i=0; i<8; ++i)
+	{
+		if (n.Children[i] >= 0 && getLooseBox(Nodes[n.Children[i]]).intersectsWithLine(line))
+			getItems(n.Children[i], line, outUserData);
+	}
+}
+
+
+//! Append the loose boxes of the nodes intersecting a box, for debugging
+void CLooseOctree::getBoundingBoxes(const core::aabbox3df& box, core::array<core::aabbox3df>& outBoxes) const
+{
+	getBoundingBoxes(0, box, outBoxes);
+}
+
+
+void CLooseOctree::getBoundingBoxes(s32 node, const core::aabbox3df& box, core::array<core::aabbox3df>& outBoxes) const
+{
+	const core::aabbox3df loose(getLooseBox(Nodes[node]));
+	if (!loose.intersectsWithBox(box))
+		return;
+
+	outBoxes.push_back(loose);
+	for (u32 i=0; i<8; ++i)
+	{
+		if (Nodes[node].Children[i] >= 0)
+			getBoundingBoxes(Nodes[node].Children[i], box, outBoxes);
+	}
+}
+
+
+//! Sort primitives into chunks of nearby primitives
+void CLooseOctree::sortIntoChunks(const core::array<core::vector3df>& centers, u32 chunkSize,
+	core::array<u32>& outOrder, core::array<u32>& outChunkEnds)
+{
+	outOrder.set_used(centers.size());
+	for (u32 i=0; i<centers.size(); ++i)
+		outOrder[i] = i;
+	outChunkEnds.set_used(0);
+	if (centers.empty())
+		return;
+	chunkSize = core::max_(chunkSize, 1u);
+
+	// ranges still to split as begin and end, the first range is split first
+	// so the chunks keep the order of the ranges
+	core::array<u32> ranges;
+	ranges.push_back(0);
+	ranges.push_back(centers.size());
+	while (!ranges.empty())
+	{
+		const u32 end = ranges.getLast();
+		const u32 begin = ranges[ranges.size() - 2];
+		ranges.set_used(ranges.size() - 2);
+		if (end - begin <= chunkSize)
+		{
+			outChunkEnds.push_back(end);
+			continue;
+		}
+
+		core::aabbox3df box(centers[outOrder[begin]]);
+		for (u32 i=begin+1; i<end; ++i)
+			box.addInternalPoint(centers[outOrder[i]]);
+		const core::vector3df extent = box.getExtent();
+		const u32 axis = (extent.X >= extent.Y && extent.X >= extent.Z) ? 0 : (extent.Y >= extent.Z ? 1 : 2);
+		const f32 split = getCoordinate(box.getCenter(), axis);
+
+		u32 middle = begin;
+		u32 last = end;
+		while (middle < last)
+		{
+			if (getCoordinate(centers[outOrder[middle]], axis) < split)
+				++middle;
+			else
+				core::swap(outOrder[middle], outOrder[--last]);
+		}
+		// all centers at the same place
+		if (middle == begin || middle == end)
+			middle = (begin + end) / 2;
+
+		ranges.push_back(middle);
+		ranges.push_back(end);
+		ranges.push_back(begin);
+		ranges.push_back(middle);
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,155 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_LOOSE_OCTREE_H_INCLUDED__
+#define __C_LOOSE_OCTREE_H_INCLUDED__
+
+#include "irrArray.h"
+#include "aabbox3d.h"
+#include "line3d.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! An octree of items with bounding boxes, which can be changed at any time.
+	/** Each node of a loose octree covers twice the size of its cell, so an
+	item is stored in exactly one node: the one at the depth matching the item
+	size whose cell contains the center of the item. Inserting, removing and
+	moving an item only visits the nodes on the way from the root to that node.
+	Items are identified by the id returned from insert(), and carry a user
+	value, e.g. the index of a range of indices or of a scene node. */
+	class CLooseOctree
+	{
+	public:
+
+		//! Constructor
+		/** \param bounds Space the items are expected in. Items outside of it
+		are stored in the root node.
+		\param maxDepth Depth of the smallest nodes, the root has depth 0. */
+		CLooseOctree(const core::aabbox3df& bounds, u32 maxDepth=8);
+
+		//! Add an item
+		/** \return Id of the item, valid until it is removed */
+		u32 insert(const core::aabbox3df& box, u32 userData);
+
+		//! Remove an item
+		void remove(u32 item);
+
+		//! Change the bounding box of an item
+		void update(u32 item, const core::aabbox3df& box);
+
+		//! Remove all items
+		void clear();
+
+		//! Get the user value of an item
+		u32 getUserData(u32 item) const
+		{
+			return Items[item].UserData;
+		}
+
+		//! Get the bounding box of an item
+		const core::aabbox3df& getBox(u32 item) const
+		{
+			return Items[item].Box;
+		}
+
+		//! Number of items
+		u32 getItemCount() const
+		{
+			return ItemCount;
+		}
+
+		//! Number of nodes, empty nodes are removed
+		u32 getNodeCount() const
+		{
+			return NodeCount;
+		}
+
+		//! Append the user values of all items intersecting a box
+		void getItems(const core::aabbox3df& box, core::array<u32>& outUserData) const;
+
+		//! Append the user values of all items in a view frustum
+		void getItems(const SViewFrustum& frustum, core::array<u32>& outUserData) const;
+
+		//! Append the user values of all items a line may intersect
+		void getItems(const core::line3df& line, core::array<u32>& outUserData) const;
+
+		//! Append the loose boxes of the nodes intersecting a box, for debugging
+		void getBoundingBoxes(const core::aabbox3df& box, core::array<core::aabbox3df>& outBoxes) const;
+
+		//! Sort primitives into chunks of nearby primitives
+		/** Splits the primitives along the longest axis of their centers
+		until each chunk has at most chunkSize primitives.
+		\param centers Centers of the primitives.
+		\param chunkSize Largest number of primitives in a chunk.
+		\param outOrder Receives the indices of the primitives, chunk by chunk.
+		\param outChunkEnds Receives the end of each chunk in outOrder. */
+		static void sortIntoChunks(const core::array<core::vector3df>& centers, u32 chunkSize,
+			core::array<u32>& outOrder, core::array<u32>& outChunkEnds);
+
+	private:
+
+		struct SNode
+		{
+			core::vector3df Center;
+			f32 HalfSize;
+			u32 Depth;
+			s32 Parent;
+			s32 Children[8];
+			//! first item of the list of items in this node, -1 if none
+			s32 FirstItem;
+		};
+
+		struct SItem
+		{
+			core::aabbox3df Box;
+			u32 UserData;
+			//! node of the item, -1 for unused items
+			s32 Node;
+			s32 Prev;
+			s32 Next;
+		};
+
+		//! Find or create the node an item belongs to
+		s32 findNode(const core::aabbox3df& box);
+
+		//! Add an item to the list of a node
+		void link(u32 item, s32 node);
+
+		//! Remove an item from its node, and remove nodes which became empty
+		void unlink(u32 item);
+
+		s32 allocateNode(const core::vector3df& center, f32 halfSize, u32 depth, s32 parent);
+
+		void getItems(s32 node, const core::aabbox3df& box, core::array<u32>& outUserData) const;
+		void getItems(s32 node, const SViewFrustum& frustum, bool inside, core::array<u32>& outUserData) const;
+		void getItems(s32 node, const core::line3df& line, core::array<u32>& outUserData) const;
+		void getBoundingBoxes(s32 node, const core::aabbox3df& box, core::array<core::aabbox3df>& outBoxes) const;
+
+		//! the cell of a node, with the loose border
+		core::aabbox3df getLooseBox(const SNode& node) const
+		{
+			const f32 size = 2.f * node.HalfSize;
+			return core::aabbox3df(node.Center.X - size, node.Center.Y - size, node.Center.Z - size,
+				node.Center.X + size, node.Center.Y + size, node.Center.Z + size);
+		}
+
+		core::array<SNode> Nodes;
+		core::array<SItem> Items;
+		//! unused entries of Nodes and Items
+		core::array<s32> FreeNodes;
+		core::array<s32> FreeItems;
+		u32 MaxDepth;
+		u32 NodeCount;
+		u32 ItemCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -6,9 +6,12 @@
 #include "SMesh.h"
 #include "CMeshBuffer.h"
 #include "SAnimatedMesh.h"
+#include "SLODMesh.h"
+#include "CDynamicMeshBuffer.h"
 #include "os.h"
 #include "irrMap.h"
 #include "triangle3d.h"
+#include "CWorkerPool.h"
 
 namespace irr
 {
@@ -36,6 +39,412 @@ static inline core::vector3df getAngleWeight(const core::vector3df& v1,
 }
 
 
+namespace
+{
+
+//! Copy the used vertices of a mesh buffer into a new buffer of the same type
+template <class T>
+IMeshBuffer* createMeshBufferSubsetT(const IMeshBuffer* mb, const core::array<u32>& vertices, const core::array<u32>& indices)
+{
+	CMeshBuffer<T>* buffer = new CMeshBuffer<T>();
+	const T* v = (const T*)mb->getVertices();
+
+	buffer->Vertices.reallocate(vertices.size());
+	for (u32 i=0; i<vertices.size(); ++i)
+		buffer->Vertices.push_back(v[vertices[i]]);
+
+	buffer->Indices.reallocate(indices.size());
+	for (u32 i=0; i<indices.size(); ++i)
+		buffer->Indices.push_back((u16)indices[i]);
+
+	buffer->Material = mb->getMaterial();
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Index(), EBT_INDEX);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+
+//! Copy the used vertices of a mesh buffer into a new buffer
+/** \param vertices Source index of each new vertex
+\param indices Triangle list using the new vertex indices
+\return Buffer of the same vertex type. It uses 32 bit indices when the source
+did or the vertices do not fit 16 bit. */
+IMeshBuffer* createMeshBufferSubset(const IMeshBuffer* mb, const core::array<u32>& vertices, const core::array<u32>& indices)
+{
+	if (mb->getIndexType() == video::EIT_16BIT && vertices.size() <= 65536)
+	{
+		switch (mb->getVertexType())
+		{
+		case video::EVT_STANDARD:
+			return createMeshBufferSubsetT<video::S3DVertex>(mb, vertices, indices);
+		case video::EVT_2TCOORDS:
+			return createMeshBufferSubsetT<video::S3DVertex2TCoords>(mb, vertices, indices);
+		case video::EVT_TANGENTS:
+			return createMeshBufferSubsetT<video::S3DVertexTangents>(mb, vertices, indices);
+		}
+	}
+
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(mb->getVertexType(), video::EIT_32BIT);
+	const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+	const u8* src = (const u8*)mb->getVertices();
+
+	buffer->getVertexBuffer().set_used(vertices.size());
+	u8* dst = (u8*)buffer->getVertexBuffer().getData();
+	for (u32 i=0; i<vertices.size(); ++i)
+		memcpy(dst + i*pitch, src + vertices[i]*pitch, pitch);
+
+	buffer->getIndexBuffer().set_used(indices.size());
+	if (indices.size())
+		memcpy(buffer->getIndexBuffer().getData(), indices.const_pointer(), indices.size()*sizeof(u32));
+
+	buffer->Material = mb->getMaterial();
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Index(), EBT_INDEX);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+
+//! Read the indices of a mesh buffer into 32 bit
+void getIndices32(const IMeshBuffer* mb, core::array<u32>& indices)
+{
+	const u32 icount = mb->getIndexCount();
+	indices.set_used(icount);
+	if (mb->getIndexType() == video::EIT_16BIT)
+	{
+		const u16* ind = mb->getIndices();
+		for (u32 i=0; i<icount; ++i)
+			indices[i] = ind[i];
+	}
+	else
+	{
+		const u32* ind = (const u32*)mb->getIndices();
+		for (u32 i=0; i<icount; ++i)
+			indices[i] = ind[i];
+	}
+}
+
+//! Vertices used by a triangle list, in order of first use
+/** \param indices Triangle list, changed to index the returned vertices
+\param vertices Receives the source index of each used vertex */
+void compactVertices(u32 vertexCount, core::array<u32>& indices, core::array<u32>& vertices)
+{
+	core::array<u32> vertexMap(vertexCount);
+	vertexMap.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		vertexMap[i] = 0xffffffff;
+
+	vertices.set_used(0);
+	for (u32 i=0; i<indices.size(); ++i)
+	{
+		u32& mapped = vertexMap[indices[i]];
+		if (mapped == 0xffffffff)
+		{
+			mapped = vertices.size();
+			vertices.push_back(indices[i]);
+		}
+		indices[i] = mapped;
+	}
+}
+
+//! Spatial hash of the vertex positions of a mesh buffer
+/** The grid cells have the size of the tolerance, so vertices closer than the
+tolerance are at most one cell apart. Each cell keeps its vertices in index
+order, which allows to find the first matching vertex like a linear search
+would, but with only a few comparisons. The cells are a few float steps larger
+than the tolerance, as the comparisons round and may accept slightly larger
+distances. */
+class CVertexPositionGrid
+{
+public:
+
+	CVertexPositionGrid(const IMeshBuffer* mb, f32 tolerance)
+		: Buffer(mb), CellSize(1.0), Reach(0.0)
+	{
+		const u32 vcount = mb->getVertexCount();
+
+		f32 extent = 0.f;
+		for (u32 v=0; v<vcount; ++v)
+		{
+			const core::vector3df& pos = mb->getPosition(v);
+			extent = core::max_(extent, core::abs_(pos.X), core::max_(core::abs_(pos.Y), core::abs_(pos.Z)));
+		}
+		if (tolerance > 0.f)
+		{
+			CellSize = tolerance * 1.001 + extent * 1e-6;
+			Reach = tolerance * 1.0005 + extent * 5e-7;
+		}
+
+		// open addressing table, at most half filled
+		u32 tableSize = 16;
+		while (tableSize < vcount*2)
+			tableSize <<= 1;
+		Mask = tableSize - 1;
+
+		SCell empty;
+		empty.First = 0xffffffff;
+		Cells.set_used(tableSize);
+		for (u32 i=0; i<tableSize; ++i)
+			Cells[i] = empty;
+
+		Next.set_used(vcount);
+		for (u32 v=0; v<vcount; ++v)
+		{
+			s64 x, y, z;
+			getCell(mb->getPosition(v), x, y, z);
+			SCell& cell = findCell(x, y, z);
+			if (cell.First == 0xffffffff)
+			{
+				cell.X = x;
+				cell.Y = y;
+				cell.Z = z;
+				cell.First = v;
+			}
+			else
+				Next[cell.Last] = v;
+			cell.Last = v;
+			Next[v] = 0xffffffff;
+		}
+	}
+
+	//! Find the first vertex before vertex i which matches it
+	/** Only vertices in the neighbouring cells which are closer than the
+	tolerance are checked.
+	\param test Functor with bool operator()(u32 i, u32 j), which has to
+	include the position comparison with the tolerance of the grid.
+	\return Index of the first matching vertex, i if there is none. */
+	template <class TEST>
+	u32 findFirst(u32 i, const TEST& test) const
+	{
+		const core::vector3df& pos = Buffer->getPosition(i);
+		s64 x, y, z;
+		getCell(pos, x, y, z);
+		s64 lowX, highX, lowY, highY, lowZ, highZ;
+		getNeighbours(pos.X, x, lowX, highX);
+		getNeighbours(pos.Y, y, lowY, highY);
+		getNeighbours(pos.Z, z, lowZ, highZ);
+
+		u32 first = i;
+		for (s64 dx=lowX; dx<=highX; ++dx)
+		for (s64 dy=lowY; dy<=highY; ++dy)
+		for (s64 dz=lowZ; dz<=highZ; ++dz)
+		{
+			const SCell& cell = findCell(x+dx, y+dy, z+dz);
+			for (u32 j=cell.First; j<first; j=Next[j])
+			{
+				if (test(i, j))
+				{
+					first = j;
+					break;
+				}
+			}
+		}
+		return first;
+	}
+
+private:
+
+	struct SCell
+	{
+		s64 X, Y, Z;
+		u32 First;
+		u32 Last;
+	};
+
+	void getCell(const core::vector3df& pos, s64& x, s64& y, s64& z) const
+	{
+		x = (s64)floor(pos.X / CellSize);
+		y = (s64)floor(pos.Y / CellSize);
+		z = (s64)floor(pos.Z / CellSize);
+	}
+
+	//! Range of neighbour cells along one axis which are within reach of a coordinate
+	void getNeighbours(f32 coord, s64 cell, s64& low, s64& high) const
+	{
+		low = (coord - cell * CellSize <= Reach) ? -1 : 0;
+		high = ((cell + 1) * CellSize - coord <= Reach) ? 1 : 0;
+	}
+
+	//! Returns the cell, or the empty slot where it has to be added
+	SCell& findCell(s64 x, s64 y, s64 z) const
+	{
+		u32 slot = (u32)((x * 73856093) ^ (y * 19349663) ^ (z * 83492791)) & Mask;
+		for (;;)
+		{
+			SCell& cell = Cells[slot];
+			if (cell.First == 0xffffffff || (cell.X == x && cell.Y == y && cell.Z == z))
+				return cell;
+			slot = (slot + 1) & Mask;
+		}
+	}
+
+	const IMeshBuffer* Buffer;
+	f64 CellSize;
+	//! Distance from a cell border below which the neighbour cell is checked
+	f64 Reach;
+	u32 Mask;
+	mutable core::array<SCell> Cells;
+	core::array<u32> Next;
+};
+
+//! Vertices which createMeshWelded merges
+inline bool weldEquals(const video::S3DVertex& a, const video::S3DVertex& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		(a.Color == b.Color);
+}
+
+inline bool weldEquals(const video::S3DVertex2TCoords& a, const video::S3DVertex2TCoords& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.TCoords2.equals(b.TCoords2) &&
+		(a.Color == b.Color);
+}
+
+inline bool weldEquals(const video::S3DVertexTangents& a, const video::S3DVertexTangents& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.Tangent.equals(b.Tangent, tolerance) &&
+		a.Binormal.equals(b.Binormal, tolerance) &&
+		(a.Color == b.Color);
+}
+
+//! Vertex comparison for welding, for CVertexPositionGrid::findFirst
+template <class T>
+struct SWeldTest
+{
+	SWeldTest(const IMeshBuffer* mb, f32 tolerance)
+		: Vertices((const T*)mb->getVertices()), Tolerance(tolerance) {}
+
+	bool operator()(u32 i, u32 j) const
+	{
+		return weldEquals(Vertices[i], Vertices[j], Tolerance);
+	}
+
+	const T* Vertices;
+	f32 Tolerance;
+};
+
+//! Compares only the positions
+struct SPositionTest
+{
+	SPositionTest(const IMeshBuffer* mb, f32 tolerance)
+		: Buffer(mb), Tolerance(tolerance) {}
+
+	bool operator()(u32 i, u32 j) const
+	{
+		return Buffer->getPosition(i).equals(Buffer->getPosition(j), Tolerance);
+	}
+
+	const IMeshBuffer* Buffer;
+	f32 Tolerance;
+};
+
+//! Vertices per range when loops over vertices are spread over the worker threads
+const u32 VertexGrainSize = 4096;
+//! Triangles per range when loops over triangles are spread over the worker threads
+const u32 TriangleGrainSize = 2048;
+
+//! Looks up the first matching vertex of each vertex
+template <class TEST>
+struct SFindFirstJob
+{
+	SFindFirstJob(const CVertexPositionGrid& grid, const TEST& test, u32* targets)
+		: Grid(grid), Test(test), Targets(targets) {}
+
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 i=begin; i<end; ++i)
+			Targets[i] = Grid.findFirst(i, Test);
+	}
+
+	const CVertexPositionGrid& Grid;
+	const TEST& Test;
+	u32* Targets;
+};
+
+//! For each vertex the first vertex of the group of matching vertices it belongs to
+/** \param test Comparison as for CVertexPositionGrid::findFirst */
+template <class TEST>
+void findSharedVertices(const IMeshBuffer* mb, f32 tolerance, const TEST& test, core::array<u32>& targets)
+{
+	const u32 vcount = mb->getVertexCount();
+	const CVertexPositionGrid grid(mb, tolerance);
+	targets.set_used(vcount);
+
+	SFindFirstJob<TEST> job(grid, test, targets.pointer());
+	CWorkerPool::getInstance().parallelFor(vcount, VertexGrainSize, job);
+
+	// earlier vertices already point to the first one of their group
+	for (u32 i=0; i<vcount; ++i)
+		targets[i] = targets[targets[i]];
+}
+
+//! For each vertex the first vertex which can be welded with it
+template <class T>
+void findWeldTargetsT(const IMeshBuffer* mb, f32 tolerance, core::array<u32>& targets)
+{
+	findSharedVertices(mb, tolerance, SWeldTest<T>(mb, tolerance), targets);
+}
+
+//! The triangle corners of each vertex, in triangle order
+/** Lets each vertex sum up the values of its triangles on its own, so vertices
+can be spread over the worker threads without write conflicts. The sums are
+built in the same order as a loop over all triangles would do, so the results
+do not depend on the number of threads. */
+struct SVertexCorners
+{
+	//! Collect the corners
+	/** \param groups Optional vertex for each vertex, under which its corners are collected */
+	template <typename T>
+	void build(const T* idx, u32 cornerCount, u32 vertexCount, const u32* groups)
+	{
+		First.set_used(vertexCount+1);
+		for (u32 i=0; i<=vertexCount; ++i)
+			First[i] = 0;
+		for (u32 c=0; c<cornerCount; ++c)
+			++First[(groups ? groups[idx[c]] : idx[c]) + 1];
+		for (u32 i=0; i<vertexCount; ++i)
+			First[i+1] += First[i];
+
+		core::array<u32> next(First);
+		Corners.set_used(cornerCount);
+		for (u32 c=0; c<cornerCount; ++c)
+			Corners[next[groups ? groups[idx[c]] : idx[c]]++] = c;
+	}
+
+	//! Corners of vertex v are Corners[First[v]] to Corners[First[v+1]-1]
+	core::array<u32> First;
+	core::array<u32> Corners;
+};
+
+//! For each vertex its last triangle corner, or 0xffffffff when it is not used
+/** Per face values are written by the last triangle of a vertex only, as it
+would happen in a plain loop over the triangles. */
+template <typename T>
+void findLastCorners(const T* idx, u32 cornerCount, u32 vertexCount, core::array<u32>& last)
+{
+	last.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		last[i] = 0xffffffff;
+	for (u32 c=0; c<cornerCount; ++c)
+		last[idx[c]] = c;
+}
+
+//! Get the weight of a triangle corner
+inline f32 getCornerWeight(const core::vector3df& weights, u32 corner)
+{
+	return corner == 0 ? weights.X : (corner == 1 ? weights.Y : weights.Z);
+}
+
+} // end anonymous namespace
+
+
 //! Flips the direction of surfaces. Changes backfacing triangles to frontfacing
 //! triangles and vice versa.
 //! \param mesh: Mesh on which the operation is performed.
@@ -75,51 +484,150 @@ void CMeshManipulator::flipSurfaces(scene::IMesh* mesh) const
 
 namespace
 {
+//! Flat normals, each vertex gets the normal of its last triangle
+template <typename T>
+struct SFlatNormalJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 t=begin; t<end; ++t)
+		{
+			const u32 i = t*3;
+			if (Last[Indices[i+0]] != i+0 && Last[Indices[i+1]] != i+1 && Last[Indices[i+2]] != i+2)
+				continue;
+
+			const core::vector3df normal = core::plane3d<f32>(
+				Buffer->getPosition(Indices[i+0]),
+				Buffer->getPosition(Indices[i+1]),
+				Buffer->getPosition(Indices[i+2])).Normal;
+			for (u32 k=0; k<3; ++k)
+			{
+				if (Last[Indices[i+k]] == i+k)
+					Buffer->getNormal(Indices[i+k]) = normal;
+			}
+		}
+	}
+
+	IMeshBuffer* Buffer;
+	const T* Indices;
+	const u32* Last;
+};
+
+//! Face normals and optional angle weights of all triangles
+template <typename T>
+struct SFaceNormalJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 t=begin; t<end; ++t)
+		{
+			const core::vector3df& v1 = Buffer->getPosition(Indices[t*3+0]);
+			const core::vector3df& v2 = Buffer->getPosition(Indices[t*3+1]);
+			const core::vector3df& v3 = Buffer->getPosition(Indices[t*3+2]);
+			Normals[t] = core::plane3d<f32>(v1, v2, v3).Normal;
+			if (Weights)
+				Weights[t] = irr::scene::getAngleWeight(v1,v2,v3); // writing irr::scene:: necessary for borland
+		}
+	}
+
+	const IMeshBuffer* Buffer;
+	const T* Indices;
+	core::vector3df* Normals;
+	core::vector3df* Weights;
+};
+
+//! Sums up the face normals around each vertex
+/** With Shared set, only the first vertex at each position is written. */
+struct SSmoothNormalJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 v=begin; v<end; ++v)
+		{
+			if (Shared && Shared[v] != v)
+				continue;
+
+			core::vector3df normal(0.f, 0.f, 0.f);
+			for (u32 k=Corners->First[v]; k<Corners->First[v+1]; ++k)
+			{
+				const u32 c = Corners->Corners[k];
+				if (Weights)
+					normal += Normals[c/3] * getCornerWeight(Weights[c/3], c%3);
+				else
+					normal += Normals[c/3];
+			}
+			Buffer->getNormal(v) = normal.normalize();
+		}
+	}
+
+	IMeshBuffer* Buffer;
+	const u32* Shared;
+	const SVertexCorners* Corners;
+	const core::vector3df* Normals;
+	const core::vector3df* Weights;
+};
+
+//! Vertices at the same position copy the normal of the first one
+struct SCopySharedNormalJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 v=begin; v<end; ++v)
+		{
+			if (Shared[v] != v)
+				Buffer->getNormal(v) = Buffer->getNormal(Shared[v]);
+		}
+	}
+
+	IMeshBuffer* Buffer;
+	const u32* Shared;
+};
+
 template <typename T>
-void recalculateNormalsT(IMeshBuffer* buffer, bool smooth, bool angleWeighted)
+void recalculateNormalsT(IMeshBuffer* buffer, bool smooth, bool angleWeighted, bool weldPositions)
 {
 	const u32 vtxcnt = buffer->getVertexCount();
-	const u32 idxcnt = buffer->getIndexCount();
+	const u32 tricnt = buffer->getIndexCount() / 3;
 	const T* idx = reinterpret_cast<T*>(buffer->getIndices());
+	CWorkerPool& pool = CWorkerPool::getInstance();
 
 	if (!smooth)
 	{
-		for (u32 i=0; i<idxcnt; i+=3)
-		{
-			const core::vector3df& v1 = buffer->getPosition(idx[i+0]);
-			const core::vector3df& v2 = buffer->getPosition(idx[i+1]);
-			const core::vector3df& v3 = buffer->getPosition(idx[i+2]);
-			const core::vector3df normal = core::plane3d<f32>(v1, v2, v3).Normal;
-			buffer->getNormal(idx[i+0]) = normal;
-			buffer->getNormal(idx[i+1]) = normal;
-			buffer->getNormal(idx[i+2]) = normal;
-		}
+		core::array<u32> last;
+		findLastCorners(idx, tricnt*3, vtxcnt, last);
+
+		SFlatNormalJob<T> job = { buffer, idx, last.const_pointer() };
+		pool.parallelFor(tricnt, TriangleGrainSize, job);
 	}
 	else
 	{
-		u32 i;
+		// only triangles using the same index are averaged, unless vertices
+		// at the same position shall share one normal
+		core::array<u32> shared;
+		if (weldPositions)
+			findSharedVertices(buffer, core::ROUNDING_ERROR_f32, SPositionTest(buffer, core::ROUNDING_ERROR_f32), shared);
+		const u32* sharedVertices = weldPositions ? shared.const_pointer() : 0;
 
-		for ( i = 0; i!= vtxcnt; ++i )
-			buffer->getNormal(i).set(0.f, 0.f, 0.f);
+		core::array<core::vector3df> normals(tricnt);
+		normals.set_used(tricnt);
+		core::array<core::vector3df> weights;
+		if (angleWeighted)
+			weights.set_used(tricnt);
 
-		for ( i=0; i<idxcnt; i+=3)
-		{
-			const core::vector3df& v1 = buffer->getPosition(idx[i+0]);
-			const core::vector3df& v2 = buffer->getPosition(idx[i+1]);
-			const core::vector3df& v3 = buffer->getPosition(idx[i+2]);
-			const core::vector3df normal = core::plane3d<f32>(v1, v2, v3).Normal;
+		SFaceNormalJob<T> faces = { buffer, idx, normals.pointer(), angleWeighted ? weights.pointer() : 0 };
+		pool.parallelFor(tricnt, TriangleGrainSize, faces);
 
-			core::vector3df weight(1.f,1.f,1.f);
-			if (angleWeighted)
-				weight = irr::scene::getAngleWeight(v1,v2,v3); // writing irr::scene:: necessary for borland
+		SVertexCorners corners;
+		corners.build(idx, tricnt*3, vtxcnt, sharedVertices);
 
-			buffer->getNormal(idx[i+0]) += weight.X*normal;
-			buffer->getNormal(idx[i+1]) += weight.Y*normal;
-			buffer->getNormal(idx[i+2]) += weight.Z*normal;
-		}
+		SSmoothNormalJob sum = { buffer, sharedVertices, &corners, normals.const_pointer(), faces.Weights };
+		pool.parallelFor(vtxcnt, VertexGrainSize, sum);
 
-		for ( i = 0; i!= vtxcnt; ++i )
-			buffer->getNormal(i).normalize();
+		if (weldPositions)
+		{
+			SCopySharedNormalJob copy = { buffer, sharedVertices };
+			pool.parallelFor(vtxcnt, VertexGrainSize, copy);
+		}
 	}
 }
 }
@@ -127,28 +635,28 @@ void recalculateNormalsT(IMeshBuffer* buffer, bool smooth, bool angleWeighted)
 
 //! Recalculates all normals of the mesh buffer.
 /** \param buffer: Mesh buffer on which the operation is performed. */
-void CMeshManipulator::recalculateNormals(IMeshBuffer* buffer, bool smooth, bool angleWeighted) const
+void CMeshManipulator::recalculateNormals(IMeshBuffer* buffer, bool smooth, bool angleWeighted, bool weldPositions) const
 {
 	if (!buffer)
 		return;
 
 	if (buffer->getIndexType()==video::EIT_16BIT)
-		recalculateNormalsT<u16>(buffer, smooth, angleWeighted);
+		recalculateNormalsT<u16>(buffer, smooth, angleWeighted, weldPositions);
 	else
-		recalculateNormalsT<u32>(buffer, smooth, angleWeighted);
+		recalculateNormalsT<u32>(buffer, smooth, angleWeighted, weldPositions);
 }
 
 
 //! Recalculates all normals of the mesh.
 //! \param mesh: Mesh on which the operation is performed.
-void CMeshManipulator::recalculateNormals(scene::IMesh* mesh, bool smooth, bool angleWeighted) const
+void CMeshManipulator::recalculateNormals(scene::IMesh* mesh, bool smooth, bool angleWeighted, bool weldPositions) const
 {
 	if (!mesh)
 		return;
 
 	const u32 bcount = mesh->getMeshBufferCount();
 	for ( u32 b=0; b<bcount; ++b)
-		recalculateNormals(mesh->getMeshBuffer(b), smooth, angleWeighted);
+		recalculateNormals(mesh->getMeshBuffer(b), smooth, angleWeighted, weldPositions);
 }
 
 
@@ -250,179 +758,382 @@ void calculateTangents(
 }
 
 
-//! Recalculates tangents for a tangent mesh buffer
+//! Tangents of the last triangle corner of each vertex
 template <typename T>
-void recalculateTangentsT(IMeshBuffer* buffer, bool recalculateNormals, bool smooth, bool angleWeighted)
+struct SFlatTangentJob
 {
-	if (!buffer || (buffer->getVertexType()!= video::EVT_TANGENTS))
-		return;
-
-	const u32 vtxCnt = buffer->getVertexCount();
-	const u32 idxCnt = buffer->getIndexCount();
-
-	T* idx = reinterpret_cast<T*>(buffer->getIndices());
-	video::S3DVertexTangents* v =
-		(video::S3DVertexTangents*)buffer->getVertices();
-
-	if (smooth)
+	void operator()(u32 begin, u32 end, u32 worker) const
 	{
-		u32 i;
-
-		for ( i = 0; i!= vtxCnt; ++i )
+		core::vector3df localNormal;
+		for (u32 c=begin*3; c<end*3; ++c)
 		{
-			if (recalculateNormals)
-				v[i].Normal.set( 0.f, 0.f, 0.f );
-			v[i].Tangent.set( 0.f, 0.f, 0.f );
-			v[i].Binormal.set( 0.f, 0.f, 0.f );
-		}
-
-		//Each vertex gets the sum of the tangents and binormals from the faces around it
-		for ( i=0; i<idxCnt; i+=3)
-		{
-			// if this triangle is degenerate, skip it!
-			if (v[idx[i+0]].Pos == v[idx[i+1]].Pos ||
-				v[idx[i+0]].Pos == v[idx[i+2]].Pos ||
-				v[idx[i+1]].Pos == v[idx[i+2]].Pos
-				/*||
-				v[idx[i+0]].TCoords == v[idx[i+1]].TCoords ||
-				v[idx[i+0]].TCoords == v[idx[i+2]].TCoords ||
-				v[idx[i+1]].TCoords == v[idx[i+2]].TCoords */
-				)
+			video::S3DVertexTangents& vertex = Vertices[Indices[c]];
+			if (Last[Indices[c]] != c)
 				continue;
 
-			//Angle-weighted normals look better, but are slightly more CPU intensive to calculate
-			core::vector3df weight(1.f,1.f,1.f);
-			if (angleWeighted)
-				weight = irr::scene::getAngleWeight(v[i+0].Pos,v[i+1].Pos,v[i+2].Pos);	// writing irr::scene:: necessary for borland
-			core::vector3df localNormal;
-			core::vector3df localTangent;
-			core::vector3df localBinormal;
-
-			calculateTangents(
-				localNormal,
-				localTangent,
-				localBinormal,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].TCoords,
-				v[idx[i+1]].TCoords,
-				v[idx[i+2]].TCoords);
-
-			if (recalculateNormals)
-				v[idx[i+0]].Normal += localNormal * weight.X;
-			v[idx[i+0]].Tangent += localTangent * weight.X;
-			v[idx[i+0]].Binormal += localBinormal * weight.X;
-
+			const T* tri = Indices + c - c%3;
+			const u32 k = c%3;
+			const video::S3DVertexTangents& next = Vertices[tri[(k+1)%3]];
+			const video::S3DVertexTangents& prev = Vertices[tri[(k+2)%3]];
 			calculateTangents(
 				localNormal,
-				localTangent,
-				localBinormal,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].TCoords,
-				v[idx[i+2]].TCoords,
-				v[idx[i+0]].TCoords);
+				vertex.Tangent,
+				vertex.Binormal,
+				vertex.Pos,
+				next.Pos,
+				prev.Pos,
+				vertex.TCoords,
+				next.TCoords,
+				prev.TCoords);
+			if (RecalculateNormals)
+				vertex.Normal = localNormal;
+		}
+	}
 
-			if (recalculateNormals)
-				v[idx[i+1]].Normal += localNormal * weight.Y;
-			v[idx[i+1]].Tangent += localTangent * weight.Y;
-			v[idx[i+1]].Binormal += localBinormal * weight.Y;
+	video::S3DVertexTangents* Vertices;
+	const T* Indices;
+	const u32* Last;
+	bool RecalculateNormals;
+};
 
-			calculateTangents(
-				localNormal,
-				localTangent,
-				localBinormal,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].TCoords,
-				v[idx[i+0]].TCoords,
-				v[idx[i+1]].TCoords);
+//! Angle weights of all triangles
+template <typename T>
+struct SAngleWeightJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 t=begin; t<end; ++t)
+			Weights[t] = irr::scene::getAngleWeight(Vertices[Indices[t*3+0]].Pos,
+				Vertices[Indices[t*3+1]].Pos, Vertices[Indices[t*3+2]].Pos);
+	}
 
-			if (recalculateNormals)
-				v[idx[i+2]].Normal += localNormal * weight.Z;
-			v[idx[i+2]].Tangent += localTangent * weight.Z;
-			v[idx[i+2]].Binormal += localBinormal * weight.Z;
-		}
+	const video::S3DVertexTangents* Vertices;
+	const T* Indices;
+	core::vector3df* Weights;
+};
 
-		// Normalize the tangents and binormals
-		if (recalculateNormals)
-		{
-			for ( i = 0; i!= vtxCnt; ++i )
-				v[i].Normal.normalize();
-		}
-		for ( i = 0; i!= vtxCnt; ++i )
-		{
-			v[i].Tangent.normalize();
-			v[i].Binormal.normalize();
-		}
-	}
-	else
+//! Each vertex gets the sum of the tangents and binormals from the faces around it
+template <typename T>
+struct SSmoothTangentJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
 	{
 		core::vector3df localNormal;
-		for (u32 i=0; i<idxCnt; i+=3)
+		core::vector3df localTangent;
+		core::vector3df localBinormal;
+
+		for (u32 v=begin; v<end; ++v)
 		{
-			calculateTangents(
-				localNormal,
-				v[idx[i+0]].Tangent,
-				v[idx[i+0]].Binormal,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].TCoords,
-				v[idx[i+1]].TCoords,
-				v[idx[i+2]].TCoords);
-			if (recalculateNormals)
-				v[idx[i+0]].Normal=localNormal;
+			video::S3DVertexTangents& vertex = Vertices[v];
+			if (RecalculateNormals)
+				vertex.Normal.set(0.f, 0.f, 0.f);
+			vertex.Tangent.set(0.f, 0.f, 0.f);
+			vertex.Binormal.set(0.f, 0.f, 0.f);
 
-			calculateTangents(
-				localNormal,
-				v[idx[i+1]].Tangent,
-				v[idx[i+1]].Binormal,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].TCoords,
-				v[idx[i+2]].TCoords,
-				v[idx[i+0]].TCoords);
-			if (recalculateNormals)
-				v[idx[i+1]].Normal=localNormal;
+			for (u32 i=Corners->First[v]; i<Corners->First[v+1]; ++i)
+			{
+				const u32 c = Corners->Corners[i];
+				const T* tri = Indices + c - c%3;
+				const u32 k = c%3;
+				const video::S3DVertexTangents& next = Vertices[tri[(k+1)%3]];
+				const video::S3DVertexTangents& prev = Vertices[tri[(k+2)%3]];
+
+				// if this triangle is degenerate, skip it!
+				if (vertex.Pos == next.Pos || vertex.Pos == prev.Pos || next.Pos == prev.Pos)
+					continue;
 
-			calculateTangents(
-				localNormal,
-				v[idx[i+2]].Tangent,
-				v[idx[i+2]].Binormal,
-				v[idx[i+2]].Pos,
-				v[idx[i+0]].Pos,
-				v[idx[i+1]].Pos,
-				v[idx[i+2]].TCoords,
-				v[idx[i+0]].TCoords,
-				v[idx[i+1]].TCoords);
-			if (recalculateNormals)
-				v[idx[i+2]].Normal=localNormal;
+				//Angle-weighted normals look better, but are slightly more CPU intensive to calculate
+				const f32 weight = Weights ? getCornerWeight(Weights[c/3], k) : 1.f;
+
+				calculateTangents(
+					localNormal,
+					localTangent,
+					localBinormal,
+					vertex.Pos,
+					next.Pos,
+					prev.Pos,
+					vertex.TCoords,
+					next.TCoords,
+					prev.TCoords);
+
+				if (RecalculateNormals)
+					vertex.Normal += localNormal * weight;
+				vertex.Tangent += localTangent * weight;
+				vertex.Binormal += localBinormal * weight;
+			}
+
+			// Normalize the tangents and binormals
+			if (RecalculateNormals)
+				vertex.Normal.normalize();
+			vertex.Tangent.normalize();
+			vertex.Binormal.normalize();
 		}
 	}
-}
-}
 
+	video::S3DVertexTangents* Vertices;
+	const T* Indices;
+	const SVertexCorners* Corners;
+	const core::vector3df* Weights;
+	bool RecalculateNormals;
+};
 
-//! Recalculates tangents for a tangent mesh buffer
-void CMeshManipulator::recalculateTangents(IMeshBuffer* buffer, bool recalculateNormals, bool smooth, bool angleWeighted) const
+//! MikkTSpace tests against FLT_MIN instead of a rounding error
+inline bool mikkNotZero(f32 value)
 {
-	if (buffer && (buffer->getVertexType() == video::EVT_TANGENTS))
-	{
-		if (buffer->getIndexType() == video::EIT_16BIT)
-			recalculateTangentsT<u16>(buffer, recalculateNormals, smooth, angleWeighted);
-		else
-			recalculateTangentsT<u32>(buffer, recalculateNormals, smooth, angleWeighted);
-	}
+	return fabsf(value) > FLT_MIN;
 }
 
-
-//! Recalculates tangents for all tangent mesh buffers
-void CMeshManipulator::recalculateTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted) const
+inline bool mikkNotZero(const core::vector3df& v)
+{
+	return mikkNotZero(v.X) || mikkNotZero(v.Y) || mikkNotZero(v.Z);
+}
+
+//! Per triangle tangent directions as MikkTSpace calculates them
+template <typename T>
+struct SMikkFaceJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 t=begin; t<end; ++t)
+		{
+			const video::S3DVertexTangents& v1 = Vertices[Indices[t*3+0]];
+			const video::S3DVertexTangents& v2 = Vertices[Indices[t*3+1]];
+			const video::S3DVertexTangents& v3 = Vertices[Indices[t*3+2]];
+
+			const f32 t21x = v2.TCoords.X - v1.TCoords.X;
+			const f32 t21y = v2.TCoords.Y - v1.TCoords.Y;
+			const f32 t31x = v3.TCoords.X - v1.TCoords.X;
+			const f32 t31y = v3.TCoords.Y - v1.TCoords.Y;
+			const core::vector3df d1 = v2.Pos - v1.Pos;
+			const core::vector3df d2 = v3.Pos - v1.Pos;
+
+			const f32 signedAreaSTx2 = t21x*t31y - t21y*t31x;
+			Preserving[t] = signedAreaSTx2 > 0.f;
+
+			// triangles without texture area don't add to any tangent
+			Tangents[t].set(0.f, 0.f, 0.f);
+			if (mikkNotZero(signedAreaSTx2))
+			{
+				const core::vector3df os = d1*t31y - d2*t21y;
+				const f32 length = os.getLength();
+				if (mikkNotZero(length))
+					Tangents[t] = os * ((Preserving[t] ? 1.f : -1.f) / length);
+			}
+		}
+	}
+
+	const video::S3DVertexTangents* Vertices;
+	const T* Indices;
+	core::vector3df* Tangents;
+	bool* Preserving;
+};
+
+//! Project a vector into the plane of a normal and normalize it
+inline core::vector3df mikkProject(const core::vector3df& v, const core::vector3df& normal)
+{
+	core::vector3df p = v - normal * normal.dotProduct(v);
+	if (mikkNotZero(p))
+		p.normalize();
+	return p;
+}
+
+//! Sums up the projected, angle weighted triangle tangents of each vertex group
+template <typename T>
+struct SMikkVertexJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 v=begin; v<end; ++v)
+		{
+			if (Groups[v] != v)
+				continue;
+
+			video::S3DVertexTangents& vertex = Vertices[v];
+			const core::vector3df& n = vertex.Normal;
+
+			// MikkTSpace splits vertices with mirrored texture coordinates,
+			// here the orientation with the larger angle wins
+			core::vector3df sum[2];
+			f32 angleSum[2] = { 0.f, 0.f };
+			for (u32 i=Corners->First[v]; i<Corners->First[v+1]; ++i)
+			{
+				const u32 c = Corners->Corners[i];
+				const u32 t = c/3;
+				if (!mikkNotZero(Tangents[t]))
+					continue;
+
+				const T* tri = Indices + t*3;
+				const u32 k = c%3;
+				const core::vector3df& p0 = Vertices[tri[(k+2)%3]].Pos;
+				const core::vector3df& p1 = Vertices[tri[k]].Pos;
+				const core::vector3df& p2 = Vertices[tri[(k+1)%3]].Pos;
+
+				// weight contribution by the angle between the two edges
+				const core::vector3df e1 = mikkProject(p0 - p1, n);
+				const core::vector3df e2 = mikkProject(p2 - p1, n);
+				const f32 angle = acosf(core::clamp(e1.dotProduct(e2), -1.f, 1.f));
+
+				const u32 orientation = Preserving[t] ? 1 : 0;
+				sum[orientation] += mikkProject(Tangents[t], n) * angle;
+				angleSum[orientation] += angle;
+			}
+
+			const u32 orientation = angleSum[0] > angleSum[1] ? 0 : 1;
+			core::vector3df tangent = sum[orientation];
+			if (mikkNotZero(tangent))
+				tangent.normalize();
+			else
+			{
+				// no triangle with texture area, any tangent will do
+				tangent = n.crossProduct(fabsf(n.Y) < 0.99f ? core::vector3df(0.f, 1.f, 0.f) : core::vector3df(1.f, 0.f, 0.f));
+				tangent.normalize();
+			}
+
+			vertex.Tangent = tangent;
+			vertex.Binormal = n.crossProduct(tangent) * (orientation ? 1.f : -1.f);
+		}
+	}
+
+	video::S3DVertexTangents* Vertices;
+	const T* Indices;
+	const u32* Groups;
+	const SVertexCorners* Corners;
+	const core::vector3df* Tangents;
+	const bool* Preserving;
+};
+
+//! Vertices of a group copy the tangents of the first one
+struct SCopyGroupTangentJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 v=begin; v<end; ++v)
+		{
+			if (Groups[v] != v)
+			{
+				Vertices[v].Tangent = Vertices[Groups[v]].Tangent;
+				Vertices[v].Binormal = Vertices[Groups[v]].Binormal;
+			}
+		}
+	}
+
+	video::S3DVertexTangents* Vertices;
+	const u32* Groups;
+};
+
+//! MikkTSpace merges vertices with equal position, normal and texture coordinates
+struct SMikkGroupTest
+{
+	bool operator()(u32 i, u32 j) const
+	{
+		const video::S3DVertexTangents& a = Vertices[i];
+		const video::S3DVertexTangents& b = Vertices[j];
+		return a.Pos.X == b.Pos.X && a.Pos.Y == b.Pos.Y && a.Pos.Z == b.Pos.Z &&
+			a.Normal.X == b.Normal.X && a.Normal.Y == b.Normal.Y && a.Normal.Z == b.Normal.Z &&
+			a.TCoords.X == b.TCoords.X && a.TCoords.Y == b.TCoords.Y;
+	}
+
+	const video::S3DVertexTangents* Vertices;
+};
+
+//! Recalculates tangents like MikkTSpace for a tangent mesh buffer
+template <typename T>
+void recalculateTangentsMikkT(IMeshBuffer* buffer)
+{
+	const u32 vtxCnt = buffer->getVertexCount();
+	const u32 triCnt = buffer->getIndexCount() / 3;
+	const T* idx = reinterpret_cast<T*>(buffer->getIndices());
+	video::S3DVertexTangents* v = (video::S3DVertexTangents*)buffer->getVertices();
+	CWorkerPool& pool = CWorkerPool::getInstance();
+
+	core::array<core::vector3df> tangents(triCnt);
+	tangents.set_used(triCnt);
+	core::array<bool> preserving(triCnt);
+	preserving.set_used(triCnt);
+	SMikkFaceJob<T> faces = { v, idx, tangents.pointer(), preserving.pointer() };
+	pool.parallelFor(triCnt, TriangleGrainSize, faces);
+
+	core::array<u32> groups;
+	const SMikkGroupTest test = { v };
+	findSharedVertices(buffer, 0.f, test, groups);
+
+	SVertexCorners corners;
+	corners.build(idx, triCnt*3, vtxCnt, groups.const_pointer());
+
+	SMikkVertexJob<T> sum = { v, idx, groups.const_pointer(), &corners, tangents.const_pointer(), preserving.const_pointer() };
+	pool.parallelFor(vtxCnt, VertexGrainSize, sum);
+
+	SCopyGroupTangentJob copy = { v, groups.const_pointer() };
+	pool.parallelFor(vtxCnt, VertexGrainSize, copy);
+}
+
+//! Recalculates tangents for a tangent mesh buffer
+template <typename T>
+void recalculateTangentsT(IMeshBuffer* buffer, bool recalculateNormals, bool smooth, bool angleWeighted)
+{
+	if (!buffer || (buffer->getVertexType()!= video::EVT_TANGENTS))
+		return;
+
+	const u32 vtxCnt = buffer->getVertexCount();
+	const u32 triCnt = buffer->getIndexCount() / 3;
+
+	T* idx = reinterpret_cast<T*>(buffer->getIndices());
+	video::S3DVertexTangents* v =
+		(video::S3DVertexTangents*)buffer->getVertices();
+	CWorkerPool& pool = CWorkerPool::getInstance();
+
+	if (smooth)
+	{
+		core::array<core::vector3df> weights;
+		if (angleWeighted)
+		{
+			weights.set_used(triCnt);
+			SAngleWeightJob<T> job = { v, idx, weights.pointer() };
+			pool.parallelFor(triCnt, TriangleGrainSize, job);
+		}
+
+		SVertexCorners corners;
+		corners.build(idx, triCnt*3, vtxCnt, (const u32*)0);
+
+		SSmoothTangentJob<T> job = { v, idx, &corners, angleWeighted ? weights.const_pointer() : 0, recalculateNormals };
+		pool.parallelFor(vtxCnt, VertexGrainSize, job);
+	}
+	else
+	{
+		core::array<u32> last;
+		findLastCorners(idx, triCnt*3, vtxCnt, last);
+
+		SFlatTangentJob<T> job = { v, idx, last.const_pointer(), recalculateNormals };
+		pool.parallelFor(triCnt, TriangleGrainSize, job);
+	}
+}
+}
+
+
+//! Recalculates tangents for a tangent mesh buffer
+void CMeshManipulator::recalculateTangents(IMeshBuffer* buffer, bool recalculateNormals, bool smooth, bool angleWeighted, E_TANGENT_ALGORITHM algorithm) const
+{
+	if (buffer && (buffer->getVertexType() == video::EVT_TANGENTS))
+	{
+		if (algorithm == ETA_MIKKTSPACE)
+		{
+			if (recalculateNormals)
+				CMeshManipulator::recalculateNormals(buffer, smooth, angleWeighted);
+			if (buffer->getIndexType() == video::EIT_16BIT)
+				recalculateTangentsMikkT<u16>(buffer);
+			else
+				recalculateTangentsMikkT<u32>(buffer);
+		}
+		else if (buffer->getIndexType() == video::EIT_16BIT)
+			recalculateTangentsT<u16>(buffer, recalculateNormals, smooth, angleWeighted);
+		else
+			recalculateTangentsT<u32>(buffer, recalculateNormals, smooth, angleWeighted);
+	}
+}
+
+
+//! Recalculates tangents for all tangent mesh buffers
+void CMeshManipulator::recalculateTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted, E_TANGENT_ALGORITHM algorithm) const
 {
 	if (!mesh)
 		return;
@@ -430,7 +1141,7 @@ void CMeshManipulator::recalculateTangents(IMesh* mesh, bool recalculateNormals,
 	const u32 meshBufferCount = mesh->getMeshBufferCount();
 	for (u32 b=0; b<meshBufferCount; ++b)
 	{
-		recalculateTangents(mesh->getMeshBuffer(b), recalculateNormals, smooth, angleWeighted);
+		recalculateTangents(mesh->getMeshBuffer(b), recalculateNormals, smooth, angleWeighted, algorithm);
 	}
 }
 
@@ -762,171 +1473,61 @@ IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 
 
 //! Creates a copy of a mesh, which will have identical vertices welded together
-// not yet 32bit
+/** Each vertex is welded to the first vertex it matches, found with a spatial
+hash of the positions instead of comparing all vertex pairs. */
 IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
 {
 	SMesh* clone = new SMesh();
 	clone->BoundingBox = mesh->getBoundingBox();
 
-	core::array<u16> redirects;
+	core::array<u32> targets;
+	core::array<u32> vertices;
+	core::array<u32> indices;
+	core::array<u32> welded;
 
 	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
 	{
 		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
-		// reset redirect list
-		redirects.set_used(mb->getVertexCount());
-
-		const u16* indices = 0;
-		u32 indexCount = 0;
-		core::array<u16>* outIdx = 0;
 
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
-		{
-			SMeshBuffer* buffer = new SMeshBuffer();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertex* v =
-					(video::S3DVertex*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
-
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
-
-			buffer->Vertices.reallocate(vertexCount);
-
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-
+			findWeldTargetsT<video::S3DVertex>(mb, tolerance, targets);
 			break;
-		}
 		case video::EVT_2TCOORDS:
-		{
-			SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertex2TCoords* v =
-					(video::S3DVertex2TCoords*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
-
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
-
-			buffer->Vertices.reallocate(vertexCount);
-
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].TCoords2.equals( v[j].TCoords2 ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
+			findWeldTargetsT<video::S3DVertex2TCoords>(mb, tolerance, targets);
 			break;
-		}
 		case video::EVT_TANGENTS:
-		{
-			SMeshBufferTangents* buffer = new SMeshBufferTangents();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertexTangents* v =
-					(video::S3DVertexTangents*)mb->getVertices();
-
-			u32 vertexCount = mb->getVertexCount();
-
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
-
-			buffer->Vertices.reallocate(vertexCount);
-
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].Tangent.equals( v[j].Tangent, tolerance ) &&
-						 v[i].Binormal.equals( v[j].Binormal, tolerance ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
+			findWeldTargetsT<video::S3DVertexTangents>(mb, tolerance, targets);
 			break;
-		}
 		default:
 			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
-			break;
+			continue;
+		}
+
+		// keep the first vertex of each welded group, in vertex order
+		const u32 vertexCount = mb->getVertexCount();
+		vertices.set_used(0);
+		for (u32 i=0; i<vertexCount; ++i)
+		{
+			if (targets[i] == i)
+			{
+				targets[i] = vertices.size();
+				vertices.push_back(i);
+			}
+			else
+				targets[i] = targets[targets[i]];
 		}
 
 		// Clean up any degenerate tris
- 		core::array<u16> &Indices = *outIdx;
-		Indices.clear();
-		Indices.reallocate(indexCount);
-		for (u32 i = 0; i < indexCount; i+=3)
- 		{
-			u16 a, b, c;
-			a = redirects[indices[i]];
-			b = redirects[indices[i+1]];
-			c = redirects[indices[i+2]];
+		getIndices32(mb, indices);
+		welded.set_used(0);
+		welded.reallocate(indices.size());
+		for (u32 i = 0; i+2 < indices.size(); i+=3)
+		{
+			const u32 a = targets[indices[i]];
+			const u32 b = targets[indices[i+1]];
+			const u32 c = targets[indices[i+2]];
 
 			bool drop = false;
 
@@ -937,11 +1538,16 @@ IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
 
 			if (!drop)
 			{
-				Indices.push_back(a);
-				Indices.push_back(b);
-				Indices.push_back(c);
+				welded.push_back(a);
+				welded.push_back(b);
+				welded.push_back(c);
 			}
 		}
+
+		IMeshBuffer* buffer = createMeshBufferSubset(mb, vertices, welded);
+		buffer->setBoundingBox(mb->getBoundingBox());
+		clone->addMeshBuffer(buffer);
+		buffer->drop();
 	}
 	return clone;
 }
@@ -949,7 +1555,7 @@ IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
 
 //! Creates a copy of the mesh, which will only consist of S3DVertexTangents vertices.
 // not yet 32bit
-IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted, bool calculateTangents) const
+IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted, bool calculateTangents, E_TANGENT_ALGORITHM algorithm) const
 {
 	if (!mesh)
 		return 0;
@@ -1030,7 +1636,7 @@ IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNor
 
 	clone->recalculateBoundingBox();
 	if (calculateTangents)
-		recalculateTangents(clone, recalculateNormals, smooth, angleWeighted);
+		recalculateTangents(clone, recalculateNormals, smooth, angleWeighted, algorithm);
 
 	return clone;
 }
@@ -2145,6 +2751,954 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 	return newmesh;
 }
 
+namespace
+{
+
+//! Vertex position with its index, sorted to find vertices at the same position
+struct SPositionKey
+{
+	core::vector3df Pos;
+	u32 Index;
+
+	bool operator<(const SPositionKey& other) const
+	{
+		if (Pos.X != other.Pos.X)
+			return Pos.X < other.Pos.X;
+		if (Pos.Y != other.Pos.Y)
+			return Pos.Y < other.Pos.Y;
+		if (Pos.Z != other.Pos.Z)
+			return Pos.Z < other.Pos.Z;
+		return Index < other.Index;
+	}
+};
+
+//! Edge between two vertices, sorted to find neighbouring triangles
+struct SEdgeKey
+{
+	u32 A;
+	u32 B;
+	u32 Triangle;
+
+	bool operator<(const SEdgeKey& other) const
+	{
+		if (A != other.A)
+			return A < other.A;
+		if (B != other.B)
+			return B < other.B;
+		return Triangle < other.Triangle;
+	}
+};
+
+//! Symmetric 4x4 matrix summing the squared distances to a set of planes
+struct SQuadric
+{
+	f64 XX, XY, XZ, XW, YY, YZ, YW, ZZ, ZW, WW;
+	//! Sum of the plane weights
+	f64 Weight;
+
+	void reset()
+	{
+		XX = XY = XZ = XW = YY = YZ = YW = ZZ = ZW = WW = Weight = 0.0;
+	}
+
+	//! Add plane with normalized normal n and distance d, weighted by w
+	void addPlane(const core::vector3df& n, f64 d, f64 w)
+	{
+		const f64 a = n.X, b = n.Y, c = n.Z;
+		XX += w*a*a; XY += w*a*b; XZ += w*a*c; XW += w*a*d;
+		YY += w*b*b; YZ += w*b*c; YW += w*b*d;
+		ZZ += w*c*c; ZW += w*c*d;
+		WW += w*d*d;
+		Weight += w;
+	}
+
+	void add(const SQuadric& o)
+	{
+		XX += o.XX; XY += o.XY; XZ += o.XZ; XW += o.XW;
+		YY += o.YY; YZ += o.YZ; YW += o.YW;
+		ZZ += o.ZZ; ZW += o.ZW;
+		WW += o.WW;
+		Weight += o.Weight;
+	}
+
+	//! Weighted sum of squared distances of p to all planes
+	f64 eval(const core::vector3df& p) const
+	{
+		const f64 x = p.X, y = p.Y, z = p.Z;
+		return x*x*XX + y*y*YY + z*z*ZZ + WW +
+			2.0 * (x*y*XY + x*z*XZ + y*z*YZ + x*XW + y*YW + z*ZW);
+	}
+
+	//! Weighted mean of the squared distances
+	f64 getMeanError(const core::vector3df& p) const
+	{
+		return (Weight > 0.0) ? core::max_(eval(p), 0.0) / Weight : 0.0;
+	}
+};
+
+//! Collapse of the edge From-To into vertex To
+struct SEdgeCollapse
+{
+	f64 Cost;
+	u32 From;
+	u32 To;
+	u32 FromVersion;
+	u32 ToVersion;
+};
+
+//! Binary min heap of edge collapses
+/** Entries are not updated, outdated ones are detected by the vertex versions
+when they are popped. */
+class CCollapseHeap
+{
+public:
+	bool empty() const { return Data.empty(); }
+
+	void push(const SEdgeCollapse& c)
+	{
+		Data.push_back(c);
+		u32 i = Data.size() - 1;
+		while (i)
+		{
+			const u32 parent = (i - 1) >> 1;
+			if (Data[parent].Cost <= Data[i].Cost)
+				break;
+			core::swap(Data[parent], Data[i]);
+			i = parent;
+		}
+	}
+
+	SEdgeCollapse pop()
+	{
+		const SEdgeCollapse top = Data[0];
+		Data[0] = Data.getLast();
+		Data.erase(Data.size() - 1);
+
+		const u32 size = Data.size();
+		u32 i = 0;
+		for (;;)
+		{
+			const u32 left = 2*i + 1;
+			if (left >= size)
+				break;
+			u32 smallest = left;
+			if (left + 1 < size && Data[left+1].Cost < Data[left].Cost)
+				smallest = left + 1;
+			if (Data[i].Cost <= Data[smallest].Cost)
+				break;
+			core::swap(Data[i], Data[smallest]);
+			i = smallest;
+		}
+		return top;
+	}
+
+private:
+	core::array<SEdgeCollapse> Data;
+};
+
+//! Queue the collapse of vertex from onto vertex to
+/** The cost is the larger of the mean squared distances to the surface and
+to the border planes. */
+void pushCollapse(CCollapseHeap& heap, const IMeshBuffer* mb, const core::array<SQuadric>& faces,
+		const core::array<SQuadric>& borders, const core::array<u32>& version, u32 from, u32 to)
+{
+	const core::vector3df& target = mb->getPosition(to);
+	SQuadric face = faces[from];
+	face.add(faces[to]);
+	SQuadric border = borders[from];
+	border.add(borders[to]);
+
+	SEdgeCollapse c;
+	c.Cost = core::max_(face.getMeanError(target), border.getMeanError(target));
+	c.From = from;
+	c.To = to;
+	c.FromVersion = version[from];
+	c.ToVersion = version[to];
+	heap.push(c);
+}
+
+//! Edge collapse simplification with quadric error metrics.
+/** Based on Garland and Heckbert, "Surface Simplification Using Quadric Error
+Metrics". Each collapse moves one vertex onto a neighbour, so no new vertices
+are created. Face quadrics are weighted by triangle area, border quadrics by
+edge length. Both are normalized by their weight, so the root of the error is
+a mean distance to the planes in object space, not a bound on the distance.
+\param mb Mesh buffer with the vertices
+\param indices Triangle list, replaced by the simplified list
+\param targetTriangles Number of triangles to reach
+\param maxError Stop when the next collapse has a larger error, 0 for no limit
+\return Largest error of all collapses done */
+f32 simplifyTriangles(const IMeshBuffer* mb, core::array<u32>& indices, u32 targetTriangles, f32 maxError)
+{
+	const u32 vcount = mb->getVertexCount();
+	const u32 tcount = indices.size() / 3;
+	if (!vcount || tcount <= targetTriangles)
+		return 0.f;
+
+	const u8* vertexData = (const u8*)mb->getVertices();
+	const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+
+	// Merge vertices which are identical. Vertices sharing a position with
+	// different attributes are on a seam and must not move.
+	core::array<u32> remap(vcount);
+	core::array<bool> locked(vcount);
+	remap.set_used(vcount);
+	locked.set_used(vcount);
+	{
+		core::array<SPositionKey> keys(vcount);
+		keys.set_used(vcount);
+		for (u32 i=0; i<vcount; ++i)
+		{
+			keys[i].Pos = mb->getPosition(i);
+			keys[i].Index = i;
+			remap[i] = i;
+			locked[i] = false;
+		}
+		keys.sort();
+
+		for (u32 start=0; start<vcount; )
+		{
+			u32 end = start + 1;
+			while (end < vcount && keys[end].Pos == keys[start].Pos)
+				++end;
+
+			bool seam = false;
+			for (u32 i=start+1; i<end; ++i)
+			{
+				const u32 v = keys[i].Index;
+				for (u32 k=start; k<i; ++k)
+				{
+					const u32 w = keys[k].Index;
+					if (remap[w] == w && !memcmp(vertexData + v*pitch, vertexData + w*pitch, pitch))
+					{
+						remap[v] = w;
+						break;
+					}
+				}
+				if (remap[v] == v)
+					seam = true;
+			}
+			if (seam)
+			{
+				for (u32 i=start; i<end; ++i)
+					locked[keys[i].Index] = true;
+			}
+			start = end;
+		}
+	}
+
+	core::array<u32> tris(tcount*3);
+	tris.set_used(tcount*3);
+	for (u32 i=0; i<tcount*3; ++i)
+		tris[i] = remap[indices[i]];
+
+	core::array<bool> removed(tcount);
+	removed.set_used(tcount);
+	u32 liveTriangles = 0;
+	for (u32 t=0; t<tcount; ++t)
+	{
+		const u32* c = &tris[t*3];
+		removed[t] = (c[0] == c[1] || c[1] == c[2] || c[0] == c[2]);
+		if (!removed[t])
+			++liveTriangles;
+	}
+
+	// triangles around each vertex, and the face quadrics
+	core::array<u32>* vertexTris = new core::array<u32>[vcount];
+	core::array<SQuadric> quadrics(vcount);
+	core::array<SQuadric> borders(vcount);
+	quadrics.set_used(vcount);
+	borders.set_used(vcount);
+	for (u32 i=0; i<vcount; ++i)
+	{
+		quadrics[i].reset();
+		borders[i].reset();
+	}
+
+	core::array<SEdgeKey> edges(liveTriangles*3);
+	for (u32 t=0; t<tcount; ++t)
+	{
+		if (removed[t])
+			continue;
+
+		const u32* c = &tris[t*3];
+		const core::vector3df& p0 = mb->getPosition(c[0]);
+		core::vector3df normal = (mb->getPosition(c[1]) - p0).crossProduct(mb->getPosition(c[2]) - p0);
+		const f64 area = normal.getLength() * 0.5;
+		if (area > 0.0)
+		{
+			normal.normalize();
+			const f64 d = -normal.dotProduct(p0);
+			for (u32 k=0; k<3; ++k)
+				quadrics[c[k]].addPlane(normal, d, area);
+		}
+
+		for (u32 k=0; k<3; ++k)
+		{
+			vertexTris[c[k]].push_back(t);
+
+			SEdgeKey e;
+			e.A = core::min_(c[k], c[(k+1)%3]);
+			e.B = core::max_(c[k], c[(k+1)%3]);
+			e.Triangle = t;
+			edges.push_back(e);
+		}
+	}
+	edges.sort();
+
+	// Open borders get a plane perpendicular to the triangle through the edge,
+	// so they stay in place. Vertices of non-manifold edges are locked.
+	for (u32 start=0; start<edges.size(); )
+	{
+		u32 end = start + 1;
+		while (end < edges.size() && edges[end].A == edges[start].A && edges[end].B == edges[start].B)
+			++end;
+
+		const SEdgeKey& e = edges[start];
+		if (end - start == 1)
+		{
+			const u32* c = &tris[e.Triangle*3];
+			const core::vector3df& p0 = mb->getPosition(c[0]);
+			const core::vector3df normal = (mb->getPosition(c[1]) - p0).crossProduct(mb->getPosition(c[2]) - p0);
+			const core::vector3df dir = mb->getPosition(e.B) - mb->getPosition(e.A);
+			core::vector3df borderNormal = dir.crossProduct(normal);
+			if (borderNormal.getLengthSQ() > 0.f)
+			{
+				borderNormal.normalize();
+				const f64 d = -borderNormal.dotProduct(mb->getPosition(e.A));
+				const f64 w = dir.getLength();
+				borders[e.A].addPlane(borderNormal, d, w);
+				borders[e.B].addPlane(borderNormal, d, w);
+			}
+		}
+		else if (end - start > 2)
+		{
+			locked[e.A] = true;
+			locked[e.B] = true;
+		}
+		start = end;
+	}
+
+	core::array<u32> version(vcount);
+	version.set_used(vcount);
+	for (u32 i=0; i<vcount; ++i)
+		version[i] = 0;
+
+	CCollapseHeap heap;
+	for (u32 i=0; i<edges.size(); ++i)
+	{
+		if (i && edges[i].A == edges[i-1].A && edges[i].B == edges[i-1].B)
+			continue;
+		if (!locked[edges[i].A])
+			pushCollapse(heap, mb, quadrics, borders, version, edges[i].A, edges[i].B);
+		if (!locked[edges[i].B])
+			pushCollapse(heap, mb, quadrics, borders, version, edges[i].B, edges[i].A);
+	}
+	edges.clear();
+
+	const f64 maxCost = (maxError > 0.f) ? (f64)maxError * maxError : -1.0;
+	f64 worstCost = 0.0;
+	core::array<u32> neighbours;
+
+	while (liveTriangles > targetTriangles && !heap.empty())
+	{
+		const SEdgeCollapse top = heap.pop();
+		const u32 from = top.From;
+		const u32 to = top.To;
+		if (remap[from] != from || remap[to] != to ||
+			top.FromVersion != version[from] || top.ToVersion != version[to])
+			continue;
+
+		if (maxCost >= 0.0 && top.Cost > maxCost)
+			break;
+
+		// the edge has to exist and no remaining triangle may flip
+		const core::vector3df& target = mb->getPosition(to);
+		u32 shared = 0;
+		bool flips = false;
+		const core::array<u32>& fromTris = vertexTris[from];
+		for (u32 i=0; i<fromTris.size() && !flips; ++i)
+		{
+			const u32 t = fromTris[i];
+			if (removed[t])
+				continue;
+			const u32* tc = &tris[t*3];
+			if (tc[0] == to || tc[1] == to || tc[2] == to)
+			{
+				++shared;
+				continue;
+			}
+
+			core::vector3df p[3];
+			for (u32 k=0; k<3; ++k)
+				p[k] = mb->getPosition(tc[k]);
+			const core::vector3df before = (p[1] - p[0]).crossProduct(p[2] - p[0]);
+			for (u32 k=0; k<3; ++k)
+				if (tc[k] == from)
+					p[k] = target;
+			const core::vector3df after = (p[1] - p[0]).crossProduct(p[2] - p[0]);
+			flips = before.dotProduct(after) <= 0.f;
+		}
+		if (!shared || flips)
+			continue;
+
+		// collapse
+		for (u32 i=0; i<fromTris.size(); ++i)
+		{
+			const u32 t = fromTris[i];
+			if (removed[t])
+				continue;
+			u32* tc = &tris[t*3];
+			if (tc[0] == to || tc[1] == to || tc[2] == to)
+			{
+				removed[t] = true;
+				--liveTriangles;
+				continue;
+			}
+			for (u32 k=0; k<3; ++k)
+				if (tc[k] == from)
+					tc[k] = to;
+			vertexTris[to].push_back(t);
+		}
+		vertexTris[from].clear();
+		remap[from] = to;
+		quadrics[to].add(quadrics[from]);
+		borders[to].add(borders[from]);
+		++version[to];
+		worstCost = core::max_(worstCost, top.Cost);
+
+		// compact the triangle list and find the new neighbours
+		core::array<u32>& toTris = vertexTris[to];
+		neighbours.set_used(0);
+		u32 used = 0;
+		for (u32 i=0; i<toTris.size(); ++i)
+		{
+			const u32 t = toTris[i];
+			if (removed[t])
+				continue;
+			toTris[used++] = t;
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 w = tris[t*3+k];
+				if (w != to && neighbours.linear_search(w) == -1)
+					neighbours.push_back(w);
+			}
+		}
+		toTris.set_used(used);
+
+		for (u32 i=0; i<neighbours.size(); ++i)
+		{
+			const u32 w = neighbours[i];
+			if (!locked[to])
+				pushCollapse(heap, mb, quadrics, borders, version, to, w);
+			if (!locked[w])
+				pushCollapse(heap, mb, quadrics, borders, version, w, to);
+		}
+	}
+
+	delete [] vertexTris;
+
+	indices.set_used(0);
+	for (u32 t=0; t<tcount; ++t)
+	{
+		if (removed[t])
+			continue;
+		indices.push_back(tris[t*3]);
+		indices.push_back(tris[t*3+1]);
+		indices.push_back(tris[t*3+2]);
+	}
+
+	return (f32)sqrt(worstCost);
+}
+
+//! Hash of the memory of one vertex, FNV-1a on 32 bit words
+inline u32 hashVertex(const u8* vertex, u32 pitch)
+{
+	const u32* words = (const u32*)vertex;
+	u32 hash = 2166136261u;
+	for (u32 i=0; i<pitch/4; ++i)
+	{
+		hash ^= words[i];
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+//! Redirect all indices to the first of bitwise identical vertices
+void mergeIdenticalVertices(const IMeshBuffer* mb, core::array<u32>& indices)
+{
+	const u32 vcount = mb->getVertexCount();
+	const u8* vertexData = (const u8*)mb->getVertices();
+	const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+
+	// open addressing table, at most half filled
+	u32 tableSize = 16;
+	while (tableSize < vcount*2)
+		tableSize <<= 1;
+	const u32 mask = tableSize - 1;
+	core::array<u32> table(tableSize);
+	table.set_used(tableSize);
+	for (u32 i=0; i<tableSize; ++i)
+		table[i] = 0xffffffff;
+
+	core::array<u32> remap(vcount);
+	remap.set_used(vcount);
+	for (u32 v=0; v<vcount; ++v)
+	{
+		const u8* vertex = vertexData + v*pitch;
+		u32 slot = hashVertex(vertex, pitch) & mask;
+		for (;;)
+		{
+			const u32 entry = table[slot];
+			if (entry == 0xffffffff)
+			{
+				table[slot] = v;
+				remap[v] = v;
+				break;
+			}
+			if (!memcmp(vertexData + entry*pitch, vertex, pitch))
+			{
+				remap[v] = entry;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	for (u32 i=0; i<indices.size(); ++i)
+		indices[i] = remap[indices[i]];
+}
+
+//! Count the vertex transformations of a triangle list with a FIFO cache
+/** \return Number of cache misses */
+u32 simulateVertexCache(const core::array<u32>& indices, u32 vertexCount, u32 cacheSize)
+{
+	// a vertex is in the cache when less than cacheSize misses happened since it was loaded
+	core::array<u32> timestamps(vertexCount);
+	timestamps.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		timestamps[i] = 0;
+
+	u32 time = cacheSize + 1;
+	for (u32 i=0; i<indices.size(); ++i)
+	{
+		const u32 v = indices[i];
+		if (time - timestamps[v] > cacheSize)
+			timestamps[v] = time++;
+	}
+	return time - cacheSize - 1;
+}
+
+//! Reorder triangles for the vertex cache with Tipsify
+/** Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality
+and Reduced Overdraw". Triangles are emitted as fans around a vertex, the next
+fan vertex is one of the last fan which will still be in the cache.
+\param indices Triangle list, replaced by the reordered list
+\param clusters Receives the first triangle of each cluster. Clusters start
+where the algorithm had to jump to a vertex outside of the cache, so they can
+be reordered with little loss of cache efficiency. */
+void tipsifyTriangles(core::array<u32>& indices, u32 vertexCount, u32 cacheSize, core::array<u32>& clusters)
+{
+	const u32 tcount = indices.size() / 3;
+
+	// triangles around each vertex as one compressed list
+	core::array<u32> live(vertexCount);
+	core::array<u32> offsets(vertexCount+1);
+	core::array<u32> timestamps(vertexCount);
+	live.set_used(vertexCount);
+	offsets.set_used(vertexCount+1);
+	timestamps.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		live[i] = 0;
+		timestamps[i] = 0;
+	}
+	for (u32 i=0; i<indices.size(); ++i)
+		++live[indices[i]];
+
+	offsets[0] = 0;
+	for (u32 i=0; i<vertexCount; ++i)
+		offsets[i+1] = offsets[i] + live[i];
+
+	core::array<u32> adjacency(indices.size());
+	adjacency.set_used(indices.size());
+	for (u32 i=0; i<indices.size(); ++i)
+		adjacency[offsets[indices[i]]++] = i / 3;
+	// filling has moved each offset to the start of the next vertex
+	for (u32 i=vertexCount; i>0; --i)
+		offsets[i] = offsets[i-1];
+	offsets[0] = 0;
+
+	core::array<bool> emitted(tcount);
+	emitted.set_used(tcount);
+	for (u32 i=0; i<tcount; ++i)
+		emitted[i] = false;
+
+	core::array<u32> result(indices.size());
+	core::array<u32> deadEnds;
+	core::array<u32> candidates;
+	clusters.set_used(0);
+
+	u32 time = cacheSize + 1;
+	u32 cursor = 0;
+	s32 fanning = -1;
+	while (cursor < vertexCount && fanning < 0)
+	{
+		if (live[cursor])
+			fanning = cursor;
+		++cursor;
+	}
+	bool newCluster = true;
+
+	while (fanning >= 0)
+	{
+		if (newCluster)
+		{
+			clusters.push_back(result.size() / 3);
+			newCluster = false;
+		}
+
+		candidates.set_used(0);
+		for (u32 a=offsets[fanning]; a<offsets[fanning+1]; ++a)
+		{
+			const u32 t = adjacency[a];
+			if (emitted[t])
+				continue;
+
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 v = indices[t*3+k];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - timestamps[v] > cacheSize)
+					timestamps[v] = time++;
+			}
+			emitted[t] = true;
+		}
+
+		// next fan around the candidate staying longest in the cache, but
+		// only when its remaining triangles don't push it out
+		fanning = -1;
+		s32 best = -1;
+		for (u32 i=0; i<candidates.size(); ++i)
+		{
+			const u32 v = candidates[i];
+			if (!live[v])
+				continue;
+
+			s32 priority = 0;
+			if (time - timestamps[v] + 2*live[v] <= cacheSize)
+				priority = time - timestamps[v];
+			if (priority > best)
+			{
+				best = priority;
+				fanning = v;
+			}
+		}
+
+		if (fanning < 0)
+		{
+			// dead end, go back to recently used vertices or any vertex left
+			while (!deadEnds.empty() && fanning < 0)
+			{
+				const u32 v = deadEnds.getLast();
+				deadEnds.set_used(deadEnds.size() - 1);
+				if (live[v])
+					fanning = v;
+			}
+			while (cursor < vertexCount && fanning < 0)
+			{
+				if (live[cursor])
+					fanning = cursor;
+				++cursor;
+			}
+			newCluster = true;
+		}
+	}
+
+	indices = result;
+}
+
+//! Sort key of a triangle cluster for overdraw
+struct SClusterOrder
+{
+	f32 Key;
+	u32 Start;
+	u32 End;
+
+	//! sorts clusters with larger keys first
+	bool operator<(const SClusterOrder& other) const
+	{
+		return Key > other.Key;
+	}
+};
+
+//! Sort triangle clusters to reduce overdraw
+/** Clusters facing away from the mesh center are likely in front of other
+clusters and are drawn first. Hard clusters are split further as long as
+the cache miss ratio of the parts stays within threshold of the whole list.
+\param indices Triangle list, ordered by tipsifyTriangles
+\param hardClusters First triangle of each cluster found by tipsifyTriangles */
+void sortClustersForOverdraw(const IMeshBuffer* mb, core::array<u32>& indices,
+		const core::array<u32>& hardClusters, u32 cacheSize, f32 threshold)
+{
+	const u32 vcount = mb->getVertexCount();
+	const u32 tcount = indices.size() / 3;
+	if (!tcount)
+		return;
+
+	const f32 targetACMR = threshold * simulateVertexCache(indices, vcount, cacheSize) / tcount;
+
+	// soft boundaries, each cluster starts with an empty cache
+	core::array<u32> clusters;
+	core::array<u32> timestamps(vcount);
+	timestamps.set_used(vcount);
+	for (u32 i=0; i<vcount; ++i)
+		timestamps[i] = 0;
+
+	u32 time = cacheSize + 1;
+	for (u32 c=0; c<hardClusters.size(); ++c)
+	{
+		const u32 end = (c+1 < hardClusters.size()) ? hardClusters[c+1] : tcount;
+		u32 start = hardClusters[c];
+		u32 misses = 0;
+		clusters.push_back(start);
+		time += cacheSize + 1;
+
+		for (u32 t=hardClusters[c]; t<end; ++t)
+		{
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 v = indices[t*3+k];
+				if (time - timestamps[v] > cacheSize)
+				{
+					timestamps[v] = time++;
+					++misses;
+				}
+			}
+
+			if (t+1 < end && misses <= targetACMR * (t+1 - start))
+			{
+				start = t + 1;
+				misses = 0;
+				clusters.push_back(start);
+				time += cacheSize + 1;
+			}
+		}
+	}
+
+	core::vector3df meshCenter;
+	for (u32 i=0; i<vcount; ++i)
+		meshCenter += mb->getPosition(i);
+	meshCenter /= (f32)core::max_(vcount, 1u);
+
+	// area weighted center and normal of each cluster
+	core::array<SClusterOrder> order(clusters.size());
+	for (u32 c=0; c<clusters.size(); ++c)
+	{
+		SClusterOrder cluster;
+		cluster.Start = clusters[c];
+		cluster.End = (c+1 < clusters.size()) ? clusters[c+1] : tcount;
+
+		core::vector3df center;
+		core::vector3df normal;
+		f32 area = 0.f;
+		for (u32 t=cluster.Start; t<cluster.End; ++t)
+		{
+			const core::vector3df& p0 = mb->getPosition(indices[t*3]);
+			const core::vector3df& p1 = mb->getPosition(indices[t*3+1]);
+			const core::vector3df& p2 = mb->getPosition(indices[t*3+2]);
+			const core::vector3df n = (p1 - p0).crossProduct(p2 - p0);
+			const f32 a = n.getLength();
+			center += (p0 + p1 + p2) * (a / 3.f);
+			normal += n;
+			area += a;
+		}
+		if (area > 0.f)
+			center /= area;
+		normal.normalize();
+
+		cluster.Key = (center - meshCenter).dotProduct(normal);
+		order.push_back(cluster);
+	}
+	order.sort();
+
+	core::array<u32> result(indices.size());
+	for (u32 c=0; c<order.size(); ++c)
+	{
+		for (u32 i=order[c].Start*3; i<order[c].End*3; ++i)
+			result.push_back(indices[i]);
+	}
+	indices = result;
+}
+
+} // end anonymous namespace
+
+
+//! Creates a simplified copy of the mesh
+IMesh* CMeshManipulator::createSimplifiedMesh(IMesh* mesh, f32 triangleRatio, f32 maxError, f32* outError) const
+{
+	if (outError)
+		*outError = 0.f;
+	if (!mesh)
+		return 0;
+
+	SMesh* result = new SMesh();
+	core::array<u32> indices;
+	core::array<u32> vertices;
+
+	const u32 mbcount = mesh->getMeshBufferCount();
+	for (u32 b=0; b<mbcount; ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		getIndices32(mb, indices);
+
+		const u32 target = (u32)(indices.size() / 3 * core::clamp(triangleRatio, 0.f, 1.f));
+		const f32 error = simplifyTriangles(mb, indices, target, maxError);
+		if (outError)
+			*outError = core::max_(*outError, error);
+
+		// keep only the vertices still used
+		compactVertices(mb->getVertexCount(), indices, vertices);
+
+		IMeshBuffer* buffer = createMeshBufferSubset(mb, vertices, indices);
+		result->addMeshBuffer(buffer);
+		buffer->drop();
+	}
+
+	result->recalculateBoundingBox();
+	return result;
+}
+
+
+//! Creates a mesh with several levels of detail
+SLODMesh* CMeshManipulator::createLODMesh(IMesh* mesh, u32 levelCount, f32 triangleRatio) const
+{
+	if (!mesh)
+		return 0;
+
+	SLODMesh* lod = new SLODMesh();
+	lod->addLevel(mesh, 0.f);
+
+	IMesh* previous = mesh;
+	u32 previousTriangles = getPolyCount(mesh);
+	f32 error = 0.f;
+
+	for (u32 i=1; i<levelCount && previousTriangles; ++i)
+	{
+		f32 levelError = 0.f;
+		IMesh* level = createSimplifiedMesh(previous, triangleRatio, 0.f, &levelError);
+		const u32 triangles = getPolyCount(level);
+
+		// stop when the mesh can't be reduced any further in a useful way
+		if (triangles * 20 >= previousTriangles * 19)
+		{
+			level->drop();
+			break;
+		}
+
+		// errors of chained levels add up at most
+		error += levelError;
+		lod->addLevel(level, error);
+		level->drop();
+
+		previous = level;
+		previousTriangles = triangles;
+	}
+
+	lod->recalculateBoundingBox();
+	return lod;
+}
+
+
+//! Creates a copy of the mesh optimized for vertex cache, overdraw and vertex fetch
+IMesh* CMeshManipulator::createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold, u32 cacheSize) const
+{
+	if (!mesh)
+		return 0;
+
+	SMesh* result = new SMesh();
+	core::array<u32> indices;
+	core::array<u32> reordered;
+	core::array<u32> clusters;
+	core::array<u32> vertices;
+
+	const u32 mbcount = mesh->getMeshBufferCount();
+	for (u32 b=0; b<mbcount; ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		const u32 vcount = mb->getVertexCount();
+		getIndices32(mb, indices);
+
+		mergeIdenticalVertices(mb, indices);
+
+		// keep the source order when it is already better, e.g. for regular grids
+		reordered = indices;
+		tipsifyTriangles(reordered, vcount, cacheSize, clusters);
+		if (simulateVertexCache(reordered, vcount, cacheSize) < simulateVertexCache(indices, vcount, cacheSize))
+			indices = reordered;
+		else
+		{
+			clusters.set_used(1);
+			clusters[0] = 0;
+		}
+		if (overdrawThreshold >= 1.f)
+			sortClustersForOverdraw(mb, indices, clusters, cacheSize, overdrawThreshold);
+		compactVertices(vcount, indices, vertices);
+
+		IMeshBuffer* buffer = createMeshBufferSubset(mb, vertices, indices);
+		result->addMeshBuffer(buffer);
+		buffer->drop();
+	}
+
+	result->BoundingBox = mesh->getBoundingBox();
+	return result;
+}
+
+
+//! Simulates the post transform vertex cache for the mesh
+SVertexCacheStatistics CMeshManipulator::getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize) const
+{
+	SVertexCacheStatistics stats;
+	if (!mesh)
+		return stats;
+
+	u32 transformed = 0;
+	core::array<u32> indices;
+	core::array<bool> used;
+
+	const u32 mbcount = mesh->getMeshBufferCount();
+	for (u32 b=0; b<mbcount; ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		const u32 vcount = mb->getVertexCount();
+		getIndices32(mb, indices);
+
+		transformed += simulateVertexCache(indices, vcount, cacheSize);
+		stats.TriangleCount += indices.size() / 3;
+
+		used.set_used(vcount);
+		for (u32 i=0; i<vcount; ++i)
+			used[i] = false;
+		for (u32 i=0; i<indices.size(); ++i)
+		{
+			if (!used[indices[i]])
+			{
+				used[indices[i]] = true;
+				++stats.VertexCount;
+			}
+		}
+	}
+
+	if (stats.TriangleCount)
+		stats.ACMR = (f32)transformed / stats.TriangleCount;
+	if (stats.VertexCount)
+		stats.ATVR = (f32)transformed / stats.VertexCount;
+	return stats;
+}
+
 } // end namespace scene
 } // end namespace irr
 
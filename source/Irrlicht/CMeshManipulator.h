@@ -28,12 +28,12 @@ public:
 	//! Recalculates all normals of the mesh.
 	/** \param mesh: Mesh on which the operation is performed.
 	\param smooth: Whether to use smoothed normals. */
-	virtual void recalculateNormals(scene::IMesh* mesh, bool smooth = false, bool angleWeighted = false) const _IRR_OVERRIDE_;
+	virtual void recalculateNormals(scene::IMesh* mesh, bool smooth = false, bool angleWeighted = false, bool weldPositions = false) const _IRR_OVERRIDE_;
 
 	//! Recalculates all normals of the mesh buffer.
 	/** \param buffer: Mesh buffer on which the operation is performed.
 	\param smooth: Whether to use smoothed normals. */
-	virtual void recalculateNormals(IMeshBuffer* buffer, bool smooth = false, bool angleWeighted = false) const _IRR_OVERRIDE_;
+	virtual void recalculateNormals(IMeshBuffer* buffer, bool smooth = false, bool angleWeighted = false, bool weldPositions = false) const _IRR_OVERRIDE_;
 
 	//! Clones a static IMesh into a modifiable SMesh.
 	virtual SMesh* createMeshCopy(scene::IMesh* mesh) const _IRR_OVERRIDE_;
@@ -55,13 +55,13 @@ public:
 	void makePlanarTextureMapping(scene::IMesh* mesh, f32 resolutionS, f32 resolutionT, u8 axis, const core::vector3df& offset) const _IRR_OVERRIDE_;
 
 	//! Recalculates tangents, requires a tangent mesh buffer
-	virtual void recalculateTangents(IMeshBuffer* buffer, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false) const _IRR_OVERRIDE_;
+	virtual void recalculateTangents(IMeshBuffer* buffer, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false, E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const _IRR_OVERRIDE_;
 
 	//! Recalculates tangents, requires a tangent mesh
-	virtual void recalculateTangents(IMesh* mesh, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false) const _IRR_OVERRIDE_;
+	virtual void recalculateTangents(IMesh* mesh, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false, E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const _IRR_OVERRIDE_;
 
 	//! Creates a copy of the mesh, which will only consist of S3DVertexTangents vertices.
-	virtual IMesh* createMeshWithTangents(IMesh* mesh, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false, bool recalculateTangents=true) const _IRR_OVERRIDE_;
+	virtual IMesh* createMeshWithTangents(IMesh* mesh, bool recalculateNormals=false, bool smooth=false, bool angleWeighted=false, bool recalculateTangents=true, E_TANGENT_ALGORITHM algorithm=ETA_IRRLICHT) const _IRR_OVERRIDE_;
 
 	//! Creates a copy of the mesh, which will only consist of S3D2TCoords vertices.
 	virtual IMesh* createMeshWith2TCoords(IMesh* mesh) const _IRR_OVERRIDE_;
@@ -87,6 +87,18 @@ public:
 	//! create a mesh optimized for the vertex cache
 	virtual IMesh* createForsythOptimizedMesh(const scene::IMesh *mesh) const _IRR_OVERRIDE_;
 
+	//! Creates a simplified copy of the mesh
+	virtual IMesh* createSimplifiedMesh(IMesh* mesh, f32 triangleRatio, f32 maxError=0.f, f32* outError=0) const _IRR_OVERRIDE_;
+
+	//! Creates a mesh with several levels of detail
+	virtual SLODMesh* createLODMesh(IMesh* mesh, u32 levelCount=4, f32 triangleRatio=0.5f) const _IRR_OVERRIDE_;
+
+	//! Creates a copy of the mesh optimized for vertex cache, overdraw and vertex fetch
+	virtual IMesh* createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold=1.05f, u32 cacheSize=16) const _IRR_OVERRIDE_;
+
+	//! Simulates the post transform vertex cache for the mesh
+	virtual SVertexCacheStatistics getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize=16) const _IRR_OVERRIDE_;
+
 	//! Optimizes the mesh using an algorithm tuned for heightmaps
 	virtual void heightmapOptimizeMesh(IMesh * const m, const f32 tolerance = core::ROUNDING_ERROR_f32) const _IRR_OVERRIDE_;
 
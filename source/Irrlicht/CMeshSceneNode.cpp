@@ -12,6 +12,7 @@
 #include "IMaterialRenderer.h"
 #include "IFileSystem.h"
 #include "CShadowVolumeSceneNode.h"
+#include "SLODMesh.h"
 
 namespace irr
 {
@@ -24,8 +25,8 @@ namespace scene
 CMeshSceneNode::CMeshSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
 			const core::vector3df& position, const core::vector3df& rotation,
 			const core::vector3df& scale)
-: IMeshSceneNode(parent, mgr, id, position, rotation, scale), Mesh(0), Shadow(0),
-	PassCount(0), ReadOnlyMaterials(false)
+: IMeshSceneNode(parent, mgr, id, position, rotation, scale), Mesh(0), LODMesh(0),
+	LODLevel(0), Shadow(0), PassCount(0), ReadOnlyMaterials(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CMeshSceneNode");
@@ -50,6 +51,9 @@ void CMeshSceneNode::OnRegisterSceneNode()
 {
 	if (IsVisible)
 	{
+		if (LODMesh)
+			updateLODLevel();
+
 		// because this node supports rendering of mixed mode meshes consisting of
 		// transparent and solid material at the same time, we need to go through all
 		// materials, check of what type they are and register this node for the right
@@ -120,6 +124,9 @@ void CMeshSceneNode::render()
 	if (!Mesh || !driver)
 		return;
 
+	// draw the level of detail selected in OnRegisterSceneNode
+	IMesh* mesh = LODMesh ? LODMesh->getLevel(LODLevel) : Mesh;
+
 	bool isTransparentPass =
 		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
 
@@ -140,12 +147,12 @@ void CMeshSceneNode::render()
 		// overwrite half transparency
 		if (DebugDataVisible & scene::EDS_HALF_TRANSPARENCY)
 		{
-			for (u32 g=0; g<Mesh->getMeshBufferCount(); ++g)
+			for (u32 g=0; g<mesh->getMeshBufferCount(); ++g)
 			{
 				mat = Materials[g];
 				mat.MaterialType = video::EMT_TRANSPARENT_ADD_COLOR;
 				driver->setMaterial(mat);
-				driver->drawMeshBuffer(Mesh->getMeshBuffer(g));
+				driver->drawMeshBuffer(mesh->getMeshBuffer(g));
 			}
 			renderMeshes = false;
 		}
@@ -154,9 +161,9 @@ void CMeshSceneNode::render()
 	// render original meshes
 	if (renderMeshes)
 	{
-		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+		for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
 		{
-			scene::IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
 			if (mb)
 			{
 				const video::SMaterial& material = ReadOnlyMaterials ? mb->getMaterial() : Materials[i];
@@ -191,10 +198,10 @@ void CMeshSceneNode::render()
 		}
 		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
 		{
-			for (u32 g=0; g<Mesh->getMeshBufferCount(); ++g)
+			for (u32 g=0; g<mesh->getMeshBufferCount(); ++g)
 			{
 				driver->draw3DBox(
-					Mesh->getMeshBuffer(g)->getBoundingBox(),
+					mesh->getMeshBuffer(g)->getBoundingBox(),
 					video::SColor(255,190,128,128));
 			}
 		}
@@ -204,11 +211,11 @@ void CMeshSceneNode::render()
 			// draw normals
 			const f32 debugNormalLength = SceneManager->getParameters()->getAttributeAsFloat(DEBUG_NORMAL_LENGTH);
 			const video::SColor debugNormalColor = SceneManager->getParameters()->getAttributeAsColor(DEBUG_NORMAL_COLOR);
-			const u32 count = Mesh->getMeshBufferCount();
+			const u32 count = mesh->getMeshBufferCount();
 
 			for (u32 i=0; i != count; ++i)
 			{
-				driver->drawMeshBufferNormals(Mesh->getMeshBuffer(i), debugNormalLength, debugNormalColor);
+				driver->drawMeshBufferNormals(mesh->getMeshBuffer(i), debugNormalLength, debugNormalColor);
 			}
 		}
 
@@ -218,15 +225,61 @@ void CMeshSceneNode::render()
 			m.Wireframe = true;
 			driver->setMaterial(m);
 
-			for (u32 g=0; g<Mesh->getMeshBufferCount(); ++g)
+			for (u32 g=0; g<mesh->getMeshBufferCount(); ++g)
 			{
-				driver->drawMeshBuffer(Mesh->getMeshBuffer(g));
+				driver->drawMeshBuffer(mesh->getMeshBuffer(g));
 			}
 		}
 	}
 }
 
 
+//! Selects the coarsest level of detail which is still precise enough
+void CMeshSceneNode::updateLODLevel()
+{
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	const u32 levelCount = LODMesh->getLevelCount();
+	if (!camera || levelCount < 2)
+	{
+		LODLevel = 0;
+		return;
+	}
+
+	// screen pixels covered by one unit in object space at the node's distance
+	const core::vector3df scale = AbsoluteTransformation.getScale();
+	const f32 maxScale = core::max_(core::abs_(scale.X), core::abs_(scale.Y), core::abs_(scale.Z));
+	f32 pixelsPerUnit = SceneManager->getVideoDriver()->getViewPort().getHeight() * 0.5f *
+		core::abs_(camera->getProjectionMatrix()[5]) * maxScale;
+
+	if (!camera->isOrthogonal())
+	{
+		// use the nearest point of the bounding sphere
+		const core::aabbox3df box = getTransformedBoundingBox();
+		const f32 distance = camera->getAbsolutePosition().getDistanceFrom(box.getCenter()) -
+			box.getExtent().getLength() * 0.5f;
+
+		if (distance <= camera->getNearValue())
+		{
+			LODLevel = 0;
+			return;
+		}
+		pixelsPerUnit /= distance;
+	}
+
+	const f32 maxError = LODMesh->MaxScreenError;
+	u32 level = 0;
+	while (level+1 < levelCount && LODMesh->getLevelError(level+1) * pixelsPerUnit <= maxError)
+		++level;
+
+	// a coarser level than the current one has to be clearly good enough,
+	// otherwise nodes at the threshold distance would flicker between two levels
+	while (level > LODLevel && LODMesh->getLevelError(level) * pixelsPerUnit > maxError * (1.f - LODMesh->Hysteresis))
+		--level;
+
+	LODLevel = level;
+}
+
+
 //! Removes a child from this scene node.
 //! Implemented here, to be able to remove the shadow properly, if there is one,
 //! or to remove attached childs.
@@ -289,6 +342,8 @@ void CMeshSceneNode::setMesh(IMesh* mesh)
 			Mesh->drop();
 
 		Mesh = mesh;
+		LODMesh = (Mesh->getMeshType() == EAMT_LOD) ? static_cast<SLODMesh*>(Mesh) : 0;
+		LODLevel = 0;
 		copyMaterials();
 	}
 }
@@ -363,7 +418,10 @@ void CMeshSceneNode::deserializeAttributes(io::IAttributes* in, io::SAttributeRe
 		IMesh* newMesh = 0;
 		IAnimatedMesh* newAnimatedMesh = SceneManager->getMesh(newMeshStr.c_str());
 
-		if (newAnimatedMesh)
+		// meshes with several levels of detail are selected by the node itself
+		if (newAnimatedMesh && newAnimatedMesh->getMeshType() == EAMT_LOD)
+			newMesh = newAnimatedMesh;
+		else if (newAnimatedMesh)
 			newMesh = newAnimatedMesh->getMesh(0);
 
 		if (newMesh)
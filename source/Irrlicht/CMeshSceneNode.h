@@ -12,6 +12,8 @@ namespace irr
 {
 namespace scene
 {
+	struct SLODMesh;
+
 
 	class CMeshSceneNode : public IMeshSceneNode
 	{
@@ -85,11 +87,17 @@ namespace scene
 
 		void copyMaterials();
 
+		//! Selects the level to draw when the mesh is a SLODMesh
+		void updateLODLevel();
+
 		core::array<video::SMaterial> Materials;
 		core::aabbox3d<f32> Box;
 		video::SMaterial ReadOnlyMaterial;
 
 		IMesh* Mesh;
+		//! Mesh as level of detail mesh, 0 for other meshes
+		SLODMesh* LODMesh;
+		u32 LODLevel;
 		IShadowVolumeSceneNode* Shadow;
 
 		s32 PassCount;
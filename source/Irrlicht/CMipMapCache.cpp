@@ -0,0 +1,213 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMipMapCache.h"
+#include "IReadFile.h"
+#include "IWriteFile.h"
+#include "os.h"
+#include <string.h>
+
+namespace irr
+{
+namespace video
+{
+
+namespace
+{
+	//! Changes whenever the way the levels are generated changes
+	const u32 MipMapCacheVersion = 2;
+
+	//! Start of each cache file
+	struct SMipMapCacheHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u64 Key;
+		u32 Options;
+		u32 Format;
+		u32 Width;
+		u32 Height;
+		u32 DataSize;
+		u32 Padding;
+		u64 Check;
+	};
+
+	const u32 MipMapCacheMagic = 0x50494D49; // "IMIP"
+
+	//! Second hash of the image data, independent of the key
+	/** Multiplies and rotates each word like MurmurHash2, so images colliding
+	in the FNV-1a key are very unlikely to collide here as well. */
+	u64 getCheck(const IImage* image)
+	{
+		const u64 m = 0xC6A4A7935BD1E995ULL;
+		const u32 size = image->getImageDataSizeInBytes();
+		u64 hash = 0x9E3779B97F4A7C15ULL ^ (size * m);
+
+		const u8* data = (const u8*)image->getData();
+		u32 i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			u64 word;
+			memcpy(&word, data + i, 8);
+			word *= m;
+			word ^= word >> 47;
+			word *= m;
+			hash ^= word;
+			hash *= m;
+		}
+		for (; i < size; ++i)
+		{
+			hash ^= data[i];
+			hash = (hash << 31 | hash >> 33) * m;
+		}
+
+		hash ^= hash >> 47;
+		hash *= m;
+		return hash ^ (hash >> 47);
+	}
+
+	void initHeader(SMipMapCacheHeader& header, const IImage* image, u64 key, u32 options)
+	{
+		memset(&header, 0, sizeof(header));
+		header.Magic = MipMapCacheMagic;
+		header.Version = MipMapCacheVersion;
+		header.Key = key;
+		header.Options = options;
+		header.Format = image->getColorFormat();
+		header.Width = image->getDimension().Width;
+		header.Height = image->getDimension().Height;
+		header.DataSize = IImage::getMipMapsDataSizeFromFormat(image->getColorFormat(), header.Width, header.Height);
+		header.Check = getCheck(image);
+	}
+} // end anonymous namespace
+
+
+//! constructor
+CMipMapCache::CMipMapCache(io::IFileSystem* fileSystem)
+	: FileSystem(fileSystem)
+{
+}
+
+
+//! Sets the directory of the cache files, an empty path disables the cache
+void CMipMapCache::setDirectory(const io::path& directory)
+{
+	Directory = directory;
+	if (Directory.size() && Directory.lastChar() != '/' && Directory.lastChar() != '\\')
+		Directory.append('/');
+}
+
+
+//! Checks if the cache is used
+bool CMipMapCache::isEnabled() const
+{
+	return FileSystem && Directory.size();
+}
+
+
+//! Hash of the image data, its size and format and the options
+u64 CMipMapCache::getKey(const IImage* image, u32 options)
+{
+	// FNV-1a on 64 bit words
+	const u64 prime = 1099511628211ULL;
+	u64 hash = 14695981039346656037ULL;
+
+	const u32 header[4] = { (u32)image->getColorFormat(), image->getDimension().Width, image->getDimension().Height, options };
+	for (u32 i=0; i<4; ++i)
+	{
+		hash ^= header[i];
+		hash *= prime;
+	}
+
+	const u8* data = (const u8*)image->getData();
+	const u32 size = image->getImageDataSizeInBytes();
+	u32 i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		u64 word;
+		memcpy(&word, data + i, 8);
+		hash ^= word;
+		hash *= prime;
+	}
+	for (; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= prime;
+	}
+
+	return hash ^ (hash >> 29);
+}
+
+
+//! Sets the mip map levels of the image from the cache
+bool CMipMapCache::read(IImage* image, u64 key, u32 options) const
+{
+	if (!isEnabled())
+		return false;
+
+	const io::path fileName = getFileName(key);
+	if (!FileSystem->existFile(fileName))
+		return false;
+
+	io::IReadFile* file = FileSystem->createAndOpenFile(fileName);
+	if (!file)
+		return false;
+
+	SMipMapCacheHeader expected;
+	initHeader(expected, image, key, options);
+	SMipMapCacheHeader header;
+
+	bool result = false;
+	if (file->read(&header, sizeof(header)) == sizeof(header) &&
+		memcmp(&header, &expected, sizeof(header)) == 0 &&
+		file->getSize() == (long)(sizeof(header) + header.DataSize))
+	{
+		u8* data = new u8[header.DataSize];
+		if (file->read(data, header.DataSize) == (size_t)header.DataSize)
+		{
+			image->setMipMapsData(data, false, false);
+			result = true;
+		}
+		delete [] data;
+	}
+	file->drop();
+
+	if (!result)
+		os::Printer::log("Ignoring invalid mip map cache file", fileName, ELL_WARNING);
+
+	return result;
+}
+
+
+//! Writes the mip map levels of the image into the cache
+void CMipMapCache::write(const IImage* image, u64 key, u32 options) const
+{
+	if (!isEnabled() || !image->getMipMapsData())
+		return;
+
+	const io::path fileName = getFileName(key);
+	io::IWriteFile* file = FileSystem->createAndWriteFile(fileName);
+	if (!file)
+	{
+		os::Printer::log("Could not write mip map cache file", fileName, ELL_WARNING);
+		return;
+	}
+
+	SMipMapCacheHeader header;
+	initHeader(header, image, key, options);
+	file->write(&header, sizeof(header));
+	file->write(image->getMipMapsData(), header.DataSize);
+	file->drop();
+}
+
+
+io::path CMipMapCache::getFileName(u64 key) const
+{
+	c8 name[32];
+	snprintf_irr(name, sizeof(name), "%08x%08x.mip", (u32)(key >> 32), (u32)key);
+	return Directory + name;
+}
+
+} // end namespace video
+} // end namespace irr
@@ -0,0 +1,57 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MIP_MAP_CACHE_H_INCLUDED__
+#define __C_MIP_MAP_CACHE_H_INCLUDED__
+
+#include "IImage.h"
+#include "IFileSystem.h"
+
+namespace irr
+{
+namespace video
+{
+
+//! Stores mip map levels generated on the CPU in files
+/** Each file is named after a hash of the image data, its size and format
+and the options of the generation, so a changed image or option simply
+misses the cache. The header of the file repeats all of them along with a
+second, independent hash of the data. A file is only used when both hashes
+match, so an image colliding with another one in the key is still rejected
+unless it collides in the second hash as well. */
+class CMipMapCache
+{
+public:
+
+	//! constructor
+	CMipMapCache(io::IFileSystem* fileSystem);
+
+	//! Sets the directory of the cache files, an empty path disables the cache
+	void setDirectory(const io::path& directory);
+
+	//! Checks if the cache is used
+	bool isEnabled() const;
+
+	//! Hash of the image data, its size and format and the options
+	static u64 getKey(const IImage* image, u32 options);
+
+	//! Sets the mip map levels of the image from the cache
+	/** \return False if the levels of this key and options are not cached. */
+	bool read(IImage* image, u64 key, u32 options) const;
+
+	//! Writes the mip map levels of the image into the cache
+	void write(const IImage* image, u64 key, u32 options) const;
+
+private:
+
+	io::path getFileName(u64 key) const;
+
+	io::IFileSystem* FileSystem;
+	io::path Directory;
+};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
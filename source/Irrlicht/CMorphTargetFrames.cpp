@@ -0,0 +1,162 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+#if defined(_IRR_COMPILE_WITH_MD2_LOADER_) || defined(_IRR_COMPILE_WITH_MD3_LOADER_)
+
+#include "CMorphTargetFrames.h"
+#include "irrMath.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CMorphTargetFrames::CMorphTargetFrames()
+	: FrameCount(0), VertexCount(0), Stride(0), FrameSize(0)
+{
+}
+
+
+//! Allocate storage for frameCount frames with vertexCount vertices each
+void CMorphTargetFrames::setup(u32 frameCount, u32 vertexCount)
+{
+	FrameCount = frameCount;
+	VertexCount = vertexCount;
+	Stride = (vertexCount + 3) & ~3;
+	FrameSize = Stride * 6;
+
+	// padding has to be valid floats, it is interpolated as well
+	Data.set_used(FrameCount * FrameSize);
+	for (u32 i=0; i<Data.size(); ++i)
+		Data[i] = 0.f;
+}
+
+
+//! Interpolate two frames into a vertex array.
+void CMorphTargetFrames::interpolate(u32 frameA, u32 frameB, f32 t,
+		void* vertices, u32 vertexPitch) const
+{
+	if (frameA >= FrameCount || frameB >= FrameCount)
+		return;
+
+	const f32* a = Data.const_pointer() + frameA * FrameSize;
+	const f32* b = Data.const_pointer() + frameB * FrameSize;
+	u8* target = (u8*) vertices;
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128 blend = _mm_set1_ps(t);
+
+	for (u32 i=0; i<VertexCount; i+=4)
+	{
+		__m128 r[6];
+		for (u32 c=0; c<6; ++c)
+		{
+			const __m128 va = _mm_loadu_ps(a + c*Stride + i);
+			const __m128 vb = _mm_loadu_ps(b + c*Stride + i);
+			r[c] = _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), blend));
+		}
+
+		// rows are now pos.X pos.Y pos.Z normal.X of each vertex
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+		// normal.Y normal.Z of vertex 0,1 and 2,3
+		const __m128 lo = _mm_unpacklo_ps(r[4], r[5]);
+		const __m128 hi = _mm_unpackhi_ps(r[4], r[5]);
+
+		const u32 count = core::min_(VertexCount - i, 4u);
+		for (u32 k=0; k<count; ++k)
+		{
+			f32* dst = (f32*)(target + (i+k) * vertexPitch);
+			_mm_storeu_ps(dst, r[k]);
+			switch (k)
+			{
+				case 0: _mm_storel_pi((__m64*)(dst+4), lo); break;
+				case 1: _mm_storeh_pi((__m64*)(dst+4), lo); break;
+				case 2: _mm_storel_pi((__m64*)(dst+4), hi); break;
+				default: _mm_storeh_pi((__m64*)(dst+4), hi); break;
+			}
+		}
+	}
+#else
+	for (u32 i=0; i<VertexCount; ++i)
+	{
+		f32* dst = (f32*)(target + i * vertexPitch);
+		for (u32 c=0; c<6; ++c)
+		{
+			const f32 va = a[c*Stride + i];
+			dst[c] = va + (b[c*Stride + i] - va) * t;
+		}
+	}
+#endif
+}
+
+
+//! constructor
+CMorphPoseCache::CMorphPoseCache(u32 capacity)
+	: UseCounter(0)
+{
+	Slots.set_used(core::max_(capacity, 1u));
+	clear();
+}
+
+
+//! Returns the slot for a pose.
+u32 CMorphPoseCache::getSlot(s32 frameA, s32 frameB, f32 blend, bool& hit)
+{
+	const s32 quantised = core::round32(blend * 256.f);
+
+	// counter overflow, restart ages
+	if (++UseCounter == 0)
+	{
+		for (u32 i=0; i<Slots.size(); ++i)
+			Slots[i].LastUse = 0;
+		UseCounter = 1;
+	}
+
+	u32 oldest = 0;
+	for (u32 i=0; i<Slots.size(); ++i)
+	{
+		SPoseSlot& s = Slots[i];
+		if (s.FrameA == frameA && s.FrameB == frameB && s.Blend == quantised)
+		{
+			s.LastUse = UseCounter;
+			hit = true;
+			return i;
+		}
+		if (s.LastUse < Slots[oldest].LastUse)
+			oldest = i;
+	}
+
+	SPoseSlot& s = Slots[oldest];
+	s.FrameA = frameA;
+	s.FrameB = frameB;
+	s.Blend = quantised;
+	s.LastUse = UseCounter;
+	hit = false;
+	return oldest;
+}
+
+
+//! Forget all poses
+void CMorphPoseCache::clear()
+{
+	for (u32 i=0; i<Slots.size(); ++i)
+	{
+		Slots[i].FrameA = -1;
+		Slots[i].FrameB = -1;
+		Slots[i].Blend = -1;
+		Slots[i].LastUse = 0;
+	}
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_MD2_LOADER_ || _IRR_COMPILE_WITH_MD3_LOADER_
@@ -0,0 +1,107 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MORPH_TARGET_FRAMES_H_INCLUDED__
+#define __C_MORPH_TARGET_FRAMES_H_INCLUDED__
+
+#include "irrArray.h"
+#include "vector3d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Keyframes of a vertex morph animation (MD2, MD3), decoded to floats.
+	/** Each frame is stored as structure of arrays: all X positions, then all Y
+	positions and so on, followed by the three normal components. Every channel
+	is padded to a multiple of 4 vertices, so interpolation can always work on
+	full SSE registers. */
+	class CMorphTargetFrames
+	{
+	public:
+
+		//! constructor
+		CMorphTargetFrames();
+
+		//! Allocate storage for frameCount frames with vertexCount vertices each
+		void setup(u32 frameCount, u32 vertexCount);
+
+		//! Set the decoded position and normal of one vertex in one frame
+		void setVertex(u32 frame, u32 vertex, const core::vector3df& pos, const core::vector3df& normal)
+		{
+			f32* p = Data.pointer() + frame * FrameSize + vertex;
+			p[0] = pos.X;
+			p[Stride] = pos.Y;
+			p[Stride*2] = pos.Z;
+			p[Stride*3] = normal.X;
+			p[Stride*4] = normal.Y;
+			p[Stride*5] = normal.Z;
+		}
+
+		//! Interpolate two frames into a vertex array.
+		/** \param frameA First frame, used for t=0
+		\param frameB Second frame, used for t=1
+		\param t Blend factor between both frames
+		\param vertices Pointer to the first vertex. The vertex must have its normal
+		directly behind the position, as in all S3DVertex types.
+		\param vertexPitch Size of one vertex in bytes. */
+		void interpolate(u32 frameA, u32 frameB, f32 t, void* vertices, u32 vertexPitch) const;
+
+		u32 getFrameCount() const { return FrameCount; }
+		u32 getVertexCount() const { return VertexCount; }
+
+	private:
+
+		u32 FrameCount;
+		u32 VertexCount;
+		//! floats per channel, VertexCount rounded up to a multiple of 4
+		u32 Stride;
+		//! floats per frame, 6*Stride
+		u32 FrameSize;
+
+		core::array<f32> Data;
+	};
+
+
+	//! Least recently used table of interpolated poses of one animated mesh.
+	/** A pose is identified by its two frames and the blend factor, which is
+	quantised to 1/256. Scene nodes showing the same pose of a mesh in the same
+	frame then share one interpolation. The table only manages the slot numbers,
+	the owner keeps the actual vertex data per slot. */
+	class CMorphPoseCache
+	{
+	public:
+
+		//! constructor
+		CMorphPoseCache(u32 capacity=16);
+
+		//! Returns the slot for a pose.
+		/** \param hit Set to true when the slot already contains this pose,
+		otherwise the least recently used slot is returned and must be refilled. */
+		u32 getSlot(s32 frameA, s32 frameB, f32 blend, bool& hit);
+
+		//! Forget all poses, e.g. after the keyframes have changed
+		void clear();
+
+		u32 getCapacity() const { return Slots.size(); }
+
+	private:
+
+		struct SPoseSlot
+		{
+			s32 FrameA;
+			s32 FrameB;
+			s32 Blend;
+			u32 LastUse;
+		};
+
+		core::array<SPoseSlot> Slots;
+		u32 UseCounter;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -89,7 +89,7 @@ IImageWriter* createImageWriterPPM();
 CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& screenSize)
 	: SharedRenderTarget(0), CurrentRenderTarget(0), CurrentRenderTargetSize(0, 0), FileSystem(io), MeshManipulator(0),
 	ViewPort(0, 0, 0, 0), ScreenSize(screenSize), PrimitivesDrawn(0), MinVertexCountForVBO(500),
-	TextureCreationFlags(0), OverrideMaterial2DEnabled(false), AllowZWriteOnTransparent(false)
+	TextureCreationFlags(0), MipMapCache(io), OverrideMaterial2DEnabled(false), AllowZWriteOnTransparent(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CNullDriver");
@@ -618,10 +618,21 @@ video::ITexture* CNullDriver::loadTextureFromFile(io::IReadFile* file, const io:
 
 	E_TEXTURE_TYPE type = ETT_2D;
 
-	core::array<IImage*> imageArray = createImagesFromFile(file, &type);
+	core::array<IImage*> imageArray;
+	IImage* image = loadTextureImage(file);
+	if (image)
+		imageArray.push_back(image);
+	else
+		imageArray = createImagesFromFile(file, &type);
 
 	if (checkImage(imageArray))
 	{
+		for (u32 i = 0; i < imageArray.size(); ++i)
+		{
+			if (imageArray[i])
+				createMipMaps(imageArray[i]);
+		}
+
 		switch (type)
 		{
 		case ETT_2D:
@@ -652,6 +663,83 @@ video::ITexture* CNullDriver::loadTextureFromFile(io::IReadFile* file, const io:
 }
 
 
+//! decodes a file row by row into an image in the texture load format, if its loader supports that
+IImage* CNullDriver::loadTextureImage(io::IReadFile* file)
+{
+	for (s32 i = SurfaceLoader.size() - 1; i >= 0; --i)
+	{
+		if (!SurfaceLoader[i]->isALoadableFileExtension(file->getFileName()))
+			continue;
+
+		// other loaders and files which the loader can't decode this way are
+		// left to createImagesFromFile
+		core::dimension2d<u32> size;
+		ECOLOR_FORMAT fileFormat;
+		file->seek(0);
+		if (!SurfaceLoader[i]->getImageInfo(file, size, fileFormat))
+			return 0;
+
+		ECOLOR_FORMAT format = getTextureLoadFormat(fileFormat);
+		if (format == ECF_UNKNOWN)
+			format = fileFormat;
+
+		IImage* image = new CImage(format, size);
+		file->seek(0);
+		if (SurfaceLoader[i]->loadImageInto(file, image->getData(), format, image->getPitch()))
+			return image;
+
+		image->drop();
+		return 0;
+	}
+
+	return 0;
+}
+
+
+//! color format image files are decoded into for textures
+ECOLOR_FORMAT CNullDriver::getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const
+{
+	return ECF_UNKNOWN;
+}
+
+
+//! checks if textures filter their mip map levels themselves when an image has none
+bool CNullDriver::createsMipMapLevels() const
+{
+	return queryFeature(EVDF_MIP_MAP_AUTO_UPDATE);
+}
+
+
+//! generates the mip map levels of a loaded image on the CPU or reads them from the cache, if needed
+void CNullDriver::createMipMaps(IImage* image)
+{
+	if (!getTextureCreationFlag(ETCF_CREATE_MIP_MAPS) || !queryFeature(EVDF_MIP_MAP) ||
+		image->getMipMapsData() || IImage::isCompressedFormat(image->getColorFormat()))
+		return;
+
+	const bool gammaCorrect = getTextureCreationFlag(ETCF_MIP_MAPS_GAMMA_CORRECT);
+	const bool premultipliedAlpha = getTextureCreationFlag(ETCF_MIP_MAPS_PREMULTIPLIED_ALPHA);
+
+	// leave the levels to drivers which create them themselves, unless they can't do it like asked
+	if (createsMipMapLevels() && !gammaCorrect && !premultipliedAlpha && !MipMapCache.isEnabled())
+		return;
+
+	const E_IMAGE_FILTER filter = EIF_BOX;
+	const u32 options = filter | (gammaCorrect ? 0x100 : 0) | (premultipliedAlpha ? 0x200 : 0);
+
+	u64 key = 0;
+	if (MipMapCache.isEnabled())
+	{
+		key = CMipMapCache::getKey(image, options);
+		if (MipMapCache.read(image, key, options))
+			return;
+	}
+
+	if (image->generateMipMaps(filter, gammaCorrect, premultipliedAlpha))
+		MipMapCache.write(image, key, options);
+}
+
+
 //! adds a surface, not loaded or created by the Irrlicht Engine
 void CNullDriver::addTexture(video::ITexture* texture)
 {
@@ -1049,6 +1137,13 @@ void CNullDriver::drawStencilShadow(bool clearStencilBuffer,
 }
 
 
+//! Darkens the parts of the rendered scene a light does not reach.
+void CNullDriver::drawShadowMap(ITexture* shadowMap, const core::matrix4& lightViewProjection,
+		video::SColor shadowColor, f32 bias)
+{
+}
+
+
 //! deletes all dynamic lights there are
 void CNullDriver::deleteAllDynamicLights()
 {
@@ -1499,6 +1594,13 @@ bool CNullDriver::getTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag) const
 	return (TextureCreationFlags & flag)!=0;
 }
 
+
+//! Sets a directory to cache the mip map levels of textures in
+void CNullDriver::setMipMapCacheDirectory(const io::path& directory)
+{
+	MipMapCache.setDirectory(directory);
+}
+
 core::array<IImage*> CNullDriver::createImagesFromFile(const io::path& filename, E_TEXTURE_TYPE* type)
 {
 	// TO-DO -> use 'move' feature from C++11 standard.
@@ -1693,14 +1795,9 @@ IImage* CNullDriver::createImage(ITexture* texture, const core::position2d<s32>&
 		if (!src)
 			return 0;
 		IImage* image = new CImage(texture->getColorFormat(), clamped.getSize());
-		u8* dst = static_cast<u8*>(image->getData());
 		src += clamped.UpperLeftCorner.Y * texture->getPitch() + image->getBytesPerPixel() * clamped.UpperLeftCorner.X;
-		for (u32 i=0; i<clamped.getHeight(); ++i)
-		{
-			video::CColorConverter::convert_viaFormat(src, texture->getColorFormat(), clamped.getWidth(), dst, image->getColorFormat());
-			src += texture->getPitch();
-			dst += image->getPitch();
-		}
+		video::CColorConverter::convert_viaFormat(src, texture->getColorFormat(), texture->getPitch(),
+			image->getData(), image->getColorFormat(), image->getPitch(), clamped.getWidth(), clamped.getHeight());
 		texture->unlock();
 		return image;
 	}
@@ -17,6 +17,7 @@
 #include "IMeshBuffer.h"
 #include "IMeshSceneNode.h"
 #include "CFPSCounter.h"
+#include "CMipMapCache.h"
 #include "S3DVertex.h"
 #include "SVertexIndex.h"
 #include "SLight.h"
@@ -297,6 +298,10 @@ namespace video
 			video::SColor leftDownEdge = video::SColor(0,0,0,0),
 			video::SColor rightDownEdge = video::SColor(0,0,0,0)) _IRR_OVERRIDE_;
 
+		//! Darkens the parts of the rendered scene a light does not reach.
+		virtual void drawShadowMap(ITexture* shadowMap, const core::matrix4& lightViewProjection,
+			video::SColor shadowColor = video::SColor(150,0,0,0), f32 bias = 0.001f) _IRR_OVERRIDE_;
+
 		//! Returns current amount of dynamic lights set
 		//! \return Current amount of dynamic lights set
 		virtual u32 getDynamicLightCount() const _IRR_OVERRIDE_;
@@ -341,6 +346,9 @@ namespace video
 		//! Returns if a texture creation flag is enabled or disabled.
 		virtual bool getTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag) const _IRR_OVERRIDE_;
 
+		//! Sets a directory to cache the mip map levels of textures in
+		virtual void setMipMapCacheDirectory(const io::path& directory) _IRR_OVERRIDE_;
+
 		virtual core::array<IImage*> createImagesFromFile(const io::path& filename, E_TEXTURE_TYPE* type = 0) _IRR_OVERRIDE_;
 
 		virtual core::array<IImage*> createImagesFromFile(io::IReadFile* file, E_TEXTURE_TYPE* type = 0) _IRR_OVERRIDE_;
@@ -678,6 +686,21 @@ namespace video
 		//! opens the file and loads it into the surface
 		video::ITexture* loadTextureFromFile(io::IReadFile* file, const io::path& hashName = "");
 
+		//! decodes a file row by row into an image in the texture load format, if its loader supports that
+		IImage* loadTextureImage(io::IReadFile* file);
+
+		//! color format image files are decoded into for textures
+		/** Drivers return the format of their textures, so they can copy the
+		image without converting it. The default keeps the format of the file. */
+		virtual ECOLOR_FORMAT getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const;
+
+		//! checks if textures filter their mip map levels themselves when an image has none
+		/** The default relies on EVDF_MIP_MAP_AUTO_UPDATE. */
+		virtual bool createsMipMapLevels() const;
+
+		//! generates the mip map levels of a loaded image on the CPU or reads them from the cache, if needed
+		void createMipMaps(IImage* image);
+
 		//! adds a surface, not loaded or created by the Irrlicht Engine
 		void addTexture(video::ITexture* surface);
 
@@ -864,6 +887,8 @@ namespace video
 
 		u32 TextureCreationFlags;
 
+		CMipMapCache MipMapCache;
+
 		f32 FogStart;
 		f32 FogEnd;
 		f32 FogDensity;
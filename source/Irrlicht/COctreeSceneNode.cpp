@@ -142,13 +142,12 @@ void COctreeSceneNode::render()
 				StdOctree->calculatePolys(frust);
 			IRR_PROFILE(getProfiler().stop(EPID_OC_CALCPOLYS));
 
-			const Octree<video::S3DVertex>::SIndexData* d = StdOctree->getIndexData();
+			// one draw call for each visible range of indices
+			const core::array<Octree<video::S3DVertex>::SIndexRange>& ranges = StdOctree->getVisibleRanges();
 
-			for (u32 i=0; i<Materials.size(); ++i)
+			for (u32 r=0; r<ranges.size(); ++r)
 			{
-				if ( 0 == d[i].CurrentSize )
-					continue;
-
+				const u32 i = ranges[r].MeshBuffer;
 				const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(Materials[i].MaterialType);
 				const bool transparent = (rnd && rnd->isTransparent());
 
@@ -156,10 +155,11 @@ void COctreeSceneNode::render()
 				// and solid only in solid pass
 				if (transparent == isTransparentPass)
 				{
-					driver->setMaterial(Materials[i]);
+					if (r == 0 || ranges[r-1].MeshBuffer != i)
+						driver->setMaterial(Materials[i]);
 					driver->drawIndexedTriangleList(
 						&StdMeshes[i].Vertices[0], StdMeshes[i].Vertices.size(),
-						d[i].Indices, d[i].CurrentSize / 3);
+						&StdMeshes[i].Indices[ranges[r].First], ranges[r].Count / 3);
 				}
 			}
 
@@ -167,7 +167,7 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3df& box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< core::aabbox3d<f32> > boxes;
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -175,7 +175,7 @@ void COctreeSceneNode::render()
 				{
 					StdOctree->getBoundingBoxes(box, boxes);
 					for (u32 b=0; b!=boxes.size(); ++b)
-						driver->draw3DBox(*boxes[b]);
+						driver->draw3DBox(boxes[b]);
 				}
 
 				if ( DebugDataVisible & scene::EDS_BBOX )
@@ -192,13 +192,12 @@ void COctreeSceneNode::render()
 				LightMapOctree->calculatePolys(frust);
 			IRR_PROFILE(getProfiler().stop(EPID_OC_CALCPOLYS));
 
-			const Octree<video::S3DVertex2TCoords>::SIndexData* d = LightMapOctree->getIndexData();
+			// one draw call for each visible range of indices
+			const core::array<Octree<video::S3DVertex2TCoords>::SIndexRange>& ranges = LightMapOctree->getVisibleRanges();
 
-			for (u32 i=0; i<Materials.size(); ++i)
+			for (u32 r=0; r<ranges.size(); ++r)
 			{
-				if ( 0 == d[i].CurrentSize )
-					continue;
-
+				const u32 i = ranges[r].MeshBuffer;
 				const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(Materials[i].MaterialType);
 				const bool transparent = (rnd && rnd->isTransparent());
 
@@ -206,28 +205,47 @@ void COctreeSceneNode::render()
 				// and solid only in solid pass
 				if (transparent == isTransparentPass)
 				{
-					driver->setMaterial(Materials[i]);
+					if (r == 0 || ranges[r-1].MeshBuffer != i)
+						driver->setMaterial(Materials[i]);
 					if (UseVBOs)
 					{
 						if (UseVisibilityAndVBOs)
 						{
+							// hardware index buffers are drawn as a whole,
+							// so gather the visible ranges of the mesh buffer
+							VisibleIndices.set_used(0);
+							for (; r<ranges.size() && ranges[r].MeshBuffer == i; ++r)
+							{
+								const u32 first = VisibleIndices.size();
+								VisibleIndices.set_used(first + ranges[r].Count);
+								memcpy(&VisibleIndices[first], &LightMapMeshes[i].Indices[ranges[r].First],
+									ranges[r].Count * sizeof(u16));
+							}
+							--r;
+
 							u16* oldPointer = LightMapMeshes[i].Indices.pointer();
 							const u32 oldSize = LightMapMeshes[i].Indices.size();
 							LightMapMeshes[i].Indices.set_free_when_destroyed(false);
-							LightMapMeshes[i].Indices.set_pointer(d[i].Indices, d[i].CurrentSize, false, false);
+							LightMapMeshes[i].Indices.set_pointer(VisibleIndices.pointer(), VisibleIndices.size(), false, false);
 							LightMapMeshes[i].setDirty(scene::EBT_INDEX);
 							driver->drawMeshBuffer ( &LightMapMeshes[i] );
 							LightMapMeshes[i].Indices.set_pointer(oldPointer, oldSize);
 							LightMapMeshes[i].setDirty(scene::EBT_INDEX);
 						}
 						else
+						{
 							driver->drawMeshBuffer ( &LightMapMeshes[i] );
+
+							// the whole mesh buffer is drawn
+							while (r+1<ranges.size() && ranges[r+1].MeshBuffer == i)
+								++r;
+						}
 					}
 					else
 						driver->drawIndexedTriangleList(
 							&LightMapMeshes[i].Vertices[0],
 							LightMapMeshes[i].Vertices.size(),
-							d[i].Indices, d[i].CurrentSize / 3);
+							&LightMapMeshes[i].Indices[ranges[r].First], ranges[r].Count / 3);
 				}
 			}
 
@@ -235,7 +253,7 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3d<float> &box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< core::aabbox3d<f32> > boxes;
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -243,7 +261,7 @@ void COctreeSceneNode::render()
 				{
 					LightMapOctree->getBoundingBoxes(box, boxes);
 					for (u32 b=0; b<boxes.size(); ++b)
-						driver->draw3DBox(*boxes[b]);
+						driver->draw3DBox(boxes[b]);
 				}
 
 				if ( DebugDataVisible & scene::EDS_BBOX )
@@ -260,13 +278,12 @@ void COctreeSceneNode::render()
 				TangentsOctree->calculatePolys(frust);
 			IRR_PROFILE(getProfiler().stop(EPID_OC_CALCPOLYS));
 
-			const Octree<video::S3DVertexTangents>::SIndexData* d =  TangentsOctree->getIndexData();
+			// one draw call for each visible range of indices
+			const core::array<Octree<video::S3DVertexTangents>::SIndexRange>& ranges = TangentsOctree->getVisibleRanges();
 
-			for (u32 i=0; i<Materials.size(); ++i)
+			for (u32 r=0; r<ranges.size(); ++r)
 			{
-				if ( 0 == d[i].CurrentSize )
-					continue;
-
+				const u32 i = ranges[r].MeshBuffer;
 				const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(Materials[i].MaterialType);
 				const bool transparent = (rnd && rnd->isTransparent());
 
@@ -274,10 +291,11 @@ void COctreeSceneNode::render()
 				// and solid only in solid pass
 				if (transparent == isTransparentPass)
 				{
-					driver->setMaterial(Materials[i]);
+					if (r == 0 || ranges[r-1].MeshBuffer != i)
+						driver->setMaterial(Materials[i]);
 					driver->drawIndexedTriangleList(
 						&TangentsMeshes[i].Vertices[0], TangentsMeshes[i].Vertices.size(),
-						d[i].Indices, d[i].CurrentSize / 3);
+						&TangentsMeshes[i].Indices[ranges[r].First], ranges[r].Count / 3);
 				}
 			}
 
@@ -285,7 +303,7 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3d<float> &box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< core::aabbox3d<f32> > boxes;
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -293,7 +311,7 @@ void COctreeSceneNode::render()
 				{
 					TangentsOctree->getBoundingBoxes(box, boxes);
 					for (u32 b=0; b<boxes.size(); ++b)
-						driver->draw3DBox(*boxes[b]);
+						driver->draw3DBox(boxes[b]);
 				}
 
 				if ( DebugDataVisible & scene::EDS_BBOX )
@@ -106,6 +106,8 @@ namespace scene
 		bool UseVisibilityAndVBOs;
 		//! use bounding box or frustum for calculate polys
 		bool BoxBased;
+		//! visible indices of a mesh buffer, when drawn with VBOs
+		core::array<u16> VisibleIndices;
 	};
 
 } // end namespace scene
@@ -16,8 +16,7 @@ namespace scene
 COctreeTriangleSelector::COctreeTriangleSelector(const IMesh* mesh,
 		ISceneNode* node, s32 minimalPolysPerNode)
 	: CTriangleSelector(mesh, node, false)
-	, Root(0), NodeCount(0)
-	, MinimalPolysPerNode(minimalPolysPerNode)
+	, Tree(0), MinimalPolysPerNode(minimalPolysPerNode)
 {
 	#ifdef _DEBUG
 	setDebugName("COctreeTriangleSelector");
@@ -28,21 +27,18 @@ COctreeTriangleSelector::COctreeTriangleSelector(const IMesh* mesh,
 		const u32 start = os::Timer::getRealTime();
 
 		// create the triangle octree
-		Root = new SOctreeNode();
-		Root->Triangles = Triangles;
-		constructOctree(Root);
+		createTree();
 
 		c8 tmp[256];
-		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%d nodes, %u polys)",
-			os::Timer::getRealTime() - start, NodeCount, Triangles.size());
+		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%u nodes, %u polys)",
+			os::Timer::getRealTime() - start, Tree->getNodeCount(), Triangles.size());
 		os::Printer::log(tmp, ELL_INFORMATION);
 	}
 }
 
 COctreeTriangleSelector::COctreeTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node, s32 minimalPolysPerNode)
 	: CTriangleSelector(meshBuffer, materialIndex, node)
-	, Root(0), NodeCount(0)
-	, MinimalPolysPerNode(minimalPolysPerNode)
+	, Tree(0), MinimalPolysPerNode(minimalPolysPerNode)
 {
 	#ifdef _DEBUG
 	setDebugName("COctreeTriangleSelector");
@@ -53,13 +49,11 @@ COctreeTriangleSelector::COctreeTriangleSelector(const IMeshBuffer* meshBuffer,
 		const u32 start = os::Timer::getRealTime();
 
 		// create the triangle octree
-		Root = new SOctreeNode();
-		Root->Triangles = Triangles;
-		constructOctree(Root);
+		createTree();
 
 		c8 tmp[256];
-		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%d nodes, %u polys)",
-			os::Timer::getRealTime() - start, NodeCount, Triangles.size());
+		sprintf(tmp, "Needed %ums to create OctreeTriangleSelector.(%u nodes, %u polys)",
+			os::Timer::getRealTime() - start, Tree->getNodeCount(), Triangles.size());
 		os::Printer::log(tmp, ELL_INFORMATION);
 	}
 }
@@ -67,67 +61,54 @@ COctreeTriangleSelector::COctreeTriangleSelector(const IMeshBuffer* meshBuffer,
 //! destructor
 COctreeTriangleSelector::~COctreeTriangleSelector()
 {
-	delete Root;
+	delete Tree;
 }
 
 
-void COctreeTriangleSelector::constructOctree(SOctreeNode* node)
+void COctreeTriangleSelector::createTree()
 {
-	++NodeCount;
-
-	node->Box.reset(node->Triangles[0].pointA);
-
-	// get bounding box
-	const u32 cnt = node->Triangles.size();
+	// sort the triangles into chunks of nearby triangles
+	const u32 cnt = Triangles.size();
+	core::array<core::vector3df> centers;
+	centers.set_used(cnt);
+	core::aabbox3df bounds(Triangles[0].pointA);
 	for (u32 i=0; i<cnt; ++i)
 	{
-		node->Box.addInternalPoint(node->Triangles[i].pointA);
-		node->Box.addInternalPoint(node->Triangles[i].pointB);
-		node->Box.addInternalPoint(node->Triangles[i].pointC);
+		const core::triangle3df& tri = Triangles[i];
+		centers[i] = (tri.pointA + tri.pointB + tri.pointC) / 3.f;
+		bounds.addInternalPoint(tri.pointA);
+		bounds.addInternalPoint(tri.pointB);
+		bounds.addInternalPoint(tri.pointC);
 	}
 
-	const core::vector3df& middle = node->Box.getCenter();
-	core::vector3df edges[8];
-	node->Box.getEdges(edges);
-
-	core::aabbox3d<f32> box;
-	core::array<core::triangle3df> keepTriangles;
-
-	// calculate children
+	core::array<u32> order;
+	core::array<u32> chunkEnds;
+	CLooseOctree::sortIntoChunks(centers, core::max_(MinimalPolysPerNode, 1), order, chunkEnds);
 
-	if (!node->Box.isEmpty() && (s32)node->Triangles.size() > MinimalPolysPerNode)
-	for (s32 ch=0; ch<8; ++ch)
+	core::array<core::triangle3df> sorted;
+	sorted.set_used(cnt);
+	for (u32 i=0; i<cnt; ++i)
+		sorted[i] = Triangles[order[i]];
+	Triangles = sorted;
+
+	// one item for each chunk
+	Tree = new CLooseOctree(bounds);
+	Chunks.set_used(chunkEnds.size());
+	u32 first = 0;
+	for (u32 c=0; c<chunkEnds.size(); ++c)
 	{
-		box.reset(middle);
-		box.addInternalPoint(edges[ch]);
-		node->Child[ch] = new SOctreeNode();
-
-		for (s32 i=0; i<(s32)node->Triangles.size(); ++i)
+		core::aabbox3df box(Triangles[first].pointA);
+		for (u32 i=first; i<chunkEnds[c]; ++i)
 		{
-			if (node->Triangles[i].isTotalInsideBox(box))
-			{
-				node->Child[ch]->Triangles.push_back(node->Triangles[i]);
-				//node->Triangles.erase(i);
-				//--i;
-			}
-			else
-			{
-				keepTriangles.push_back(node->Triangles[i]);
-			}
+			box.addInternalPoint(Triangles[i].pointA);
+			box.addInternalPoint(Triangles[i].pointB);
+			box.addInternalPoint(Triangles[i].pointC);
 		}
-		memcpy(node->Triangles.pointer(), keepTriangles.pointer(),
-			sizeof(core::triangle3df)*keepTriangles.size());
 
-		node->Triangles.set_used(keepTriangles.size());
-		keepTriangles.set_used(0);
-
-		if (node->Child[ch]->Triangles.empty())
-		{
-			delete node->Child[ch];
-			node->Child[ch] = 0;
-		}
-		else
-			constructOctree(node->Child[ch]);
+		Chunks[c].First = first;
+		Chunks[c].Count = chunkEnds[c] - first;
+		Tree->insert(box, c);
+		first = chunkEnds[c];
 	}
 }
 
@@ -161,9 +142,32 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	s32 trianglesWritten = 0;
 
-	if (Root)
-		getTrianglesFromOctree(Root, trianglesWritten,
-			arraySize, invbox, &mat, triangles);
+	VisibleChunks.set_used(0);
+	if (Tree)
+		Tree->getItems(invbox, VisibleChunks);
+
+	for (u32 c=0; c<VisibleChunks.size() && trianglesWritten < arraySize; ++c)
+	{
+		const SChunk& chunk = Chunks[VisibleChunks[c]];
+		for (u32 i=chunk.First; i<chunk.First+chunk.Count; ++i)
+		{
+			const core::triangle3df& srcTri = Triangles[i];
+			// This isn't an accurate test, but it's fast, and the
+			// API contract doesn't guarantee complete accuracy.
+			if (srcTri.isTotalOutsideBox(invbox))
+				continue;
+
+			core::triangle3df& dstTri = triangles[trianglesWritten];
+			mat.transformVect(dstTri.pointA, srcTri.pointA );
+			mat.transformVect(dstTri.pointB, srcTri.pointB );
+			mat.transformVect(dstTri.pointC, srcTri.pointC );
+			++trianglesWritten;
+
+			// Halt when the out array is full.
+			if (trianglesWritten == arraySize)
+				break;
+		}
+	}
 
 	if ( outTriangleInfo )
 	{
@@ -180,42 +184,6 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 }
 
 
-void COctreeTriangleSelector::getTrianglesFromOctree(
-		SOctreeNode* node, s32& trianglesWritten,
-		s32 maximumSize, const core::aabbox3d<f32>& box,
-		const core::matrix4* mat, core::triangle3df* triangles) const
-{
-	if (!box.intersectsWithBox(node->Box))
-		return;
-
-	const u32 cnt = node->Triangles.size();
-
-	for (u32 i=0; i<cnt; ++i)
-	{
-		const core::triangle3df& srcTri = node->Triangles[i];
-		// This isn't an accurate test, but it's fast, and the
-		// API contract doesn't guarantee complete accuracy.
-		if (srcTri.isTotalOutsideBox(box))
-			continue;
-
-		core::triangle3df& dstTri = triangles[trianglesWritten];
-		mat->transformVect(dstTri.pointA, srcTri.pointA );
-		mat->transformVect(dstTri.pointB, srcTri.pointB );
-		mat->transformVect(dstTri.pointC, srcTri.pointC );
-		++trianglesWritten;
-
-		// Halt when the out array is full.
-		if (trianglesWritten == maximumSize)
-			return;
-	}
-
-	for (u32 i=0; i<8; ++i)
-		if (node->Child[i])
-			getTrianglesFromOctree(node->Child[i], trianglesWritten,
-			maximumSize, box, mat, triangles);
-}
-
-
 //! Gets all triangles which have or may have contact with a 3d line.
 // new version: from user Piraaate
 void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arraySize,
@@ -254,8 +222,27 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arr
 
 	s32 trianglesWritten = 0;
 
-	if (Root)
-		getTrianglesFromOctree(Root, trianglesWritten, arraySize, invline, &mat, triangles);
+	VisibleChunks.set_used(0);
+	if (Tree)
+		Tree->getItems(invline, VisibleChunks);
+
+	const bool identity = mat.isIdentity();
+	for (u32 c=0; c<VisibleChunks.size() && trianglesWritten < arraySize; ++c)
+	{
+		const SChunk& chunk = Chunks[VisibleChunks[c]];
+		const u32 cnt = core::min_(chunk.Count, (u32)(arraySize - trianglesWritten));
+		for (u32 i=chunk.First; i<chunk.First+cnt; ++i)
+		{
+			triangles[trianglesWritten] = Triangles[i];
+			if (!identity)
+			{
+				mat.transformVect(triangles[trianglesWritten].pointA);
+				mat.transformVect(triangles[trianglesWritten].pointB);
+				mat.transformVect(triangles[trianglesWritten].pointC);
+			}
+			++trianglesWritten;
+		}
+	}
 
 	if ( outTriangleInfo )
 	{
@@ -272,45 +259,6 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arr
 #endif
 }
 
-void COctreeTriangleSelector::getTrianglesFromOctree(SOctreeNode* node,
-		s32& trianglesWritten, s32 maximumSize, const core::line3d<f32>& line,
-		const core::matrix4* transform, core::triangle3df* triangles) const
-{
-	if (!node->Box.intersectsWithLine(line))
-		return;
-
-	s32 cnt = node->Triangles.size();
-	if (cnt + trianglesWritten > maximumSize)
-		cnt -= cnt + trianglesWritten - maximumSize;
-
-	s32 i;
-
-	if ( transform->isIdentity() )
-	{
-		for (i=0; i<cnt; ++i)
-		{
-			triangles[trianglesWritten] = node->Triangles[i];
-			++trianglesWritten;
-		}
-	}
-	else
-	{
-		for (i=0; i<cnt; ++i)
-		{
-			triangles[trianglesWritten] = node->Triangles[i];
-			transform->transformVect(triangles[trianglesWritten].pointA);
-			transform->transformVect(triangles[trianglesWritten].pointB);
-			transform->transformVect(triangles[trianglesWritten].pointC);
-			++trianglesWritten;
-		}
-	}
-
-	for (i=0; i<8; ++i)
-		if (node->Child[i])
-			getTrianglesFromOctree(node->Child[i], trianglesWritten,
-			maximumSize, line, transform, triangles);
-}
-
 
 } // end namespace scene
 } // end namespace irr
@@ -6,6 +6,7 @@
 #define __C_OCTREE_TRIANGLE_SELECTOR_H_INCLUDED__
 
 #include "CTriangleSelector.h"
+#include "CLooseOctree.h"
 
 namespace irr
 {
@@ -14,7 +15,7 @@ namespace scene
 
 class ISceneNode;
 
-//! Stupid triangle selector without optimization
+//! Triangle selector which keeps nearby triangles together in a loose octree
 class COctreeTriangleSelector : public CTriangleSelector
 {
 public:
@@ -40,40 +41,20 @@ public:
 
 private:
 
-	struct SOctreeNode
+	//! A range of the triangles
+	struct SChunk
 	{
-		SOctreeNode()
-		{
-			for (u32 i=0; i!=8; ++i)
-				Child[i] = 0;
-		}
-
-		~SOctreeNode()
-		{
-			for (u32 i=0; i!=8; ++i)
-				delete Child[i];
-		}
-
-		core::array<core::triangle3df> Triangles;
-		SOctreeNode* Child[8];
-		core::aabbox3d<f32> Box;
+		u32 First;
+		u32 Count;
 	};
 
+	//! Sort the triangles into chunks and put those into the octree
+	void createTree();
 
-	void constructOctree(SOctreeNode* node);
-	void deleteEmptyNodes(SOctreeNode* node);
-	void getTrianglesFromOctree(SOctreeNode* node, s32& trianglesWritten,
-			s32 maximumSize, const core::aabbox3d<f32>& box,
-			const core::matrix4* transform,
-			core::triangle3df* triangles) const;
-
-	void getTrianglesFromOctree(SOctreeNode* node, s32& trianglesWritten,
-			s32 maximumSize, const core::line3d<f32>& line,
-			const core::matrix4* transform,
-			core::triangle3df* triangles) const;
-
-	SOctreeNode* Root;
-	s32 NodeCount;
+	CLooseOctree* Tree;
+	core::array<SChunk> Chunks;
+	//! chunks found by the last query
+	mutable core::array<u32> VisibleChunks;
 	s32 MinimalPolysPerNode;
 };
 
@@ -77,9 +77,12 @@ public:
 				Image[i] = Driver->createImage(ColorFormat, Size);
 
 				if (image[i]->getDimension() == Size)
+				{
 					image[i]->copyTo(Image[i]);
+					CColorConverter::convertMipMaps(image[i], Image[i]);
+				}
 				else
-					image[i]->copyToScaling(Image[i]);
+					image[i]->copyToResampling(Image[i], EIF_MITCHELL);
 			}
 
 			tmpImage = &Image;
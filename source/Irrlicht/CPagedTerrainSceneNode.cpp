@@ -0,0 +1,714 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CPagedTerrainSceneNode.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "IVideoDriver.h"
+#include "IReadFile.h"
+#include "os.h"
+#include <string.h>
+
+namespace irr
+{
+namespace scene
+{
+
+//! Chunks queued at most while rendering, so the nearest chunks are loaded first
+static const u32 MaxQueuedChunks = 4;
+
+//! Memory budget of new paged terrains
+static const u32 DefaultMemoryBudget = 64 * 1024 * 1024;
+
+namespace
+{
+	//! A chunk in load distance which is not in memory
+	struct SChunkRequest
+	{
+		f32 Distance;
+		u32 Index;
+
+		bool operator<(const SChunkRequest& other) const
+		{
+			return Distance < other.Distance;
+		}
+	};
+
+	//! Add a quad hanging down from a chunk border, facing away from the chunk
+	void addSkirtQuad(core::array<u16>& indices, u16 top0, u16 top1, u16 skirt0, u16 skirt1, bool flip)
+	{
+		if (flip)
+		{
+			indices.push_back(top1);
+			indices.push_back(top0);
+			indices.push_back(skirt0);
+			indices.push_back(skirt1);
+			indices.push_back(top1);
+			indices.push_back(skirt0);
+		}
+		else
+		{
+			indices.push_back(top0);
+			indices.push_back(top1);
+			indices.push_back(skirt0);
+			indices.push_back(top1);
+			indices.push_back(skirt1);
+			indices.push_back(skirt0);
+		}
+	}
+}
+
+
+//! constructor
+CPagedTerrainSceneNode::CPagedTerrainSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+		io::IReadFile* heightMapFile, u32 width, s32 bitsPerPixel,
+		bool signedData, bool floatVals, u32 chunkSize, video::SColor vertexColor,
+		const core::vector3df& position, const core::vector3df& rotation,
+		const core::vector3df& scale)
+	: IPagedTerrainSceneNode(parent, mgr, id, position, rotation, scale),
+	HeightMapFile(0), Width(width), Rows(0), BytesPerSample((u32)bitsPerPixel / 8),
+	SignedData(signedData), FloatVals(floatVals), ChunkSize(16), VertexColor(vertexColor),
+	LoadDistance(0.f), MemoryBudget(DefaultMemoryBudget), MemoryUsage(0), ChunkMemory(0), MaxLOD(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CPagedTerrainSceneNode");
+	#endif
+
+	// a power of two, so vertices and skirts fit 16 bit indices
+	while (ChunkSize < 128 && ChunkSize * 2 <= chunkSize)
+		ChunkSize *= 2;
+
+	if (!heightMapFile || (bitsPerPixel != 8 && bitsPerPixel != 16 && bitsPerPixel != 32) ||
+		(floatVals && bitsPerPixel != 32))
+	{
+		os::Printer::log("Paged terrain needs 8, 16 or 32 bit integers or 32 bit floats.", ELL_ERROR);
+		return;
+	}
+
+	if (width > 1)
+		Rows = (u32)(heightMapFile->getSize() / ((long)BytesPerSample * width));
+	if (Rows < 2)
+	{
+		os::Printer::log("Error reading paged terrain heightmap", "File is too small.", ELL_ERROR);
+		return;
+	}
+
+	HeightMapFile = heightMapFile;
+	HeightMapFile->grab();
+
+	ChunkCount.set((Rows - 2) / ChunkSize + 1, (Width - 2) / ChunkSize + 1);
+	Chunks.set_used(ChunkCount.Width * ChunkCount.Height);
+	for (u32 i=0; i<Chunks.size(); ++i)
+		Chunks[i] = 0;
+
+	// the coarsest LOD has 2x2 quads
+	while ((ChunkSize >> (MaxLOD + 1)) > 2)
+		++MaxLOD;
+	createLODIndices();
+
+	const u32 size = ChunkSize + 1;
+	ChunkMemory = (size * size + 4 * size) * sizeof(video::S3DVertex2TCoords) +
+		LODIndices[0].size() * sizeof(u16);
+
+	// heights are added when chunks are loaded
+	BoundingBox.reset(0.f, 0.f, 0.f);
+	BoundingBox.addInternalPoint((f32)(Rows - 1), 0.f, (f32)(Width - 1));
+
+	LoadDistance = 4.f * ChunkSize * core::max_(fabsf(scale.X), fabsf(scale.Z));
+	Material.NormalizeNormals = true;
+}
+
+
+//! destructor
+CPagedTerrainSceneNode::~CPagedTerrainSceneNode()
+{
+	Loader.clear();
+
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	for (u32 i=0; i<Resident.size(); ++i)
+	{
+		if (Resident[i]->Buffer)
+		{
+			if (driver)
+				driver->removeHardwareBuffer(Resident[i]->Buffer);
+			Resident[i]->Buffer->drop();
+		}
+		delete Resident[i];
+	}
+
+	if (HeightMapFile)
+		HeightMapFile->drop();
+}
+
+
+//! Create the indices of all LODs
+void CPagedTerrainSceneNode::createLODIndices()
+{
+	// The vertices of a chunk are the samples row by row, followed by the
+	// skirt vertices below the borders x=0, x=ChunkSize, z=0 and z=ChunkSize.
+	const u32 size = ChunkSize + 1;
+	const u32 skirt = size * size;
+
+	for (s32 lod=0; lod<=MaxLOD; ++lod)
+	{
+		const u32 step = 1 << lod;
+		const u32 quads = ChunkSize / step;
+		core::array<u16>& indices = LODIndices[lod];
+		indices.reallocate(quads * quads * 6 + quads * 4 * 6);
+
+		for (u32 x=0; x<ChunkSize; x+=step)
+		{
+			for (u32 z=0; z<ChunkSize; z+=step)
+			{
+				// same triangles as the geo mip map terrain
+				const u16 index11 = (u16)(x * size + z);
+				const u16 index21 = (u16)((x + step) * size + z);
+				const u16 index12 = (u16)(x * size + z + step);
+				const u16 index22 = (u16)((x + step) * size + z + step);
+
+				indices.push_back(index12);
+				indices.push_back(index11);
+				indices.push_back(index22);
+				indices.push_back(index22);
+				indices.push_back(index11);
+				indices.push_back(index21);
+			}
+		}
+
+		for (u32 i=0; i<ChunkSize; i+=step)
+		{
+			const u32 j = i + step;
+			addSkirtQuad(indices, (u16)i, (u16)j, (u16)(skirt + i), (u16)(skirt + j), false);
+			addSkirtQuad(indices, (u16)(ChunkSize * size + i), (u16)(ChunkSize * size + j),
+				(u16)(skirt + size + i), (u16)(skirt + size + j), true);
+			addSkirtQuad(indices, (u16)(i * size), (u16)(j * size),
+				(u16)(skirt + 2 * size + i), (u16)(skirt + 2 * size + j), true);
+			addSkirtQuad(indices, (u16)(i * size + ChunkSize), (u16)(j * size + ChunkSize),
+				(u16)(skirt + 3 * size + i), (u16)(skirt + 3 * size + j), false);
+		}
+	}
+}
+
+
+//! Job function of the loader, loads a chunk
+void CPagedTerrainSceneNode::loadChunkJob(void* chunk)
+{
+	SChunk* c = (SChunk*)chunk;
+	c->Failed = !c->Node->loadChunk(*c);
+}
+
+
+//! Read the samples of a part of a row
+bool CPagedTerrainSceneNode::readSamples(u32 row, u32 first, u32 count, f32* heights)
+{
+	if (!HeightMapFile->seek(((long)row * Width + first) * BytesPerSample))
+		return false;
+
+	Samples.set_used(count * BytesPerSample);
+	if (HeightMapFile->read(Samples.pointer(), Samples.size()) != (size_t)Samples.size())
+		return false;
+
+	// same scaling as the RAW heightmaps of the geo mip map terrain
+	const u8* data = Samples.const_pointer();
+	for (u32 i=0; i<count; ++i)
+	{
+		if (FloatVals)
+			memcpy(&heights[i], data + i * 4, 4);
+		else if (BytesPerSample == 1)
+			heights[i] = SignedData ? (f32)((const s8*)data)[i] : (f32)data[i];
+		else if (BytesPerSample == 2)
+			heights[i] = (SignedData ? (f32)((const s16*)data)[i] : (f32)((const u16*)data)[i]) / 256.f;
+		else
+			heights[i] = (SignedData ? (f32)((const s32*)data)[i] : (f32)((const u32*)data)[i]) / 16777216.f;
+	}
+	return true;
+}
+
+
+//! Read the heights and create the vertices of a chunk, on the loader thread
+bool CPagedTerrainSceneNode::loadChunk(SChunk& chunk)
+{
+	const u32 size = ChunkSize + 1;
+	const s32 x0 = chunk.X * ChunkSize;
+	const s32 z0 = chunk.Z * ChunkSize;
+
+	// The heights with a border of one sample for the normals. Samples
+	// outside of the heightmap are clamped to its border, so the last
+	// chunks have degenerated triangles beyond it.
+	const u32 border = size + 2;
+	Heights.set_used(border * border);
+	const u32 firstZ = z0 ? z0 - 1 : 0;
+	const u32 lastZ = core::min_((u32)z0 + ChunkSize + 1, Width - 1);
+	Row.set_used(lastZ - firstZ + 1);
+	for (u32 i=0; i<border; ++i)
+	{
+		const u32 x = (u32)core::clamp(x0 - 1 + (s32)i, 0, (s32)Rows - 1);
+		if (!readSamples(x, firstZ, Row.size(), Row.pointer()))
+			return false;
+		for (u32 j=0; j<border; ++j)
+			Heights[i * border + j] = Row[core::clamp(z0 - 1 + (s32)j, 0, (s32)Width - 1) - firstZ];
+	}
+
+	core::array<video::S3DVertex2TCoords>& vertices = chunk.Buffer->Vertices;
+	vertices.set_used(size * size + 4 * size);
+	const f32 tcX = 1.f / (Rows - 1);
+	const f32 tcZ = 1.f / (Width - 1);
+	f32 minY = FLT_MAX;
+	f32 maxY = -FLT_MAX;
+	for (u32 i=0; i<size; ++i)
+	{
+		const s32 x = core::min_(x0 + (s32)i, (s32)Rows - 1);
+		const f32 dx = (f32)core::max_(core::min_(x + 1, (s32)Rows - 1) - core::max_(x - 1, 0), 1);
+		for (u32 j=0; j<size; ++j)
+		{
+			const s32 z = core::min_(z0 + (s32)j, (s32)Width - 1);
+			const f32 dz = (f32)core::max_(core::min_(z + 1, (s32)Width - 1) - core::max_(z - 1, 0), 1);
+			const f32* h = &Heights[(i + 1) * border + j + 1];
+
+			// central differences in samples, the node transformation scales the normals
+			core::vector3df normal((h[-(s32)border] - h[border]) / dx, 1.f, (h[-1] - h[1]) / dz);
+			normal.normalize();
+
+			video::S3DVertex2TCoords& v = vertices[i * size + j];
+			v.Pos.set((f32)x, h[0], (f32)z);
+			v.Normal = normal;
+			v.Color = VertexColor;
+			v.TCoords.set(1.f - x * tcX, z * tcZ);
+			v.TCoords2 = v.TCoords;
+
+			minY = core::min_(minY, h[0]);
+			maxY = core::max_(maxY, h[0]);
+		}
+	}
+
+	// Gaps to chunks with another LOD are at most as high as the
+	// heights of the chunk border differ, the skirts cover them.
+	const f32 skirtDepth = core::max_(maxY - minY, 0.01f);
+	video::S3DVertex2TCoords* skirt = &vertices[size * size];
+	for (u32 i=0; i<size; ++i)
+	{
+		skirt[i] = vertices[i];
+		skirt[size + i] = vertices[ChunkSize * size + i];
+		skirt[2 * size + i] = vertices[i * size];
+		skirt[3 * size + i] = vertices[i * size + ChunkSize];
+	}
+	for (u32 i=0; i<4 * size; ++i)
+		skirt[i].Pos.Y -= skirtDepth;
+
+	chunk.Buffer->recalculateBoundingBox();
+	return true;
+}
+
+
+//! Take over the chunks the loader is done with
+void CPagedTerrainSceneNode::collectLoadedChunks()
+{
+	Finished.set_used(0);
+	Loader.getFinished(Finished);
+
+	for (u32 i=0; i<Finished.size(); ++i)
+	{
+		SChunk* chunk = (SChunk*)Finished[i];
+		if (chunk->Failed)
+		{
+			// failed chunks stay, so they are not read again
+			os::Printer::log("Could not read paged terrain chunk.", ELL_WARNING);
+			chunk->State = ECS_FAILED;
+			chunk->Buffer->drop();
+			chunk->Buffer = 0;
+			MemoryUsage -= ChunkMemory;
+		}
+		else
+		{
+			chunk->State = ECS_LOADED;
+			chunk->Buffer->setHardwareMappingHint(EHM_STATIC);
+			BoundingBox.addInternalBox(chunk->Buffer->getBoundingBox());
+		}
+	}
+}
+
+
+//! Distance of a chunk to a position in world space
+f32 CPagedTerrainSceneNode::getChunkDistance(u32 x, u32 z, const core::vector3df& position) const
+{
+	core::matrix4 inverse(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	core::vector3df local(position);
+	inverse.transformVect(local);
+
+	// Nearest point of the chunk in the heightmap, stays the nearest
+	// point after scaling along the axes and rotating.
+	const SChunk* chunk = Chunks[x * ChunkCount.Height + z];
+	const core::aabbox3df& heights = chunk && chunk->State == ECS_LOADED ? chunk->Buffer->getBoundingBox() : BoundingBox;
+	core::vector3df nearest(
+		core::clamp(local.X, (f32)(x * ChunkSize), (f32)core::min_((x + 1) * ChunkSize, Rows - 1)),
+		core::clamp(local.Y, heights.MinEdge.Y, heights.MaxEdge.Y),
+		core::clamp(local.Z, (f32)(z * ChunkSize), (f32)core::min_((z + 1) * ChunkSize, Width - 1)));
+	AbsoluteTransformation.transformVect(nearest);
+	return nearest.getDistanceFrom(position);
+}
+
+
+//! Remove a chunk from memory
+void CPagedTerrainSceneNode::evictChunk(u32 resident)
+{
+	SChunk* chunk = Resident[resident];
+	if (chunk->Buffer)
+	{
+		SceneManager->getVideoDriver()->removeHardwareBuffer(chunk->Buffer);
+		chunk->Buffer->drop();
+		MemoryUsage -= ChunkMemory;
+	}
+	Chunks[chunk->X * ChunkCount.Height + chunk->Z] = 0;
+	delete chunk;
+
+	Resident[resident] = Resident.getLast();
+	Resident.set_used(Resident.size() - 1);
+}
+
+
+//! Request chunks near a position, evict far ones, cancel chunks out of range
+void CPagedTerrainSceneNode::updateChunks(const core::vector3df& position, u32 maxQueued)
+{
+	u32 queued = 0;
+	for (u32 i=0; i<Resident.size();)
+	{
+		SChunk* chunk = Resident[i];
+		chunk->Distance = getChunkDistance(chunk->X, chunk->Z, position);
+		if (chunk->State == ECS_QUEUED)
+		{
+			if (chunk->Distance > LoadDistance && Loader.cancel(chunk))
+			{
+				evictChunk(i);
+				continue;
+			}
+			++queued;
+		}
+		++i;
+	}
+
+	// the chunks in load distance, nearest first
+	core::matrix4 inverse(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	core::vector3df local(position);
+	inverse.transformVect(local);
+	const core::vector3df scale = AbsoluteTransformation.getScale();
+	const f32 range = LoadDistance / core::max_(core::min_(scale.X, scale.Z), 0.0001f);
+	const s32 minX = core::max_(core::floor32((local.X - range) / ChunkSize), 0);
+	const s32 maxX = core::min_(core::floor32((local.X + range) / ChunkSize), (s32)ChunkCount.Width - 1);
+	const s32 minZ = core::max_(core::floor32((local.Z - range) / ChunkSize), 0);
+	const s32 maxZ = core::min_(core::floor32((local.Z + range) / ChunkSize), (s32)ChunkCount.Height - 1);
+
+	core::array<SChunkRequest> requests;
+	for (s32 x=minX; x<=maxX; ++x)
+	{
+		for (s32 z=minZ; z<=maxZ; ++z)
+		{
+			SChunkRequest request;
+			request.Index = x * ChunkCount.Height + z;
+			if (Chunks[request.Index])
+				continue;
+			request.Distance = getChunkDistance(x, z, position);
+			if (request.Distance <= LoadDistance)
+				requests.push_back(request);
+		}
+	}
+	requests.sort();
+
+	for (u32 r=0; r<requests.size() && queued<maxQueued; ++r)
+	{
+		// make room by evicting chunks farther away
+		while (MemoryUsage + ChunkMemory > MemoryBudget)
+		{
+			s32 farthest = -1;
+			for (u32 i=0; i<Resident.size(); ++i)
+			{
+				if (Resident[i]->State == ECS_LOADED && Resident[i]->Distance > requests[r].Distance &&
+					(farthest < 0 || Resident[i]->Distance > Resident[farthest]->Distance))
+					farthest = i;
+			}
+			if (farthest < 0)
+				break;
+			evictChunk(farthest);
+		}
+		if (MemoryUsage + ChunkMemory > MemoryBudget)
+			break;
+
+		SChunk* chunk = new SChunk;
+		chunk->Node = this;
+		chunk->Buffer = new SMeshBufferLightMap();
+		chunk->Buffer->Material = Material;
+		chunk->X = requests[r].Index / ChunkCount.Height;
+		chunk->Z = requests[r].Index % ChunkCount.Height;
+		chunk->State = ECS_QUEUED;
+		chunk->LOD = -1;
+		chunk->Distance = requests[r].Distance;
+		chunk->Failed = false;
+		Chunks[requests[r].Index] = chunk;
+		Resident.push_back(chunk);
+		MemoryUsage += ChunkMemory;
+		++queued;
+
+		Loader.push(&loadChunkJob, chunk);
+	}
+
+	// the budget may have been lowered
+	while (MemoryUsage > MemoryBudget)
+	{
+		s32 farthest = -1;
+		for (u32 i=0; i<Resident.size(); ++i)
+		{
+			if (Resident[i]->State == ECS_LOADED &&
+				(farthest < 0 || Resident[i]->Distance > Resident[farthest]->Distance))
+				farthest = i;
+		}
+		if (farthest < 0)
+			break;
+		evictChunk(farthest);
+	}
+}
+
+
+//! Select the chunks to draw and their LOD
+void CPagedTerrainSceneNode::selectVisibleChunks(const SViewFrustum& frustum)
+{
+	VisibleChunks.set_used(0);
+
+	SViewFrustum localFrustum(frustum);
+	core::matrix4 inverse(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	localFrustum.transform(inverse);
+
+	// each LOD is used over twice the distance of the one before
+	const core::vector3df scale = AbsoluteTransformation.getScale();
+	const f32 chunkExtent = ChunkSize * core::max_(scale.X, scale.Z);
+
+	for (u32 i=0; i<Resident.size(); ++i)
+	{
+		SChunk* chunk = Resident[i];
+		if (chunk->State != ECS_LOADED)
+			continue;
+
+		core::vector3df edges[8];
+		chunk->Buffer->getBoundingBox().getEdges(edges);
+		bool culled = false;
+		for (s32 p=0; p<SViewFrustum::VF_PLANE_COUNT && !culled; ++p)
+		{
+			culled = true;
+			for (u32 e=0; e<8; ++e)
+			{
+				if (localFrustum.planes[p].classifyPointRelation(edges[e]) != core::ISREL3D_FRONT)
+				{
+					culled = false;
+					break;
+				}
+			}
+		}
+		if (culled)
+			continue;
+
+		s32 lod = 0;
+		while (lod < MaxLOD && chunk->Distance >= chunkExtent * (2 << lod))
+			++lod;
+		if (lod != chunk->LOD)
+		{
+			chunk->Buffer->Indices = LODIndices[lod];
+			chunk->Buffer->setDirty(EBT_INDEX);
+			chunk->LOD = lod;
+		}
+		VisibleChunks.push_back(chunk);
+	}
+}
+
+
+//! pre render event
+void CPagedTerrainSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible && HeightMapFile)
+	{
+		collectLoadedChunks();
+
+		ICameraSceneNode* camera = SceneManager->getActiveCamera();
+		if (camera)
+		{
+			updateChunks(camera->getAbsolutePosition(), MaxQueuedChunks);
+			selectVisibleChunks(*camera->getViewFrustum());
+
+			if (!VisibleChunks.empty())
+				SceneManager->registerNodeForRendering(this);
+		}
+	}
+
+	ISceneNode::OnRegisterSceneNode();
+}
+
+
+//! render
+void CPagedTerrainSceneNode::render()
+{
+	if (VisibleChunks.empty())
+		return;
+
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+	driver->setMaterial(Material);
+
+	for (u32 i=0; i<VisibleChunks.size(); ++i)
+		driver->drawMeshBuffer(VisibleChunks[i]->Buffer);
+
+	if (DebugDataVisible & scene::EDS_BBOX)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+		for (u32 i=0; i<VisibleChunks.size(); ++i)
+			driver->draw3DBox(VisibleChunks[i]->Buffer->getBoundingBox(), video::SColor(255,255,255,255));
+	}
+}
+
+
+//! returns the axis aligned bounding box of the loaded chunks
+const core::aabbox3d<f32>& CPagedTerrainSceneNode::getBoundingBox() const
+{
+	return BoundingBox;
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CPagedTerrainSceneNode::getMaterialCount() const
+{
+	return 1;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CPagedTerrainSceneNode::getMaterial(u32 i)
+{
+	return Material;
+}
+
+
+//! Get the height of the terrain at a position in world space.
+f32 CPagedTerrainSceneNode::getHeight(f32 x, f32 z) const
+{
+	if (!HeightMapFile)
+		return -FLT_MAX;
+
+	core::matrix4 inverse(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	core::vector3df pos(x, 0.f, z);
+	inverse.transformVect(pos);
+	if (pos.X < 0.f || pos.Z < 0.f || pos.X > Rows - 1 || pos.Z > Width - 1)
+		return -FLT_MAX;
+
+	const u32 chunkX = core::min_((u32)pos.X / ChunkSize, ChunkCount.Width - 1);
+	const u32 chunkZ = core::min_((u32)pos.Z / ChunkSize, ChunkCount.Height - 1);
+	const SChunk* chunk = Chunks[chunkX * ChunkCount.Height + chunkZ];
+	if (!chunk || chunk->State != ECS_LOADED)
+		return -FLT_MAX;
+
+	// same triangles as drawn at full detail
+	const f32 fx = pos.X - chunkX * ChunkSize;
+	const f32 fz = pos.Z - chunkZ * ChunkSize;
+	const u32 X = core::min_((u32)fx, ChunkSize - 1);
+	const u32 Z = core::min_((u32)fz, ChunkSize - 1);
+	const u32 size = ChunkSize + 1;
+	const video::S3DVertex2TCoords* vertices = chunk->Buffer->Vertices.const_pointer();
+	const f32 a = vertices[X * size + Z].Pos.Y;
+	const f32 b = vertices[(X + 1) * size + Z].Pos.Y;
+	const f32 c = vertices[X * size + Z + 1].Pos.Y;
+	const f32 d = vertices[(X + 1) * size + Z + 1].Pos.Y;
+	const f32 dx = fx - X;
+	const f32 dz = fz - Z;
+
+	f32 height;
+	if (dx > dz)
+		height = a + (d - b) * dz + (b - a) * dx;
+	else
+		height = a + (d - c) * dx + (c - a) * dz;
+
+	pos.Y = height;
+	AbsoluteTransformation.transformVect(pos);
+	return pos.Y;
+}
+
+
+//! Set the distance around the camera in which chunks are loaded.
+void CPagedTerrainSceneNode::setLoadDistance(f32 distance)
+{
+	LoadDistance = distance;
+}
+
+
+//! Get the distance around the camera in which chunks are loaded.
+f32 CPagedTerrainSceneNode::getLoadDistance() const
+{
+	return LoadDistance;
+}
+
+
+//! Set the memory the chunks may use.
+void CPagedTerrainSceneNode::setMemoryBudget(u32 bytes)
+{
+	MemoryBudget = bytes;
+}
+
+
+//! Get the memory the chunks may use.
+u32 CPagedTerrainSceneNode::getMemoryBudget() const
+{
+	return MemoryBudget;
+}
+
+
+//! Get the memory used by loaded chunks and chunks being loaded.
+u32 CPagedTerrainSceneNode::getMemoryUsage() const
+{
+	return MemoryUsage;
+}
+
+
+//! Get the number of chunks along the X and Z axis of the heightmap.
+core::dimension2du CPagedTerrainSceneNode::getChunkCount() const
+{
+	return ChunkCount;
+}
+
+
+//! Get the number of chunks which are loaded.
+u32 CPagedTerrainSceneNode::getLoadedChunkCount() const
+{
+	u32 count = 0;
+	for (u32 i=0; i<Resident.size(); ++i)
+	{
+		if (Resident[i]->State == ECS_LOADED)
+			++count;
+	}
+	return count;
+}
+
+
+//! Check if a chunk is loaded.
+bool CPagedTerrainSceneNode::isChunkLoaded(u32 x, u32 z) const
+{
+	if (x >= ChunkCount.Width || z >= ChunkCount.Height)
+		return false;
+	const SChunk* chunk = Chunks[x * ChunkCount.Height + z];
+	return chunk && chunk->State == ECS_LOADED;
+}
+
+
+//! Load the chunks around a position and wait until they are loaded.
+void CPagedTerrainSceneNode::loadChunksAround(const core::vector3df& position)
+{
+	if (!HeightMapFile)
+		return;
+
+	updateAbsolutePosition();
+	collectLoadedChunks();
+	updateChunks(position, 0xffffffff);
+	Loader.waitForAll();
+	collectLoadedChunks();
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,182 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+#define __C_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+
+#include "IPagedTerrainSceneNode.h"
+#include "SMeshBufferLightMap.h"
+#include "SViewFrustum.h"
+#include "CWorkerPool.h"
+
+namespace irr
+{
+namespace io
+{
+	class IReadFile;
+}
+namespace scene
+{
+
+	//! A scene node for terrains streamed in chunks from a RAW heightmap.
+	class CPagedTerrainSceneNode : public IPagedTerrainSceneNode
+	{
+	public:
+
+		//! constructor
+		CPagedTerrainSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			io::IReadFile* heightMapFile, u32 width, s32 bitsPerPixel,
+			bool signedData, bool floatVals, u32 chunkSize, video::SColor vertexColor,
+			const core::vector3df& position, const core::vector3df& rotation,
+			const core::vector3df& scale);
+
+		//! destructor
+		virtual ~CPagedTerrainSceneNode();
+
+		//! Check if the heightmap has at least 2x2 samples of a supported format
+		bool isValid() const
+		{
+			return HeightMapFile != 0;
+		}
+
+		//! pre render event
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! render
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of the loaded chunks
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_PAGED_TERRAIN; }
+
+		//! Get the height of the terrain at a position in world space.
+		virtual f32 getHeight(f32 x, f32 z) const _IRR_OVERRIDE_;
+
+		//! Set the distance around the camera in which chunks are loaded.
+		virtual void setLoadDistance(f32 distance) _IRR_OVERRIDE_;
+
+		//! Get the distance around the camera in which chunks are loaded.
+		virtual f32 getLoadDistance() const _IRR_OVERRIDE_;
+
+		//! Set the memory the chunks may use.
+		virtual void setMemoryBudget(u32 bytes) _IRR_OVERRIDE_;
+
+		//! Get the memory the chunks may use.
+		virtual u32 getMemoryBudget() const _IRR_OVERRIDE_;
+
+		//! Get the memory used by loaded chunks and chunks being loaded.
+		virtual u32 getMemoryUsage() const _IRR_OVERRIDE_;
+
+		//! Get the number of chunks along the X and Z axis of the heightmap.
+		virtual core::dimension2du getChunkCount() const _IRR_OVERRIDE_;
+
+		//! Get the number of chunks which are loaded.
+		virtual u32 getLoadedChunkCount() const _IRR_OVERRIDE_;
+
+		//! Check if a chunk is loaded.
+		virtual bool isChunkLoaded(u32 x, u32 z) const _IRR_OVERRIDE_;
+
+		//! Load the chunks around a position and wait until they are loaded.
+		virtual void loadChunksAround(const core::vector3df& position) _IRR_OVERRIDE_;
+
+	private:
+
+		enum E_CHUNK_STATE
+		{
+			ECS_QUEUED = 0,
+			ECS_LOADED,
+			ECS_FAILED
+		};
+
+		struct SChunk
+		{
+			CPagedTerrainSceneNode* Node;
+			//! vertices and indices, written by the loader until the chunk is loaded
+			SMeshBufferLightMap* Buffer;
+			u32 X;
+			u32 Z;
+			E_CHUNK_STATE State;
+			s32 LOD;
+			//! distance to the camera in world space, updated each frame
+			f32 Distance;
+			//! set by the loader
+			bool Failed;
+		};
+
+		//! Job function of the loader, loads a chunk
+		static void loadChunkJob(void* chunk);
+
+		//! Read the heights and create the vertices of a chunk, on the loader thread
+		bool loadChunk(SChunk& chunk);
+
+		//! Read the samples of a part of a row
+		bool readSamples(u32 row, u32 first, u32 count, f32* heights);
+
+		//! Take over the chunks the loader is done with
+		void collectLoadedChunks();
+
+		//! Request chunks near a position, evict far ones, cancel chunks out of range
+		void updateChunks(const core::vector3df& position, u32 maxQueued);
+
+		//! Distance of a chunk to a position in world space
+		f32 getChunkDistance(u32 x, u32 z, const core::vector3df& position) const;
+
+		//! Remove a chunk from memory
+		void evictChunk(u32 resident);
+
+		//! Select the chunks to draw and their LOD
+		void selectVisibleChunks(const SViewFrustum& frustum);
+
+		//! Create the indices of all LODs
+		void createLODIndices();
+
+		io::IReadFile* HeightMapFile;
+		u32 Width;
+		u32 Rows;
+		u32 BytesPerSample;
+		bool SignedData;
+		bool FloatVals;
+		u32 ChunkSize;
+		core::dimension2du ChunkCount;
+		video::SColor VertexColor;
+		video::SMaterial Material;
+		core::aabbox3df BoundingBox;
+
+		f32 LoadDistance;
+		u32 MemoryBudget;
+		u32 MemoryUsage;
+		u32 ChunkMemory;
+
+		//! all chunks, 0 if not in memory
+		core::array<SChunk*> Chunks;
+		//! chunks loaded or queued
+		core::array<SChunk*> Resident;
+		core::array<SChunk*> VisibleChunks;
+
+		//! indices of all LODs, with skirts
+		core::array<u16> LODIndices[8];
+		s32 MaxLOD;
+
+		CBackgroundQueue Loader;
+		core::array<void*> Finished;
+
+		// used on the loader thread only
+		core::array<u8> Samples;
+		core::array<f32> Row;
+		core::array<f32> Heights;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
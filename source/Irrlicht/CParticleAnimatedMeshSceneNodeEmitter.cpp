@@ -5,7 +5,7 @@
 #include "CParticleAnimatedMeshSceneNodeEmitter.h"
 #include "IAnimatedMeshSceneNode.h"
 #include "IMesh.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 
 namespace irr
 {
@@ -44,7 +44,7 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if(Time > everyWhatMillisecond)
@@ -80,20 +80,20 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 						if( MaxAngleDegrees )
 						{
 							core::vector3df tgt = p.vector;
-							tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-							tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-							tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+							tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+							tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+							tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 							p.vector = tgt;
 						}
 
 						p.endTime = now + MinLifeTime;
 						if (MaxLifeTime != MinLifeTime)
-							p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+							p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 						if (MinStartColor==MaxStartColor)
 							p.color=MinStartColor;
 						else
-							p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+							p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 						p.startColor = p.color;
 						p.startVector = p.vector;
@@ -101,7 +101,7 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 						if (MinStartSize==MaxStartSize)
 							p.startSize = MinStartSize;
 						else
-							p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+							p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 						p.size = p.startSize;
 
 						Particles.push_back(p);
@@ -112,14 +112,14 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 			{
 				s32 randomMB = 0;
 				if( MBNumber < 0 )
-					randomMB = os::Randomizer::rand() % MBCount;
+					randomMB = CParticleRandomizer::currentRand() % MBCount;
 				else
 					randomMB = MBNumber;
 
 				u32 vertexNumber = frameMesh->getMeshBuffer(randomMB)->getVertexCount();
 				if (!vertexNumber)
 					continue;
-				vertexNumber = os::Randomizer::rand() % vertexNumber;
+				vertexNumber = CParticleRandomizer::currentRand() % vertexNumber;
 
 				p.pos = frameMesh->getMeshBuffer(randomMB)->getPosition(vertexNumber);
 				if( UseNormalDirection )
@@ -133,20 +133,20 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 				if( MaxAngleDegrees )
 				{
 					core::vector3df tgt = Direction;
-					tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-					tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-					tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+					tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+					tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+					tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 					p.vector = tgt;
 				}
 
 				p.endTime = now + MinLifeTime;
 				if (MaxLifeTime != MinLifeTime)
-					p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+					p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 				if (MinStartColor==MaxStartColor)
 					p.color=MinStartColor;
 				else
-					p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+					p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 				p.startColor = p.color;
 				p.startVector = p.vector;
@@ -154,7 +154,7 @@ s32 CParticleAnimatedMeshSceneNodeEmitter::emitt(u32 now, u32 timeSinceLastCall,
 				if (MinStartSize==MaxStartSize)
 					p.startSize = MinStartSize;
 				else
-					p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+					p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 				p.size = p.startSize;
 
 				Particles.push_back(p);
@@ -15,7 +15,7 @@ CParticleAttractionAffector::CParticleAttractionAffector(
 		const core::vector3df& point, f32 speed, bool attract,
 		bool affectX, bool affectY, bool affectZ )
 	: Point(point), Speed(speed), AffectX(affectX), AffectY(affectY),
-		AffectZ(affectZ), Attract(attract), LastTime(0)
+		AffectZ(affectZ), Attract(attract), LastTime(0), Step(0.f)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleAttractionAffector");
@@ -57,6 +57,73 @@ void CParticleAttractionAffector::affect(u32 now, SParticle* particlearray, u32
 	}
 }
 
+
+//! Prepare affecting all particles at time now
+bool CParticleAttractionAffector::beginAffect(u32 now)
+{
+	if( LastTime == 0 )
+	{
+		LastTime = now;
+		return false;
+	}
+
+	Step = Speed * (( now - LastTime ) / 1000.0f);
+	if( !Attract )
+		Step = -Step;
+	LastTime = now;
+
+	return Enabled && (AffectX || AffectY || AffectZ);
+}
+
+
+//! Affect the particles in [begin,end)
+void CParticleAttractionAffector::affectStore(CParticleStore& particles, u32 begin, u32 end) const
+{
+	f32* posX = particles.getFloats(EPF_POS_X);
+	f32* posY = particles.getFloats(EPF_POS_Y);
+	f32* posZ = particles.getFloats(EPF_POS_Z);
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128 pointX = _mm_set1_ps(Point.X);
+	const __m128 pointY = _mm_set1_ps(Point.Y);
+	const __m128 pointZ = _mm_set1_ps(Point.Z);
+	const __m128 step = _mm_set1_ps(Step);
+	const __m128 zero = _mm_setzero_ps();
+	for (u32 i=begin; i<end; i+=4)
+	{
+		const __m128 x = _mm_loadu_ps(posX + i);
+		const __m128 y = _mm_loadu_ps(posY + i);
+		const __m128 z = _mm_loadu_ps(posZ + i);
+		const __m128 dx = _mm_sub_ps(pointX, x);
+		const __m128 dy = _mm_sub_ps(pointY, y);
+		const __m128 dz = _mm_sub_ps(pointZ, z);
+		const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		// particles on the point itself don't move
+		const __m128 scale = _mm_and_ps(_mm_cmpneq_ps(length, zero), _mm_div_ps(step, length));
+		if (AffectX)
+			_mm_storeu_ps(posX + i, _mm_add_ps(x, _mm_mul_ps(dx, scale)));
+		if (AffectY)
+			_mm_storeu_ps(posY + i, _mm_add_ps(y, _mm_mul_ps(dy, scale)));
+		if (AffectZ)
+			_mm_storeu_ps(posZ + i, _mm_add_ps(z, _mm_mul_ps(dz, scale)));
+	}
+#else
+	for (u32 i=begin; i<end; ++i)
+	{
+		core::vector3df direction(Point.X - posX[i], Point.Y - posY[i], Point.Z - posZ[i]);
+		direction.normalize();
+		direction *= Step;
+
+		if( AffectX )
+			posX[i] += direction.X;
+		if( AffectY )
+			posY[i] += direction.Y;
+		if( AffectZ )
+			posZ[i] += direction.Z;
+	}
+#endif
+}
+
 //! Writes attributes of the object.
 void CParticleAttractionAffector::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
 {
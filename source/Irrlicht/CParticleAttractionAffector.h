@@ -6,6 +6,7 @@
 #define __C_PARTICLE_ATTRACTION_AFFECTOR_H_INCLUDED__
 
 #include "IParticleAttractionAffector.h"
+#include "CParticleStore.h"
 
 namespace irr
 {
@@ -13,7 +14,7 @@ namespace scene
 {
 
 //! Particle Affector for attracting particles to a point
-class CParticleAttractionAffector : public IParticleAttractionAffector
+class CParticleAttractionAffector : public IParticleAttractionAffector, public IParticleStoreAffector
 {
 public:
 
@@ -25,6 +26,15 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Prepare affecting all particles at time now
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affect the particles in [begin,end)
+	virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const _IRR_OVERRIDE_;
+
+	//! Get the interface which affects the particle arrays directly
+	virtual IParticleStoreAffector* getStoreAffector() _IRR_OVERRIDE_ { return this; }
+
 	//! Set the point that particles will attract to
 	virtual void setPoint( const core::vector3df& point ) _IRR_OVERRIDE_ { Point = point; }
 
@@ -76,6 +86,8 @@ private:
 	bool AffectZ;
 	bool Attract;
 	u32 LastTime;
+	//! distance moved in this update, negative for detracting
+	f32 Step;
 };
 
 } // end namespace scene
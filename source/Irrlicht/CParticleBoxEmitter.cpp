@@ -3,7 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CParticleBoxEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 #include "IAttributes.h"
 #include "irrMath.h"
 
@@ -40,7 +40,7 @@ s32 CParticleBoxEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outAr
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if (Time > everyWhatMillisecond)
@@ -56,9 +56,9 @@ s32 CParticleBoxEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outAr
 
 		for (u32 i=0; i<amount; ++i)
 		{
-			p.pos.X = Box.MinEdge.X + os::Randomizer::frand() * extent.X;
-			p.pos.Y = Box.MinEdge.Y + os::Randomizer::frand() * extent.Y;
-			p.pos.Z = Box.MinEdge.Z + os::Randomizer::frand() * extent.Z;
+			p.pos.X = Box.MinEdge.X + CParticleRandomizer::currentFrand() * extent.X;
+			p.pos.Y = Box.MinEdge.Y + CParticleRandomizer::currentFrand() * extent.Y;
+			p.pos.Z = Box.MinEdge.Z + CParticleRandomizer::currentFrand() * extent.Z;
 
 			p.startTime = now;
 			p.vector = Direction;
@@ -66,20 +66,20 @@ s32 CParticleBoxEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outAr
 			if (MaxAngleDegrees)
 			{
 				core::vector3df tgt = Direction;
-				tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+				tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 				p.vector = tgt;
 			}
 
 			p.endTime = now + MinLifeTime;
 			if (MaxLifeTime != MinLifeTime)
-				p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+				p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 			if (MinStartColor==MaxStartColor)
 				p.color=MinStartColor;
 			else
-				p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+				p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 			p.startColor = p.color;
 			p.startVector = p.vector;
@@ -87,7 +87,7 @@ s32 CParticleBoxEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outAr
 			if (MinStartSize==MaxStartSize)
 				p.startSize = MinStartSize;
 			else
-				p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+				p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 			p.size = p.startSize;
 
 			Particles.push_back(p);
@@ -3,7 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CParticleCylinderEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -43,7 +43,7 @@ s32 CParticleCylinderEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*&
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if(Time > everyWhatMillisecond)
@@ -59,14 +59,14 @@ s32 CParticleCylinderEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*&
 		for(u32 i=0; i<amount; ++i)
 		{
 			// Random distance from center if outline only is not true
-			const f32 distance = (!OutlineOnly) ? (os::Randomizer::frand() * Radius) : Radius;
+			const f32 distance = (!OutlineOnly) ? (CParticleRandomizer::currentFrand() * Radius) : Radius;
 
 			// Random direction from center
 			p.pos.set(Center.X + distance, Center.Y, Center.Z + distance);
-			p.pos.rotateXZBy(os::Randomizer::frand() * 360, Center);
+			p.pos.rotateXZBy(CParticleRandomizer::currentFrand() * 360, Center);
 
 			// Random length
-			const f32 length = os::Randomizer::frand() * Length;
+			const f32 length = CParticleRandomizer::currentFrand() * Length;
 
 			// Random point along the cylinders length
 			p.pos += Normal * length;
@@ -77,20 +77,20 @@ s32 CParticleCylinderEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*&
 			if( MaxAngleDegrees )
 			{
 				core::vector3df tgt = Direction;
-				tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+				tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 				p.vector = tgt;
 			}
 
 			p.endTime = now + MinLifeTime;
 			if (MaxLifeTime != MinLifeTime)
-				p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+				p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 			if (MinStartColor==MaxStartColor)
 				p.color=MinStartColor;
 			else
-				p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+				p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 			p.startColor = p.color;
 			p.startVector = p.vector;
@@ -98,7 +98,7 @@ s32 CParticleCylinderEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*&
 			if (MinStartSize==MaxStartSize)
 				p.startSize = MinStartSize;
 			else
-				p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+				p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 			p.size = p.startSize;
 
 			Particles.push_back(p);
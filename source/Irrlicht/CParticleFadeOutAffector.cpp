@@ -14,7 +14,7 @@ namespace scene
 //! constructor
 CParticleFadeOutAffector::CParticleFadeOutAffector(
 	const video::SColor& targetColor, u32 fadeOutTime)
-	: IParticleFadeOutAffector(), TargetColor(targetColor)
+	: IParticleFadeOutAffector(), TargetColor(targetColor), Now(0)
 {
 
 	#ifdef _DEBUG
@@ -44,6 +44,67 @@ void CParticleFadeOutAffector::affect(u32 now, SParticle* particlearray, u32 cou
 }
 
 
+//! Prepare affecting all particles at time now
+bool CParticleFadeOutAffector::beginAffect(u32 now)
+{
+	Now = now;
+	return Enabled;
+}
+
+
+//! Affect the particles in [begin,end)
+void CParticleFadeOutAffector::affectStore(CParticleStore& particles, u32 begin, u32 end) const
+{
+	const u32* endTime = particles.getInts(EPI_END_TIME);
+	const u32* startColor = particles.getInts(EPI_START_COLOR);
+	u32* color = particles.getInts(EPI_COLOR);
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i now = _mm_set1_epi32(Now);
+	const __m128 fadeOutTime = _mm_set1_ps(FadeOutTime);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i channelMask = _mm_set1_epi32(0xff);
+	__m128 target[4];
+	for (u32 c=0; c<4; ++c)
+		target[c] = _mm_set1_ps((f32)((TargetColor.color >> (c*8)) & 0xff));
+
+	for (u32 i=begin; i<end; i+=4)
+	{
+		const __m128 timeLeft = convertParticleTimes(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(endTime + i)), now));
+		const __m128 fading = _mm_cmplt_ps(timeLeft, fadeOutTime);
+		if (!_mm_movemask_ps(fading))
+			continue;
+
+		const __m128 d = _mm_min_ps(_mm_max_ps(_mm_div_ps(timeLeft, fadeOutTime), zero), one);
+		const __m128 inv = _mm_sub_ps(one, d);
+		const __m128i start = _mm_loadu_si128((const __m128i*)(startColor + i));
+		__m128i result = _mm_setzero_si128();
+		for (u32 c=0; c<4; ++c)
+		{
+			const __m128i shift = _mm_cvtsi32_si128(c*8);
+			const __m128 channel = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(start, shift), channelMask));
+			// values are never negative, so truncation rounds like round32
+			const __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(target[c], inv), _mm_mul_ps(channel, d)), half);
+			result = _mm_or_si128(result, _mm_sll_epi32(_mm_cvttps_epi32(value), shift));
+		}
+
+		const __m128i mask = _mm_castps_si128(fading);
+		const __m128i old = _mm_loadu_si128((const __m128i*)(color + i));
+		_mm_storeu_si128((__m128i*)(color + i), _mm_or_si128(_mm_and_si128(mask, result), _mm_andnot_si128(mask, old)));
+	}
+#else
+	for (u32 i=begin; i<end; ++i)
+	{
+		const f32 timeLeft = (f32)(endTime[i] - Now);
+		if (timeLeft < FadeOutTime)
+			color[i] = video::SColor(startColor[i]).getInterpolated(TargetColor, timeLeft / FadeOutTime).color;
+	}
+#endif
+}
+
+
 //! Writes attributes of the object.
 //! Implement this to expose the attributes of your scene node animator for
 //! scripting languages, editors, debuggers or xml serialization purposes.
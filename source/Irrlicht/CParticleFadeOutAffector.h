@@ -6,6 +6,7 @@
 #define __C_PARTICLE_FADE_OUT_AFFECTOR_H_INCLUDED__
 
 #include "IParticleFadeOutAffector.h"
+#include "CParticleStore.h"
 #include "SColor.h"
 
 namespace irr
@@ -14,7 +15,7 @@ namespace scene
 {
 
 //! Particle Affector for fading out a color
-class CParticleFadeOutAffector : public IParticleFadeOutAffector
+class CParticleFadeOutAffector : public IParticleFadeOutAffector, public IParticleStoreAffector
 {
 public:
 
@@ -23,6 +24,15 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Prepare affecting all particles at time now
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affect the particles in [begin,end)
+	virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const _IRR_OVERRIDE_;
+
+	//! Get the interface which affects the particle arrays directly
+	virtual IParticleStoreAffector* getStoreAffector() _IRR_OVERRIDE_ { return this; }
+
 	//! Sets the targetColor, i.e. the color the particles will interpolate
 	//! to over time.
 	virtual void setTargetColor( const video::SColor& targetColor ) _IRR_OVERRIDE_ { TargetColor = targetColor; }
@@ -53,6 +63,7 @@ private:
 
 	video::SColor TargetColor;
 	f32 FadeOutTime;
+	u32 Now;
 };
 
 } // end namespace scene
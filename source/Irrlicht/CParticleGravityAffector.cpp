@@ -14,7 +14,7 @@ namespace scene
 //! constructor
 CParticleGravityAffector::CParticleGravityAffector(
 	const core::vector3df& gravity, u32 timeForceLost)
-	: IParticleGravityAffector(), TimeForceLost(static_cast<f32>(timeForceLost)), Gravity(gravity)
+	: IParticleGravityAffector(), TimeForceLost(static_cast<f32>(timeForceLost)), Gravity(gravity), Now(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleGravityAffector");
@@ -42,6 +42,56 @@ void CParticleGravityAffector::affect(u32 now, SParticle* particlearray, u32 cou
 	}
 }
 
+
+//! Prepare affecting all particles at time now
+bool CParticleGravityAffector::beginAffect(u32 now)
+{
+	Now = now;
+	return Enabled;
+}
+
+
+//! Affect the particles in [begin,end)
+void CParticleGravityAffector::affectStore(CParticleStore& particles, u32 begin, u32 end) const
+{
+	const u32* startTime = particles.getInts(EPI_START_TIME);
+	const f32* startX = particles.getFloats(EPF_START_VECTOR_X);
+	const f32* startY = particles.getFloats(EPF_START_VECTOR_Y);
+	const f32* startZ = particles.getFloats(EPF_START_VECTOR_Z);
+	f32* vectorX = particles.getFloats(EPF_VECTOR_X);
+	f32* vectorY = particles.getFloats(EPF_VECTOR_Y);
+	f32* vectorZ = particles.getFloats(EPF_VECTOR_Z);
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128i now = _mm_set1_epi32(Now);
+	const __m128 timeForceLost = _mm_set1_ps(TimeForceLost);
+	const __m128 gravityX = _mm_set1_ps(Gravity.X);
+	const __m128 gravityY = _mm_set1_ps(Gravity.Y);
+	const __m128 gravityZ = _mm_set1_ps(Gravity.Z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	for (u32 i=begin; i<end; i+=4)
+	{
+		const __m128i age = _mm_sub_epi32(now, _mm_loadu_si128((const __m128i*)(startTime + i)));
+		// weight of gravity, the start vector gets the rest
+		const __m128 d = _mm_min_ps(_mm_max_ps(_mm_div_ps(convertParticleTimes(age), timeForceLost), zero), one);
+		const __m128 inv = _mm_sub_ps(one, d);
+		_mm_storeu_ps(vectorX + i, _mm_add_ps(_mm_mul_ps(gravityX, d), _mm_mul_ps(_mm_loadu_ps(startX + i), inv)));
+		_mm_storeu_ps(vectorY + i, _mm_add_ps(_mm_mul_ps(gravityY, d), _mm_mul_ps(_mm_loadu_ps(startY + i), inv)));
+		_mm_storeu_ps(vectorZ + i, _mm_add_ps(_mm_mul_ps(gravityZ, d), _mm_mul_ps(_mm_loadu_ps(startZ + i), inv)));
+	}
+#else
+	for (u32 i=begin; i<end; ++i)
+	{
+		const f32 d = core::clamp((Now - startTime[i]) / TimeForceLost, 0.f, 1.f);
+		const f32 inv = 1.f - d;
+		vectorX[i] = Gravity.X * d + startX[i] * inv;
+		vectorY[i] = Gravity.Y * d + startY[i] * inv;
+		vectorZ[i] = Gravity.Z * d + startZ[i] * inv;
+	}
+#endif
+}
+
 //! Writes attributes of the object.
 void CParticleGravityAffector::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
 {
@@ -6,6 +6,7 @@
 #define __C_PARTICLE_GRAVITY_AFFECTOR_H_INCLUDED__
 
 #include "IParticleGravityAffector.h"
+#include "CParticleStore.h"
 #include "SColor.h"
 
 namespace irr
@@ -14,7 +15,7 @@ namespace scene
 {
 
 //! Particle Affector for affecting direction of particle
-class CParticleGravityAffector : public IParticleGravityAffector
+class CParticleGravityAffector : public IParticleGravityAffector, public IParticleStoreAffector
 {
 public:
 
@@ -25,6 +26,15 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Prepare affecting all particles at time now
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affect the particles in [begin,end)
+	virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const _IRR_OVERRIDE_;
+
+	//! Get the interface which affects the particle arrays directly
+	virtual IParticleStoreAffector* getStoreAffector() _IRR_OVERRIDE_ { return this; }
+
 	//! Set the time in milliseconds when the gravity force is totally
 	//! lost and the particle does not move any more.
 	virtual void setTimeForceLost( f32 timeForceLost ) _IRR_OVERRIDE_ { TimeForceLost = timeForceLost; }
@@ -54,6 +64,7 @@ public:
 private:
 	f32 TimeForceLost;
 	core::vector3df Gravity;
+	u32 Now;
 };
 
 } // end namespace scene
@@ -4,7 +4,7 @@
 
 #include "IrrCompileConfig.h"
 #include "CParticleMeshEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 
 namespace irr
 {
@@ -44,7 +44,7 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if(Time > everyWhatMillisecond)
@@ -77,20 +77,20 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 						if( MaxAngleDegrees )
 						{
 							core::vector3df tgt = p.vector;
-							tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-							tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-							tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+							tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+							tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+							tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 							p.vector = tgt;
 						}
 
 						p.endTime = now + MinLifeTime;
 						if (MaxLifeTime != MinLifeTime)
-							p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+							p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 						if (MinStartColor==MaxStartColor)
 							p.color=MinStartColor;
 						else
-							p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+							p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 						p.startColor = p.color;
 						p.startVector = p.vector;
@@ -98,7 +98,7 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 						if (MinStartSize==MaxStartSize)
 							p.startSize = MinStartSize;
 						else
-							p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+							p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 						p.size = p.startSize;
 
 						Particles.push_back(p);
@@ -107,12 +107,12 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 			}
 			else
 			{
-				const s32 randomMB = (MBNumber < 0) ? (os::Randomizer::rand() % MBCount) : MBNumber;
+				const s32 randomMB = (MBNumber < 0) ? (CParticleRandomizer::currentRand() % MBCount) : MBNumber;
 
 				u32 vertexNumber = Mesh->getMeshBuffer(randomMB)->getVertexCount();
 				if (!vertexNumber)
 					continue;
-				vertexNumber = os::Randomizer::rand() % vertexNumber;
+				vertexNumber = CParticleRandomizer::currentRand() % vertexNumber;
 
 				p.pos = Mesh->getMeshBuffer(randomMB)->getPosition(vertexNumber);
 				if( UseNormalDirection )
@@ -126,20 +126,20 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 				if( MaxAngleDegrees )
 				{
 					core::vector3df tgt = Direction;
-					tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-					tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-					tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+					tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+					tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+					tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 					p.vector = tgt;
 				}
 
 				p.endTime = now + MinLifeTime;
 				if (MaxLifeTime != MinLifeTime)
-					p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+					p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 				if (MinStartColor==MaxStartColor)
 					p.color=MinStartColor;
 				else
-					p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+					p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 				p.startColor = p.color;
 				p.startVector = p.vector;
@@ -147,7 +147,7 @@ s32 CParticleMeshEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 				if (MinStartSize==MaxStartSize)
 					p.startSize = MinStartSize;
 				else
-					p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+					p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 				p.size = p.startSize;
 
 				Particles.push_back(p);
@@ -3,7 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CParticlePointEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -40,7 +40,7 @@ s32 CParticlePointEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& out
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if (Time > everyWhatMillisecond)
@@ -52,20 +52,20 @@ s32 CParticlePointEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& out
 		if (MaxAngleDegrees)
 		{
 			core::vector3df tgt = Direction;
-			tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-			tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-			tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+			tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+			tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+			tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 			Particle.vector = tgt;
 		}
 
 		Particle.endTime = now + MinLifeTime;
 		if (MaxLifeTime != MinLifeTime)
-			Particle.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+			Particle.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 		if (MinStartColor==MaxStartColor)
 			Particle.color=MinStartColor;
 		else
-			Particle.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+			Particle.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 		Particle.startColor = Particle.color;
 		Particle.startVector = Particle.vector;
@@ -73,7 +73,7 @@ s32 CParticlePointEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& out
 		if (MinStartSize==MaxStartSize)
 			Particle.startSize = MinStartSize;
 		else
-			Particle.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+			Particle.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 		Particle.size = Particle.startSize;
 
 		outArray = &Particle;
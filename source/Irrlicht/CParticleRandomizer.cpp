@@ -0,0 +1,86 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CParticleRandomizer.h"
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	const s32 m = 2147483647;	// a Mersenne prime (2^31-1)
+	const s32 a = 16807;
+	const s32 q = m/a;
+	const s32 r = m%a;
+	const s32 rMax = m-2;
+
+#if defined(_IRR_COMPILE_WITH_WORKER_THREADS_) && defined(_MSC_VER)
+	__declspec(thread) CParticleRandomizer* Current = 0;
+#elif defined(_IRR_COMPILE_WITH_WORKER_THREADS_)
+	__thread CParticleRandomizer* Current = 0;
+#else
+	CParticleRandomizer* Current = 0;
+#endif
+}
+
+
+//! resets the randomizer
+void CParticleRandomizer::reset(s32 seed)
+{
+	if (seed<0)
+		Seed = seed+m;
+	else if ( seed == 0 || seed == m)
+		Seed = 1;
+	else
+		Seed = seed;
+}
+
+
+//! generates a pseudo random number in the range 0..randMax()
+s32 CParticleRandomizer::rand()
+{
+	// (a*seed)%m with Schrage's method
+	Seed = a * (Seed%q) - r* (Seed/q);
+	if (Seed<1)
+		Seed += m;
+
+	return Seed-1;
+}
+
+
+//! generates a pseudo random number in the range 0..1
+f32 CParticleRandomizer::frand()
+{
+	return rand()*(1.f/rMax);
+}
+
+
+//! Make a randomizer the one of the calling thread
+CParticleRandomizer* CParticleRandomizer::setCurrent(CParticleRandomizer* randomizer)
+{
+	CParticleRandomizer* previous = Current;
+	Current = randomizer;
+	return previous;
+}
+
+
+//! Random number from the randomizer of the calling thread
+s32 CParticleRandomizer::currentRand()
+{
+	return Current ? Current->rand() : os::Randomizer::rand();
+}
+
+
+//! Random number in the range 0..1 from the randomizer of the calling thread
+f32 CParticleRandomizer::currentFrand()
+{
+	return Current ? Current->frand() : os::Randomizer::frand();
+}
+
+} // end namespace scene
+} // end namespace irr
+
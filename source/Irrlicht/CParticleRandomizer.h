@@ -0,0 +1,60 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_PARTICLE_RANDOMIZER_H_INCLUDED__
+#define __C_PARTICLE_RANDOMIZER_H_INCLUDED__
+
+#include "irrTypes.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Random numbers of one particle system.
+	/** Particle systems can be simulated on worker threads, so the built in
+	emitters must not use os::Randomizer. Each system has its own randomizer
+	instead, which makes the particles independent of the order in which the
+	systems are simulated. Same algorithm as os::Randomizer. */
+	class CParticleRandomizer
+	{
+	public:
+
+		//! constructor
+		CParticleRandomizer(s32 seed=0x0f0f0f0f)
+		{
+			reset(seed);
+		}
+
+		//! resets the randomizer
+		void reset(s32 seed=0x0f0f0f0f);
+
+		//! generates a pseudo random number in the range 0..randMax()
+		s32 rand();
+
+		//! generates a pseudo random number in the range 0..1
+		f32 frand();
+
+		//! Make a randomizer the one of the calling thread
+		/** \return The previous randomizer of the thread, 0 if none */
+		static CParticleRandomizer* setCurrent(CParticleRandomizer* randomizer);
+
+		//! Random number from the randomizer of the calling thread
+		/** Falls back to os::Randomizer when no particle system is simulated on
+		this thread, for example when an emitter is called directly. */
+		static s32 currentRand();
+
+		//! Random number in the range 0..1 from the randomizer of the calling thread
+		static f32 currentFrand();
+
+	private:
+
+		s32 Seed;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -3,7 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CParticleRingEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -42,7 +42,7 @@ s32 CParticleRingEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 	Time += timeSinceLastCall;
 
 	u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if(Time > everyWhatMillisecond)
@@ -57,14 +57,14 @@ s32 CParticleRingEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 
 		for(u32 i=0; i<amount; ++i)
 		{
-			f32 distance = os::Randomizer::frand() * RingThickness * 0.5f;
-			if (os::Randomizer::rand() % 2)
+			f32 distance = CParticleRandomizer::currentFrand() * RingThickness * 0.5f;
+			if (CParticleRandomizer::currentRand() % 2)
 				distance -= Radius;
 			else
 				distance += Radius;
 
 			p.pos.set(Center.X + distance, Center.Y, Center.Z + distance);
-			p.pos.rotateXZBy(os::Randomizer::frand() * 360, Center );
+			p.pos.rotateXZBy(CParticleRandomizer::currentFrand() * 360, Center );
 
 			p.startTime = now;
 			p.vector = Direction;
@@ -72,20 +72,20 @@ s32 CParticleRingEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 			if(MaxAngleDegrees)
 			{
 				core::vector3df tgt = Direction;
-				tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees, Center );
-				tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees, Center );
-				tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees, Center );
+				tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees, Center );
+				tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees, Center );
+				tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees, Center );
 				p.vector = tgt;
 			}
 
 			p.endTime = now + MinLifeTime;
 			if (MaxLifeTime != MinLifeTime)
-				p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+				p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 			if (MinStartColor==MaxStartColor)
 				p.color=MinStartColor;
 			else
-				p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+				p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 			p.startColor = p.color;
 			p.startVector = p.vector;
@@ -93,7 +93,7 @@ s32 CParticleRingEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& outA
 			if (MinStartSize==MaxStartSize)
 				p.startSize = MinStartSize;
 			else
-				p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+				p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 			p.size = p.startSize;
 
 			Particles.push_back(p);
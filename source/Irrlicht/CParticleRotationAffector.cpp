@@ -48,6 +48,77 @@ void CParticleRotationAffector::affect(u32 now, SParticle* particlearray, u32 co
 	}
 }
 
+
+//! Prepare affecting all particles at time now
+bool CParticleRotationAffector::beginAffect(u32 now)
+{
+	if( LastTime == 0 )
+	{
+		LastTime = now;
+		return false;
+	}
+
+	const f32 timeDelta = ( now - LastTime ) / 1000.0f;
+	LastTime = now;
+
+	for (u32 a=0; a<3; ++a)
+	{
+		const f64 degrees = (f64)(timeDelta * (a == 0 ? Speed.X : a == 1 ? Speed.Y : Speed.Z)) * core::DEGTORAD64;
+		Cos[a] = (f32)cos(degrees);
+		Sin[a] = (f32)sin(degrees);
+	}
+
+	return Enabled && (Speed.X != 0.0f || Speed.Y != 0.0f || Speed.Z != 0.0f);
+}
+
+
+namespace
+{
+	//! Rotate the points (a,b) around (centerA,centerB)
+	inline void rotatePoints(f32* a, f32* b, u32 begin, u32 end, f32 centerA, f32 centerB, f32 cs, f32 sn)
+	{
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		const __m128 ca = _mm_set1_ps(centerA);
+		const __m128 cb = _mm_set1_ps(centerB);
+		const __m128 c = _mm_set1_ps(cs);
+		const __m128 s = _mm_set1_ps(sn);
+		for (u32 i=begin; i<end; i+=4)
+		{
+			const __m128 x = _mm_sub_ps(_mm_loadu_ps(a + i), ca);
+			const __m128 y = _mm_sub_ps(_mm_loadu_ps(b + i), cb);
+			_mm_storeu_ps(a + i, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(x, c), _mm_mul_ps(y, s)), ca));
+			_mm_storeu_ps(b + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, s), _mm_mul_ps(y, c)), cb));
+		}
+#else
+		for (u32 i=begin; i<end; ++i)
+		{
+			const f32 x = a[i] - centerA;
+			const f32 y = b[i] - centerB;
+			a[i] = x*cs - y*sn + centerA;
+			b[i] = x*sn + y*cs + centerB;
+		}
+#endif
+	}
+}
+
+
+//! Affect the particles in [begin,end)
+void CParticleRotationAffector::affectStore(CParticleStore& particles, u32 begin, u32 end) const
+{
+	f32* posX = particles.getFloats(EPF_POS_X);
+	f32* posY = particles.getFloats(EPF_POS_Y);
+	f32* posZ = particles.getFloats(EPF_POS_Z);
+
+	if( Speed.X != 0.0f )
+		rotatePoints(posY, posZ, begin, end, PivotPoint.Y, PivotPoint.Z, Cos[0], Sin[0]);
+
+	if( Speed.Y != 0.0f )
+		rotatePoints(posX, posZ, begin, end, PivotPoint.X, PivotPoint.Z, Cos[1], Sin[1]);
+
+	if( Speed.Z != 0.0f )
+		rotatePoints(posX, posY, begin, end, PivotPoint.X, PivotPoint.Y, Cos[2], Sin[2]);
+}
+
 //! Writes attributes of the object.
 void CParticleRotationAffector::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
 {
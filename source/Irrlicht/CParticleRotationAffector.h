@@ -6,6 +6,7 @@
 #define __C_PARTICLE_ROTATION_AFFECTOR_H_INCLUDED__
 
 #include "IParticleRotationAffector.h"
+#include "CParticleStore.h"
 
 namespace irr
 {
@@ -13,7 +14,7 @@ namespace scene
 {
 
 //! Particle Affector for rotating particles about a point
-class CParticleRotationAffector : public IParticleRotationAffector
+class CParticleRotationAffector : public IParticleRotationAffector, public IParticleStoreAffector
 {
 public:
 
@@ -23,6 +24,15 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Prepare affecting all particles at time now
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affect the particles in [begin,end)
+	virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const _IRR_OVERRIDE_;
+
+	//! Get the interface which affects the particle arrays directly
+	virtual IParticleStoreAffector* getStoreAffector() _IRR_OVERRIDE_ { return this; }
+
 	//! Set the point that particles will attract to
 	virtual void setPivotPoint( const core::vector3df& point ) _IRR_OVERRIDE_ { PivotPoint = point; }
 
@@ -46,6 +56,9 @@ private:
 	core::vector3df PivotPoint;
 	core::vector3df Speed;
 	u32 LastTime;
+	//! cosine and sine of the rotation around each axis in this update
+	f32 Cos[3];
+	f32 Sin[3];
 };
 
 } // end namespace scene
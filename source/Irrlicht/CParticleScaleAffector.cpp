@@ -10,7 +10,7 @@ namespace irr
 	namespace scene
 	{
 		CParticleScaleAffector::CParticleScaleAffector(const core::dimension2df& scaleTo)
-			: ScaleTo(scaleTo)
+			: ScaleTo(scaleTo), Now(0)
 		{
 			#ifdef _DEBUG
 			setDebugName("CParticleScaleAffector");
@@ -30,6 +30,46 @@ namespace irr
 		}
 
 
+		bool CParticleScaleAffector::beginAffect(u32 now)
+		{
+			// like affect, this ignores Enabled
+			Now = now;
+			return true;
+		}
+
+
+		void CParticleScaleAffector::affectStore(CParticleStore& particles, u32 begin, u32 end) const
+		{
+			const u32* startTime = particles.getInts(EPI_START_TIME);
+			const u32* endTime = particles.getInts(EPI_END_TIME);
+			const f32* startWidth = particles.getFloats(EPF_START_WIDTH);
+			const f32* startHeight = particles.getFloats(EPF_START_HEIGHT);
+			f32* width = particles.getFloats(EPF_WIDTH);
+			f32* height = particles.getFloats(EPF_HEIGHT);
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+			const __m128i now = _mm_set1_epi32(Now);
+			const __m128 scaleWidth = _mm_set1_ps(ScaleTo.Width);
+			const __m128 scaleHeight = _mm_set1_ps(ScaleTo.Height);
+			for (u32 i=begin; i<end; i+=4)
+			{
+				const __m128i start = _mm_loadu_si128((const __m128i*)(startTime + i));
+				const __m128i maxdiff = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(endTime + i)), start);
+				const __m128 newscale = _mm_div_ps(convertParticleTimes(_mm_sub_epi32(now, start)), convertParticleTimes(maxdiff));
+				_mm_storeu_ps(width + i, _mm_add_ps(_mm_loadu_ps(startWidth + i), _mm_mul_ps(scaleWidth, newscale)));
+				_mm_storeu_ps(height + i, _mm_add_ps(_mm_loadu_ps(startHeight + i), _mm_mul_ps(scaleHeight, newscale)));
+			}
+#else
+			for (u32 i=begin; i<end; ++i)
+			{
+				const f32 newscale = (f32)(Now - startTime[i]) / (endTime[i] - startTime[i]);
+				width[i] = startWidth[i] + ScaleTo.Width*newscale;
+				height[i] = startHeight[i] + ScaleTo.Height*newscale;
+			}
+#endif
+		}
+
+
 		void CParticleScaleAffector::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
 		{
 			out->addFloat("ScaleToWidth", ScaleTo.Width);
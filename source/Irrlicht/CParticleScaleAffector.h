@@ -6,18 +6,28 @@
 #define C_PARTICLE_SCALE_AFFECTOR_H
 
 #include "IParticleAffector.h"
+#include "CParticleStore.h"
 
 namespace irr
 {
 	namespace scene
 	{
-		class CParticleScaleAffector : public IParticleAffector
+		class CParticleScaleAffector : public IParticleAffector, public IParticleStoreAffector
 		{
 		public:
 			CParticleScaleAffector(const core::dimension2df& scaleTo = core::dimension2df(1.0f, 1.0f));
 
 			virtual void affect(u32 now, SParticle *particlearray, u32 count) _IRR_OVERRIDE_;
 
+			//! Prepare affecting all particles at time now
+			virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+			//! Affect the particles in [begin,end)
+			virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const _IRR_OVERRIDE_;
+
+			//! Get the interface which affects the particle arrays directly
+			virtual IParticleStoreAffector* getStoreAffector() _IRR_OVERRIDE_ { return this; }
+
 			//! Writes attributes of the object.
 			//! Implement this to expose the attributes of your scene node animator for
 			//! scripting languages, editors, debuggers or xml serialization purposes.
@@ -35,6 +45,7 @@ namespace irr
 
 		protected:
 			core::dimension2df ScaleTo;
+			u32 Now;
 		};
 	}
 }
@@ -4,7 +4,7 @@
 
 #include "IrrCompileConfig.h"
 #include "CParticleSphereEmitter.h"
-#include "os.h"
+#include "CParticleRandomizer.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -43,7 +43,7 @@ s32 CParticleSphereEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& ou
 	Time += timeSinceLastCall;
 
 	const u32 pps = (MaxParticlesPerSecond - MinParticlesPerSecond);
-	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + os::Randomizer::frand() * pps) : MinParticlesPerSecond;
+	const f32 perSecond = pps ? ((f32)MinParticlesPerSecond + CParticleRandomizer::currentFrand() * pps) : MinParticlesPerSecond;
 	const f32 everyWhatMillisecond = 1000.0f / perSecond;
 
 	if(Time > everyWhatMillisecond)
@@ -59,13 +59,13 @@ s32 CParticleSphereEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& ou
 		for(u32 i=0; i<amount; ++i)
 		{
 			// Random distance from center
-			const f32 distance = os::Randomizer::frand() * Radius;
+			const f32 distance = CParticleRandomizer::currentFrand() * Radius;
 
 			// Random direction from center
 			p.pos.set(Center + distance);
-			p.pos.rotateXYBy(os::Randomizer::frand() * 360.f, Center );
-			p.pos.rotateYZBy(os::Randomizer::frand() * 360.f, Center );
-			p.pos.rotateXZBy(os::Randomizer::frand() * 360.f, Center );
+			p.pos.rotateXYBy(CParticleRandomizer::currentFrand() * 360.f, Center );
+			p.pos.rotateYZBy(CParticleRandomizer::currentFrand() * 360.f, Center );
+			p.pos.rotateXZBy(CParticleRandomizer::currentFrand() * 360.f, Center );
 
 			p.startTime = now;
 			p.vector = Direction;
@@ -73,20 +73,20 @@ s32 CParticleSphereEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& ou
 			if(MaxAngleDegrees)
 			{
 				core::vector3df tgt = Direction;
-				tgt.rotateXYBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateYZBy(os::Randomizer::frand() * MaxAngleDegrees);
-				tgt.rotateXZBy(os::Randomizer::frand() * MaxAngleDegrees);
+				tgt.rotateXYBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateYZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
+				tgt.rotateXZBy(CParticleRandomizer::currentFrand() * MaxAngleDegrees);
 				p.vector = tgt;
 			}
 
 			p.endTime = now + MinLifeTime;
 			if (MaxLifeTime != MinLifeTime)
-				p.endTime += os::Randomizer::rand() % (MaxLifeTime - MinLifeTime);
+				p.endTime += CParticleRandomizer::currentRand() % (MaxLifeTime - MinLifeTime);
 
 			if (MinStartColor==MaxStartColor)
 				p.color=MinStartColor;
 			else
-				p.color = MinStartColor.getInterpolated(MaxStartColor, os::Randomizer::frand());
+				p.color = MinStartColor.getInterpolated(MaxStartColor, CParticleRandomizer::currentFrand());
 
 			p.startColor = p.color;
 			p.startVector = p.vector;
@@ -94,7 +94,7 @@ s32 CParticleSphereEmitter::emitt(u32 now, u32 timeSinceLastCall, SParticle*& ou
 			if (MinStartSize==MaxStartSize)
 				p.startSize = MinStartSize;
 			else
-				p.startSize = MinStartSize.getInterpolated(MaxStartSize, os::Randomizer::frand());
+				p.startSize = MinStartSize.getInterpolated(MaxStartSize, CParticleRandomizer::currentFrand());
 			p.size = p.startSize;
 
 			Particles.push_back(p);
@@ -0,0 +1,200 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CParticleStore.h"
+#include <string.h>
+
+namespace irr
+{
+namespace scene
+{
+
+//! Make room for at least count particles, keeps the particles
+void CParticleStore::reallocate(u32 count)
+{
+	u32 capacity = core::max_(Capacity, 16u);
+	while (capacity < count)
+		capacity *= 2;
+	if (capacity == Capacity)
+		return;
+
+	core::array<f32> floats(capacity * EPF_COUNT);
+	floats.set_used(capacity * EPF_COUNT);
+	memset(floats.pointer(), 0, capacity * EPF_COUNT * sizeof(f32));
+	for (u32 m=0; m<EPF_COUNT; ++m)
+		memcpy(floats.pointer() + m*capacity, Floats.const_pointer() + m*Capacity, Count*sizeof(f32));
+
+	core::array<u32> ints(capacity * EPI_COUNT);
+	ints.set_used(capacity * EPI_COUNT);
+	memset(ints.pointer(), 0, capacity * EPI_COUNT * sizeof(u32));
+	for (u32 m=0; m<EPI_COUNT; ++m)
+		memcpy(ints.pointer() + m*capacity, Ints.const_pointer() + m*Capacity, Count*sizeof(u32));
+
+	Floats.swap(floats);
+	Ints.swap(ints);
+	Capacity = capacity;
+}
+
+
+//! Remove a particle, the last particle moves into its place
+void CParticleStore::swapRemove(u32 index)
+{
+	--Count;
+	if (index == Count)
+		return;
+
+	for (u32 m=0; m<EPF_COUNT; ++m)
+		Floats[m*Capacity + index] = Floats[m*Capacity + Count];
+	for (u32 m=0; m<EPI_COUNT; ++m)
+		Ints[m*Capacity + index] = Ints[m*Capacity + Count];
+}
+
+
+//! Get a particle
+void CParticleStore::getParticle(u32 index, SParticle& particle) const
+{
+	const f32* f = Floats.const_pointer() + index;
+	particle.pos.set(f[EPF_POS_X*Capacity], f[EPF_POS_Y*Capacity], f[EPF_POS_Z*Capacity]);
+	particle.vector.set(f[EPF_VECTOR_X*Capacity], f[EPF_VECTOR_Y*Capacity], f[EPF_VECTOR_Z*Capacity]);
+	particle.startVector.set(f[EPF_START_VECTOR_X*Capacity], f[EPF_START_VECTOR_Y*Capacity], f[EPF_START_VECTOR_Z*Capacity]);
+	particle.size.set(f[EPF_WIDTH*Capacity], f[EPF_HEIGHT*Capacity]);
+	particle.startSize.set(f[EPF_START_WIDTH*Capacity], f[EPF_START_HEIGHT*Capacity]);
+
+	const u32* i = Ints.const_pointer() + index;
+	particle.startTime = i[EPI_START_TIME*Capacity];
+	particle.endTime = i[EPI_END_TIME*Capacity];
+	particle.color.color = i[EPI_COLOR*Capacity];
+	particle.startColor.color = i[EPI_START_COLOR*Capacity];
+}
+
+
+//! Overwrite a particle
+void CParticleStore::setParticle(u32 index, const SParticle& particle)
+{
+	f32* f = Floats.pointer() + index;
+	f[EPF_POS_X*Capacity] = particle.pos.X;
+	f[EPF_POS_Y*Capacity] = particle.pos.Y;
+	f[EPF_POS_Z*Capacity] = particle.pos.Z;
+	f[EPF_VECTOR_X*Capacity] = particle.vector.X;
+	f[EPF_VECTOR_Y*Capacity] = particle.vector.Y;
+	f[EPF_VECTOR_Z*Capacity] = particle.vector.Z;
+	f[EPF_START_VECTOR_X*Capacity] = particle.startVector.X;
+	f[EPF_START_VECTOR_Y*Capacity] = particle.startVector.Y;
+	f[EPF_START_VECTOR_Z*Capacity] = particle.startVector.Z;
+	f[EPF_WIDTH*Capacity] = particle.size.Width;
+	f[EPF_HEIGHT*Capacity] = particle.size.Height;
+	f[EPF_START_WIDTH*Capacity] = particle.startSize.Width;
+	f[EPF_START_HEIGHT*Capacity] = particle.startSize.Height;
+
+	u32* i = Ints.pointer() + index;
+	i[EPI_START_TIME*Capacity] = particle.startTime;
+	i[EPI_END_TIME*Capacity] = particle.endTime;
+	i[EPI_COLOR*Capacity] = particle.color.color;
+	i[EPI_START_COLOR*Capacity] = particle.startColor.color;
+}
+
+
+//! Copy all particles into an array of structures
+void CParticleStore::copyTo(core::array<SParticle>& particles) const
+{
+	particles.set_used(Count);
+	for (u32 i=0; i<Count; ++i)
+		getParticle(i, particles[i]);
+}
+
+
+//! Replace all particles with those of an array of structures
+void CParticleStore::copyFrom(const core::array<SParticle>& particles)
+{
+	if (particles.size() > Capacity)
+		reallocate(particles.size());
+	Count = particles.size();
+	for (u32 i=0; i<Count; ++i)
+		setParticle(i, particles[i]);
+}
+
+
+//! Move the particles in [begin,end) by their vector times timeScale
+void CParticleStore::move(u32 begin, u32 end, f32 timeScale)
+{
+	for (u32 c=0; c<3; ++c)
+	{
+		f32* pos = getFloats((E_PARTICLE_FLOAT)(EPF_POS_X + c));
+		const f32* vector = getFloats((E_PARTICLE_FLOAT)(EPF_VECTOR_X + c));
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		const __m128 scale = _mm_set1_ps(timeScale);
+		for (u32 i=begin; i<end; i+=4)
+			_mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(_mm_loadu_ps(vector + i), scale)));
+#else
+		for (u32 i=begin; i<end; ++i)
+			pos[i] += vector[i] * timeScale;
+#endif
+	}
+}
+
+
+//! Remove all particles with an end time before now
+void CParticleStore::removeExpired(u32 now)
+{
+	const u32* endTime = getInts(EPI_END_TIME);
+	for (u32 i=0; i<Count;)
+	{
+		if (now > endTime[i])
+			swapRemove(i);
+		else
+			++i;
+	}
+}
+
+
+//! Extend a box so it contains the positions of all particles
+void CParticleStore::addToBoundingBox(core::aabbox3df& box) const
+{
+	const f32* x = getFloats(EPF_POS_X);
+	const f32* y = getFloats(EPF_POS_Y);
+	const f32* z = getFloats(EPF_POS_Z);
+	u32 i=0;
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	if (Count >= 4)
+	{
+		__m128 minX = _mm_loadu_ps(x), maxX = minX;
+		__m128 minY = _mm_loadu_ps(y), maxY = minY;
+		__m128 minZ = _mm_loadu_ps(z), maxZ = minZ;
+		for (i=4; i+4<=Count; i+=4)
+		{
+			const __m128 px = _mm_loadu_ps(x + i);
+			const __m128 py = _mm_loadu_ps(y + i);
+			const __m128 pz = _mm_loadu_ps(z + i);
+			minX = _mm_min_ps(minX, px);
+			maxX = _mm_max_ps(maxX, px);
+			minY = _mm_min_ps(minY, py);
+			maxY = _mm_max_ps(maxY, py);
+			minZ = _mm_min_ps(minZ, pz);
+			maxZ = _mm_max_ps(maxZ, pz);
+		}
+
+		f32 mins[3][4];
+		f32 maxs[3][4];
+		_mm_storeu_ps(mins[0], minX);
+		_mm_storeu_ps(mins[1], minY);
+		_mm_storeu_ps(mins[2], minZ);
+		_mm_storeu_ps(maxs[0], maxX);
+		_mm_storeu_ps(maxs[1], maxY);
+		_mm_storeu_ps(maxs[2], maxZ);
+		for (u32 k=0; k<4; ++k)
+		{
+			box.addInternalPoint(mins[0][k], mins[1][k], mins[2][k]);
+			box.addInternalPoint(maxs[0][k], maxs[1][k], maxs[2][k]);
+		}
+	}
+#endif
+
+	for (; i<Count; ++i)
+		box.addInternalPoint(x[i], y[i], z[i]);
+}
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,179 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_PARTICLE_STORE_H_INCLUDED__
+#define __C_PARTICLE_STORE_H_INCLUDED__
+
+#include "IParticleAffector.h"
+#include "irrArray.h"
+#include "aabbox3d.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Float members of the particles in a CParticleStore
+	enum E_PARTICLE_FLOAT
+	{
+		EPF_POS_X = 0,
+		EPF_POS_Y,
+		EPF_POS_Z,
+		EPF_VECTOR_X,
+		EPF_VECTOR_Y,
+		EPF_VECTOR_Z,
+		EPF_START_VECTOR_X,
+		EPF_START_VECTOR_Y,
+		EPF_START_VECTOR_Z,
+		EPF_WIDTH,
+		EPF_HEIGHT,
+		EPF_START_WIDTH,
+		EPF_START_HEIGHT,
+		EPF_COUNT
+	};
+
+	//! Integer members of the particles in a CParticleStore
+	enum E_PARTICLE_INT
+	{
+		EPI_START_TIME = 0,
+		EPI_END_TIME,
+		EPI_COLOR,
+		EPI_START_COLOR,
+		EPI_COUNT
+	};
+
+	//! Particles stored as structure of arrays.
+	/** Each member of SParticle has its own array, so loops over one member
+	of all particles can use SIMD instructions. Colors are stored as ARGB u32.
+	All arrays have room for a multiple of 4 particles, the values behind the
+	last particle can be read and written freely. Particles are removed by
+	moving the last particle into their place, so the order changes. */
+	class CParticleStore
+	{
+	public:
+
+		//! constructor
+		CParticleStore() : Count(0), Capacity(0) {}
+
+		//! Number of particles
+		u32 size() const
+		{
+			return Count;
+		}
+
+		//! Remove all particles
+		void clear()
+		{
+			Count = 0;
+		}
+
+		//! Add a particle at the end
+		void push_back(const SParticle& particle)
+		{
+			if (Count == Capacity)
+				reallocate(Count + 1);
+			setParticle(Count++, particle);
+		}
+
+		//! Remove a particle, the last particle moves into its place
+		void swapRemove(u32 index);
+
+		//! Get a particle
+		void getParticle(u32 index, SParticle& particle) const;
+
+		//! Overwrite a particle
+		void setParticle(u32 index, const SParticle& particle);
+
+		//! Copy all particles into an array of structures
+		void copyTo(core::array<SParticle>& particles) const;
+
+		//! Replace all particles with those of an array of structures
+		void copyFrom(const core::array<SParticle>& particles);
+
+		//! Move the particles in [begin,end) by their vector times timeScale
+		void move(u32 begin, u32 end, f32 timeScale);
+
+		//! Remove all particles with an end time before now
+		void removeExpired(u32 now);
+
+		//! Extend a box so it contains the positions of all particles
+		void addToBoundingBox(core::aabbox3df& box) const;
+
+		//! Get the array of a float member, with room for a multiple of 4 particles
+		f32* getFloats(E_PARTICLE_FLOAT member)
+		{
+			return Floats.pointer() + member * Capacity;
+		}
+
+		const f32* getFloats(E_PARTICLE_FLOAT member) const
+		{
+			return Floats.const_pointer() + member * Capacity;
+		}
+
+		//! Get the array of an integer member, with room for a multiple of 4 particles
+		u32* getInts(E_PARTICLE_INT member)
+		{
+			return Ints.pointer() + member * Capacity;
+		}
+
+		const u32* getInts(E_PARTICLE_INT member) const
+		{
+			return Ints.const_pointer() + member * Capacity;
+		}
+
+	private:
+
+		//! Make room for at least count particles, keeps the particles
+		void reallocate(u32 count);
+
+		core::array<f32> Floats;
+		core::array<u32> Ints;
+		u32 Count;
+		u32 Capacity;
+	};
+
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	//! Convert 4 unsigned integers to floats, like a cast of each u32
+	/** SSE2 can only convert signed integers, so the upper and lower
+	16 bits are converted separately. The sum is rounded only once. */
+	inline __m128 convertParticleTimes(__m128i times)
+	{
+		const __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(times, 16));
+		const __m128 low = _mm_cvtepi32_ps(_mm_and_si128(times, _mm_set1_epi32(0xffff)));
+		return _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.f)), low);
+	}
+#endif
+
+
+	//! Built in particle affectors, which can work on a CParticleStore directly.
+	/** The particle system scene node runs all such affectors together on
+	small ranges of particles, so the particle data stays in the cache. */
+	class IParticleStoreAffector
+	{
+	public:
+
+		virtual ~IParticleStoreAffector() {}
+
+		//! Prepare affecting all particles at time now
+		/** Called once per update, before affectStore.
+		\return False if the affector has nothing to do now */
+		virtual bool beginAffect(u32 now) = 0;
+
+		//! Affect the particles in [begin,end)
+		/** \param begin First particle, a multiple of 4
+		\param end Particle behind the last one. Particles up to the next
+		multiple of 4 may be changed as well. */
+		virtual void affectStore(CParticleStore& particles, u32 begin, u32 end) const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
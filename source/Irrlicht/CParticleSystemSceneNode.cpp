@@ -21,12 +21,124 @@
 #include "CParticleRotationAffector.h"
 #include "CParticleScaleAffector.h"
 #include "SViewFrustum.h"
+#include "CWorkerPool.h"
 
 namespace irr
 {
 namespace scene
 {
 
+//! Particles drawn with one call, so 16 bit indices can address all their vertices
+static const u32 MaxQuadsPerDraw = 16384;
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+//! Store the same corner of the quads of four particles
+/** Positions are transposed and stored together with Normal.X, which
+directly follows Pos in S3DVertex, so each vertex needs only one store. */
+static inline void storeCorners(video::S3DVertex* v, __m128 x, __m128 y, __m128 z, __m128 normalX)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, normalX);
+	_mm_storeu_ps(&v[0].Pos.X, x);
+	_mm_storeu_ps(&v[4].Pos.X, y);
+	_mm_storeu_ps(&v[8].Pos.X, z);
+	_mm_storeu_ps(&v[12].Pos.X, normalX);
+}
+#endif
+
+//! Write the positions and colors of the camera facing quads of all particles
+/** Four particles are expanded at once, each quad gets the corners
+pos+h+v, pos+h-v, pos-h-v, pos-h+v with h and v the scaled camera axes. */
+static void expandParticles(const CParticleStore& particles, const core::matrix4& view, video::S3DVertex* vertices)
+{
+	const f32* posX = particles.getFloats(EPF_POS_X);
+	const f32* posY = particles.getFloats(EPF_POS_Y);
+	const f32* posZ = particles.getFloats(EPF_POS_Z);
+	const f32* width = particles.getFloats(EPF_WIDTH);
+	const f32* height = particles.getFloats(EPF_HEIGHT);
+	const u32* color = particles.getInts(EPI_COLOR);
+	const u32 count = particles.size();
+	u32 i=0;
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+	const __m128 horizontalX = _mm_set1_ps(0.5f * view[0]);
+	const __m128 horizontalY = _mm_set1_ps(0.5f * view[4]);
+	const __m128 horizontalZ = _mm_set1_ps(0.5f * view[8]);
+	const __m128 verticalX = _mm_set1_ps(-0.5f * view[1]);
+	const __m128 verticalY = _mm_set1_ps(-0.5f * view[5]);
+	const __m128 verticalZ = _mm_set1_ps(-0.5f * view[9]);
+
+	// each position is written together with the following Normal.X
+	const __m128 normalX = _mm_set1_ps(-view[2]);
+	for (; i+4<=count; i+=4)
+	{
+		const __m128 w = _mm_loadu_ps(width + i);
+		const __m128 h = _mm_loadu_ps(height + i);
+		const __m128 px = _mm_loadu_ps(posX + i);
+		const __m128 py = _mm_loadu_ps(posY + i);
+		const __m128 pz = _mm_loadu_ps(posZ + i);
+		const __m128 hx = _mm_mul_ps(w, horizontalX);
+		const __m128 hy = _mm_mul_ps(w, horizontalY);
+		const __m128 hz = _mm_mul_ps(w, horizontalZ);
+		const __m128 vx = _mm_mul_ps(h, verticalX);
+		const __m128 vy = _mm_mul_ps(h, verticalY);
+		const __m128 vz = _mm_mul_ps(h, verticalZ);
+
+		const __m128 rightX = _mm_add_ps(px, hx);
+		const __m128 rightY = _mm_add_ps(py, hy);
+		const __m128 rightZ = _mm_add_ps(pz, hz);
+		const __m128 leftX = _mm_sub_ps(px, hx);
+		const __m128 leftY = _mm_sub_ps(py, hy);
+		const __m128 leftZ = _mm_sub_ps(pz, hz);
+
+		video::S3DVertex* v = vertices + i*4;
+		storeCorners(v, _mm_add_ps(rightX, vx), _mm_add_ps(rightY, vy), _mm_add_ps(rightZ, vz), normalX);
+		storeCorners(v+1, _mm_sub_ps(rightX, vx), _mm_sub_ps(rightY, vy), _mm_sub_ps(rightZ, vz), normalX);
+		storeCorners(v+2, _mm_sub_ps(leftX, vx), _mm_sub_ps(leftY, vy), _mm_sub_ps(leftZ, vz), normalX);
+		storeCorners(v+3, _mm_add_ps(leftX, vx), _mm_add_ps(leftY, vy), _mm_add_ps(leftZ, vz), normalX);
+
+		for (u32 k=0; k<16; ++k)
+			v[k].Color = color[i+k/4];
+	}
+#endif
+
+	for (; i<count; ++i)
+	{
+		const core::vector3df pos(posX[i], posY[i], posZ[i]);
+		f32 f;
+
+		f = 0.5f * width[i];
+		const core::vector3df horizontal ( view[0] * f, view[4] * f, view[8] * f );
+
+		f = -0.5f * height[i];
+		const core::vector3df vertical ( view[1] * f, view[5] * f, view[9] * f );
+
+		video::S3DVertex* v = vertices + i*4;
+		v[0].Pos = pos + horizontal + vertical;
+		v[0].Color = color[i];
+
+		v[1].Pos = pos + horizontal - vertical;
+		v[1].Color = color[i];
+
+		v[2].Pos = pos - horizontal - vertical;
+		v[2].Color = color[i];
+
+		v[3].Pos = pos - horizontal + vertical;
+		v[3].Color = color[i];
+	}
+}
+
+struct CParticleSystemSceneNode::SSimulateJob
+{
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 i=begin; i<end; ++i)
+			Queue[i]->doParticleSystem(Queue[i]->QueuedTime);
+	}
+
+	CParticleSystemSceneNode* const* Queue;
+};
+
+
 //! constructor
 CParticleSystemSceneNode::CParticleSystemSceneNode(bool createDefaultEmitter,
 	ISceneNode* parent, ISceneManager* mgr, s32 id,
@@ -34,7 +146,8 @@ CParticleSystemSceneNode::CParticleSystemSceneNode(bool createDefaultEmitter,
 	const core::vector3df& scale)
 	: IParticleSystemSceneNode(parent, mgr, id, position, rotation, scale),
 	Emitter(0), ParticleSize(core::dimension2d<f32>(5.0f, 5.0f)), LastEmitTime(0),
-	Buffer(0), ParticlesAreGlobal(true)
+	Randomizer(os::Randomizer::rand()), SimulationQueue(0), QueuedTime(0), SimulationDone(false),
+	Buffer(0), ValidNormals(0), ParticlesAreGlobal(true)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleSystemSceneNode");
@@ -53,6 +166,13 @@ CParticleSystemSceneNode::CParticleSystemSceneNode(bool createDefaultEmitter,
 //! destructor
 CParticleSystemSceneNode::~CParticleSystemSceneNode()
 {
+	if (SimulationQueue)
+	{
+		const s32 i = SimulationQueue->linear_search(this);
+		if (i >= 0)
+			SimulationQueue->erase(i);
+	}
+
 	if (Emitter)
 		Emitter->drop();
 	if (Buffer)
@@ -290,10 +410,53 @@ IParticleRotationAffector* CParticleSystemSceneNode::createRotationAffector(
 }
 
 
+//! animates the node, queues the simulation for EPB_PARALLEL_SIMULATION
+void CParticleSystemSceneNode::OnAnimate(u32 timeMs)
+{
+	// the simulation needs the new absolute transformation
+	ISceneNode::OnAnimate(timeMs);
+	SimulationDone = false;
+
+	// the animated mesh emitter reads the animated mesh, which is not thread safe
+	if ((getParticleBehavior() & EPB_PARALLEL_SIMULATION) && !SimulationQueue &&
+		!(Emitter && Emitter->getType() == EPET_ANIMATED_MESH))
+	{
+		SimulationQueue = SceneManager->getParticleSimulationQueue();
+		if (SimulationQueue)
+		{
+			QueuedTime = timeMs;
+			SimulationQueue->push_back(this);
+		}
+	}
+}
+
+
+//! Simulate all particle systems of a queue on the worker threads
+void CParticleSystemSceneNode::simulateQueued(core::array<CParticleSystemSceneNode*>& queue)
+{
+	SSimulateJob job = { queue.const_pointer() };
+	CWorkerPool::getInstance().parallelFor(queue.size(), 1, job);
+
+	for (u32 i=0; i<queue.size(); ++i)
+	{
+		queue[i]->SimulationQueue = 0;
+		queue[i]->SimulationDone = true;
+	}
+	queue.set_used(0);
+}
+
+
 //! pre render event
 void CParticleSystemSceneNode::OnRegisterSceneNode()
 {
-	doParticleSystem(os::Timer::getTime());
+	// the first queued system to be registered simulates all of them,
+	// so the bounding boxes are up to date for culling
+	if (SimulationQueue)
+		simulateQueued(*SimulationQueue);
+	if (SimulationDone)
+		SimulationDone = false;
+	else
+		doParticleSystem(os::Timer::getTime());
 
 	if (IsVisible && (Particles.size() != 0))
 	{
@@ -332,48 +495,17 @@ void CParticleSystemSceneNode::render()
 	reallocateBuffers();
 
 	// create particle vertex data
-	s32 idx = 0;
-	for (u32 i=0; i<Particles.size(); ++i)
-	{
-		const SParticle& particle = Particles[i];
-
-		#if 0
-			core::vector3df horizontal = camera->getUpVector().crossProduct(view);
-			horizontal.normalize();
-			horizontal *= 0.5f * particle.size.Width;
-
-			core::vector3df vertical = horizontal.crossProduct(view);
-			vertical.normalize();
-			vertical *= 0.5f * particle.size.Height;
-
-		#else
-			f32 f;
-
-			f = 0.5f * particle.size.Width;
-			const core::vector3df horizontal ( m[0] * f, m[4] * f, m[8] * f );
-
-			f = -0.5f * particle.size.Height;
-			const core::vector3df vertical ( m[1] * f, m[5] * f, m[9] * f );
-		#endif
-
-		Buffer->Vertices[0+idx].Pos = particle.pos + horizontal + vertical;
-		Buffer->Vertices[0+idx].Color = particle.color;
-		Buffer->Vertices[0+idx].Normal = view;
-
-		Buffer->Vertices[1+idx].Pos = particle.pos + horizontal - vertical;
-		Buffer->Vertices[1+idx].Color = particle.color;
-		Buffer->Vertices[1+idx].Normal = view;
-
-		Buffer->Vertices[2+idx].Pos = particle.pos - horizontal - vertical;
-		Buffer->Vertices[2+idx].Color = particle.color;
-		Buffer->Vertices[2+idx].Normal = view;
+	expandParticles(Particles, m, Buffer->Vertices.pointer());
 
-		Buffer->Vertices[3+idx].Pos = particle.pos - horizontal + vertical;
-		Buffer->Vertices[3+idx].Color = particle.color;
-		Buffer->Vertices[3+idx].Normal = view;
-
-		idx +=4;
+	// normals only change with the view direction, texture coords never
+	if (view != LastView)
+	{
+		LastView = view;
+		ValidNormals = 0;
 	}
+	for (u32 i=ValidNormals; i<Particles.size()*4; ++i)
+		Buffer->Vertices[i].Normal = view;
+	ValidNormals = core::max_(ValidNormals, Particles.size()*4);
 
 	// render all
 	core::matrix4 mat;
@@ -383,8 +515,13 @@ void CParticleSystemSceneNode::render()
 
 	driver->setMaterial(Buffer->Material);
 
-	driver->drawVertexPrimitiveList(Buffer->getVertices(), Particles.size()*4,
-		Buffer->getIndices(), Particles.size()*2, video::EVT_STANDARD, EPT_TRIANGLES,Buffer->getIndexType());
+	// all chunks share the same 16 bit indices
+	for (u32 first=0; first<Particles.size(); first+=MaxQuadsPerDraw)
+	{
+		const u32 count = core::min_(Particles.size() - first, MaxQuadsPerDraw);
+		driver->drawVertexPrimitiveList(Buffer->Vertices.const_pointer() + first*4, count*4,
+			Buffer->getIndices(), count*2, video::EVT_STANDARD, EPT_TRIANGLES,Buffer->getIndexType());
+	}
 
 	// for debug purposes only:
 	if ( DebugDataVisible & scene::EDS_BBOX )
@@ -418,6 +555,9 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 	u32 timediff = time - LastEmitTime;
 	LastEmitTime = time;
 
+	// built in emitters take their random numbers from this system
+	CParticleRandomizer* previousRandomizer = CParticleRandomizer::setCurrent(&Randomizer);
+
 
 	bool visible = isVisible();
 	int behavior = getParticleBehavior();
@@ -430,96 +570,94 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 
 		if (newParticles && array)
 		{
-			s32 j=Particles.size();
-			if (newParticles > 16250-j)	// avoid having more than 64k vertices in the scenenode
-				newParticles=16250-j;
-			Particles.set_used(j+newParticles);
-			for (s32 i=j; i<j+newParticles; ++i)
+			for (s32 i=0; i<newParticles; ++i)
 			{
-				Particles[i]=array[i-j];
+				SParticle particle = array[i];
 
 				if ( ParticlesAreGlobal && behavior & EPB_EMITTER_FRAME_INTERPOLATION )
 				{
 					// Interpolate between current node transformations and last ones.
 					// (Lazy solution - calculating twice and interpolating results)
-					f32 randInterpolate = (f32)(os::Randomizer::rand() % 101) / 100.f;	// 0 to 1
-					core::vector3df posNow(Particles[i].pos);
-					core::vector3df posLast(Particles[i].pos);
+					f32 randInterpolate = (f32)(Randomizer.rand() % 101) / 100.f;	// 0 to 1
+					core::vector3df posNow(particle.pos);
+					core::vector3df posLast(particle.pos);
 
 					AbsoluteTransformation.transformVect(posNow);
 					LastAbsoluteTransformation.transformVect(posLast);
-					Particles[i].pos = posNow.getInterpolated(posLast, randInterpolate);
+					particle.pos = posNow.getInterpolated(posLast, randInterpolate);
 
 					if ( !(behavior & EPB_EMITTER_VECTOR_IGNORE_ROTATION) )
 					{
-						core::vector3df vecNow(Particles[i].startVector);
-						core::vector3df vecOld(Particles[i].startVector);
+						core::vector3df vecNow(particle.startVector);
+						core::vector3df vecOld(particle.startVector);
 						AbsoluteTransformation.rotateVect(vecNow);
 						LastAbsoluteTransformation.rotateVect(vecOld);
-						Particles[i].startVector = vecNow.getInterpolated(vecOld, randInterpolate);
+						particle.startVector = vecNow.getInterpolated(vecOld, randInterpolate);
 
-						vecNow = Particles[i].vector;
-						vecOld = Particles[i].vector;
+						vecNow = particle.vector;
+						vecOld = particle.vector;
 						AbsoluteTransformation.rotateVect(vecNow);
 						LastAbsoluteTransformation.rotateVect(vecOld);
-						Particles[i].vector = vecNow.getInterpolated(vecOld, randInterpolate);
+						particle.vector = vecNow.getInterpolated(vecOld, randInterpolate);
 					}
 				}
 				else
 				{
 					if (ParticlesAreGlobal)
-						AbsoluteTransformation.transformVect(Particles[i].pos);
+						AbsoluteTransformation.transformVect(particle.pos);
 
 					if ( !(behavior & EPB_EMITTER_VECTOR_IGNORE_ROTATION) )
 					{
 						if (!ParticlesAreGlobal)
-							AbsoluteTransformation.rotateVect(Particles[i].pos);
+							AbsoluteTransformation.rotateVect(particle.pos);
 
-						AbsoluteTransformation.rotateVect(Particles[i].startVector);
-						AbsoluteTransformation.rotateVect(Particles[i].vector);
+						AbsoluteTransformation.rotateVect(particle.startVector);
+						AbsoluteTransformation.rotateVect(particle.vector);
 					}
 				}
+
+				Particles.push_back(particle);
 			}
 		}
 	}
 
 	// run affectors
+	const bool animate = visible || behavior & EPB_INVISIBLE_ANIMATING;
 	if ( visible || behavior & EPB_INVISIBLE_AFFECTING )
 	{
 		core::list<IParticleAffector*>::Iterator ait = AffectorList.begin();
 		for (; ait != AffectorList.end(); ++ait)
-			(*ait)->affect(now, Particles.pointer(), Particles.size());
+		{
+			IParticleStoreAffector* storeAffector = (*ait)->getStoreAffector();
+			if (storeAffector)
+			{
+				if (storeAffector->beginAffect(now))
+					StoreAffectors.push_back(storeAffector);
+			}
+			else
+			{
+				runStoreAffectors(false, 0.f);
+				Particles.copyTo(ParticleArray);
+				(*ait)->affect(now, ParticleArray.pointer(), ParticleArray.size());
+				Particles.copyFrom(ParticleArray);
+			}
+		}
 	}
 
+	// animate all particles, moving them while the last affectors have them in the cache
+	runStoreAffectors(animate, (f32)timediff);
+
 	if (ParticlesAreGlobal)
 		Buffer->BoundingBox.reset(AbsoluteTransformation.getTranslation());
 	else
 		Buffer->BoundingBox.reset(core::vector3df(0,0,0));
 
-	// animate all particles
-	if ( visible || behavior & EPB_INVISIBLE_ANIMATING )
+	if (animate)
 	{
-		f32 scale = (f32)timediff;
-
-		for (u32 i=0; i<Particles.size();)
-		{
-			// erase is pretty expensive!
-			if (now > Particles[i].endTime)
-			{
-				// Particle order does not seem to matter.
-				// So we can delete by switching with last particle and deleting that one.
-				// This is a lot faster and speed is very important here as the erase otherwise
-				// can cause noticable freezes.
-				Particles[i] = Particles[Particles.size()-1];
-				Particles.erase( Particles.size()-1 );
-			}
-			else
-			{
-				Particles[i].pos += (Particles[i].vector * scale);
-				Buffer->BoundingBox.addInternalPoint(Particles[i].pos);
-				++i;
-			}
-		}
+		// Particle order does not seem to matter.
+		// So expired particles are replaced by the last particle.
+		Particles.removeExpired(now);
+		Particles.addToBoundingBox(Buffer->BoundingBox);
 	}
 
 	const f32 m = (ParticleSize.Width > ParticleSize.Height ? ParticleSize.Width : ParticleSize.Height) * 0.5f;
@@ -538,6 +676,29 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 	}
 
 	LastAbsoluteTransformation = AbsoluteTransformation;
+	CParticleRandomizer::setCurrent(previousRandomizer);
+}
+
+
+//! Run the affectors collected in StoreAffectors on all particles
+void CParticleSystemSceneNode::runStoreAffectors(bool move, f32 timeScale)
+{
+	// 256 particles use 17kB, a few chunks fit into the first level cache
+	const u32 chunkSize = 256;
+
+	if (StoreAffectors.size() || move)
+	{
+		const u32 count = Particles.size();
+		for (u32 begin=0; begin<count; begin+=chunkSize)
+		{
+			const u32 end = core::min_(begin + chunkSize, count);
+			for (u32 i=0; i<StoreAffectors.size(); ++i)
+				StoreAffectors[i]->affectStore(Particles, begin, end);
+			if (move)
+				Particles.move(begin, end, timeScale);
+		}
+	}
+	StoreAffectors.set_used(0);
 }
 
 
@@ -552,7 +713,7 @@ void CParticleSystemSceneNode::setParticlesAreGlobal(bool global)
 //! Remove all currently visible particles
 void CParticleSystemSceneNode::clearParticles()
 {
-	Particles.set_used(0);
+	Particles.clear();
 }
 
 //! Sets if the node should be visible or not.
@@ -582,11 +743,12 @@ void CParticleSystemSceneNode::setParticleSize(const core::dimension2d<f32> &siz
 
 void CParticleSystemSceneNode::reallocateBuffers()
 {
+	const u32 quadCount = core::min_(Particles.size(), MaxQuadsPerDraw);
 	if (Particles.size() * 4 > Buffer->getVertexCount() ||
-			Particles.size() * 6 > Buffer->getIndexCount())
+			quadCount * 6 > Buffer->getIndexCount())
 	{
 		u32 oldSize = Buffer->getVertexCount();
-		Buffer->Vertices.set_used(Particles.size() * 4);
+		Buffer->Vertices.set_used(core::max_(Particles.size() * 4, oldSize));
 
 		u32 i;
 
@@ -599,10 +761,10 @@ void CParticleSystemSceneNode::reallocateBuffers()
 			Buffer->Vertices[3+i].TCoords.set(1.0f, 0.0f);
 		}
 
-		// fill remaining indices
+		// fill remaining indices, they are used for each chunk of MaxQuadsPerDraw particles
 		u32 oldIdxSize = Buffer->getIndexCount();
-		u32 oldvertices = oldSize;
-		Buffer->Indices.set_used(Particles.size() * 6);
+		u32 oldvertices = oldIdxSize / 6 * 4;
+		Buffer->Indices.set_used(core::max_(quadCount * 6, oldIdxSize));
 
 		for (i=oldIdxSize; i<Buffer->Indices.size(); i+=6)
 		{
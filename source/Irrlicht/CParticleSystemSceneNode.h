@@ -9,6 +9,8 @@
 #include "irrArray.h"
 #include "irrList.h"
 #include "SMeshBuffer.h"
+#include "CParticleStore.h"
+#include "CParticleRandomizer.h"
 
 namespace irr
 {
@@ -54,6 +56,9 @@ public:
 	//! Returns amount of materials used by this scene node.
 	virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
 
+	//! animates the node, queues the simulation for EPB_PARALLEL_SIMULATION
+	virtual void OnAnimate(u32 timeMs) _IRR_OVERRIDE_;
+
 	//! pre render event
 	virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
 
@@ -215,14 +220,41 @@ private:
 
 	void reallocateBuffers();
 
+	//! Job of the worker threads simulating a queue
+	struct SSimulateJob;
+
+	//! Simulate all particle systems of a queue on the worker threads
+	static void simulateQueued(core::array<CParticleSystemSceneNode*>& queue);
+
+	//! Run the affectors collected in StoreAffectors on all particles
+	/** Works on chunks of particles which fit into the cache, each chunk
+	goes through all affectors before the next one is loaded.
+	\param move Also move the particles by their vector times timeScale */
+	void runStoreAffectors(bool move, f32 timeScale);
+
 	core::list<IParticleAffector*> AffectorList;
 	IParticleEmitter* Emitter;
-	core::array<SParticle> Particles;
+	CParticleStore Particles;
+	//! consecutive built in affectors, which are run together
+	core::array<IParticleStoreAffector*> StoreAffectors;
+	//! copy of the particles for affectors which need an array of SParticle
+	core::array<SParticle> ParticleArray;
 	core::dimension2d<f32> ParticleSize;
 	u32 LastEmitTime;
 	core::matrix4 LastAbsoluteTransformation;
+	//! random numbers for the emitter, independent of other particle systems
+	CParticleRandomizer Randomizer;
+	//! queue of the scene manager in which the node waits for the worker threads, 0 if not queued
+	core::array<CParticleSystemSceneNode*>* SimulationQueue;
+	//! time of the queued simulation
+	u32 QueuedTime;
+	//! simulated by the worker threads for this frame already
+	bool SimulationDone;
 
 	SMeshBuffer* Buffer;
+	//! view direction written into the normals of the first ValidNormals vertices
+	core::vector3df LastView;
+	u32 ValidNormals;
 
 // TODO: That was obviously planned by someone at some point and sounds like a good idea.
 // But seems it was never implemented.
@@ -13,6 +13,7 @@
 #include "ILightSceneNode.h"
 #include "IQ3Shader.h"
 #include "IFileList.h"
+#include "irrMap.h"
 
 //#define TJUNCTION_SOLVER_ROUND
 //#define TJUNCTION_SOLVER_0125
@@ -31,7 +32,7 @@ CQ3LevelMesh::CQ3LevelMesh(io::IFileSystem* fs, scene::ISceneManager* smgr,
 	Vertices(0), NumVertices(0), Faces(0), NumFaces(0), Models(0), NumModels(0),
 	Planes(0), NumPlanes(0), Nodes(0), NumNodes(0), Leafs(0), NumLeafs(0),
 	LeafFaces(0), NumLeafFaces(0), MeshVerts(0), NumMeshVerts(0),
-	Brushes(0), NumBrushes(0), BrushEntities(0), FileSystem(fs),
+	NumClusters(0), BytesPerCluster(0), Brushes(0), NumBrushes(0), BrushEntities(0), FileSystem(fs),
 	SceneManager(smgr), FramesPerSecond(25.f)
 {
 	#ifdef _DEBUG
@@ -162,6 +163,7 @@ bool CQ3LevelMesh::loadFile(io::IReadFile* file)
 
 	cleanMeshes();
 	calcBoundingBoxes();
+	buildVisibility();
 	cleanLoader();
 
 	return true;
@@ -314,7 +316,24 @@ void CQ3LevelMesh::loadFaces(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumPlanes = l->length / sizeof(tBSPPlane);
+	if (!NumPlanes)
+		return;
+	Planes = new tBSPPlane[NumPlanes];
+
+	file->seek(l->offset);
+	file->read(Planes, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumPlanes;i++)
+		{
+			Planes[i].vNormal[0] = os::Byteswap::byteswap(Planes[i].vNormal[0]);
+			Planes[i].vNormal[1] = os::Byteswap::byteswap(Planes[i].vNormal[1]);
+			Planes[i].vNormal[2] = os::Byteswap::byteswap(Planes[i].vNormal[2]);
+			Planes[i].d = os::Byteswap::byteswap(Planes[i].d);
+		}
+	}
 }
 
 
@@ -322,7 +341,28 @@ void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumNodes = l->length / sizeof(tBSPNode);
+	if (!NumNodes)
+		return;
+	Nodes = new tBSPNode[NumNodes];
+
+	file->seek(l->offset);
+	file->read(Nodes, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumNodes;i++)
+		{
+			Nodes[i].plane = os::Byteswap::byteswap(Nodes[i].plane);
+			Nodes[i].front = os::Byteswap::byteswap(Nodes[i].front);
+			Nodes[i].back = os::Byteswap::byteswap(Nodes[i].back);
+			for ( u32 j=0; j<3; ++j)
+			{
+				Nodes[i].mins[j] = os::Byteswap::byteswap(Nodes[i].mins[j]);
+				Nodes[i].maxs[j] = os::Byteswap::byteswap(Nodes[i].maxs[j]);
+			}
+		}
+	}
 }
 
 
@@ -330,7 +370,31 @@ void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafs = l->length / sizeof(tBSPLeaf);
+	if (!NumLeafs)
+		return;
+	Leafs = new tBSPLeaf[NumLeafs];
+
+	file->seek(l->offset);
+	file->read(Leafs, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumLeafs;i++)
+		{
+			Leafs[i].cluster = os::Byteswap::byteswap(Leafs[i].cluster);
+			Leafs[i].area = os::Byteswap::byteswap(Leafs[i].area);
+			for ( u32 j=0; j<3; ++j)
+			{
+				Leafs[i].mins[j] = os::Byteswap::byteswap(Leafs[i].mins[j]);
+				Leafs[i].maxs[j] = os::Byteswap::byteswap(Leafs[i].maxs[j]);
+			}
+			Leafs[i].leafface = os::Byteswap::byteswap(Leafs[i].leafface);
+			Leafs[i].numOfLeafFaces = os::Byteswap::byteswap(Leafs[i].numOfLeafFaces);
+			Leafs[i].leafBrush = os::Byteswap::byteswap(Leafs[i].leafBrush);
+			Leafs[i].numOfLeafBrushes = os::Byteswap::byteswap(Leafs[i].numOfLeafBrushes);
+		}
+	}
 }
 
 
@@ -338,7 +402,19 @@ void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafFaces(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafFaces = l->length / sizeof(s32);
+	if (!NumLeafFaces)
+		return;
+	LeafFaces = new s32[NumLeafFaces];
+
+	file->seek(l->offset);
+	file->read(LeafFaces, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for (int i=0;i<NumLeafFaces;i++)
+			LeafFaces[i] = os::Byteswap::byteswap(LeafFaces[i]);
+	}
 }
 
 
@@ -346,7 +422,35 @@ void CQ3LevelMesh::loadLeafFaces(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadVisData(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumClusters = 0;
+	BytesPerCluster = 0;
+	ClusterBits.clear();
+	if (l->length < 2*(s32)sizeof(s32))
+		return;
+
+	file->seek(l->offset);
+	file->read(&NumClusters, sizeof(s32));
+	file->read(&BytesPerCluster, sizeof(s32));
+
+	if ( LoadParam.swapHeader )
+	{
+		NumClusters = os::Byteswap::byteswap(NumClusters);
+		BytesPerCluster = os::Byteswap::byteswap(BytesPerCluster);
+	}
+
+	// the bitsets of all clusters
+	const s32 size = NumClusters * BytesPerCluster;
+	if (NumClusters <= 0 || BytesPerCluster <= 0 || size > l->length - 2*(s32)sizeof(s32) ||
+		BytesPerCluster * 8 < NumClusters)
+	{
+		os::Printer::log("quake3::loadVisData ignoring invalid visibility data", ELL_WARNING);
+		NumClusters = 0;
+		BytesPerCluster = 0;
+		return;
+	}
+
+	ClusterBits.set_used(size);
+	file->read(ClusterBits.pointer(), size);
 }
 
 
@@ -863,6 +967,23 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 	SToBuffer item [ E_Q3_MESH_SIZE ];
 	u32 itemSize;
 
+	// remember where the faces of the level geometry end up
+	if ( 0 == num )
+	{
+		SFaceRange empty;
+		empty.MeshBuffer = 0;
+		empty.First = 0;
+		empty.Count = 0;
+		FaceRanges.set_used(0);
+		FaceRanges.reallocate(NumFaces);
+		for (i = 0; i < NumFaces; ++i)
+			FaceRanges.push_back(empty);
+		FaceBuffers.set_used(0);
+		FaceBuffers.reallocate(NumFaces);
+		for (i = 0; i < NumFaces; ++i)
+			FaceBuffers.push_back(0);
+	}
+
 	for (i = Models[num].faceIndex; i < Models[num].numOfFaces + Models[num].faceIndex; ++i)
 	{
 		const tBSPFace * face = Faces + i;
@@ -965,6 +1086,8 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 			}
 
 
+			const u32 firstIndex = buffer->getIndexCount();
+
 			switch(Faces[i].type)
 			{
 				case 4: // billboards
@@ -1018,6 +1141,13 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 					break;
 
 			} // end switch
+
+			if ( 0 == num && item[g].index == E_Q3_MESH_GEOMETRY )
+			{
+				FaceBuffers[i] = buffer;
+				FaceRanges[i].First = firstIndex;
+				FaceRanges[i].Count = buffer->getIndexCount() - firstIndex;
+			}
 		}
 	}
 
@@ -1933,6 +2063,106 @@ void CQ3LevelMesh::calcBoundingBoxes()
 }
 
 
+//! keeps the BSP tree and the face ranges of the level geometry for visibility tests
+void CQ3LevelMesh::buildVisibility()
+{
+	s32 i;
+
+	// faces of mesh buffers removed by cleanMeshes have no indices
+	core::map<IMeshBuffer*, u32> bufferIndex;
+	const SMesh* geometry = Mesh[E_Q3_MESH_GEOMETRY];
+	for ( u32 j=0; j < geometry->MeshBuffers.size(); ++j)
+		bufferIndex.insert(geometry->MeshBuffers[j], j);
+
+	for (i = 0; i < (s32)FaceRanges.size(); ++i)
+	{
+		core::map<IMeshBuffer*, u32>::Node* n = FaceBuffers[i] ? bufferIndex.find(FaceBuffers[i]) : 0;
+		if (n)
+			FaceRanges[i].MeshBuffer = n->getValue();
+		else
+			FaceRanges[i].Count = 0;
+	}
+	FaceBuffers.clear();
+
+	// the tree, with the axes swapped like the vertices
+	VisNodes.set_used(0);
+	VisLeafs.set_used(0);
+	VisLeafFaces.set_used(0);
+	if (!NumNodes || !NumLeafs)
+		return;
+
+	VisNodes.reallocate(NumNodes);
+	for (i = 0; i < NumNodes; ++i)
+	{
+		// children are stored after their parent, so getLeaf always ends
+		if (Nodes[i].plane < 0 || Nodes[i].plane >= NumPlanes ||
+			Nodes[i].front >= NumNodes || -(Nodes[i].front+1) >= NumLeafs || (Nodes[i].front >= 0 && Nodes[i].front <= i) ||
+			Nodes[i].back >= NumNodes || -(Nodes[i].back+1) >= NumLeafs || (Nodes[i].back >= 0 && Nodes[i].back <= i))
+		{
+			os::Printer::log("quake3::buildVisibility ignoring invalid BSP tree", ELL_WARNING);
+			VisNodes.set_used(0);
+			return;
+		}
+
+		const tBSPPlane& p = Planes[Nodes[i].plane];
+		SVisNode node;
+		node.Plane.setPlane(core::vector3df(p.vNormal[0], p.vNormal[2], p.vNormal[1]), -p.d);
+		node.Front = Nodes[i].front;
+		node.Back = Nodes[i].back;
+		VisNodes.push_back(node);
+	}
+
+	VisLeafs.reallocate(NumLeafs);
+	for (i = 0; i < NumLeafs; ++i)
+	{
+		const tBSPLeaf& l = Leafs[i];
+		SVisLeaf leaf;
+		leaf.Box.reset(core::vector3df((f32)l.mins[0], (f32)l.mins[2], (f32)l.mins[1]));
+		leaf.Box.addInternalPoint(core::vector3df((f32)l.maxs[0], (f32)l.maxs[2], (f32)l.maxs[1]));
+		leaf.Cluster = l.cluster < NumClusters ? l.cluster : -1;
+		leaf.FirstFace = VisLeafFaces.size();
+
+		for (s32 j = 0; j < l.numOfLeafFaces; ++j)
+		{
+			const s32 f = l.leafface + j;
+			if (f >= 0 && f < NumLeafFaces && LeafFaces[f] >= 0 && LeafFaces[f] < (s32)FaceRanges.size() &&
+				FaceRanges[LeafFaces[f]].Count)
+				VisLeafFaces.push_back(LeafFaces[f]);
+		}
+		leaf.FaceCount = VisLeafFaces.size() - leaf.FirstFace;
+		VisLeafs.push_back(leaf);
+	}
+}
+
+
+//! Find the leaf containing a point of the level geometry
+s32 CQ3LevelMesh::getLeaf(const core::vector3df& point) const
+{
+	if (VisNodes.empty())
+		return -1;
+
+	s32 node = 0;
+	while (node >= 0)
+	{
+		const SVisNode& n = VisNodes[node];
+		node = n.Plane.getDistanceTo(point) >= 0.f ? n.Front : n.Back;
+	}
+	return -(node+1);
+}
+
+
+//! Check if a cluster may be seen from another cluster
+bool CQ3LevelMesh::isClusterVisible(s32 from, s32 to) const
+{
+	if (from < 0 || from >= NumClusters || ClusterBits.empty())
+		return true;
+	if (to < 0 || to >= NumClusters)
+		return false;
+
+	return (ClusterBits[from*BytesPerCluster + (to >> 3)] & (1 << (to & 7))) != 0;
+}
+
+
 //! loads the textures
 void CQ3LevelMesh::loadTextures()
 {
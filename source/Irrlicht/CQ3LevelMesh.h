@@ -12,6 +12,7 @@
 #include "SMeshBufferLightMap.h"
 #include "IVideoDriver.h"
 #include "irrString.h"
+#include "plane3d.h"
 #include "ISceneManager.h"
 #include "os.h"
 
@@ -89,6 +90,62 @@ namespace scene
 		//! returns the requested brush entity
 		virtual IMesh* getBrushEntityMesh(quake3::IEntity &ent) const _IRR_OVERRIDE_;
 
+		//! A range of indices of a mesh buffer of the level geometry
+		struct SFaceRange
+		{
+			u32 MeshBuffer;
+			u32 First;
+			u32 Count;
+		};
+
+		//! A node of the BSP tree, children below 0 are leafs: -(child+1)
+		struct SVisNode
+		{
+			core::plane3df Plane;
+			s32 Front;
+			s32 Back;
+		};
+
+		//! A leaf of the BSP tree
+		struct SVisLeaf
+		{
+			core::aabbox3df Box;
+			//! visibility cluster, -1 for leafs in solid space
+			s32 Cluster;
+			//! faces of the leaf in the leaf face array
+			u32 FirstFace;
+			u32 FaceCount;
+		};
+
+		//! Find the leaf containing a point of the level geometry
+		/** \return Index of the leaf, -1 if there is no BSP tree. */
+		s32 getLeaf(const core::vector3df& point) const;
+
+		//! Check if a cluster may be seen from another cluster
+		/** Every cluster is visible from cluster -1 or a cluster out of
+		range, and when the level has no visibility data. Clusters out of
+		range are never visible. */
+		bool isClusterVisible(s32 from, s32 to) const;
+
+		//! Get the leafs of the BSP tree
+		const core::array<SVisLeaf>& getLeafs() const
+		{
+			return VisLeafs;
+		}
+
+		//! Get the face indices of all leafs
+		const core::array<u32>& getLeafFaces() const
+		{
+			return VisLeafFaces;
+		}
+
+		//! Get the indices of each face in the geometry mesh
+		/** Faces not in E_Q3_MESH_GEOMETRY have no indices. */
+		const core::array<SFaceRange>& getFaceRanges() const
+		{
+			return FaceRanges;
+		}
+
 		//Link to held meshes? ...
 
 
@@ -407,6 +464,17 @@ namespace scene
 		s32 *MeshVerts;           // The vertex offsets for a mesh
 		s32 NumMeshVerts;
 
+		// visibility, kept after loading
+		core::array<SVisNode> VisNodes;
+		core::array<SVisLeaf> VisLeafs;
+		core::array<u32> VisLeafFaces;
+		core::array<SFaceRange> FaceRanges;
+		core::array<u8> ClusterBits;
+		s32 NumClusters;
+		s32 BytesPerCluster;
+		//! geometry mesh buffer of each face while loading
+		core::array<IMeshBuffer*> FaceBuffers;
+
 		tBSPBrush* Brushes;
 		s32 NumBrushes;
 
@@ -475,6 +543,7 @@ namespace scene
 
 		void cleanMeshes();
 		void cleanMesh(SMesh *m, const bool texture0important = false);
+		void buildVisibility();
 		void cleanLoader ();
 		void calcBoundingBoxes();
 		c8 buf[128];
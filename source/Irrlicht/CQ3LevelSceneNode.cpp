@@ -0,0 +1,367 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+
+#include "CQ3LevelSceneNode.h"
+#include "CQ3LevelMesh.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+#include "CShadowVolumeSceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CQ3LevelSceneNode::CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id)
+	: IMeshSceneNode(parent, mgr, id), LevelMesh(0), Mesh(0), Shadow(0),
+	ReadOnlyMaterials(false), PassCount(0), CameraCluster(-2), Frame(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CQ3LevelSceneNode");
+	#endif
+
+	if (!mesh)
+		return;
+
+	// only the level mesh loaded from .bsp files has the visibility data
+	if (mesh->getMeshType() == EAMT_BSP)
+	{
+		LevelMesh = static_cast<CQ3LevelMesh*>(mesh);
+		LevelMesh->grab();
+	}
+
+	setMesh(mesh->getMesh(quake3::E_Q3_MESH_GEOMETRY));
+}
+
+
+//! destructor
+CQ3LevelSceneNode::~CQ3LevelSceneNode()
+{
+	if (Shadow)
+		Shadow->drop();
+
+	if (Mesh)
+		Mesh->drop();
+
+	if (LevelMesh)
+		LevelMesh->drop();
+}
+
+
+//! frame
+void CQ3LevelSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible && Mesh)
+	{
+		video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+		PassCount = 0;
+		u32 transparentCount = 0;
+		u32 solidCount = 0;
+
+		// count transparent and solid materials in this scene node
+		for (u32 i=0; i<getMaterialCount(); ++i)
+		{
+			const video::SMaterial& material = ReadOnlyMaterials ? Mesh->getMeshBuffer(i)->getMaterial() : Materials[i];
+			const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(material.MaterialType);
+
+			if ((rnd && rnd->isTransparent()) || material.isTransparent())
+				++transparentCount;
+			else
+				++solidCount;
+
+			if (solidCount && transparentCount)
+				break;
+		}
+
+		// register according to material types counted
+
+		if (solidCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+		if (transparentCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! renders the node.
+void CQ3LevelSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	ICameraSceneNode* camera = SceneManager->getActiveCamera();
+
+	if (!Mesh || !driver || !camera)
+		return;
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+	++PassCount;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	if (Shadow)
+		Shadow->updateShadowVolumes();
+
+	// the faces are found once for both render passes
+	const bool useVisibility = LevelMesh && !LevelMesh->getLeafs().empty();
+	if (useVisibility && PassCount == 1)
+	{
+		// transform the frustum and camera to the space of the level
+		SViewFrustum frust = *camera->getViewFrustum();
+		core::vector3df cameraPosition = camera->getAbsolutePosition();
+		if ( !AbsoluteTransformation.isIdentity() )
+		{
+			core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+			frust.transform(invTrans);
+			invTrans.transformVect(cameraPosition);
+		}
+
+		collectVisibleFaces(frust, cameraPosition);
+	}
+
+	for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+	{
+		const IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+		if (useVisibility && Batches[i].empty())
+			continue;
+
+		const video::SMaterial& material = ReadOnlyMaterials ? mb->getMaterial() : Materials[i];
+		const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(material.MaterialType);
+		const bool transparent = (rnd && rnd->isTransparent());
+
+		// only render transparent buffer if this is the transparent render pass
+		// and solid only in solid pass
+		if (transparent == isTransparentPass)
+		{
+			driver->setMaterial(material);
+			if (useVisibility)
+				driver->drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(),
+					Batches[i].const_pointer(), Batches[i].size() / 3, mb->getVertexType(),
+					scene::EPT_TRIANGLES, video::EIT_16BIT);
+			else
+				driver->drawMeshBuffer(mb);
+		}
+	}
+
+	// for debug purposes only
+	if (DebugDataVisible && PassCount==1)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+			driver->draw3DBox(Box, video::SColor(255,255,255,255));
+
+		// the leafs drawn in this frame
+		if ((DebugDataVisible & scene::EDS_BBOX_BUFFERS) && useVisibility)
+		{
+			const core::array<CQ3LevelMesh::SVisLeaf>& leafs = LevelMesh->getLeafs();
+			for (u32 i=0; i<VisibleLeafs.size(); ++i)
+				driver->draw3DBox(leafs[VisibleLeafs[i]].Box, video::SColor(255,190,128,128));
+		}
+	}
+}
+
+
+//! Find the faces to draw and gather their indices by mesh buffer
+void CQ3LevelSceneNode::collectVisibleFaces(const SViewFrustum& frustum, const core::vector3df& cameraPosition)
+{
+	const core::array<CQ3LevelMesh::SVisLeaf>& leafs = LevelMesh->getLeafs();
+	const core::array<u32>& leafFaces = LevelMesh->getLeafFaces();
+	const core::array<CQ3LevelMesh::SFaceRange>& faces = LevelMesh->getFaceRanges();
+
+	// the potentially visible set only changes with the cluster of the camera
+	const s32 leaf = LevelMesh->getLeaf(cameraPosition);
+	const s32 cluster = leaf >= 0 ? leafs[leaf].Cluster : -1;
+	if (cluster != CameraCluster)
+	{
+		CameraCluster = cluster;
+		PotentiallyVisibleLeafs.set_used(0);
+		for (u32 i=0; i<leafs.size(); ++i)
+		{
+			if (leafs[i].FaceCount && LevelMesh->isClusterVisible(cluster, leafs[i].Cluster))
+				PotentiallyVisibleLeafs.push_back(i);
+		}
+	}
+
+	if (FaceFrames.size() != faces.size())
+	{
+		FaceFrames.set_used(faces.size());
+		memset(FaceFrames.pointer(), 0, FaceFrames.size() * sizeof(u32));
+		Frame = 0;
+	}
+	++Frame;
+
+	for (u32 i=0; i<Batches.size(); ++i)
+		Batches[i].set_used(0);
+	VisibleLeafs.set_used(0);
+
+	for (u32 i=0; i<PotentiallyVisibleLeafs.size(); ++i)
+	{
+		const CQ3LevelMesh::SVisLeaf& l = leafs[PotentiallyVisibleLeafs[i]];
+
+		bool visible = true;
+		for (u32 p=0; p!=SViewFrustum::VF_PLANE_COUNT; ++p)
+		{
+			if (l.Box.classifyPlaneRelation(frustum.planes[p]) == core::ISREL3D_FRONT)
+			{
+				visible = false;
+				break;
+			}
+		}
+		if (!visible)
+			continue;
+		VisibleLeafs.push_back(PotentiallyVisibleLeafs[i]);
+
+		// faces may be in several leafs
+		for (u32 f=l.FirstFace; f<l.FirstFace+l.FaceCount; ++f)
+		{
+			const u32 face = leafFaces[f];
+			if (FaceFrames[face] == Frame)
+				continue;
+			FaceFrames[face] = Frame;
+
+			const CQ3LevelMesh::SFaceRange& range = faces[face];
+			core::array<u16>& batch = Batches[range.MeshBuffer];
+			const u32 first = batch.size();
+			batch.set_used(first + range.Count);
+			memcpy(&batch[first], Mesh->getMeshBuffer(range.MeshBuffer)->getIndices() + range.First,
+				range.Count * sizeof(u16));
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CQ3LevelSceneNode::getBoundingBox() const
+{
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CQ3LevelSceneNode::getMaterial(u32 i)
+{
+	if (Mesh && ReadOnlyMaterials && i<Mesh->getMeshBufferCount())
+	{
+		ReadOnlyMaterial = Mesh->getMeshBuffer(i)->getMaterial();
+		return ReadOnlyMaterial;
+	}
+
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CQ3LevelSceneNode::getMaterialCount() const
+{
+	if (Mesh && ReadOnlyMaterials)
+		return Mesh->getMeshBufferCount();
+
+	return Materials.size();
+}
+
+
+//! Sets a new mesh to display
+void CQ3LevelSceneNode::setMesh(IMesh* mesh)
+{
+	if (!mesh)
+		return;
+
+	mesh->grab();
+	if (Mesh)
+		Mesh->drop();
+	Mesh = mesh;
+
+	if (LevelMesh && Mesh != LevelMesh->getMesh(quake3::E_Q3_MESH_GEOMETRY))
+	{
+		LevelMesh->drop();
+		LevelMesh = 0;
+	}
+
+	Box = Mesh->getBoundingBox();
+	Materials.clear();
+	Batches.clear();
+	for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+	{
+		Materials.push_back(Mesh->getMeshBuffer(i)->getMaterial());
+		Batches.push_back(core::array<u16>());
+	}
+	CameraCluster = -2;
+}
+
+
+//! Get the currently defined mesh for display.
+IMesh* CQ3LevelSceneNode::getMesh(void)
+{
+	return Mesh;
+}
+
+
+//! Sets if the scene node should not copy the materials of the mesh but use them in a read only style.
+void CQ3LevelSceneNode::setReadOnlyMaterials(bool readonly)
+{
+	ReadOnlyMaterials = readonly;
+}
+
+
+//! Check if the scene node should not copy the materials of the mesh but use them in a read only style
+bool CQ3LevelSceneNode::isReadOnlyMaterials() const
+{
+	return ReadOnlyMaterials;
+}
+
+
+//! Creates shadow volume scene node as child of this node
+//! and returns a pointer to it.
+IShadowVolumeSceneNode* CQ3LevelSceneNode::addShadowVolumeSceneNode(
+		const IMesh* shadowMesh, s32 id, bool zfailmethod, f32 infinity)
+{
+	if (!SceneManager->getVideoDriver()->queryFeature(video::EVDF_STENCIL_BUFFER))
+		return 0;
+
+	if (!shadowMesh)
+		shadowMesh = Mesh; // if null is given, use the mesh of node
+
+	if (Shadow)
+		Shadow->drop();
+
+	Shadow = new CShadowVolumeSceneNode(shadowMesh, this, SceneManager, id,  zfailmethod, infinity);
+	return Shadow;
+}
+
+
+//! Removes a child from this scene node.
+bool CQ3LevelSceneNode::removeChild(ISceneNode* child)
+{
+	if (child && Shadow == child)
+	{
+		Shadow->drop();
+		Shadow = 0;
+	}
+
+	return ISceneNode::removeChild(child);
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_BSP_LOADER_
+
@@ -0,0 +1,104 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+#define __C_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+
+#include "IMeshSceneNode.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IQ3LevelMesh;
+	class CQ3LevelMesh;
+
+	//! Scene node drawing the geometry of a Quake 3 level visible from the camera.
+	/** Finds the leaf of the BSP tree the camera is in, and draws the faces
+	of the leafs in the potentially visible set of its cluster which are in
+	the view frustum. The visible faces are batched into one draw call for
+	each mesh buffer of E_Q3_MESH_GEOMETRY. */
+	class CQ3LevelSceneNode : public IMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! destructor
+		virtual ~CQ3LevelSceneNode();
+
+		//! frame
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_Q3_LEVEL; }
+
+		//! Sets a new mesh to display
+		/** Only the geometry mesh of the level uses the visibility data,
+		other meshes are drawn completely. */
+		virtual void setMesh(IMesh* mesh) _IRR_OVERRIDE_;
+
+		//! Get the currently defined mesh for display.
+		virtual IMesh* getMesh(void) _IRR_OVERRIDE_;
+
+		//! Sets if the scene node should not copy the materials of the mesh but use them in a read only style.
+		virtual void setReadOnlyMaterials(bool readonly) _IRR_OVERRIDE_;
+
+		//! Check if the scene node should not copy the materials of the mesh but use them in a read only style
+		virtual bool isReadOnlyMaterials() const _IRR_OVERRIDE_;
+
+		//! Creates shadow volume scene node as child of this node
+		//! and returns a pointer to it.
+		virtual IShadowVolumeSceneNode* addShadowVolumeSceneNode(const IMesh* shadowMesh,
+			s32 id, bool zfailmethod=true, f32 infinity=10000.0f) _IRR_OVERRIDE_;
+
+		//! Removes a child from this scene node.
+		virtual bool removeChild(ISceneNode* child) _IRR_OVERRIDE_;
+
+	private:
+
+		//! Find the faces to draw and gather their indices by mesh buffer
+		void collectVisibleFaces(const SViewFrustum& frustum, const core::vector3df& cameraPosition);
+
+		//! level mesh of the geometry mesh, 0 when drawing another mesh
+		CQ3LevelMesh* LevelMesh;
+		IMesh* Mesh;
+		IShadowVolumeSceneNode* Shadow;
+		core::aabbox3d<f32> Box;
+		core::array<video::SMaterial> Materials;
+		video::SMaterial ReadOnlyMaterial;
+		bool ReadOnlyMaterials;
+		s32 PassCount;
+
+		//! cluster of the camera, and the leafs with faces visible from it
+		s32 CameraCluster;
+		core::array<u32> PotentiallyVisibleLeafs;
+		//! leafs in the view frustum in the current frame
+		core::array<u32> VisibleLeafs;
+		//! frame a face was last added in, to add faces in several leafs only once
+		core::array<u32> FaceFrames;
+		u32 Frame;
+		//! indices of the visible faces of each mesh buffer
+		core::array< core::array<u16> > Batches;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
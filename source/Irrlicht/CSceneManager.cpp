@@ -7,6 +7,7 @@
 #include "IVideoDriver.h"
 #include "IFileSystem.h"
 #include "SAnimatedMesh.h"
+#include "SLODMesh.h"
 #include "CMeshCache.h"
 #include "IXMLWriter.h"
 #include "ISceneUserDataSerializer.h"
@@ -156,9 +157,11 @@
 #include "CDummyTransformationSceneNode.h"
 #include "CWaterSurfaceSceneNode.h"
 #include "CTerrainSceneNode.h"
+#include "CPagedTerrainSceneNode.h"
 #include "CEmptySceneNode.h"
 #include "CTextSceneNode.h"
 #include "CQuake3ShaderSceneNode.h"
+#include "CQ3LevelSceneNode.h"
 #include "CVolumeLightSceneNode.h"
 
 #include "CDefaultSceneNodeFactory.h"
@@ -182,6 +185,7 @@
 #include "CDefaultSceneNodeAnimatorFactory.h"
 
 #include "CGeometryCreator.h"
+#include "CClusteredLightManager.h"
 
 #include <locale.h>
 
@@ -407,6 +411,30 @@ CSceneManager::~CSceneManager()
 }
 
 
+//! Replaces a static mesh by a mesh with levels of detail when MESH_LOD_LEVELS is set
+IAnimatedMesh* CSceneManager::createLODMeshOnLoad(IAnimatedMesh* mesh)
+{
+	const s32 levels = Parameters->getAttributeAsInt(MESH_LOD_LEVELS);
+	if (levels < 2 || mesh->getFrameCount() != 1)
+		return mesh;
+
+	const E_ANIMATED_MESH_TYPE type = mesh->getMeshType();
+	if (type == EAMT_SKINNED || type == EAMT_BSP || type == EAMT_LOD)
+		return mesh;
+
+	f32 ratio = 0.5f;
+	if (Parameters->existsAttribute(MESH_LOD_TRIANGLE_RATIO))
+		ratio = Parameters->getAttributeAsFloat(MESH_LOD_TRIANGLE_RATIO);
+
+	SLODMesh* lod = getMeshManipulator()->createLODMesh(mesh->getMesh(0), levels, ratio);
+	if (!lod)
+		return mesh;
+
+	mesh->drop();
+	return lod;
+}
+
+
 //! gets an animateable mesh. loads it if needed. returned pointer must not be dropped.
 IAnimatedMesh* CSceneManager::getMesh(const io::path& filename)
 {
@@ -432,6 +460,7 @@ IAnimatedMesh* CSceneManager::getMesh(const io::path& filename)
 			msh = MeshLoaderList[i]->createMesh(file);
 			if (msh)
 			{
+				msh = createLODMeshOnLoad(msh);
 				MeshCache->addMesh(filename, msh);
 				msh->drop();
 				break;
@@ -472,6 +501,7 @@ IAnimatedMesh* CSceneManager::getMesh(io::IReadFile* file)
 			msh = MeshLoaderList[i]->createMesh(file);
 			if (msh)
 			{
+				msh = createLODMeshOnLoad(msh);
 				MeshCache->addMesh(file->getFileName(), msh);
 				msh->drop();
 				break;
@@ -578,6 +608,27 @@ IMeshSceneNode* CSceneManager::addQuake3SceneNode(const IMeshBuffer* meshBuffer,
 }
 
 
+//! Adds a scene node drawing the geometry of a Quake3 level.
+IMeshSceneNode* CSceneManager::addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+					ISceneNode* parent, s32 id)
+{
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+	if (!mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	CQ3LevelSceneNode* node = new CQ3LevelSceneNode(mesh, parent, this, id);
+	node->drop();
+
+	return node;
+#else
+	return 0;
+#endif
+}
+
+
 //! adds Volume Lighting Scene Node.
 //! the returned pointer must not be dropped.
 IVolumeLightSceneNode* CSceneManager::addVolumeLightSceneNode(
@@ -946,6 +997,70 @@ ITerrainSceneNode* CSceneManager::addTerrainSceneNode(
 }
 
 
+//! Adds a paged terrain scene node to the scene graph.
+IPagedTerrainSceneNode* CSceneManager::addPagedTerrainSceneNode(
+	const io::path& heightMapFileName, u32 width,
+	s32 bitsPerPixel, bool signedData, bool floatVals,
+	ISceneNode* parent, s32 id,
+	const core::vector3df& position,
+	const core::vector3df& rotation,
+	const core::vector3df& scale,
+	video::SColor vertexColor, u32 chunkSize)
+{
+	io::IReadFile* file = FileSystem->createAndOpenFile(heightMapFileName);
+
+	if (!file)
+	{
+		os::Printer::log("Could not load paged terrain, because file could not be opened.",
+		heightMapFileName, ELL_ERROR);
+		return 0;
+	}
+
+	IPagedTerrainSceneNode* terrain = addPagedTerrainSceneNode(file, width,
+		bitsPerPixel, signedData, floatVals, parent, id,
+		position, rotation, scale, vertexColor, chunkSize);
+
+	file->drop();
+
+	return terrain;
+}
+
+
+//! Adds a paged terrain scene node to the scene graph.
+IPagedTerrainSceneNode* CSceneManager::addPagedTerrainSceneNode(
+	io::IReadFile* heightMapFile, u32 width,
+	s32 bitsPerPixel, bool signedData, bool floatVals,
+	ISceneNode* parent, s32 id,
+	const core::vector3df& position,
+	const core::vector3df& rotation,
+	const core::vector3df& scale,
+	video::SColor vertexColor, u32 chunkSize)
+{
+	if (!parent)
+		parent = this;
+
+	if (!heightMapFile)
+	{
+		os::Printer::log("Could not load paged terrain, because file could not be opened.", ELL_ERROR);
+		return 0;
+	}
+
+	CPagedTerrainSceneNode* node = new CPagedTerrainSceneNode(parent, this, id,
+		heightMapFile, width, bitsPerPixel, signedData, floatVals, chunkSize,
+		vertexColor, position, rotation, scale);
+
+	if (!node->isValid())
+	{
+		node->remove();
+		node->drop();
+		return 0;
+	}
+
+	node->drop();
+	return node;
+}
+
+
 //! Adds an empty scene node.
 ISceneNode* CSceneManager::addEmptySceneNode(ISceneNode* parent, s32 id)
 {
@@ -1552,8 +1667,16 @@ void CSceneManager::drawAll()
 		}
 		else
 		{
+			// billboards with the same texture follow each other after sorting
+			BillboardBatch.begin(Driver, ActiveCamera);
 			for (i=0; i<SolidNodeList.size(); ++i)
-				SolidNodeList[i].Node->render();
+			{
+				ISceneNode* node = SolidNodeList[i].Node;
+				if (node->getType() != ESNT_BILLBOARD)
+					BillboardBatch.flush();
+				node->render();
+			}
+			BillboardBatch.end();
 		}
 
 #ifdef _IRR_SCENEMANAGER_DEBUG
@@ -1619,8 +1742,15 @@ void CSceneManager::drawAll()
 		}
 		else
 		{
+			BillboardBatch.begin(Driver, ActiveCamera);
 			for (i=0; i<TransparentNodeList.size(); ++i)
-				TransparentNodeList[i].Node->render();
+			{
+				ISceneNode* node = TransparentNodeList[i].Node;
+				if (node->getType() != ESNT_BILLBOARD)
+					BillboardBatch.flush();
+				node->render();
+			}
+			BillboardBatch.end();
 		}
 
 #ifdef _IRR_SCENEMANAGER_DEBUG
@@ -1683,6 +1813,13 @@ void CSceneManager::setLightManager(ILightManager* lightManager)
 }
 
 
+//! Creates a light manager which switches on only the lights near each scene node.
+IClusteredLightManager* CSceneManager::createClusteredLightManager(const core::vector3d<u32>& clusterCount)
+{
+	return new CClusteredLightManager(this, clusterCount);
+}
+
+
 //! Sets the color of stencil buffers shadows drawn by the scene manager.
 void CSceneManager::setShadowColor(video::SColor color)
 {
@@ -13,6 +13,7 @@
 #include "IMeshLoader.h"
 #include "CAttributes.h"
 #include "ILightManager.h"
+#include "CBillboardBatch.h"
 
 namespace irr
 {
@@ -201,6 +202,10 @@ namespace scene
 		virtual IMeshSceneNode* addQuake3SceneNode(const IMeshBuffer* meshBuffer, const quake3::IShader * shader,
 			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
 
+		//! Adds a scene node drawing the geometry of a Quake3 level
+		virtual IMeshSceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
+
 
 		//! Adds a Hill Plane mesh to the mesh pool. The mesh is
 		//! generated on the fly and looks like a plane with some hills
@@ -267,6 +272,28 @@ namespace scene
 			s32 maxLOD=4, E_TERRAIN_PATCH_SIZE patchSize=ETPS_17,s32 smoothFactor=0,
 			bool addAlsoIfHeightmapEmpty=false) _IRR_OVERRIDE_;
 
+		//! Adds a paged terrain scene node to the scene graph.
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			const io::path& heightMapFileName, u32 width,
+			s32 bitsPerPixel=16, bool signedData=false, bool floatVals=false,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			video::SColor vertexColor = video::SColor(255,255,255,255),
+			u32 chunkSize=64) _IRR_OVERRIDE_;
+
+		//! Adds a paged terrain scene node to the scene graph.
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			io::IReadFile* heightMapFile, u32 width,
+			s32 bitsPerPixel=16, bool signedData=false, bool floatVals=false,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			video::SColor vertexColor = video::SColor(255,255,255,255),
+			u32 chunkSize=64) _IRR_OVERRIDE_;
+
 		//! Adds a dummy transformation scene node to the scene graph.
 		virtual IDummyTransformationSceneNode* addDummyTransformationSceneNode(
 			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
@@ -517,6 +544,9 @@ namespace scene
 		//! Register a custom callbacks manager which gets callbacks during scene rendering.
 		virtual void setLightManager(ILightManager* lightManager) _IRR_OVERRIDE_;
 
+		//! Creates a light manager which switches on only the lights near each scene node.
+		virtual IClusteredLightManager* createClusteredLightManager(const core::vector3d<u32>& clusterCount) _IRR_OVERRIDE_;
+
 		//! Get current render time.
 		virtual E_SCENE_NODE_RENDER_PASS getCurrentRenderPass() const _IRR_OVERRIDE_ { return CurrentRenderPass; }
 
@@ -529,11 +559,20 @@ namespace scene
 		//! returns if node is culled
 		virtual bool isCulled(const ISceneNode* node) const _IRR_OVERRIDE_;
 
+		//! Get the particle systems waiting for their simulation on the worker threads
+		virtual core::array<CParticleSystemSceneNode*>* getParticleSimulationQueue() _IRR_OVERRIDE_ { return &ParticleSimulationQueue; }
+
+		//! Get the batch collecting the quads of the billboards being rendered
+		virtual CBillboardBatch* getBillboardBatch() _IRR_OVERRIDE_ { return &BillboardBatch; }
+
 	private:
 
 		//! clears the deletion list
 		void clearDeletionList();
 
+		//! Replaces a static mesh by a mesh with levels of detail when MESH_LOD_LEVELS is set
+		IAnimatedMesh* createLODMeshOnLoad(IAnimatedMesh* mesh);
+
 		//! writes a scene node
 		void writeSceneNode(io::IXMLWriter* writer, ISceneNode* node, ISceneUserDataSerializer* userDataSerializer, const fschar_t* currentPath=0, bool init=false);
 
@@ -651,6 +690,12 @@ namespace scene
 		//! over the scene lighting and rendering.
 		ILightManager* LightManager;
 
+		//! Draws the billboards of the solid and transparent pass together
+		CBillboardBatch BillboardBatch;
+
+		//! Particle systems of this scene manager to be simulated together
+		core::array<CParticleSystemSceneNode*> ParticleSimulationQueue;
+
 		//! constants for reading and writing XML.
 		//! Not made static due to portability problems.
 		const core::stringw IRR_XML_FORMAT_SCENE;
@@ -10,6 +10,11 @@
 #include "SViewFrustum.h"
 #include "SLight.h"
 #include "os.h"
+#include "CWorkerPool.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
 
 namespace irr
 {
@@ -17,16 +22,100 @@ namespace scene
 {
 
 
+namespace
+{
+	//! Sets faceData[i] to true for faces with a normal pointing away from light.
+	/** normals holds the normals in blocks of 4 faces, faceData is padded to a
+	multiple of 4 faces. */
+	void classifyFaces(const f32* normals, u32 faceCount, const core::vector3df& light, bool* faceData)
+	{
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		const __m128 lx = _mm_set1_ps(light.X);
+		const __m128 ly = _mm_set1_ps(light.Y);
+		const __m128 lz = _mm_set1_ps(light.Z);
+		const __m128 zero = _mm_setzero_ps();
+		for (u32 i=0; i<faceCount; i+=4, normals+=12)
+		{
+			const __m128 d = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_loadu_ps(normals), lx),
+				_mm_mul_ps(_mm_loadu_ps(normals+4), ly)),
+				_mm_mul_ps(_mm_loadu_ps(normals+8), lz));
+			const int mask = _mm_movemask_ps(_mm_cmple_ps(d, zero));
+			faceData[i+0] = (mask & 1) != 0;
+			faceData[i+1] = (mask & 2) != 0;
+			faceData[i+2] = (mask & 4) != 0;
+			faceData[i+3] = (mask & 8) != 0;
+		}
+#else
+		for (u32 i=0; i<faceCount; i+=4, normals+=12)
+		{
+			for (u32 j=0; j<4; ++j)
+				faceData[i+j] = normals[j]*light.X + normals[j+4]*light.Y + normals[j+8]*light.Z <= 0.f;
+		}
+#endif
+	}
+
+	//! Vertex of the welded mesh, sorted by position
+	struct SWeldVertex
+	{
+		core::vector3df Pos;
+		u32 Index;
+
+		bool operator<(const SWeldVertex& other) const
+		{
+			if (Pos.X != other.Pos.X)
+				return Pos.X < other.Pos.X;
+			if (Pos.Y != other.Pos.Y)
+				return Pos.Y < other.Pos.Y;
+			if (Pos.Z != other.Pos.Z)
+				return Pos.Z < other.Pos.Z;
+			return Index < other.Index;
+		}
+	};
+
+	//! Edge of a face between two welded vertices, sorted by vertices and face
+	struct SFaceEdge
+	{
+		u32 V1;
+		u32 V2;
+		u32 Face;
+
+		bool operator<(const SFaceEdge& other) const
+		{
+			if (V1 != other.V1)
+				return V1 < other.V1;
+			if (V2 != other.V2)
+				return V2 < other.V2;
+			return Face < other.Face;
+		}
+	};
+}
+
+
+//! Creates the outdated shadow volumes on the worker threads
+struct CShadowVolumeSceneNode::SCreateJob
+{
+	CShadowVolumeSceneNode* Node;
+
+	void operator()(u32 begin, u32 end, u32 worker) const
+	{
+		for (u32 i=begin; i<end; ++i)
+			Node->createShadowVolume(Node->Outdated[i], Node->Scratch[worker]);
+	}
+};
+
+
 //! constructor
 CShadowVolumeSceneNode::CShadowVolumeSceneNode(const IMesh* shadowMesh, ISceneNode* parent,
 		ISceneManager* mgr, s32 id, bool zfailmethod, f32 infinity)
 : IShadowVolumeSceneNode(parent, mgr, id),
-	ShadowMesh(0), IndexCount(0), VertexCount(0), ShadowVolumesUsed(0),
+	ShadowMesh(0), IndexCount(0), VertexCount(0), ShadowVolumesUsed(0), Geometry(1),
 	Infinity(infinity), UseZFailMethod(zfailmethod)
 {
 	#ifdef _DEBUG
 	setDebugName("CShadowVolumeSceneNode");
 	#endif
+	Scratch.push_back(SScratch());
 	setShadowMesh(shadowMesh);
 	setAutomaticCulling(scene::EAC_OFF);
 }
@@ -40,159 +129,145 @@ CShadowVolumeSceneNode::~CShadowVolumeSceneNode()
 }
 
 
-void CShadowVolumeSceneNode::createShadowVolume(const core::vector3df& light, bool isDirectional)
+void CShadowVolumeSceneNode::createShadowVolume(u32 volume, SScratch& scratch)
 {
-	SShadowVolume* svp = 0;
-	core::aabbox3d<f32>* bb = 0;
-
-	// builds the shadow volume and adds it to the shadow volume list.
+	// builds the shadow volume for the light of the volume
+	const core::vector3df light = ShadowLights[volume];
+	SShadowVolume& svp = ShadowVolumes[volume];
+	core::aabbox3d<f32>& bb = ShadowBBox[volume];
+	const u32 faceCount = IndexCount / 3;
 
-	if (ShadowVolumes.size() > ShadowVolumesUsed)
-	{
-		// get the next unused buffer
+	// Check every face if it is front or back facing the light.
+	scratch.FaceData.set_used(FaceNormals.size() / 3);
+	classifyFaces(FaceNormals.const_pointer(), scratch.FaceData.size(), light, scratch.FaceData.pointer());
 
-		svp = &ShadowVolumes[ShadowVolumesUsed];
-		svp->set_used(0);
+	// We use triangle lists
+	scratch.Edges.set_used(IndexCount*2);
+	const u32 numEdges = createEdges(scratch);
 
-		bb = &ShadowBBox[ShadowVolumesUsed];
-	}
-	else
+	u32 capFaces = 0;
+	if (UseZFailMethod)
 	{
-		ShadowVolumes.push_back(SShadowVolume());
-		svp = &ShadowVolumes.getLast();
+		for (u32 i=0; i<faceCount; ++i)
+		{
+			if (scratch.FaceData[i])
+				++capFaces;
+		}
 
-		ShadowBBox.push_back(core::aabbox3d<f32>());
-		bb = &ShadowBBox.getLast();
+		// move all vertices to infinity once, caps and edges share them
+		scratch.Extruded.set_used(VertexCount);
+		for (u32 i=0; i<VertexCount; ++i)
+			scratch.Extruded[i] = Vertices[i]+(Vertices[i]-light).normalize()*Infinity;
 	}
-	svp->reallocate(IndexCount*5);
-	++ShadowVolumesUsed;
 
-	// We use triangle lists
-	Edges.set_used(IndexCount*2);
-	u32 numEdges = 0;
+	svp.set_used(0);
+	svp.reallocate(capFaces*6 + numEdges*6);
 
-	numEdges=createEdgesAndCaps(light, svp, bb);
+	if (faceCount >= 1)
+		bb.reset(Vertices[Indices[0]]);
+	else
+		bb.reset(0,0,0);
+
+	for (u32 i=0; capFaces && i<faceCount; ++i)
+	{
+		if (!scratch.FaceData[i])
+			continue;
+
+		// add front cap from light-facing faces
+		svp.push_back(Vertices[Indices[3*i+2]]);
+		svp.push_back(Vertices[Indices[3*i+1]]);
+		svp.push_back(Vertices[Indices[3*i+0]]);
+
+		// add back cap
+		const core::vector3df& i0 = scratch.Extruded[Indices[3*i+0]];
+		const core::vector3df& i1 = scratch.Extruded[Indices[3*i+1]];
+		const core::vector3df& i2 = scratch.Extruded[Indices[3*i+2]];
+
+		svp.push_back(i0);
+		svp.push_back(i1);
+		svp.push_back(i2);
+
+		bb.addInternalPoint(i0);
+		bb.addInternalPoint(i1);
+		bb.addInternalPoint(i2);
+	}
 
 	// for all edges add the near->far quads
 	for (u32 i=0; i<numEdges; ++i)
 	{
-		const core::vector3df &v1 = Vertices[Edges[2*i+0]];
-		const core::vector3df &v2 = Vertices[Edges[2*i+1]];
-		const core::vector3df v3(v1+(v1 - light).normalize()*Infinity);
-		const core::vector3df v4(v2+(v2 - light).normalize()*Infinity);
+		const u32 e1 = scratch.Edges[2*i+0];
+		const u32 e2 = scratch.Edges[2*i+1];
+		const core::vector3df &v1 = Vertices[e1];
+		const core::vector3df &v2 = Vertices[e2];
+		const core::vector3df v3(UseZFailMethod ? scratch.Extruded[e1] : v1+(v1 - light).normalize()*Infinity);
+		const core::vector3df v4(UseZFailMethod ? scratch.Extruded[e2] : v2+(v2 - light).normalize()*Infinity);
 
 		// Add a quad (two triangles) to the vertex list
-#ifdef _DEBUG
-		if (svp->size() >= svp->allocated_size()-5)
-			os::Printer::log("Allocation too small.", ELL_DEBUG);
-#endif
-		svp->push_back(v1);
-		svp->push_back(v2);
-		svp->push_back(v3);
+		svp.push_back(v1);
+		svp.push_back(v2);
+		svp.push_back(v3);
 
-		svp->push_back(v2);
-		svp->push_back(v4);
-		svp->push_back(v3);
+		svp.push_back(v2);
+		svp.push_back(v4);
+		svp.push_back(v3);
 	}
+
+	ShadowGeometry[volume] = Geometry;
 }
 
 
 #define IRR_USE_ADJACENCY
 #define IRR_USE_REVERSE_EXTRUDED
 
-u32 CShadowVolumeSceneNode::createEdgesAndCaps(const core::vector3df& light,
-					SShadowVolume* svp, core::aabbox3d<f32>* bb)
+u32 CShadowVolumeSceneNode::createEdges(SScratch& scratch) const
 {
 	u32 numEdges=0;
 	const u32 faceCount = IndexCount / 3;
+	const bool* faceData = scratch.FaceData.const_pointer();
+	u32* edges = scratch.Edges.pointer();
 
-	if(faceCount >= 1)
-		bb->reset(Vertices[Indices[0]]);
-	else
-		bb->reset(0,0,0);
-
-	// Check every face if it is front or back facing the light.
-	for (u32 i=0; i<faceCount; ++i)
-	{
-		const core::vector3df v0 = Vertices[Indices[3*i+0]];
-		const core::vector3df v1 = Vertices[Indices[3*i+1]];
-		const core::vector3df v2 = Vertices[Indices[3*i+2]];
-
-#ifdef IRR_USE_REVERSE_EXTRUDED
-		FaceData[i]=core::triangle3df(v0,v1,v2).isFrontFacing(light);
-#else
-		FaceData[i]=core::triangle3df(v2,v1,v0).isFrontFacing(light);
-#endif
-
-		if (UseZFailMethod && FaceData[i])
-		{
-#ifdef _DEBUG
-			if (svp->size() >= svp->allocated_size()-5)
-				os::Printer::log("Allocation too small.", ELL_DEBUG);
-#endif
-			// add front cap from light-facing faces
-			svp->push_back(v2);
-			svp->push_back(v1);
-			svp->push_back(v0);
-
-			// add back cap
-			const core::vector3df i0 = v0+(v0-light).normalize()*Infinity;
-			const core::vector3df i1 = v1+(v1-light).normalize()*Infinity;
-			const core::vector3df i2 = v2+(v2-light).normalize()*Infinity;
-
-			svp->push_back(i0);
-			svp->push_back(i1);
-			svp->push_back(i2);
-
-			bb->addInternalPoint(i0);
-			bb->addInternalPoint(i1);
-			bb->addInternalPoint(i2);
-		}
-	}
-
-	// Create edges
 	for (u32 i=0; i<faceCount; ++i)
 	{
 		// check all front facing faces
-		if (FaceData[i] == true)
+		if (faceData[i] == true)
 		{
-			const u16 wFace0 = Indices[3*i+0];
-			const u16 wFace1 = Indices[3*i+1];
-			const u16 wFace2 = Indices[3*i+2];
+			const u32 wFace0 = Indices[3*i+0];
+			const u32 wFace1 = Indices[3*i+1];
+			const u32 wFace2 = Indices[3*i+2];
 
-			const u16 adj0 = Adjacency[3*i+0];
-			const u16 adj1 = Adjacency[3*i+1];
-			const u16 adj2 = Adjacency[3*i+2];
+			const u32 adj0 = Adjacency[3*i+0];
+			const u32 adj1 = Adjacency[3*i+1];
+			const u32 adj2 = Adjacency[3*i+2];
 
 			// add edges if face is adjacent to back-facing face
 			// or if no adjacent face was found
 #ifdef IRR_USE_ADJACENCY
-			if (adj0 == i || FaceData[adj0] == false)
+			if (adj0 == i || faceData[adj0] == false)
 #endif
 			{
 				// add edge v0-v1
-				Edges[2*numEdges+0] = wFace0;
-				Edges[2*numEdges+1] = wFace1;
+				edges[2*numEdges+0] = wFace0;
+				edges[2*numEdges+1] = wFace1;
 				++numEdges;
 			}
 
 #ifdef IRR_USE_ADJACENCY
-			if (adj1 == i || FaceData[adj1] == false)
+			if (adj1 == i || faceData[adj1] == false)
 #endif
 			{
 				// add edge v1-v2
-				Edges[2*numEdges+0] = wFace1;
-				Edges[2*numEdges+1] = wFace2;
+				edges[2*numEdges+0] = wFace1;
+				edges[2*numEdges+1] = wFace2;
 				++numEdges;
 			}
 
 #ifdef IRR_USE_ADJACENCY
-			if (adj2 == i || FaceData[adj2] == false)
+			if (adj2 == i || faceData[adj2] == false)
 #endif
 			{
 				// add edge v2-v0
-				Edges[2*numEdges+0] = wFace2;
-				Edges[2*numEdges+1] = wFace0;
+				edges[2*numEdges+0] = wFace2;
+				edges[2*numEdges+1] = wFace0;
 				++numEdges;
 			}
 		}
@@ -208,6 +283,7 @@ void CShadowVolumeSceneNode::setShadowMesh(const IMesh* mesh)
 	if (ShadowMesh)
 		ShadowMesh->drop();
 	ShadowMesh = mesh;
+	BufferStates.clear();
 	if (ShadowMesh)
 	{
 		ShadowMesh->grab();
@@ -216,70 +292,120 @@ void CShadowVolumeSceneNode::setShadowMesh(const IMesh* mesh)
 }
 
 
-void CShadowVolumeSceneNode::updateShadowVolumes()
+//! Copies the shadow mesh if it changed since the last copy
+void CShadowVolumeSceneNode::updateMeshCopy()
 {
-	const u32 oldIndexCount = IndexCount;
-	const u32 oldVertexCount = VertexCount;
-
 	const IMesh* const mesh = ShadowMesh;
-	if (!mesh)
-		return;
+	const u32 bufcnt = mesh->getMeshBufferCount();
 
-	// create as much shadow volumes as there are lights but
-	// do not ignore the max light settings.
-	const u32 lightCount = SceneManager->getVideoDriver()->getDynamicLightCount();
-	if (!lightCount)
+	bool indicesChanged = BufferStates.size() != bufcnt;
+	bool verticesChanged = false;
+	for (u32 i=0; i<bufcnt && !indicesChanged; ++i)
+	{
+		const IMeshBuffer* buf = mesh->getMeshBuffer(i);
+		const SBufferState& state = BufferStates[i];
+		if (state.Buffer != buf || state.VertexCount != buf->getVertexCount() ||
+			state.IndexCount != buf->getIndexCount() || state.ChangedID_Index != buf->getChangedID_Index())
+			indicesChanged = true;
+		else if (state.ChangedID_Vertex != buf->getChangedID_Vertex())
+			verticesChanged = true;
+	}
+	if (!indicesChanged && !verticesChanged)
 		return;
 
 	// calculate total amount of vertices and indices
-
-	VertexCount = 0;
-	IndexCount = 0;
-	ShadowVolumesUsed = 0;
-
 	u32 i;
 	u32 totalVertices = 0;
 	u32 totalIndices = 0;
-	const u32 bufcnt = mesh->getMeshBufferCount();
-
+	BufferStates.set_used(bufcnt);
 	for (i=0; i<bufcnt; ++i)
 	{
 		const IMeshBuffer* buf = mesh->getMeshBuffer(i);
-		totalIndices += buf->getIndexCount();
-		totalVertices += buf->getVertexCount();
+		SBufferState& state = BufferStates[i];
+		state.Buffer = buf;
+		state.VertexCount = buf->getVertexCount();
+		state.IndexCount = buf->getIndexCount();
+		state.ChangedID_Vertex = buf->getChangedID_Vertex();
+		state.ChangedID_Index = buf->getChangedID_Index();
+		totalIndices += state.IndexCount;
+		totalVertices += state.VertexCount;
 	}
 
 	// allocate memory if necessary
-
+	bool topologyChanged = false;
 	Vertices.set_used(totalVertices);
-	Indices.set_used(totalIndices);
-	FaceData.set_used(totalIndices / 3);
+	if (indicesChanged && Indices.size() != totalIndices)
+	{
+		Indices.set_used(totalIndices);
+		topologyChanged = true;
+	}
 
-	// copy mesh
+	// copy mesh, animated meshes may use other buffers with the same indices
+	VertexCount = 0;
+	IndexCount = 0;
 	for (i=0; i<bufcnt; ++i)
 	{
 		const IMeshBuffer* buf = mesh->getMeshBuffer(i);
 
-		const u16* idxp = buf->getIndices();
-		const u16* idxpend = idxp + buf->getIndexCount();
-		for (; idxp!=idxpend; ++idxp)
-			Indices[IndexCount++] = *idxp + VertexCount;
+		const u32 idxcnt = buf->getIndexCount();
+		if (!indicesChanged)
+			IndexCount += idxcnt;
+		else if (buf->getIndexType() == video::EIT_32BIT)
+		{
+			const u32* idxp = (const u32*)buf->getIndices();
+			for (u32 j=0; j<idxcnt; ++j, ++IndexCount)
+			{
+				const u32 index = idxp[j] + VertexCount;
+				topologyChanged |= Indices[IndexCount] != index;
+				Indices[IndexCount] = index;
+			}
+		}
+		else
+		{
+			const u16* idxp = buf->getIndices();
+			for (u32 j=0; j<idxcnt; ++j, ++IndexCount)
+			{
+				const u32 index = idxp[j] + VertexCount;
+				topologyChanged |= Indices[IndexCount] != index;
+				Indices[IndexCount] = index;
+			}
+		}
 
 		const u32 vtxcnt = buf->getVertexCount();
 		for (u32 j=0; j<vtxcnt; ++j)
 			Vertices[VertexCount++] = buf->getPosition(j);
 	}
 
-	// recalculate adjacency if necessary
-	if (oldVertexCount != VertexCount || oldIndexCount != IndexCount)
+	// adjacency stays the same while only vertices move
+	if (topologyChanged)
 		calculateAdjacency();
+	calculateFaceNormals();
+	++Geometry;
+}
+
+
+void CShadowVolumeSceneNode::updateShadowVolumes()
+{
+	const IMesh* const mesh = ShadowMesh;
+	if (!mesh)
+		return;
+
+	// create as much shadow volumes as there are lights but
+	// do not ignore the max light settings.
+	const u32 lightCount = SceneManager->getVideoDriver()->getDynamicLightCount();
+	if (!lightCount)
+		return;
+
+	updateMeshCopy();
+	ShadowVolumesUsed = 0;
+	Outdated.set_used(0);
 
 	core::matrix4 mat = Parent->getAbsoluteTransformation();
 	mat.makeInverse();
 	const core::vector3df parentpos = Parent->getAbsolutePosition();
 
 	// TODO: Only correct for point lights.
-	for (i=0; i<lightCount; ++i)
+	for (u32 i=0; i<lightCount; ++i)
 	{
 		const video::SLight& dl = SceneManager->getVideoDriver()->getDynamicLight(i);
 		core::vector3df lpos = dl.Position;
@@ -287,9 +413,41 @@ void CShadowVolumeSceneNode::updateShadowVolumes()
 			fabs((lpos - parentpos).getLengthSQ()) <= (dl.Radius*dl.Radius*4.0f))
 		{
 			mat.transformVect(lpos);
-			createShadowVolume(lpos);
+
+			if (ShadowVolumes.size() == ShadowVolumesUsed)
+			{
+				ShadowVolumes.push_back(SShadowVolume());
+				ShadowBBox.push_back(core::aabbox3d<f32>());
+				ShadowLights.push_back(lpos);
+				ShadowGeometry.push_back(0);
+			}
+
+			// keep volumes whose light did not move relative to the unchanged mesh
+			if (ShadowGeometry[ShadowVolumesUsed] != Geometry || ShadowLights[ShadowVolumesUsed] != lpos)
+			{
+				ShadowLights[ShadowVolumesUsed] = lpos;
+				Outdated.push_back(ShadowVolumesUsed);
+			}
+			++ShadowVolumesUsed;
 		}
 	}
+
+	// create the volumes of several lights in parallel, if it is worth it
+	if (Outdated.size() > 1 && IndexCount >= 3*1024)
+	{
+		CWorkerPool& pool = CWorkerPool::getInstance();
+		while (Scratch.size() < pool.getWorkerCount())
+			Scratch.push_back(SScratch());
+
+		SCreateJob job;
+		job.Node = this;
+		pool.parallelFor(Outdated.size(), 1, job);
+	}
+	else
+	{
+		for (u32 i=0; i<Outdated.size(); ++i)
+			createShadowVolume(Outdated[i], Scratch[0]);
+	}
 }
 
 
@@ -369,47 +527,129 @@ const core::aabbox3d<f32>& CShadowVolumeSceneNode::getBoundingBox() const
 //! Generates adjacency information based on mesh indices.
 void CShadowVolumeSceneNode::calculateAdjacency()
 {
-	Adjacency.set_used(IndexCount);
+	// vertices at the same position get the same id
+	core::array<SWeldVertex> sorted;
+	sorted.set_used(VertexCount);
+	for (u32 i=0; i<VertexCount; ++i)
+	{
+		sorted[i].Pos = Vertices[i];
+		sorted[i].Index = i;
+	}
+	core::heapsort(sorted.pointer(), sorted.size());
+
+	core::array<u32> weld;
+	weld.set_used(VertexCount);
+	for (u32 i=0; i<VertexCount; ++i)
+	{
+		if (i && sorted[i].Pos == sorted[i-1].Pos)
+			weld[sorted[i].Index] = weld[sorted[i-1].Index];
+		else
+			weld[sorted[i].Index] = i;
+	}
 
-	// go through all faces and fetch their three neighbours
+	// sort the edges of all faces, so faces sharing an edge are next to each other
+	core::array<SFaceEdge> edges;
+	edges.set_used(IndexCount);
+	// first two faces using each vertex, for the collapsed edges of degenerated faces
+	core::array<u32> vertexFaces;
+	vertexFaces.set_used(VertexCount*2);
+	for (u32 i=0; i<vertexFaces.size(); ++i)
+		vertexFaces[i] = 0xffffffff;
 	for (u32 f=0; f<IndexCount; f+=3)
 	{
 		for (u32 edge = 0; edge<3; ++edge)
 		{
-			const core::vector3df& v1 = Vertices[Indices[f+edge]];
-			const core::vector3df& v2 = Vertices[Indices[f+((edge+1)%3)]];
+			const u32 v1 = weld[Indices[f+edge]];
+			const u32 v2 = weld[Indices[f+((edge+1)%3)]];
+			SFaceEdge& e = edges[f+edge];
+			e.V1 = core::min_(v1, v2);
+			e.V2 = core::max_(v1, v2);
+			e.Face = f/3;
+
+			if (vertexFaces[2*v1] == 0xffffffff)
+				vertexFaces[2*v1] = f/3;
+			else if (vertexFaces[2*v1] != f/3 && vertexFaces[2*v1+1] == 0xffffffff)
+				vertexFaces[2*v1+1] = f/3;
+		}
+	}
+	core::heapsort(edges.pointer(), edges.size());
 
-			// now we search an_O_ther _F_ace with these two
-			// vertices, which is not the current face.
-			u32 of;
+	// for each edge find the first other face with this edge,
+	// no adjacent edges -> store face number, else store adjacent face
+	Adjacency.set_used(IndexCount);
+	for (u32 f=0; f<IndexCount; f+=3)
+	{
+		for (u32 edge = 0; edge<3; ++edge)
+		{
+			const u32 v1 = weld[Indices[f+edge]];
+			const u32 v2 = weld[Indices[f+((edge+1)%3)]];
+			Adjacency[f + edge] = f/3;
 
-			for (of=0; of<IndexCount; of+=3)
+			// a collapsed edge is shared with every face using its vertex
+			if (v1 == v2)
 			{
-				// only other faces
-				if (of != f)
+				const u32 other = vertexFaces[2*v1] != f/3 ? vertexFaces[2*v1] : vertexFaces[2*v1+1];
+				if (other != 0xffffffff)
+					Adjacency[f + edge] = other;
+				continue;
+			}
+
+			SFaceEdge key;
+			key.V1 = core::min_(v1, v2);
+			key.V2 = core::max_(v1, v2);
+			key.Face = 0;
+
+			// first edge not below the key
+			u32 first = 0;
+			u32 last = edges.size();
+			while (first < last)
+			{
+				const u32 middle = (first + last) / 2;
+				if (edges[middle] < key)
+					first = middle + 1;
+				else
+					last = middle;
+			}
+
+			for (; first<edges.size() && edges[first].V1 == key.V1 && edges[first].V2 == key.V2; ++first)
+			{
+				if (edges[first].Face != f/3)
 				{
-					bool cnt1 = false;
-					bool cnt2 = false;
-
-					for (s32 e=0; e<3; ++e)
-					{
-						if (v1.equals(Vertices[Indices[of+e]]))
-							cnt1=true;
-
-						if (v2.equals(Vertices[Indices[of+e]]))
-							cnt2=true;
-					}
-					// one match for each vertex, i.e. edge is the same
-					if (cnt1 && cnt2)
-						break;
+					Adjacency[f + edge] = edges[first].Face;
+					break;
 				}
 			}
+		}
+	}
+}
 
-			// no adjacent edges -> store face number, else store adjacent face
-			if (of >= IndexCount)
-				Adjacency[f + edge] = f/3;
-			else
-				Adjacency[f + edge] = of/3;
+
+//! Calculates the face normals, used to find the faces turned towards a light
+void CShadowVolumeSceneNode::calculateFaceNormals()
+{
+	const u32 faceCount = IndexCount / 3;
+	FaceNormals.set_used(((faceCount + 3) & ~3) * 3);
+
+	for (u32 i=0; i<FaceNormals.size(); i+=12)
+	{
+		for (u32 j=0; j<4; ++j)
+		{
+			const u32 face = i/3 + j;
+			core::vector3df normal;
+			if (face < faceCount)
+			{
+				const core::vector3df& v0 = Vertices[Indices[3*face+0]];
+				const core::vector3df& v1 = Vertices[Indices[3*face+1]];
+				const core::vector3df& v2 = Vertices[Indices[3*face+2]];
+#ifdef IRR_USE_REVERSE_EXTRUDED
+				normal = core::triangle3df(v0,v1,v2).getNormal().normalize();
+#else
+				normal = core::triangle3df(v2,v1,v0).getNormal().normalize();
+#endif
+			}
+			FaceNormals[i+j] = normal.X;
+			FaceNormals[i+j+4] = normal.Y;
+			FaceNormals[i+j+8] = normal.Z;
 		}
 	}
 }
@@ -49,12 +49,40 @@ namespace scene
 
 		typedef core::array<core::vector3df> SShadowVolume;
 
-		void createShadowVolume(const core::vector3df& pos, bool isDirectional=false);
-		u32 createEdgesAndCaps(const core::vector3df& light, SShadowVolume* svp, core::aabbox3d<f32>* bb);
+		//! State of a mesh buffer when it was copied
+		struct SBufferState
+		{
+			const IMeshBuffer* Buffer;
+			u32 VertexCount;
+			u32 IndexCount;
+			u32 ChangedID_Vertex;
+			u32 ChangedID_Index;
+		};
+
+		//! Memory used while creating a shadow volume, one for each worker thread
+		struct SScratch
+		{
+			core::array<u32> Edges;
+			// tells if face is front facing
+			core::array<bool> FaceData;
+			// vertices moved to infinity
+			core::array<core::vector3df> Extruded;
+		};
+
+		struct SCreateJob;
+
+		void createShadowVolume(u32 volume, SScratch& scratch);
+		u32 createEdges(SScratch& scratch) const;
+
+		//! Copies the shadow mesh if it changed since the last copy
+		void updateMeshCopy();
 
 		//! Generates adjacency information based on mesh indices.
 		void calculateAdjacency();
 
+		//! Calculates the face normals, used to find the faces turned towards a light
+		void calculateFaceNormals();
+
 		core::aabbox3d<f32> Box;
 
 		// a shadow volume for every light
@@ -63,18 +91,28 @@ namespace scene
 		// a back cap bounding box for every light
 		core::array<core::aabbox3d<f32> > ShadowBBox;
 
+		// light position in object space and geometry version of every shadow volume
+		core::array<core::vector3df> ShadowLights;
+		core::array<u32> ShadowGeometry;
+
+		// shadow volumes to create in this update
+		core::array<u32> Outdated;
+
+		core::array<SBufferState> BufferStates;
 		core::array<core::vector3df> Vertices;
-		core::array<u16> Indices;
-		core::array<u16> Adjacency;
-		core::array<u16> Edges;
-		// tells if face is front facing
-		core::array<bool> FaceData;
+		core::array<u32> Indices;
+		core::array<u32> Adjacency;
+		// face normals in blocks of 4 faces: 4 X, 4 Y and 4 Z values
+		core::array<f32> FaceNormals;
+		core::array<SScratch> Scratch;
 
 		const scene::IMesh* ShadowMesh;
 
 		u32 IndexCount;
 		u32 VertexCount;
 		u32 ShadowVolumesUsed;
+		// increased whenever the vertices change
+		u32 Geometry;
 
 		f32 Infinity;
 
@@ -0,0 +1,142 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSkylinePacker.h"
+#include "irrMath.h"
+
+namespace irr
+{
+namespace core
+{
+
+CSkylinePacker::CSkylinePacker(const dimension2d<u32>& pageSize, u32 padding)
+	: PageSize(pageSize), Padding(padding)
+{
+}
+
+
+bool CSkylinePacker::insert(const dimension2d<u32>& size, u32& page, position2d<u32>& pos)
+{
+	if (!size.Width || !size.Height || size.Width > PageSize.Width || size.Height > PageSize.Height)
+		return false;
+
+	// the padding goes right and below each rectangle, it may stick out of the page
+	const u32 width = size.Width + Padding;
+	const u32 height = size.Height + Padding;
+
+	for (u32 p=0; p<=Pages.size(); ++p)
+	{
+		if (p == Pages.size())
+		{
+			Pages.push_back(array<SSegment>());
+			Pages.getLast().push_back(SSegment(0, 0, PageSize.Width + Padding));
+		}
+
+		array<SSegment>& skyline = Pages[p];
+
+		// bottom left: the lowest top edge, then the narrowest segment
+		s32 best = -1;
+		u32 bestY = 0;
+		u32 bestWidth = 0;
+		for (u32 i=0; i<skyline.size(); ++i)
+		{
+			u32 y;
+			if (!fit(skyline, i, width, height, y))
+				continue;
+			if (best < 0 || y < bestY ||
+				(y == bestY && skyline[i].Width < bestWidth))
+			{
+				best = i;
+				bestY = y;
+				bestWidth = skyline[i].Width;
+			}
+		}
+
+		if (best >= 0)
+		{
+			page = p;
+			pos.X = skyline[best].X;
+			pos.Y = bestY;
+			place(skyline, best, bestY, width, height);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+u32 CSkylinePacker::getPageCount() const
+{
+	return Pages.size();
+}
+
+
+u32 CSkylinePacker::getUsedHeight(u32 page) const
+{
+	u32 height = 0;
+	if (page < Pages.size())
+	{
+		for (u32 i=0; i<Pages[page].size(); ++i)
+			height = max_(height, Pages[page][i].Y);
+	}
+	return min_(height, PageSize.Height);
+}
+
+
+bool CSkylinePacker::fit(const array<SSegment>& skyline, u32 index, u32 width, u32 height, u32& y) const
+{
+	const u32 x = skyline[index].X;
+	if (x + width > PageSize.Width + Padding)
+		return false;
+
+	// the rectangle rests on the highest segment below it
+	y = 0;
+	u32 covered = 0;
+	for (u32 i=index; covered < width; ++i)
+	{
+		y = max_(y, skyline[i].Y);
+		if (y + height > PageSize.Height + Padding)
+			return false;
+		covered += skyline[i].Width;
+	}
+	return true;
+}
+
+
+void CSkylinePacker::place(array<SSegment>& skyline, u32 index, u32 y, u32 width, u32 height)
+{
+	const u32 right = skyline[index].X + width;
+	skyline.insert(SSegment(skyline[index].X, y + height, width), index);
+
+	// cut the segments under the rectangle
+	u32 i = index + 1;
+	while (i < skyline.size() && skyline[i].X < right)
+	{
+		const u32 end = skyline[i].X + skyline[i].Width;
+		if (end <= right)
+			skyline.erase(i);
+		else
+		{
+			skyline[i].Width = end - right;
+			skyline[i].X = right;
+			break;
+		}
+	}
+
+	// merge neighbours of the same height
+	for (i=0; i+1 < skyline.size(); )
+	{
+		if (skyline[i].Y == skyline[i+1].Y)
+		{
+			skyline[i].Width += skyline[i+1].Width;
+			skyline.erase(i+1);
+		}
+		else
+			++i;
+	}
+}
+
+} // end namespace core
+} // end namespace irr
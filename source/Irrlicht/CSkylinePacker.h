@@ -0,0 +1,71 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_SKYLINE_PACKER_H_INCLUDED__
+#define __C_SKYLINE_PACKER_H_INCLUDED__
+
+#include "irrArray.h"
+#include "dimension2d.h"
+#include "position2d.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Packs rectangles into pages of a fixed size
+/** Each page keeps its skyline, the top edge of the area used so far, as a
+list of horizontal segments. A rectangle goes to the segment where its top
+edge ends lowest, on the first page with room for it. Packing rectangles
+sorted by decreasing height gives the tightest result. */
+class CSkylinePacker
+{
+public:
+
+	//! Constructor
+	/** \param pageSize Size of each page.
+	\param padding Space kept free between the rectangles. */
+	CSkylinePacker(const dimension2d<u32>& pageSize, u32 padding);
+
+	//! Finds a place for a rectangle, a new page is started if none has room
+	/** \param size Size of the rectangle.
+	\param page Receives the index of the page.
+	\param pos Receives the upper left corner on the page.
+	\return False if the rectangle is larger than a page. */
+	bool insert(const dimension2d<u32>& size, u32& page, position2d<u32>& pos);
+
+	//! Returns the number of pages started so far
+	u32 getPageCount() const;
+
+	//! Returns the height of the used area of a page
+	u32 getUsedHeight(u32 page) const;
+
+private:
+
+	// horizontal segment of the skyline
+	struct SSegment
+	{
+		SSegment() : X(0), Y(0), Width(0) {}
+		SSegment(u32 x, u32 y, u32 width) : X(x), Y(y), Width(width) {}
+
+		u32 X;
+		u32 Y;
+		u32 Width;
+	};
+
+	// returns the lowest top edge of a rectangle placed at segment index, or false if it doesn't fit
+	bool fit(const array<SSegment>& skyline, u32 index, u32 width, u32 height, u32& y) const;
+
+	// raises the skyline under a placed rectangle
+	void place(array<SSegment>& skyline, u32 index, u32 y, u32 width, u32 height);
+
+	array< array<SSegment> > Pages;
+	dimension2d<u32> PageSize;
+	u32 Padding;
+};
+
+} // end namespace core
+} // end namespace irr
+
+#endif
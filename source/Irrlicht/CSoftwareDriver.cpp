@@ -252,6 +252,12 @@ ITexture* CSoftwareDriver::createDeviceDependentTexture(const io::path& name, II
 	return texture;
 }
 
+//! textures are created from images in ECF_A1R5G5B5 without conversion
+ECOLOR_FORMAT CSoftwareDriver::getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const
+{
+	return ECF_A1R5G5B5;
+}
+
 bool CSoftwareDriver::setRenderTargetEx(IRenderTarget* target, u16 clearFlag, SColor clearColor, f32 clearDepth, u8 clearStencil)
 {
 	if (target && target->getDriverType() != EDT_SOFTWARE)
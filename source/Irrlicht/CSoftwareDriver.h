@@ -100,6 +100,9 @@ namespace video
 
 		virtual ITexture* createDeviceDependentTexture(const io::path& name, IImage* image) _IRR_OVERRIDE_;
 
+		//! textures are created from images in ECF_A1R5G5B5 without conversion
+		virtual ECOLOR_FORMAT getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const _IRR_OVERRIDE_;
+
 		//! Creates a render target texture.
 		virtual ITexture* addRenderTargetTexture(const core::dimension2d<u32>& size,
 				const io::path& name, const ECOLOR_FORMAT format = ECF_UNKNOWN) _IRR_OVERRIDE_;
@@ -27,7 +27,7 @@ namespace video
 CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io, video::IImagePresenter* presenter)
 : CNullDriver(io, params.WindowSize), BackBuffer(0), Presenter(presenter),
 	WindowId(0), SceneSourceRect(0),
-	RenderTargetTexture(0), RenderTargetSurface(0), CurrentShader(0),
+	RenderTargetTexture(0), RenderTargetSurface(0), RenderTargetDepthOnly(false), CurrentShader(0),
 	 DepthBuffer(0), StencilBuffer ( 0 ),
 	 CurrentOut ( 16 * 2, 256 ), Temp ( 16 * 2, 256 )
 {
@@ -87,6 +87,7 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 
 	BurningShader[ETR_NORMAL_MAP_SOLID] = createTRNormalMap ( this );
 	BurningShader[ETR_STENCIL_SHADOW] = createTRStencilShadow ( this );
+	BurningShader[ETR_DEPTH_WRITE] = createTRDepthWrite ( this );
 	BurningShader[ETR_TEXTURE_BLEND] = createTRTextureBlend( this );
 
 	BurningShader[ETR_REFERENCE] = createTriangleRendererReference ( this );
@@ -276,6 +277,12 @@ void CBurningVideoDriver::setCurrentShader()
 		shader = ETR_TEXTURE_GOURAUD_WIRE;
 	}
 
+	// all materials only write depth into a shadow map
+	if ( RenderTargetDepthOnly )
+	{
+		shader = ETR_DEPTH_WRITE;
+	}
+
 	//shader = ETR_REFERENCE;
 
 	// switchToTriangleRenderer
@@ -325,6 +332,7 @@ bool CBurningVideoDriver::queryFeature(E_VIDEO_DRIVER_FEATURE feature) const
 	case EVDF_MULTITEXTURE:
 	case EVDF_HARDWARE_TL:
 	case EVDF_TEXTURE_NSQUARE:
+	case EVDF_TEXTURE_COMPRESSED_DXT:
 		return true;
 
 	default:
@@ -423,6 +431,12 @@ bool CBurningVideoDriver::setRenderTargetEx(IRenderTarget* target, u16 clearFlag
 	CSoftwareRenderTarget2* renderTarget = static_cast<CSoftwareRenderTarget2*>(target);
 	RenderTargetTexture = (renderTarget) ? renderTarget->getTexture() : 0;
 
+	// a render target with only a depth texture renders a shadow map
+	const bool depthOnly = RenderTargetDepthOnly;
+	RenderTargetDepthOnly = !RenderTargetTexture && renderTarget && renderTarget->getDepthStencil();
+	if (RenderTargetDepthOnly)
+		RenderTargetTexture = renderTarget->getDepthStencil();
+
 	if (RenderTargetTexture)
 	{
 		RenderTargetTexture->grab();
@@ -433,6 +447,9 @@ bool CBurningVideoDriver::setRenderTargetEx(IRenderTarget* target, u16 clearFlag
 		setRenderTarget(BackBuffer);
 	}
 
+	if (depthOnly != RenderTargetDepthOnly)
+		setCurrentShader();
+
 	clearBuffers(clearFlag, clearColor, clearDepth, clearStencil);
 
 	return true;
@@ -457,6 +474,10 @@ void CBurningVideoDriver::setRenderTarget(video::CImage* image)
 
 	setViewPort(core::rect<s32>(0,0,RenderTargetSize.Width,RenderTargetSize.Height));
 
+	// depth only targets are their own depth buffer, keep the one of the scene
+	if (RenderTargetDepthOnly)
+		return;
+
 	if (DepthBuffer)
 		DepthBuffer->setSize(RenderTargetSize);
 
@@ -703,9 +724,8 @@ inline void CBurningVideoDriver::ndc_2_dc_and_project ( s4DVertex *dest,s4DVerte
 		dest[g].Pos.x = iw * ( source[g].Pos.x * Transformation [ ETS_CLIPSCALE ][ 0] + w * Transformation [ ETS_CLIPSCALE ][12] );
 		dest[g].Pos.y = iw * ( source[g].Pos.y * Transformation [ ETS_CLIPSCALE ][ 5] + w * Transformation [ ETS_CLIPSCALE ][13] );
 
-#ifndef SOFTWARE_DRIVER_2_USE_WBUFFER
+		// also with a w-buffer, shadow maps store z/w
 		dest[g].Pos.z = iw * source[g].Pos.z;
-#endif
 
 	#ifdef SOFTWARE_DRIVER_2_USE_VERTEX_COLOR
 		#ifdef SOFTWARE_DRIVER_2_PERSPECTIVE_CORRECT
@@ -743,9 +763,8 @@ inline void CBurningVideoDriver::ndc_2_dc_and_project2 ( const s4DVertex **v, co
 		a[1].Pos.x = iw * ( a->Pos.x * p[ 0] + w * p[12] );
 		a[1].Pos.y = iw * ( a->Pos.y * p[ 5] + w * p[13] );
 
-#ifndef SOFTWARE_DRIVER_2_USE_WBUFFER
+		// also with a w-buffer, shadow maps store z/w
 		a[1].Pos.z = a->Pos.z * iw;
-#endif
 
 	#ifdef SOFTWARE_DRIVER_2_USE_VERTEX_COLOR
 		#ifdef SOFTWARE_DRIVER_2_PERSPECTIVE_CORRECT
@@ -897,7 +916,7 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 	Transformation [ ETS_CURRENT].transformVect ( &dest->Pos.x, base->Pos );
 
 	//mhm ;-) maybe no goto
-	if ( VertexCache.vType == 4 ) goto clipandproject;
+	if ( VertexCache.vType == 4 || RenderTargetDepthOnly ) goto clipandproject;
 
 
 #if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
@@ -2219,8 +2238,10 @@ const core::matrix4& CBurningVideoDriver::getTransform(E_TRANSFORMATION_STATE st
 ITexture* CBurningVideoDriver::addRenderTargetTexture(const core::dimension2d<u32>& size,
 		const io::path& name, const ECOLOR_FORMAT format)
 {
-	IImage* img = createImage(BURNINGSHADER_COLOR_FORMAT, size);
-	ITexture* tex = new CSoftwareTexture2(img, name, CSoftwareTexture2::IS_RENDERTARGET );
+	// depth textures store f32 depth for shadow maps
+	const bool depth = IImage::isDepthFormat(format);
+	IImage* img = depth ? new CImage(ECF_D32, size) : createImage(BURNINGSHADER_COLOR_FORMAT, size);
+	ITexture* tex = new CSoftwareTexture2(img, name, CSoftwareTexture2::IS_RENDERTARGET | (depth ? CSoftwareTexture2::IS_DEPTH : 0));
 	img->drop();
 	addTexture(tex);
 	tex->drop();
@@ -2229,6 +2250,13 @@ ITexture* CBurningVideoDriver::addRenderTargetTexture(const core::dimension2d<u3
 
 void CBurningVideoDriver::clearBuffers(u16 flag, SColor color, f32 depth, u8 stencil)
 {
+	if (RenderTargetDepthOnly)
+	{
+		if ((flag & ECBF_DEPTH) && RenderTargetSurface)
+			memset32 ( RenderTargetSurface->getData(), IR(depth), RenderTargetSurface->getImageDataSizeInBytes() );
+		return;
+	}
+
 	if ((flag & ECBF_COLOR) && RenderTargetSurface)
 		RenderTargetSurface->fill(color);
 
@@ -2265,6 +2293,20 @@ ITexture* CBurningVideoDriver::createDeviceDependentTexture(const io::path& name
 }
 
 
+//! textures are created from images in BURNINGSHADER_COLOR_FORMAT without conversion
+ECOLOR_FORMAT CBurningVideoDriver::getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const
+{
+	return BURNINGSHADER_COLOR_FORMAT;
+}
+
+
+//! textures filter the levels they keep from the level above
+bool CBurningVideoDriver::createsMipMapLevels() const
+{
+	return true;
+}
+
+
 //! Returns the maximum amount of primitives (mostly vertices) which
 //! the device is able to render with one drawIndexedTriangleList
 //! call.
@@ -2367,6 +2409,106 @@ void CBurningVideoDriver::drawStencilShadow(bool clearStencilBuffer, video::SCol
 }
 
 
+//! Darkens the parts of the rendered scene a light does not reach.
+void CBurningVideoDriver::drawShadowMap(ITexture* shadowMap, const core::matrix4& lightViewProjection,
+		video::SColor shadowColor, f32 bias)
+{
+#ifdef SOFTWARE_DRIVER_2_USE_WBUFFER
+	if (!shadowMap || shadowMap->getDriverType() != EDT_BURNINGSVIDEO ||
+		shadowMap->getColorFormat() != ECF_D32 || !DepthBuffer || RenderTargetDepthOnly)
+		return;
+
+	/*
+		The depth buffer holds 1/w of each pixel. With the pixel position it
+		gives clip x, clip y and w, which are linear in the world position, so
+		one matrix maps ( ndc x * w, ndc y * w, w ) to world and on into the
+		clip space of the light.
+	*/
+	const core::matrix4& vp = Transformation[ETS_VIEW_PROJECTION];
+	core::matrix4 clipToWorld ( core::matrix4::EM4CONST_NOTHING );
+	clipToWorld[0] = vp[0]; clipToWorld[4] = vp[4]; clipToWorld[ 8] = vp[ 8]; clipToWorld[12] = vp[12];
+	clipToWorld[1] = vp[1]; clipToWorld[5] = vp[5]; clipToWorld[ 9] = vp[ 9]; clipToWorld[13] = vp[13];
+	clipToWorld[2] = vp[3]; clipToWorld[6] = vp[7]; clipToWorld[10] = vp[11]; clipToWorld[14] = vp[15];
+	clipToWorld[3] = 0.f; clipToWorld[7] = 0.f; clipToWorld[11] = 0.f; clipToWorld[15] = 1.f;
+	if ( !clipToWorld.makeInverse() )
+		return;
+
+	const core::matrix4 toLight ( lightViewProjection * clipToWorld );
+
+	const CImage* map = ((CSoftwareTexture2*)shadowMap)->getImage();
+	const fp24* mapDepth = (const fp24*) map->getData();
+	const s32 mapWidth = map->getDimension().Width;
+	const s32 mapHeight = map->getDimension().Height;
+
+	// same mapping to texels the depth shader rendered with
+	core::matrix4 mapScale;
+	mapScale.buildNDCToDCMatrix ( core::rect<s32>(0, 0, mapWidth, mapHeight), 1 );
+
+	const f32* clipScale = Transformation[ETS_CLIPSCALE].pointer();
+	const f32 invScaleX = core::reciprocal ( clipScale[0] );
+	const f32 invScaleY = core::reciprocal ( clipScale[5] );
+
+	const u32 alpha = shadowColor.getAlpha();
+	const u32 pitch = RenderTargetSurface->getDimension().Width;
+	const fp24* depthBase = (const fp24*) DepthBuffer->lock();
+
+	for ( s32 y = ViewPort.UpperLeftCorner.Y; y < ViewPort.LowerRightCorner.Y; ++y )
+	{
+		tVideoSample* dst = (tVideoSample*)RenderTargetSurface->getData() + ( y * pitch );
+		const fp24* depth = depthBase + ( y * pitch );
+		const f32 ndcY = ( (f32) y - clipScale[13] ) * invScaleY;
+
+		for ( s32 x = ViewPort.UpperLeftCorner.X; x < ViewPort.LowerRightCorner.X; ++x )
+		{
+			// nothing rendered
+			if ( depth[x] <= 0.f )
+				continue;
+
+			const f32 w = core::reciprocal ( depth[x] );
+			const core::vector3df clip ( ( (f32) x - clipScale[12] ) * invScaleX * w, ndcY * w, w );
+
+			f32 light[4];
+			toLight.transformVect ( light, clip );
+			if ( light[3] <= 0.f )
+				continue;
+
+			const f32 iw = core::reciprocal ( light[3] );
+			const f32 z = light[2] * iw - bias;
+			const f32 tx = light[0] * iw * mapScale[0] + mapScale[12];
+			const f32 ty = light[1] * iw * mapScale[5] + mapScale[13];
+
+			// bilinear weighted compare of the four nearest texels
+			const s32 x0 = core::floor32 ( tx );
+			const s32 y0 = core::floor32 ( ty );
+			const f32 fx = tx - (f32) x0;
+			const f32 fy = ty - (f32) y0;
+
+			f32 shadow = 0.f;
+			for ( s32 i = 0; i != 4; ++i )
+			{
+				const s32 sx = x0 + ( i & 1 );
+				const s32 sy = y0 + ( i >> 1 );
+				if ( sx < 0 || sy < 0 || sx >= mapWidth || sy >= mapHeight )
+					continue;
+
+				if ( z > mapDepth[ sy * mapWidth + sx ] )
+					shadow += ( ( i & 1 ) ? fx : 1.f - fx ) * ( ( i >> 1 ) ? fy : 1.f - fy );
+			}
+
+			if ( shadow <= 0.f )
+				continue;
+
+#ifdef SOFTWARE_DRIVER_2_32BIT
+			dst[x] = ( dst[x] & 0xFF000000 ) | PixelBlend32 ( dst[x], shadowColor.color, core::round32 ( shadow * ( alpha + ( alpha >> 7 ) ) ) );
+#else
+			dst[x] = PixelBlend16 ( dst[x], A8R8G8B8toA1R5G5B5 ( shadowColor.color ), (u16) core::round32 ( shadow * alpha * ( 32.f / 255.f ) ) );
+#endif
+		}
+	}
+#endif
+}
+
+
 core::dimension2du CBurningVideoDriver::getMaxTextureSize() const
 {
 	return core::dimension2du(SOFTWARE_DRIVER_2_TEXTURE_MAXSIZE, SOFTWARE_DRIVER_2_TEXTURE_MAXSIZE);
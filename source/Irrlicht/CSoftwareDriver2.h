@@ -155,6 +155,10 @@ namespace video
 			video::SColor leftDownEdge = video::SColor(0,0,0,0),
 			video::SColor rightDownEdge = video::SColor(0,0,0,0)) _IRR_OVERRIDE_;
 
+		//! Darkens the parts of the rendered scene a light does not reach.
+		virtual void drawShadowMap(ITexture* shadowMap, const core::matrix4& lightViewProjection,
+			video::SColor shadowColor = video::SColor(150,0,0,0), f32 bias = 0.001f) _IRR_OVERRIDE_;
+
 		//! Returns the graphics card vendor name.
 		virtual core::stringc getVendorInfo() _IRR_OVERRIDE_;
 
@@ -174,6 +178,12 @@ namespace video
 
 		virtual ITexture* createDeviceDependentTexture(const io::path& name, IImage* image) _IRR_OVERRIDE_;
 
+		//! textures are created from images in BURNINGSHADER_COLOR_FORMAT without conversion
+		virtual ECOLOR_FORMAT getTextureLoadFormat(ECOLOR_FORMAT fileFormat) const _IRR_OVERRIDE_;
+
+		//! textures filter the levels they keep from the level above, see CSoftwareTexture2::regenerateMipMapLevels
+		virtual bool createsMipMapLevels() const _IRR_OVERRIDE_;
+
 		video::CImage* BackBuffer;
 		video::IImagePresenter* Presenter;
 
@@ -183,6 +193,8 @@ namespace video
 		video::ITexture* RenderTargetTexture;
 		video::IImage* RenderTargetSurface;
 		core::dimension2d<u32> RenderTargetSize;
+		//! the render target is a depth texture, only depth is written
+		bool RenderTargetDepthOnly;
 
 		//! selects the right triangle renderer based on the render states.
 		void setCurrentShader();
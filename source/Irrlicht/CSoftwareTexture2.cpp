@@ -9,6 +9,7 @@
 #include "SoftwareDriver2_helper.h"
 #include "CSoftwareTexture2.h"
 #include "CSoftwareDriver2.h"
+#include "CDXTCodec.h"
 #include "os.h"
 
 namespace irr
@@ -18,7 +19,8 @@ namespace video
 
 //! constructor
 CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 flags)
-	: ITexture(name, ETT_2D), MipMapLOD(0), Flags ( flags ), OriginalFormat(video::ECF_UNKNOWN)
+	: ITexture(name, ETT_2D), DecodedImage(0), MipMapLOD(0), Flags ( flags ), OriginalFormat(video::ECF_UNKNOWN),
+	LockMode(ETLM_READ_ONLY), ModificationCount(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CSoftwareTexture2");
@@ -38,7 +40,7 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 	{
 		bool IsCompressed = false;
 
-		if (IImage::isCompressedFormat(image->getColorFormat()))
+		if (IImage::isCompressedFormat(image->getColorFormat()) && !CDXTCodec::isFormatSupported(image->getColorFormat()))
 		{
 			os::Printer::log("Texture compression not available.", ELL_ERROR);
 			IsCompressed = true;
@@ -53,7 +55,22 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 				SOFTWARE_DRIVER_2_TEXTURE_MAXSIZE)
 			);
 
-		if (OriginalSize == optSize)
+		if (Flags & IS_DEPTH)
+		{
+			// f32 depth values, written by the depth shader and read by the shadow map lookup
+			ColorFormat = OriginalFormat;
+			MipMap[0] = new CImage(OriginalFormat, OriginalSize);
+
+			const f32 farDepth = 1.f;
+			memset32 ( MipMap[0]->getData(), IR(farDepth), MipMap[0]->getImageDataSizeInBytes() );
+		}
+		else if (OriginalSize == optSize && CDXTCodec::isFormatSupported(OriginalFormat))
+		{
+			// the blocks stay compressed, the shaders decode them while sampling
+			ColorFormat = OriginalFormat;
+			MipMap[0] = new CImage(OriginalFormat, OriginalSize, image->getData(), false);
+		}
+		else if (OriginalSize == optSize)
 		{
 			MipMap[0] = new CImage(BURNINGSHADER_COLOR_FORMAT, image->getDimension());
 
@@ -73,8 +90,15 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 			os::Printer::log ( buf, ELL_WARNING );
 			MipMap[0] = new CImage(BURNINGSHADER_COLOR_FORMAT, optSize);
 
-			if (!IsCompressed)
-				image->copyToScalingBoxFilter ( MipMap[0],0, false );
+			if (CDXTCodec::isFormatSupported(OriginalFormat))
+			{
+				CImage* decoded = new CImage(ECF_A8R8G8B8, OriginalSize);
+				image->copyTo(decoded);
+				decoded->copyToResampling ( MipMap[0], EIF_MITCHELL );
+				decoded->drop();
+			}
+			else if (!IsCompressed)
+				image->copyToResampling ( MipMap[0], EIF_MITCHELL );
 		}
 
 		Size = MipMap[MipMapLOD]->getDimension();
@@ -97,6 +121,37 @@ CSoftwareTexture2::~CSoftwareTexture2()
 		if ( MipMap[i] )
 			MipMap[i]->drop();
 	}
+
+	if ( DecodedImage )
+		DecodedImage->drop();
+}
+
+
+//! returns unoptimized surface
+CImage* CSoftwareTexture2::getImage() const
+{
+	if ( !IImage::isCompressedFormat(MipMap[0]->getColorFormat()) )
+		return MipMap[0];
+
+	// the 2d methods blit from this image, so compressed textures are decoded once they are drawn in 2d
+	if ( !DecodedImage )
+	{
+		DecodedImage = new CImage(BURNINGSHADER_COLOR_FORMAT, MipMap[0]->getDimension());
+		MipMap[0]->copyTo(DecodedImage);
+	}
+
+	return DecodedImage;
+}
+
+
+//! forgets the decoded copy of a compressed texture, so getImage decodes it again
+void CSoftwareTexture2::dropDecodedImage()
+{
+	if ( DecodedImage )
+	{
+		DecodedImage->drop();
+		DecodedImage = 0;
+	}
 }
 
 
@@ -104,6 +159,10 @@ CSoftwareTexture2::~CSoftwareTexture2()
 //! modifying the texture
 void CSoftwareTexture2::regenerateMipMapLevels(void* data, u32 layer)
 {
+	// level 0 might have changed as well
+	dropDecodedImage();
+	++ModificationCount;
+
 	if (!hasMipMaps())
 		return;
 
@@ -117,49 +176,89 @@ void CSoftwareTexture2::regenerateMipMapLevels(void* data, u32 layer)
 	}
 
 	core::dimension2d<u32> newSize;
-	core::dimension2d<u32> origSize = Size;
+	// size of the last level read from data, which starts below the original image
+	core::dimension2d<u32> origSize = OriginalSize;
 
 	for (i=1; i < SOFTWARE_DRIVER_2_MIPMAPPING_MAX; ++i)
 	{
 		newSize = MipMap[i-1]->getDimension();
 		newSize.Width = core::s32_max ( 1, newSize.Width >> SOFTWARE_DRIVER_2_MIPMAPPING_SCALE );
 		newSize.Height = core::s32_max ( 1, newSize.Height >> SOFTWARE_DRIVER_2_MIPMAPPING_SCALE );
-		origSize.Width = core::s32_max(1, origSize.Width >> 1);
-		origSize.Height = core::s32_max(1, origSize.Height >> 1);
 
-		if (data)
+		// the levels in data halve the size, skip those between the levels here
+		void* levelData = 0;
+		for (u32 s=0; s<SOFTWARE_DRIVER_2_MIPMAPPING_SCALE && data; ++s)
+		{
+			// the levels in data end with 1x1
+			if (origSize.Width == 1 && origSize.Height == 1)
+			{
+				data = 0;
+				break;
+			}
+			origSize.Width = core::s32_max(1, origSize.Width >> 1);
+			origSize.Height = core::s32_max(1, origSize.Height >> 1);
+			levelData = data;
+			data = (u8*)data + IImage::getDataSizeFromFormat(OriginalFormat, origSize.Width, origSize.Height);
+		}
+
+		if (IImage::isCompressedFormat(ColorFormat))
+		{
+			// compressed levels have the sizes of those in data, levels without data
+			// are filtered from the level above and compressed again
+			if (data)
+				MipMap[i] = new CImage(ColorFormat, newSize, levelData, false);
+			else
+			{
+				CImage* decoded = new CImage(ECF_A8R8G8B8, MipMap[i-1]->getDimension());
+				MipMap[i-1]->copyTo(decoded);
+				CImage* filtered = new CImage(ECF_A8R8G8B8, newSize);
+				decoded->copyToResampling(filtered, EIF_BOX);
+				MipMap[i] = new CImage(ColorFormat, newSize);
+				filtered->copyTo(MipMap[i]);
+				filtered->drop();
+				decoded->drop();
+			}
+		}
+		else if (data)
 		{
 			if (OriginalFormat != BURNINGSHADER_COLOR_FORMAT)
 			{
-				IImage* tmpImage = new CImage(OriginalFormat, origSize, data, true, false);
+				IImage* tmpImage = new CImage(OriginalFormat, origSize, levelData, true, false);
 				MipMap[i] = new CImage(BURNINGSHADER_COLOR_FORMAT, newSize);
 				if (origSize==newSize)
 					tmpImage->copyTo(MipMap[i]);
+				else if (IImage::isCompressedFormat(OriginalFormat))
+				{
+					// the resampler can't read blocks, decode them first
+					CImage* decoded = new CImage(ECF_A8R8G8B8, origSize);
+					tmpImage->copyTo(decoded);
+					decoded->copyToResampling(MipMap[i], EIF_BOX);
+					decoded->drop();
+				}
 				else
-					tmpImage->copyToScalingBoxFilter(MipMap[i]);
+					tmpImage->copyToResampling(MipMap[i], EIF_BOX);
 				tmpImage->drop();
 			}
 			else
 			{
 				if (origSize==newSize)
-					MipMap[i] = new CImage(BURNINGSHADER_COLOR_FORMAT, newSize, data, false);
+					MipMap[i] = new CImage(BURNINGSHADER_COLOR_FORMAT, newSize, levelData, false);
 				else
 				{
 					MipMap[i] = new CImage(BURNINGSHADER_COLOR_FORMAT, newSize);
-					IImage* tmpImage = new CImage(BURNINGSHADER_COLOR_FORMAT, origSize, data, true, false);
-					tmpImage->copyToScalingBoxFilter(MipMap[i]);
+					IImage* tmpImage = new CImage(BURNINGSHADER_COLOR_FORMAT, origSize, levelData, true, false);
+					tmpImage->copyToResampling(MipMap[i], EIF_BOX);
 					tmpImage->drop();
 				}
 			}
-			data = (u8*)data +origSize.getArea()*IImage::getBitsPerPixelFromFormat(OriginalFormat)/8;
 		}
 		else
 		{
 			MipMap[i] = new CImage(BURNINGSHADER_COLOR_FORMAT, newSize);
 
 			//static u32 color[] = { 0, 0xFFFF0000, 0xFF00FF00,0xFF0000FF,0xFFFFFF00,0xFFFF00FF,0xFF00FFFF,0xFF0F0F0F };
-			MipMap[i]->fill ( 0 );
-			MipMap[0]->copyToScalingBoxFilter( MipMap[i], 0, false );
+			// each level from the one above, so the whole chain reads the texture about once
+			MipMap[i-1]->copyToResampling( MipMap[i], EIF_BOX );
 		}
 	}
 }
@@ -179,6 +278,9 @@ CSoftwareRenderTarget2::~CSoftwareRenderTarget2()
 {
 	if (Texture[0])
 		Texture[0]->drop();
+
+	if (DepthStencil)
+		DepthStencil->drop();
 }
 
 void CSoftwareRenderTarget2::setTexture(const core::array<ITexture*>& texture, ITexture* depthStencil)
@@ -205,6 +307,22 @@ void CSoftwareRenderTarget2::setTexture(const core::array<ITexture*>& texture, I
 		if (!textureDetected)
 			Texture[0] = 0;
 	}
+
+	// only depth textures of this driver can be rendered into
+	if (depthStencil && (depthStencil->getDriverType() != EDT_BURNINGSVIDEO ||
+		!IImage::isDepthFormat(depthStencil->getColorFormat())))
+		depthStencil = 0;
+
+	if (DepthStencil != depthStencil)
+	{
+		if (DepthStencil)
+			DepthStencil->drop();
+
+		DepthStencil = depthStencil;
+
+		if (DepthStencil)
+			DepthStencil->grab();
+	}
 }
 
 ITexture* CSoftwareRenderTarget2::getTexture() const
@@ -31,6 +31,7 @@ public:
 		GEN_MIPMAP	= 1,
 		IS_RENDERTARGET	= 2,
 		NP2_SIZE	= 4,
+		IS_DEPTH	= 8,
 	};
 	CSoftwareTexture2(IImage* surface, const io::path& name, u32 flags);
 
@@ -40,6 +41,7 @@ public:
 	//! lock function
 	virtual void* lock(E_TEXTURE_LOCK_MODE mode, u32 level, u32 layer)
 	{
+		LockMode = mode;
 		if (Flags & GEN_MIPMAP)
 		{
 			MipMapLOD = level;
@@ -59,6 +61,20 @@ public:
 	//! unlock function
 	virtual void unlock() _IRR_OVERRIDE_
 	{
+		// the texels might have changed in place
+		if ( LockMode != ETLM_READ_ONLY )
+		{
+			dropDecodedImage();
+			++ModificationCount;
+		}
+		LockMode = ETLM_READ_ONLY;
+	}
+
+	//! Changes whenever the texels may have changed without the texture data moving
+	/** Caches of the texels compare it, as their addresses might be the same. */
+	u32 getModificationCount() const
+	{
+		return ModificationCount;
 	}
 
 	//! Returns the size of the largest mipmap.
@@ -69,10 +85,8 @@ public:
 	}
 
 	//! returns unoptimized surface
-	virtual CImage* getImage() const
-	{
-		return MipMap[0];
-	}
+	/** Compressed textures return a decoded copy. */
+	virtual CImage* getImage() const;
 
 	//! returns texture surface
 	virtual CImage* getTexture() const
@@ -83,13 +97,18 @@ public:
 	virtual void regenerateMipMapLevels(void* data = 0, u32 layer = 0) _IRR_OVERRIDE_;
 
 private:
+	void dropDecodedImage();
+
 	f32 OrigImageDataSizeInPixels;
 
 	CImage * MipMap[SOFTWARE_DRIVER_2_MIPMAPPING_MAX];
+	mutable CImage * DecodedImage;
 
 	u32 MipMapLOD;
 	u32 Flags;
 	ECOLOR_FORMAT OriginalFormat;
+	E_TEXTURE_LOCK_MODE LockMode;
+	u32 ModificationCount;
 };
 
 /*!
@@ -23,11 +23,98 @@
 #include "SMesh.h"
 #include "CDynamicMeshBuffer.h"
 
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
+
 namespace irr
 {
 namespace scene
 {
 
+namespace
+{
+	//! Visits the cells of a grid a line crosses, in the order it crosses them
+	/** The line is start + dir * t in grid units, cells are squares on the
+	XZ plane. Only cells up to maxCell along both axes are visited. */
+	class CGridWalk
+	{
+	public:
+
+		CGridWalk(const core::vector3df& start, const core::vector3df& dir,
+				f32 tStart, f32 tEnd, f32 cellSize, s32 maxCell)
+			: T(tStart), TEnd(tEnd), MaxCell(maxCell)
+		{
+			const core::vector3df pos(start + dir * tStart);
+			X = core::clamp(core::floor32(pos.X / cellSize), 0, maxCell);
+			Z = core::clamp(core::floor32(pos.Z / cellSize), 0, maxCell);
+			initAxis(pos.X, dir.X, X, tStart, cellSize, StepX, TMaxX, TDeltaX);
+			initAxis(pos.Z, dir.Z, Z, tStart, cellSize, StepZ, TMaxZ, TDeltaZ);
+		}
+
+		//! Get the next cell and the part of the line in it
+		bool next(s32& x, s32& z, f32& t0, f32& t1)
+		{
+			if (T >= TEnd || X < 0 || X > MaxCell || Z < 0 || Z > MaxCell)
+				return false;
+
+			x = X;
+			z = Z;
+			t0 = T;
+			t1 = core::min_(TMaxX, TMaxZ, TEnd);
+			if (TMaxX < TMaxZ)
+			{
+				X += StepX;
+				TMaxX += TDeltaX;
+			}
+			else
+			{
+				Z += StepZ;
+				TMaxZ += TDeltaZ;
+			}
+			T = t1;
+			return true;
+		}
+
+	private:
+
+		static void initAxis(f32 pos, f32 dir, s32 cell, f32 tStart, f32 cellSize,
+			s32& step, f32& tMax, f32& tDelta)
+		{
+			if (dir > 0.f)
+			{
+				step = 1;
+				tMax = tStart + ((cell + 1) * cellSize - pos) / dir;
+				tDelta = cellSize / dir;
+			}
+			else if (dir < 0.f)
+			{
+				step = -1;
+				tMax = tStart + (cell * cellSize - pos) / dir;
+				tDelta = -cellSize / dir;
+			}
+			else
+			{
+				step = 0;
+				tMax = FLT_MAX;
+				tDelta = 0.f;
+			}
+		}
+
+		f32 T;
+		f32 TEnd;
+		s32 MaxCell;
+		s32 X;
+		s32 Z;
+		s32 StepX;
+		s32 StepZ;
+		f32 TMaxX;
+		f32 TMaxZ;
+		f32 TDeltaX;
+		f32 TDeltaZ;
+	};
+}
+
 	//! constructor
 	CTerrainSceneNode::CTerrainSceneNode(ISceneNode* parent, ISceneManager* mgr,
 			io::IFileSystem* fs, s32 id, s32 maxLOD, E_TERRAIN_PATCH_SIZE patchSize,
@@ -38,7 +125,8 @@ namespace scene
 	TerrainData(patchSize, maxLOD, position, rotation, scale), RenderBuffer(0),
 	VerticesToRender(0), IndicesToRender(0), DynamicSelectorUpdate(false),
 	OverrideDistanceThreshold(false), UseDefaultRotationPivot(true), ForceRecalculation(true),
-	CameraMovementDelta(10.0f), CameraRotationDelta(1.0f),CameraFOVDelta(0.1f),
+	LODMorphing(false), CameraMovementDelta(10.0f), CameraRotationDelta(1.0f),CameraFOVDelta(0.1f),
+	MorphPatchRadius(0.f),
 	TCoordScale1(1.0f), TCoordScale2(1.0f), SmoothFactor(0), FileSystem(fs)
 	{
 		#ifdef _DEBUG
@@ -206,6 +294,7 @@ namespace scene
 		// calculate all the necessary data for the patches and the terrain
 		calculateDistanceThresholds();
 		createPatches();
+		storeHeightField();
 		calculatePatchData();
 
 		// set the default rotation pivot point to the terrain nodes center
@@ -445,6 +534,7 @@ namespace scene
 		// calculate all the necessary data for the patches and the terrain
 		calculateDistanceThresholds();
 		createPatches();
+		storeHeightField();
 		calculatePatchData();
 
 		// set the default rotation pivot point to the terrain nodes center
@@ -540,6 +630,24 @@ namespace scene
 		core::matrix4 rotMatrix;
 		rotMatrix.setRotationDegrees(TerrainData.Rotation);
 
+		// the same transformation as a matrix, for the height field
+		core::vector3df axisX(TerrainData.Scale.X, 0.f, 0.f);
+		core::vector3df axisY(0.f, TerrainData.Scale.Y, 0.f);
+		core::vector3df axisZ(0.f, 0.f, TerrainData.Scale.Z);
+		core::vector3df origin(TerrainData.Position - TerrainData.RotationPivot);
+		rotMatrix.inverseRotateVect(axisX);
+		rotMatrix.inverseRotateVect(axisY);
+		rotMatrix.inverseRotateVect(axisZ);
+		rotMatrix.inverseRotateVect(origin);
+		origin += TerrainData.RotationPivot;
+
+		f32* m = GridToWorld.pointer();
+		m[0] = axisX.X; m[1] = axisX.Y; m[2] = axisX.Z;
+		m[4] = axisY.X; m[5] = axisY.Y; m[6] = axisY.Z;
+		m[8] = axisZ.X; m[9] = axisZ.Y; m[10] = axisZ.Z;
+		m[12] = origin.X; m[13] = origin.Y; m[14] = origin.Z;
+		GridToWorld.getInverse(WorldToGrid);
+
 		const s32 vtxCount = Mesh->getMeshBuffer(0)->getVertexCount();
 		for (s32 i = 0; i < vtxCount; ++i)
 		{
@@ -552,6 +660,7 @@ namespace scene
 
 		calculateDistanceThresholds(true);
 		calculatePatchData();
+		storeMorphStart();
 
 		RenderBuffer->setDirty(EBT_VERTEX);
 	}
@@ -603,6 +712,9 @@ namespace scene
 					if (fabs(CameraFOV-OldCameraFOV) < CameraFOVDelta &&
 						cameraUp.dotProduct(OldCameraUp) > (1.f - (cos(core::DEGTORAD * CameraRotationDelta))))
 					{
+						// LODs stay, but morphing follows each movement
+						if (LODMorphing && cameraPosition != MorphCameraPosition)
+							updateMorphing(cameraPosition);
 						return;
 					}
 				}
@@ -618,6 +730,9 @@ namespace scene
 
 		preRenderLODCalculations();
 		preRenderIndicesCalculations();
+
+		if (LODMorphing)
+			updateMorphing(cameraPosition);
 	}
 
 	void CTerrainSceneNode::preRenderLODCalculations()
@@ -661,55 +776,66 @@ namespace scene
 	void CTerrainSceneNode::preRenderIndicesCalculations()
 	{
 		scene::IIndexBuffer& indexBuffer = RenderBuffer->getIndexBuffer();
-		IndicesToRender = 0;
-		indexBuffer.set_used(0);
 
+		// The number of indices of a patch only depends on its LOD, stitching
+		// just moves vertices. So the index buffer can be made large enough first.
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		u32 indexCount = 0;
+		for (s32 i = 0; i < count; ++i)
+		{
+			if (TerrainData.Patches[i].CurrentLOD >= 0)
+			{
+				const u32 quads = TerrainData.CalcPatchSize >> TerrainData.Patches[i].CurrentLOD;
+				indexCount += quads * quads * 6;
+			}
+		}
+		if (indexBuffer.size() < indexCount)
+			indexBuffer.set_used(indexCount);
+
+		// Then copy the indices of all patches that are visible. Patches whose
+		// indices are already in the right place are skipped.
+		bool changed = false;
+		u32 start = 0;
 		s32 index = 0;
-		// Then generate the indices for all patches that are visible.
 		for (s32 i = 0; i < TerrainData.PatchCount; ++i)
 		{
-			for (s32 j = 0; j < TerrainData.PatchCount; ++j)
+			for (s32 j = 0; j < TerrainData.PatchCount; ++j, ++index)
 			{
-				if (TerrainData.Patches[index].CurrentLOD >= 0)
+				SPatch& patch = TerrainData.Patches[index];
+				if (patch.CurrentLOD < 0)
 				{
-					s32 x = 0;
-					s32 z = 0;
-
-					// calculate the step we take this patch, based on the patches current LOD
-					const s32 step = 1 << TerrainData.Patches[index].CurrentLOD;
+					patch.IndexKey = 0xffffffff;
+					continue;
+				}
 
-					// Loop through patch and generate indices
-					while (z < TerrainData.CalcPatchSize)
+				const u32 key = getPatchIndexKey(patch);
+				const core::array<u32>& indices = getPatchIndices(key);
+				if (key != patch.IndexKey || start != patch.IndexStart)
+				{
+					const u32 first = (i * TerrainData.CalcPatchSize) * TerrainData.Size + j * TerrainData.CalcPatchSize;
+					if (indexBuffer.getType() == video::EIT_16BIT)
 					{
-						const s32 index11 = getIndex(j, i, index, x, z);
-						const s32 index21 = getIndex(j, i, index, x + step, z);
-						const s32 index12 = getIndex(j, i, index, x, z + step);
-						const s32 index22 = getIndex(j, i, index, x + step, z + step);
-
-						indexBuffer.push_back(index12);
-						indexBuffer.push_back(index11);
-						indexBuffer.push_back(index22);
-						indexBuffer.push_back(index22);
-						indexBuffer.push_back(index11);
-						indexBuffer.push_back(index21);
-						IndicesToRender+=6;
-
-						// increment index position horizontally
-						x += step;
-
-						// we've hit an edge
-						if (x >= TerrainData.CalcPatchSize)
-						{
-							x = 0;
-							z += step;
-						}
+						u16* target = (u16*)indexBuffer.pointer() + start;
+						for (u32 k = 0; k < indices.size(); ++k)
+							target[k] = (u16)(first + indices[k]);
 					}
+					else
+					{
+						u32* target = (u32*)indexBuffer.pointer() + start;
+						for (u32 k = 0; k < indices.size(); ++k)
+							target[k] = first + indices[k];
+					}
+					patch.IndexKey = key;
+					patch.IndexStart = start;
+					changed = true;
 				}
-				++index;
+				start += indices.size();
 			}
 		}
+		IndicesToRender = start;
 
-		RenderBuffer->setDirty(EBT_INDEX);
+		if (changed)
+			RenderBuffer->setDirty(EBT_INDEX);
 
 		if (DynamicSelectorUpdate && TriangleSelector)
 		{
@@ -1031,56 +1157,217 @@ namespace scene
 	u32 CTerrainSceneNode::getIndex(const s32 PatchX, const s32 PatchZ,
 					const s32 PatchIndex, u32 vX, u32 vZ) const
 	{
-		// top border
-		if (vZ == 0)
+		s32 stitchedLOD[4];
+		getStitchedLODs(TerrainData.Patches[PatchIndex], stitchedLOD);
+
+		return getPatchVertex(stitchedLOD, vX, vZ) +
+			((TerrainData.CalcPatchSize) * PatchZ) * TerrainData.Size +
+			((TerrainData.CalcPatchSize) * PatchX);
+	}
+
+
+	//! get the LODs the borders of a patch are stitched to, 0 for borders which are not stitched
+	void CTerrainSceneNode::getStitchedLODs(const SPatch& patch, s32 stitchedLOD[4]) const
+	{
+		// a border is stitched to a neighbour with a coarser LOD
+		const SPatch* neighbours[4] = { patch.Top, patch.Bottom, patch.Left, patch.Right };
+		for (u32 i = 0; i < 4; ++i)
 		{
-			if (TerrainData.Patches[PatchIndex].Top &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Top->CurrentLOD &&
-				(vX % (1 << TerrainData.Patches[PatchIndex].Top->CurrentLOD)) != 0 )
-			{
-				vX -= vX % (1 << TerrainData.Patches[PatchIndex].Top->CurrentLOD);
-			}
+			if (neighbours[i] && patch.CurrentLOD < neighbours[i]->CurrentLOD)
+				stitchedLOD[i] = neighbours[i]->CurrentLOD;
+			else
+				stitchedLOD[i] = 0;
 		}
+	}
+
+
+	//! get the vertex of a patch relative to its first vertex, moved onto the coarser LOD of stitched borders
+	u32 CTerrainSceneNode::getPatchVertex(const s32 stitchedLOD[4], u32 vX, u32 vZ) const
+	{
+		// top border
+		if (vZ == 0)
+			vX -= vX % (1 << stitchedLOD[0]);
 		else
 		if (vZ == (u32)TerrainData.CalcPatchSize) // bottom border
-		{
-			if (TerrainData.Patches[PatchIndex].Bottom &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Bottom->CurrentLOD &&
-				(vX % (1 << TerrainData.Patches[PatchIndex].Bottom->CurrentLOD)) != 0)
-			{
-				vX -= vX % (1 << TerrainData.Patches[PatchIndex].Bottom->CurrentLOD);
-			}
-		}
+			vX -= vX % (1 << stitchedLOD[1]);
 
 		// left border
 		if (vX == 0)
+			vZ -= vZ % (1 << stitchedLOD[2]);
+		else
+		if (vX == (u32)TerrainData.CalcPatchSize) // right border
+			vZ -= vZ % (1 << stitchedLOD[3]);
+
+		if (vZ >= (u32)TerrainData.PatchSize)
+			vZ = TerrainData.CalcPatchSize;
+
+		if (vX >= (u32)TerrainData.PatchSize)
+			vX = TerrainData.CalcPatchSize;
+
+		return vZ * TerrainData.Size + vX;
+	}
+
+
+	//! get the key of the indices a patch needs with its LOD and the LODs of its neighbours
+	u32 CTerrainSceneNode::getPatchIndexKey(const SPatch& patch) const
+	{
+		// the MaxLOD is at most 7, so each LOD fits into 4 bits
+		s32 stitchedLOD[4];
+		getStitchedLODs(patch, stitchedLOD);
+		return patch.CurrentLOD | (stitchedLOD[0] << 4) | (stitchedLOD[1] << 8) |
+			(stitchedLOD[2] << 12) | (stitchedLOD[3] << 16);
+	}
+
+
+	//! get the indices of all patches with the same key, relative to their first vertex
+	const core::array<u32>& CTerrainSceneNode::getPatchIndices(u32 key)
+	{
+		core::map<u32, core::array<u32> >::Node* node = PatchIndices.find(key);
+		if (node)
+			return node->getValue();
+
+		s32 stitchedLOD[4];
+		for (u32 i = 0; i < 4; ++i)
+			stitchedLOD[i] = (key >> (4 * (i + 1))) & 15;
+
+		// calculate the step we take for this patch, based on its LOD
+		const s32 step = 1 << (key & 15);
+		const u32 quads = TerrainData.CalcPatchSize / step;
+		core::array<u32> indices(quads * quads * 6);
+
+		// Loop through patch and generate indices
+		for (s32 z = 0; z < TerrainData.CalcPatchSize; z += step)
 		{
-			if (TerrainData.Patches[PatchIndex].Left &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Left->CurrentLOD &&
-				(vZ % (1 << TerrainData.Patches[PatchIndex].Left->CurrentLOD)) != 0)
+			for (s32 x = 0; x < TerrainData.CalcPatchSize; x += step)
 			{
-				vZ -= vZ % (1 << TerrainData.Patches[PatchIndex].Left->CurrentLOD);
+				const u32 index11 = getPatchVertex(stitchedLOD, x, z);
+				const u32 index21 = getPatchVertex(stitchedLOD, x + step, z);
+				const u32 index12 = getPatchVertex(stitchedLOD, x, z + step);
+				const u32 index22 = getPatchVertex(stitchedLOD, x + step, z + step);
+
+				indices.push_back(index12);
+				indices.push_back(index11);
+				indices.push_back(index22);
+				indices.push_back(index22);
+				indices.push_back(index11);
+				indices.push_back(index21);
 			}
 		}
+
+		PatchIndices.insert(key, indices);
+		return PatchIndices.find(key)->getValue();
+	}
+
+
+	//! Enable smooth transitions between the levels of detail of the patches.
+	void CTerrainSceneNode::setLODMorphing(bool enable)
+	{
+		if (enable == LODMorphing)
+			return;
+
+		LODMorphing = enable;
+		if (enable)
+		{
+			RenderBuffer->setHardwareMappingHint(scene::EHM_DYNAMIC, scene::EBT_VERTEX);
+			storeMorphStart();
+		}
 		else
-		if (vX == (u32)TerrainData.CalcPatchSize) // right border
 		{
-			if (TerrainData.Patches[PatchIndex].Right &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Right->CurrentLOD &&
-				(vZ % (1 << TerrainData.Patches[PatchIndex].Right->CurrentLOD)) != 0)
-			{
-				vZ -= vZ % (1 << TerrainData.Patches[PatchIndex].Right->CurrentLOD);
-			}
+			RenderBuffer->setHardwareMappingHint(scene::EHM_STATIC, scene::EBT_VERTEX);
+			for (u32 i = 0; i < MorphStart.size(); ++i)
+				RenderBuffer->getVertexBuffer()[i].Pos = MorphStart[i];
+			MorphStart.clear();
+			RenderBuffer->setDirty(EBT_VERTEX);
 		}
+		ForceRecalculation = true;
+	}
 
-		if (vZ >= (u32)TerrainData.PatchSize)
-			vZ = TerrainData.CalcPatchSize;
 
-		if (vX >= (u32)TerrainData.PatchSize)
-			vX = TerrainData.CalcPatchSize;
+	//! store the unmorphed vertex positions
+	void CTerrainSceneNode::storeMorphStart()
+	{
+		if (!LODMorphing || !Mesh->getMeshBufferCount())
+			return;
+
+		const u32 vertexCount = RenderBuffer->getVertexCount();
+		MorphStart.set_used(vertexCount);
+		for (u32 i = 0; i < vertexCount; ++i)
+			MorphStart[i] = RenderBuffer->getPosition(i);
+
+		// half diagonal of the largest patch
+		MorphPatchRadius = 0.f;
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		for (s32 i = 0; i < count; ++i)
+			MorphPatchRadius = core::max_(MorphPatchRadius, TerrainData.Patches[i].BoundingBox.getExtent().getLength() * 0.5f);
+
+		ForceRecalculation = true;
+	}
 
-		return (vZ + ((TerrainData.CalcPatchSize) * PatchZ)) * TerrainData.Size +
-			(vX + ((TerrainData.CalcPatchSize) * PatchX));
+
+	//! morph the vertices of visible patches towards the next coarser LOD
+	void CTerrainSceneNode::updateMorphing(const core::vector3df& cameraPosition)
+	{
+		MorphCameraPosition = cameraPosition;
+		if (MorphStart.empty())
+			return;
+
+		// A patch changes to LOD i+1 when its center is further away than the
+		// threshold, its vertices are closer by up to the patch radius. LODs are
+		// only updated after the camera moved by CameraMovementDelta in some
+		// direction. The vertices dropped in LOD i+1 are morphed in the second
+		// half of the distances where LOD i is used, up to that limit.
+		const f32 slack = MorphPatchRadius + CameraMovementDelta * 1.7320508f;
+		f32 morphBegin[8];
+		f32 morphScale[8];
+		for (s32 i = 0; i < TerrainData.MaxLOD - 1; ++i)
+		{
+			const f32 lodBegin = i ? sqrtf((f32)TerrainData.LODDistanceThreshold[i]) : 0.f;
+			const f32 morphEnd = sqrtf((f32)TerrainData.LODDistanceThreshold[i + 1]) - slack;
+			morphBegin[i] = core::min_((lodBegin + morphEnd) * 0.5f, morphEnd);
+			morphScale[i] = morphEnd > morphBegin[i] ? 1.f / (morphEnd - morphBegin[i]) : FLT_MAX;
+		}
+
+		const s32 size = TerrainData.Size;
+		const s32 calc = TerrainData.CalcPatchSize;
+		video::S3DVertex2TCoords* vertices = (video::S3DVertex2TCoords*)RenderBuffer->getVertexBuffer().pointer();
+
+		s32 index = 0;
+		for (s32 i = 0; i < TerrainData.PatchCount; ++i)
+		{
+			for (s32 j = 0; j < TerrainData.PatchCount; ++j, ++index)
+			{
+				const s32 lod = TerrainData.Patches[index].CurrentLOD;
+				if (lod < 0)
+					continue;
+
+				// Vertices dropped in the next LOD move to the middle of an edge or
+				// the diagonal of a quad of that LOD. Those vertices are morphed
+				// already, as coarser levels are done first. Vertices on the border
+				// of two patches are morphed twice in the same way.
+				for (s32 level = TerrainData.MaxLOD - 2; level >= lod; --level)
+				{
+					const s32 step = 1 << level;
+					for (s32 x = 0; x <= calc; x += step)
+					{
+						for (s32 z = 0; z <= calc; z += step)
+						{
+							const s32 dx = x & step;
+							const s32 dz = z & step;
+							if (!(dx | dz))
+								continue;
+
+							const s32 v = (i * calc + x) * size + j * calc + z;
+							const f32 distance = cameraPosition.getDistanceFrom(MorphStart[v]);
+							const f32 morph = core::clamp((distance - morphBegin[level]) * morphScale[level], 0.f, 1.f);
+							const core::vector3df target = (vertices[v - dx * size - dz].Pos + vertices[v + dx * size + dz].Pos) * 0.5f;
+							vertices[v].Pos = MorphStart[v] + (target - MorphStart[v]) * morph;
+						}
+					}
+				}
+			}
+		}
+
+		RenderBuffer->setDirty(EBT_VERTEX);
 	}
 
 
@@ -1239,6 +1526,38 @@ namespace scene
 			delete [] TerrainData.Patches;
 
 		TerrainData.Patches = new SPatch[TerrainData.PatchCount * TerrainData.PatchCount];
+
+		// the indices depend on the size of the terrain
+		PatchIndices.clear();
+	}
+
+
+	//! copy the heights into the height field and store the height range of the patches
+	void CTerrainSceneNode::storeHeightField()
+	{
+		const IMeshBuffer* mb = Mesh->getMeshBuffer(0);
+		HeightField.set_used(TerrainData.Size * TerrainData.Size);
+		for (u32 i = 0; i < HeightField.size(); ++i)
+			HeightField[i] = mb->getPosition(i).Y;
+
+		for (s32 x = 0; x < TerrainData.PatchCount; ++x)
+		{
+			for (s32 z = 0; z < TerrainData.PatchCount; ++z)
+			{
+				SPatch& patch = TerrainData.Patches[x * TerrainData.PatchCount + z];
+				patch.MinHeight = FLT_MAX;
+				patch.MaxHeight = -FLT_MAX;
+				for (s32 i = 0; i <= TerrainData.CalcPatchSize; ++i)
+				{
+					const f32* h = &HeightField[(x * TerrainData.CalcPatchSize + i) * TerrainData.Size + z * TerrainData.CalcPatchSize];
+					for (s32 j = 0; j <= TerrainData.CalcPatchSize; ++j)
+					{
+						patch.MinHeight = core::min_(patch.MinHeight, h[j]);
+						patch.MaxHeight = core::max_(patch.MaxHeight, h[j]);
+					}
+				}
+			}
+		}
 	}
 
 
@@ -1353,40 +1672,309 @@ namespace scene
 		if (!Mesh->getMeshBufferCount())
 			return 0;
 
-		core::matrix4 rotMatrix;
-		rotMatrix.setRotationDegrees(TerrainData.Rotation);
-		core::vector3df pos(x, 0.0f, z);
-		rotMatrix.rotateVect(pos);
-		pos -= TerrainData.Position;
-		pos /= TerrainData.Scale;
+		const core::vector3df pos(x, 0.0f, z);
+		f32 height;
+		getHeights(&pos, 1, &height);
+		return height;
+	}
 
-		s32 X(core::floor32(pos.X));
-		s32 Z(core::floor32(pos.Z));
 
-		f32 height = -FLT_MAX;
-		if (X >= 0 && X < TerrainData.Size-1 &&
-				Z >= 0 && Z < TerrainData.Size-1)
+	//! get the interpolated height and its slopes at a position in heightmap samples
+	bool CTerrainSceneNode::sampleHeightField(f32 x, f32 z, E_TERRAIN_HEIGHT_SAMPLING sampling,
+			f32& height, f32& slopeX, f32& slopeZ) const
+	{
+		const f32 cellX = floorf(x);
+		const f32 cellZ = floorf(z);
+		const f32 maxCell = (f32)(TerrainData.Size - 1);
+		if (!(cellX >= 0.f && cellX < maxCell && cellZ >= 0.f && cellZ < maxCell))
 		{
-			const video::S3DVertex2TCoords* Vertices = (const video::S3DVertex2TCoords*)Mesh->getMeshBuffer(0)->getVertices();
-			const core::vector3df& a = Vertices[X * TerrainData.Size + Z].Pos;
-			const core::vector3df& b = Vertices[(X + 1) * TerrainData.Size + Z].Pos;
-			const core::vector3df& c = Vertices[X * TerrainData.Size + (Z + 1)].Pos;
-			const core::vector3df& d = Vertices[(X + 1) * TerrainData.Size + (Z + 1)].Pos;
+			height = slopeX = slopeZ = 0.f;
+			return false;
+		}
 
-			// offset from integer position
-			const f32 dx = pos.X - X;
-			const f32 dz = pos.Z - Z;
+		const f32* h = &HeightField[(s32)cellX * TerrainData.Size + (s32)cellZ];
+		const f32 a = h[0];
+		const f32 b = h[TerrainData.Size];
+		const f32 c = h[1];
+		const f32 d = h[TerrainData.Size + 1];
 
+		// offset from integer position
+		const f32 dx = x - cellX;
+		const f32 dz = z - cellZ;
+
+		if (sampling == ETHS_BILINEAR)
+		{
+			slopeX = (b - a) + (d - c - b + a) * dz;
+			slopeZ = (c - a) + (d - c - b + a) * dx;
+			height = a + (b - a) * dx + slopeZ * dz;
+		}
+		else
+		{
 			if (dx > dz)
-				height = a.Y + (d.Y - b.Y)*dz + (b.Y - a.Y)*dx;
+			{
+				slopeX = b - a;
+				slopeZ = d - b;
+			}
+			else
+			{
+				slopeX = d - c;
+				slopeZ = c - a;
+			}
+			height = a + slopeX * dx + slopeZ * dz;
+		}
+		return true;
+	}
+
+
+	//! transform a slope in heightmap samples to a normal in world space
+	core::vector3df CTerrainSceneNode::getWorldNormal(f32 slopeX, f32 slopeZ) const
+	{
+		// normals transform with the transposed inverse
+		const f32* w = WorldToGrid.pointer();
+		core::vector3df normal(
+			w[1] - slopeX * w[0] - slopeZ * w[2],
+			w[5] - slopeX * w[4] - slopeZ * w[6],
+			w[9] - slopeX * w[8] - slopeZ * w[10]);
+		return normal.normalize();
+	}
+
+
+	//! Get the heights and normals of the terrain at many points.
+	void CTerrainSceneNode::getHeights(const core::vector3df* positions, u32 count, f32* outHeights,
+			core::vector3df* outNormals, E_TERRAIN_HEIGHT_SAMPLING sampling) const
+	{
+		const f32* w = WorldToGrid.pointer();
+		const f32* g = GridToWorld.pointer();
+		u32 i = 0;
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+		// four points at once, only reading the samples is done one by one
+		const s32 size = TerrainData.Size;
+		for (; i + 4 <= count && !HeightField.empty(); i += 4)
+		{
+			const core::vector3df* p = positions + i;
+			const __m128 x = _mm_set_ps(p[3].X, p[2].X, p[1].X, p[0].X);
+			const __m128 z = _mm_set_ps(p[3].Z, p[2].Z, p[1].Z, p[0].Z);
+			const __m128 gx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(w[0])), _mm_mul_ps(z, _mm_set1_ps(w[8]))), _mm_set1_ps(w[12]));
+			const __m128 gz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(w[2])), _mm_mul_ps(z, _mm_set1_ps(w[10]))), _mm_set1_ps(w[14]));
+
+			// floor, the conversion truncates towards zero
+			__m128i cellX = _mm_cvttps_epi32(gx);
+			__m128i cellZ = _mm_cvttps_epi32(gz);
+			cellX = _mm_add_epi32(cellX, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(cellX), gx)));
+			cellZ = _mm_add_epi32(cellZ, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(cellZ), gz)));
+			const __m128 fx = _mm_cvtepi32_ps(cellX);
+			const __m128 fz = _mm_cvtepi32_ps(cellZ);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 maxCell = _mm_set1_ps((f32)(size - 1));
+			const __m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, maxCell)),
+				_mm_and_ps(_mm_cmpge_ps(fz, zero), _mm_cmplt_ps(fz, maxCell)));
+			const s32 mask = _mm_movemask_ps(inside);
+
+			s32 cx[4];
+			s32 cz[4];
+			_mm_storeu_si128((__m128i*)cx, cellX);
+			_mm_storeu_si128((__m128i*)cz, cellZ);
+			f32 samples[4][4];
+			for (u32 k = 0; k < 4; ++k)
+			{
+				if (mask & (1 << k))
+				{
+					const f32* h = &HeightField[cx[k] * size + cz[k]];
+					samples[0][k] = h[0];
+					samples[1][k] = h[size];
+					samples[2][k] = h[1];
+					samples[3][k] = h[size + 1];
+				}
+				else
+					samples[0][k] = samples[1][k] = samples[2][k] = samples[3][k] = 0.f;
+			}
+			const __m128 a = _mm_loadu_ps(samples[0]);
+			const __m128 b = _mm_loadu_ps(samples[1]);
+			const __m128 c = _mm_loadu_ps(samples[2]);
+			const __m128 d = _mm_loadu_ps(samples[3]);
+			const __m128 dx = _mm_sub_ps(gx, fx);
+			const __m128 dz = _mm_sub_ps(gz, fz);
+
+			__m128 slopeX;
+			__m128 slopeZ;
+			__m128 height;
+			if (sampling == ETHS_BILINEAR)
+			{
+				const __m128 twist = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(d, c), b), a);
+				slopeX = _mm_add_ps(_mm_sub_ps(b, a), _mm_mul_ps(twist, dz));
+				slopeZ = _mm_add_ps(_mm_sub_ps(c, a), _mm_mul_ps(twist, dx));
+				height = _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), dx)), _mm_mul_ps(slopeZ, dz));
+			}
 			else
-				height = a.Y + (d.Y - c.Y)*dx + (c.Y - a.Y)*dz;
+			{
+				// triangle abd if dx > dz, else acd
+				const __m128 upper = _mm_cmpgt_ps(dx, dz);
+				slopeX = _mm_or_ps(_mm_and_ps(upper, _mm_sub_ps(b, a)), _mm_andnot_ps(upper, _mm_sub_ps(d, c)));
+				slopeZ = _mm_or_ps(_mm_and_ps(upper, _mm_sub_ps(d, b)), _mm_andnot_ps(upper, _mm_sub_ps(c, a)));
+				height = _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(slopeX, dx)), _mm_mul_ps(slopeZ, dz));
+			}
+
+			__m128 y = _mm_add_ps(_mm_mul_ps(gx, _mm_set1_ps(g[1])), _mm_mul_ps(height, _mm_set1_ps(g[5])));
+			y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(gz, _mm_set1_ps(g[9]))), _mm_set1_ps(g[13]));
+			y = _mm_or_ps(_mm_and_ps(inside, y), _mm_andnot_ps(inside, _mm_set1_ps(-FLT_MAX)));
+			_mm_storeu_ps(outHeights + i, y);
 
-			height *= TerrainData.Scale.Y;
-			height += TerrainData.Position.Y;
+			if (outNormals)
+			{
+				// outside of the terrain the slopes are 0, the normal is the up axis of the terrain
+				__m128 n[3];
+				for (u32 k = 0; k < 3; ++k)
+				{
+					n[k] = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(w[k*4 + 1]),
+						_mm_mul_ps(slopeX, _mm_set1_ps(w[k*4]))), _mm_mul_ps(slopeZ, _mm_set1_ps(w[k*4 + 2])));
+				}
+				const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2])));
+				f32 normals[3][4];
+				for (u32 k = 0; k < 3; ++k)
+					_mm_storeu_ps(normals[k], _mm_div_ps(n[k], length));
+				for (u32 k = 0; k < 4; ++k)
+					outNormals[i + k].set(normals[0][k], normals[1][k], normals[2][k]);
+			}
 		}
+#endif
 
-		return height;
+		for (; i < count; ++i)
+		{
+			const f32 x = positions[i].X;
+			const f32 z = positions[i].Z;
+			const f32 gx = x * w[0] + z * w[8] + w[12];
+			const f32 gz = x * w[2] + z * w[10] + w[14];
+
+			f32 height = 0.f;
+			f32 slopeX = 0.f;
+			f32 slopeZ = 0.f;
+			if (!HeightField.empty() && sampleHeightField(gx, gz, sampling, height, slopeX, slopeZ))
+				outHeights[i] = gx * g[1] + height * g[5] + gz * g[9] + g[13];
+			else
+				outHeights[i] = -FLT_MAX;
+
+			if (outNormals)
+				outNormals[i] = getWorldNormal(slopeX, slopeZ);
+		}
+	}
+
+
+	//! Get the first intersection of a line with the terrain.
+	bool CTerrainSceneNode::getIntersectionWithLine(const core::line3df& line,
+			core::vector3df& outIntersection, core::vector3df* outNormal) const
+	{
+		if (HeightField.empty() || !TerrainData.PatchCount)
+			return false;
+
+		// the line in heightmap samples
+		core::vector3df start(line.start);
+		core::vector3df end(line.end);
+		WorldToGrid.transformVect(start);
+		WorldToGrid.transformVect(end);
+		const core::vector3df dir(end - start);
+
+		// clip it to the part of the heightmap covered by patches
+		const f32 extent = (f32)(TerrainData.PatchCount * TerrainData.CalcPatchSize);
+		f32 tStart = 0.f;
+		f32 tEnd = 1.f;
+		for (u32 axis = 0; axis < 3; axis += 2)
+		{
+			const f32 s = axis ? start.Z : start.X;
+			const f32 d = axis ? dir.Z : dir.X;
+			if (core::iszero(d))
+			{
+				if (s < 0.f || s > extent)
+					return false;
+				continue;
+			}
+			f32 t0 = -s / d;
+			f32 t1 = (extent - s) / d;
+			if (t0 > t1)
+				core::swap(t0, t1);
+			tStart = core::max_(tStart, t0);
+			tEnd = core::min_(tEnd, t1);
+		}
+		if (tStart > tEnd)
+			return false;
+
+		const s32 size = TerrainData.Size;
+		CGridWalk patchWalk(start, dir, tStart, tEnd, (f32)TerrainData.CalcPatchSize, TerrainData.PatchCount - 1);
+		s32 patchX, patchZ;
+		f32 patchT0, patchT1;
+		while (patchWalk.next(patchX, patchZ, patchT0, patchT1))
+		{
+			// skip patches the line passes above or below
+			const SPatch& patch = TerrainData.Patches[patchX * TerrainData.PatchCount + patchZ];
+			const f32 y0 = start.Y + dir.Y * patchT0;
+			const f32 y1 = start.Y + dir.Y * patchT1;
+			if (core::min_(y0, y1) > patch.MaxHeight || core::max_(y0, y1) < patch.MinHeight)
+				continue;
+
+			CGridWalk cellWalk(start, dir, patchT0, patchT1, 1.f, size - 2);
+			s32 x, z;
+			f32 t0, t1;
+			while (cellWalk.next(x, z, t0, t1))
+			{
+				const f32* h = &HeightField[x * size + z];
+				const f32 a = h[0];
+				const f32 b = h[size];
+				const f32 c = h[1];
+				const f32 d = h[size + 1];
+
+				// the line may cross the diagonal between the two triangles of the cell
+				const f32 u0 = (start.X + dir.X * t0 - x) - (start.Z + dir.Z * t0 - z);
+				const f32 u1 = (start.X + dir.X * t1 - x) - (start.Z + dir.Z * t1 - z);
+				f32 split[3] = { t0, t1, t1 };
+				u32 parts = 1;
+				if ((u0 > 0.f) != (u1 > 0.f) && u0 != u1)
+				{
+					split[1] = t0 + (t1 - t0) * u0 / (u0 - u1);
+					parts = 2;
+				}
+
+				for (u32 k = 0; k < parts; ++k)
+				{
+					const f32 ta = split[k];
+					const f32 tb = split[k + 1];
+					const f32 tm = (ta + tb) * 0.5f;
+					const f32 dx = start.X + dir.X * tm - x;
+					const f32 dz = start.Z + dir.Z * tm - z;
+
+					// the plane of the triangle, like sampleHeightField
+					f32 slopeX, slopeZ;
+					if (dx > dz)
+					{
+						slopeX = b - a;
+						slopeZ = d - b;
+					}
+					else
+					{
+						slopeX = d - c;
+						slopeZ = c - a;
+					}
+
+					// height of the line above the plane at ta and tb
+					const f32 fa = start.Y + dir.Y * ta -
+						(a + slopeX * (start.X + dir.X * ta - x) + slopeZ * (start.Z + dir.Z * ta - z));
+					const f32 fb = start.Y + dir.Y * tb -
+						(a + slopeX * (start.X + dir.X * tb - x) + slopeZ * (start.Z + dir.Z * tb - z));
+					if ((fa > 0.f) == (fb > 0.f))
+						continue;
+
+					const f32 t = ta + (tb - ta) * fa / (fa - fb);
+					outIntersection = start + dir * t;
+					GridToWorld.transformVect(outIntersection);
+					if (outNormal)
+						*outNormal = getWorldNormal(slopeX, slopeZ);
+					return true;
+				}
+			}
+		}
+
+		return false;
 	}
 
 
@@ -1473,6 +2061,7 @@ namespace scene
 		// scale textures
 
 		nb->scaleTexture(TCoordScale1, TCoordScale2);
+		nb->setLODMorphing(LODMorphing);
 
 		// copy materials
 
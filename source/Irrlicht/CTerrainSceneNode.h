@@ -12,6 +12,7 @@
 #include "ITerrainSceneNode.h"
 #include "IDynamicMeshBuffer.h"
 #include "path.h"
+#include "irrMap.h"
 
 namespace irr
 {
@@ -172,6 +173,14 @@ namespace scene
 		//! Returns center of terrain.
 		virtual f32 getHeight( f32 x, f32 y ) const _IRR_OVERRIDE_;
 
+		//! Get the heights and normals of the terrain at many points.
+		virtual void getHeights(const core::vector3df* positions, u32 count, f32* outHeights,
+			core::vector3df* outNormals=0, E_TERRAIN_HEIGHT_SAMPLING sampling=ETHS_TRIANGLE) const _IRR_OVERRIDE_;
+
+		//! Get the first intersection of a line with the terrain.
+		virtual bool getIntersectionWithLine(const core::line3df& line,
+			core::vector3df& outIntersection, core::vector3df* outNormal=0) const _IRR_OVERRIDE_;
+
 		//! Sets the movement camera threshold which is used to determine when to recalculate
 		//! indices for the scene node.  The default value is 10.0f.
 		virtual void setCameraMovementDelta(f32 delta) _IRR_OVERRIDE_
@@ -192,6 +201,9 @@ namespace scene
 		//! NOTE: Temporarily disabled while working out issues with DynamicSelectorUpdate
 		virtual void setDynamicSelectorUpdate(bool bVal ) _IRR_OVERRIDE_ { DynamicSelectorUpdate = false; }
 
+		//! Enable smooth transitions between the levels of detail of the patches.
+		virtual void setLODMorphing(bool enable) _IRR_OVERRIDE_;
+
 		//! Override the default generation of distance thresholds for determining the LOD a patch
 		//! is rendered at. If any LOD is overridden, then the scene node will no longer apply
 		//! scaling factors to these values. If you override these distances and then apply
@@ -223,7 +235,8 @@ namespace scene
 		struct SPatch
 		{
 			SPatch()
-			: Top(0), Bottom(0), Right(0), Left(0), CurrentLOD(-1)
+			: Top(0), Bottom(0), Right(0), Left(0), CurrentLOD(-1),
+				IndexKey(0xffffffff), IndexStart(0), MinHeight(0.f), MaxHeight(0.f)
 			{
 			}
 
@@ -232,6 +245,13 @@ namespace scene
 			SPatch* Right;
 			SPatch* Left;
 			s32 CurrentLOD;
+			//! key of the indices in the index buffer, 0xffffffff if none
+			u32 IndexKey;
+			//! position of the indices in the index buffer
+			u32 IndexStart;
+			//! height range of the heightmap samples, without scaling
+			f32 MinHeight;
+			f32 MaxHeight;
 			core::aabbox3df BoundingBox;
 			core::vector3df Center;
 		};
@@ -267,6 +287,34 @@ namespace scene
 		//! get indices when generating index data for patches at varying levels of detail.
 		u32 getIndex(const s32 PatchX, const s32 PatchZ, const s32 PatchIndex, u32 vX, u32 vZ) const;
 
+		//! get the LODs the borders of a patch are stitched to, 0 for borders which are not stitched
+		void getStitchedLODs(const SPatch& patch, s32 stitchedLOD[4]) const;
+
+		//! get the vertex of a patch relative to its first vertex, moved onto the coarser LOD of stitched borders
+		u32 getPatchVertex(const s32 stitchedLOD[4], u32 vX, u32 vZ) const;
+
+		//! get the key of the indices a patch needs with its LOD and the LODs of its neighbours
+		u32 getPatchIndexKey(const SPatch& patch) const;
+
+		//! get the indices of all patches with the same key, relative to their first vertex
+		const core::array<u32>& getPatchIndices(u32 key);
+
+		//! store the unmorphed vertex positions
+		void storeMorphStart();
+
+		//! morph the vertices of visible patches towards the next coarser LOD
+		void updateMorphing(const core::vector3df& cameraPosition);
+
+		//! copy the heights into the height field and store the height range of the patches
+		void storeHeightField();
+
+		//! get the interpolated height and its slopes at a position in heightmap samples
+		bool sampleHeightField(f32 x, f32 z, E_TERRAIN_HEIGHT_SAMPLING sampling,
+			f32& height, f32& slopeX, f32& slopeZ) const;
+
+		//! transform a slope in heightmap samples to a normal in world space
+		core::vector3df getWorldNormal(f32 slopeX, f32 slopeZ) const;
+
 		//! smooth the terrain
 		void smoothTerrain(IDynamicMeshBuffer* mb, s32 smoothFactor);
 
@@ -303,6 +351,7 @@ namespace scene
 		bool OverrideDistanceThreshold;
 		bool UseDefaultRotationPivot;
 		bool ForceRecalculation;
+		bool LODMorphing;
 
 		core::vector3df	OldCameraPosition;
 		core::vector3df	OldCameraRotation;
@@ -312,6 +361,20 @@ namespace scene
 		f32 CameraRotationDelta;
 		f32 CameraFOVDelta;
 
+		//! indices of the patch types in use, generated once for each key
+		core::map<u32, core::array<u32> > PatchIndices;
+
+		//! heights of the heightmap samples without scaling, row by row
+		core::array<f32> HeightField;
+		//! transformation from heightmap samples to world space and back
+		core::matrix4 GridToWorld;
+		core::matrix4 WorldToGrid;
+
+		//! unmorphed vertex positions
+		core::array<core::vector3df> MorphStart;
+		f32 MorphPatchRadius;
+		core::vector3df MorphCameraPosition;
+
 		// needed for (de)serialization
 		f32 TCoordScale1;
 		f32 TCoordScale2;
@@ -0,0 +1,576 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CWorkerPool.h"
+#include "irrMath.h"
+
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace irr
+{
+
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+
+#if defined(_IRR_WINDOWS_API_)
+
+struct CWorkerPool::SPlatformData
+{
+	CRITICAL_SECTION Mutex;
+	CONDITION_VARIABLE Start;
+	CONDITION_VARIABLE Done;
+};
+
+struct CBackgroundQueue::SPlatformData
+{
+	CRITICAL_SECTION Mutex;
+	CONDITION_VARIABLE Work;
+	CONDITION_VARIABLE Done;
+};
+
+namespace
+{
+	inline void lock(CRITICAL_SECTION& mutex) { EnterCriticalSection(&mutex); }
+	inline void unlock(CRITICAL_SECTION& mutex) { LeaveCriticalSection(&mutex); }
+	inline void wait(CONDITION_VARIABLE& cond, CRITICAL_SECTION& mutex) { SleepConditionVariableCS(&cond, &mutex, INFINITE); }
+	inline void signalAll(CONDITION_VARIABLE& cond) { WakeAllConditionVariable(&cond); }
+	inline long atomicIncrement(volatile long* value) { return InterlockedIncrement(value) - 1; }
+	inline long atomicDecrement(volatile long* value) { return InterlockedDecrement(value) + 1; }
+	inline void* atomicCompareExchange(void* volatile* value, void* exchange, void* comparand)
+	{
+		return InterlockedCompareExchangePointer(value, exchange, comparand);
+	}
+	inline void* atomicExchange(void* volatile* value, void* exchange) { return InterlockedExchangePointer(value, exchange); }
+
+	u32 getProcessorCount()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors;
+	}
+}
+
+#else
+
+struct CWorkerPool::SPlatformData
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t Start;
+	pthread_cond_t Done;
+};
+
+struct CBackgroundQueue::SPlatformData
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t Work;
+	pthread_cond_t Done;
+};
+
+namespace
+{
+	inline void lock(pthread_mutex_t& mutex) { pthread_mutex_lock(&mutex); }
+	inline void unlock(pthread_mutex_t& mutex) { pthread_mutex_unlock(&mutex); }
+	inline void wait(pthread_cond_t& cond, pthread_mutex_t& mutex) { pthread_cond_wait(&cond, &mutex); }
+	inline void signalAll(pthread_cond_t& cond) { pthread_cond_broadcast(&cond); }
+	inline long atomicIncrement(volatile long* value) { return __sync_fetch_and_add(value, 1); }
+	inline long atomicDecrement(volatile long* value) { return __sync_fetch_and_sub(value, 1); }
+	inline void* atomicCompareExchange(void* volatile* value, void* exchange, void* comparand)
+	{
+		return __sync_val_compare_and_swap(value, comparand, exchange);
+	}
+	inline void* atomicExchange(void* volatile* value, void* exchange)
+	{
+		__sync_synchronize();
+		return __sync_lock_test_and_set(value, exchange);
+	}
+
+	u32 getProcessorCount()
+	{
+		const long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (u32)count : 1;
+	}
+}
+
+#endif
+
+//! Threads started at most, more cores are rarely of use for the loops in the engine
+static const u32 MaxWorkerThreads = 15;
+
+
+//! constructor
+CWorkerPool::CWorkerPool()
+	: Platform(new SPlatformData), Function(0), UserData(0), Count(0), GrainSize(1),
+	RangeCount(0), NextRange(0), Generation(0), Running(0), Busy(false), Quit(false)
+{
+#if defined(_IRR_WINDOWS_API_)
+	InitializeCriticalSection(&Platform->Mutex);
+	InitializeConditionVariable(&Platform->Start);
+	InitializeConditionVariable(&Platform->Done);
+#else
+	pthread_mutex_init(&Platform->Mutex, 0);
+	pthread_cond_init(&Platform->Start, 0);
+	pthread_cond_init(&Platform->Done, 0);
+#endif
+
+	const u32 threadCount = core::min_(getProcessorCount(), MaxWorkerThreads+1) - 1;
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		SThreadStart* start = new SThreadStart;
+		start->Pool = this;
+		start->Worker = i+1;
+#if defined(_IRR_WINDOWS_API_)
+		HANDLE thread = CreateThread(0, 0, &threadMain, start, 0, 0);
+		if (!thread)
+#else
+		pthread_t* thread = new pthread_t;
+		if (pthread_create(thread, 0, &threadMain, start) != 0)
+#endif
+		{
+#if !defined(_IRR_WINDOWS_API_)
+			delete thread;
+#endif
+			delete start;
+			break;
+		}
+		Threads.push_back(thread);
+	}
+}
+
+
+//! destructor
+CWorkerPool::~CWorkerPool()
+{
+	lock(Platform->Mutex);
+	Quit = true;
+	signalAll(Platform->Start);
+	unlock(Platform->Mutex);
+
+	for (u32 i=0; i<Threads.size(); ++i)
+	{
+#if defined(_IRR_WINDOWS_API_)
+		WaitForSingleObject((HANDLE)Threads[i], INFINITE);
+		CloseHandle((HANDLE)Threads[i]);
+#else
+		pthread_t* thread = (pthread_t*)Threads[i];
+		pthread_join(*thread, 0);
+		delete thread;
+#endif
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	DeleteCriticalSection(&Platform->Mutex);
+#else
+	pthread_cond_destroy(&Platform->Done);
+	pthread_cond_destroy(&Platform->Start);
+	pthread_mutex_destroy(&Platform->Mutex);
+#endif
+	delete Platform;
+}
+
+
+//! Thread function of the workers
+#if defined(_IRR_WINDOWS_API_)
+unsigned long __stdcall
+#else
+void*
+#endif
+CWorkerPool::threadMain(void* start)
+{
+	SThreadStart* s = (SThreadStart*)start;
+	CWorkerPool* pool = s->Pool;
+	const u32 worker = s->Worker;
+	delete s;
+
+	pool->workerLoop(worker);
+	return 0;
+}
+
+
+//! Thread function of the workers
+void CWorkerPool::workerLoop(u32 worker)
+{
+	u32 seen = 0;
+	lock(Platform->Mutex);
+	while (true)
+	{
+		while (Generation == seen && !Quit)
+			wait(Platform->Start, Platform->Mutex);
+		if (Quit)
+			break;
+		seen = Generation;
+		unlock(Platform->Mutex);
+
+		runRanges(worker);
+
+		lock(Platform->Mutex);
+		if (--Running == 0)
+			signalAll(Platform->Done);
+	}
+	unlock(Platform->Mutex);
+}
+
+
+//! Calls function for all items in [0,count) and waits until all are done.
+void CWorkerPool::parallelFor(u32 count, u32 grainSize, RangeFunction function, void* userData)
+{
+	grainSize = core::max_(grainSize, 1u);
+	if (count <= grainSize || Threads.empty())
+	{
+		if (count)
+			function(userData, 0, count, 0);
+		return;
+	}
+
+	lock(Platform->Mutex);
+	if (Busy)
+	{
+		// nested or concurrent loop, the workers are used by someone else
+		unlock(Platform->Mutex);
+		function(userData, 0, count, 0);
+		return;
+	}
+	Busy = true;
+	Function = function;
+	UserData = userData;
+	Count = count;
+	GrainSize = grainSize;
+	RangeCount = (count + grainSize - 1) / grainSize;
+	NextRange = 0;
+	Running = Threads.size();
+	++Generation;
+	signalAll(Platform->Start);
+	unlock(Platform->Mutex);
+
+	runRanges(0);
+
+	lock(Platform->Mutex);
+	while (Running)
+		wait(Platform->Done, Platform->Mutex);
+	Busy = false;
+	unlock(Platform->Mutex);
+}
+
+
+//! constructor, starts the thread
+CBackgroundQueue::CBackgroundQueue()
+	: Platform(new SPlatformData), Thread(0), Running(false), Quit(false)
+{
+#if defined(_IRR_WINDOWS_API_)
+	InitializeCriticalSection(&Platform->Mutex);
+	InitializeConditionVariable(&Platform->Work);
+	InitializeConditionVariable(&Platform->Done);
+	Thread = CreateThread(0, 0, &threadMain, this, 0, 0);
+#else
+	pthread_mutex_init(&Platform->Mutex, 0);
+	pthread_cond_init(&Platform->Work, 0);
+	pthread_cond_init(&Platform->Done, 0);
+	pthread_t* thread = new pthread_t;
+	if (pthread_create(thread, 0, &threadMain, this) == 0)
+		Thread = thread;
+	else
+		delete thread;
+#endif
+}
+
+
+//! destructor, waits for the running job, queued jobs are not run
+CBackgroundQueue::~CBackgroundQueue()
+{
+	lock(Platform->Mutex);
+	Queued.clear();
+	Quit = true;
+	signalAll(Platform->Work);
+	unlock(Platform->Mutex);
+
+	if (Thread)
+	{
+#if defined(_IRR_WINDOWS_API_)
+		WaitForSingleObject((HANDLE)Thread, INFINITE);
+		CloseHandle((HANDLE)Thread);
+#else
+		pthread_t* thread = (pthread_t*)Thread;
+		pthread_join(*thread, 0);
+		delete thread;
+#endif
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	DeleteCriticalSection(&Platform->Mutex);
+#else
+	pthread_cond_destroy(&Platform->Done);
+	pthread_cond_destroy(&Platform->Work);
+	pthread_mutex_destroy(&Platform->Mutex);
+#endif
+	delete Platform;
+}
+
+
+//! Thread function
+#if defined(_IRR_WINDOWS_API_)
+unsigned long __stdcall
+#else
+void*
+#endif
+CBackgroundQueue::threadMain(void* queue)
+{
+	((CBackgroundQueue*)queue)->jobLoop();
+	return 0;
+}
+
+
+//! Thread function
+void CBackgroundQueue::jobLoop()
+{
+	lock(Platform->Mutex);
+	while (true)
+	{
+		while (Queued.empty() && !Quit)
+			wait(Platform->Work, Platform->Mutex);
+		if (Quit)
+			break;
+		const SJob job = Queued[0];
+		Queued.erase(0);
+		Running = true;
+		unlock(Platform->Mutex);
+
+		job.Function(job.UserData);
+
+		lock(Platform->Mutex);
+		Running = false;
+		Finished.push_back(job.UserData);
+		signalAll(Platform->Done);
+	}
+	unlock(Platform->Mutex);
+}
+
+
+//! Add a job at the end of the queue
+void CBackgroundQueue::push(JobFunction function, void* userData)
+{
+	if (!Thread)
+	{
+		function(userData);
+		Finished.push_back(userData);
+		return;
+	}
+
+	SJob job;
+	job.Function = function;
+	job.UserData = userData;
+	lock(Platform->Mutex);
+	Queued.push_back(job);
+	signalAll(Platform->Work);
+	unlock(Platform->Mutex);
+}
+
+
+//! Remove a job which has not started yet
+bool CBackgroundQueue::cancel(void* userData)
+{
+	bool removed = false;
+	lock(Platform->Mutex);
+	for (u32 i=0; i<Queued.size(); ++i)
+	{
+		if (Queued[i].UserData == userData)
+		{
+			Queued.erase(i);
+			removed = true;
+			break;
+		}
+	}
+	unlock(Platform->Mutex);
+	return removed;
+}
+
+
+//! Remove all jobs which have not started yet and wait for the running one
+void CBackgroundQueue::clear()
+{
+	lock(Platform->Mutex);
+	Queued.clear();
+	while (Running)
+		wait(Platform->Done, Platform->Mutex);
+	unlock(Platform->Mutex);
+}
+
+
+//! Wait until all jobs are done
+void CBackgroundQueue::waitForAll()
+{
+	lock(Platform->Mutex);
+	while (!Queued.empty() || Running)
+		wait(Platform->Done, Platform->Mutex);
+	unlock(Platform->Mutex);
+}
+
+
+//! Append the user data of the jobs done since the last call to finished
+void CBackgroundQueue::getFinished(core::array<void*>& finished)
+{
+	lock(Platform->Mutex);
+	for (u32 i=0; i<Finished.size(); ++i)
+		finished.push_back(Finished[i]);
+	Finished.set_used(0);
+	unlock(Platform->Mutex);
+}
+
+#else // _IRR_COMPILE_WITH_WORKER_THREADS_
+
+struct CWorkerPool::SPlatformData
+{
+};
+
+//! constructor
+CWorkerPool::CWorkerPool()
+	: Platform(0), Function(0), UserData(0), Count(0), GrainSize(1),
+	RangeCount(0), NextRange(0), Generation(0), Running(0), Busy(false), Quit(false)
+{
+}
+
+
+//! destructor
+CWorkerPool::~CWorkerPool()
+{
+}
+
+
+//! Calls function for all items in [0,count) and waits until all are done.
+void CWorkerPool::parallelFor(u32 count, u32 grainSize, RangeFunction function, void* userData)
+{
+	if (count)
+		function(userData, 0, count, 0);
+}
+
+
+//! constructor
+CBackgroundQueue::CBackgroundQueue()
+	: Platform(0), Thread(0), Running(false), Quit(false)
+{
+}
+
+
+//! destructor
+CBackgroundQueue::~CBackgroundQueue()
+{
+}
+
+
+//! Runs the job right away
+void CBackgroundQueue::push(JobFunction function, void* userData)
+{
+	function(userData);
+	Finished.push_back(userData);
+}
+
+
+//! Jobs are never queued
+bool CBackgroundQueue::cancel(void* userData)
+{
+	return false;
+}
+
+
+//! Jobs are never queued
+void CBackgroundQueue::clear()
+{
+}
+
+
+//! Jobs are never queued
+void CBackgroundQueue::waitForAll()
+{
+}
+
+
+//! Append the user data of the jobs done since the last call to finished
+void CBackgroundQueue::getFinished(core::array<void*>& finished)
+{
+	for (u32 i=0; i<Finished.size(); ++i)
+		finished.push_back(Finished[i]);
+	Finished.set_used(0);
+}
+
+#endif // _IRR_COMPILE_WITH_WORKER_THREADS_
+
+
+CWorkerPool* volatile CWorkerPool::Instance = 0;
+volatile long CWorkerPool::DeviceCount = 0;
+
+
+//! Get the pool of this process, it is created on the first call
+CWorkerPool& CWorkerPool::getInstance()
+{
+	CWorkerPool* pool = Instance;
+	if (pool)
+		return *pool;
+
+	pool = new CWorkerPool();
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+	// another thread may have created one meanwhile, the first one wins
+	CWorkerPool* other = (CWorkerPool*)atomicCompareExchange((void* volatile*)&Instance, pool, 0);
+	if (other)
+	{
+		delete pool;
+		return *other;
+	}
+#else
+	Instance = pool;
+#endif
+	return *pool;
+}
+
+
+//! Called by each device when it is created
+void CWorkerPool::grabInstance()
+{
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+	atomicIncrement(&DeviceCount);
+#else
+	++DeviceCount;
+#endif
+}
+
+
+//! Called by each device when it is destroyed, the last one stops the threads
+void CWorkerPool::dropInstance()
+{
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+	if (atomicDecrement(&DeviceCount) != 1)
+		return;
+	CWorkerPool* pool = (CWorkerPool*)atomicExchange((void* volatile*)&Instance, 0);
+#else
+	if (--DeviceCount != 0)
+		return;
+	CWorkerPool* pool = Instance;
+	Instance = 0;
+#endif
+	delete pool;
+}
+
+
+//! Work on ranges of the current loop until none is left
+void CWorkerPool::runRanges(u32 worker)
+{
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+	while (true)
+	{
+		const u32 range = (u32)atomicIncrement(&NextRange);
+		if (range >= RangeCount)
+			break;
+
+		const u32 begin = range * GrainSize;
+		Function(UserData, begin, core::min_(begin + GrainSize, Count), worker);
+	}
+#endif
+}
+
+} // end namespace irr
+
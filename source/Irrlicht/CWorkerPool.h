@@ -0,0 +1,195 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_WORKER_POOL_H_INCLUDED__
+#define __C_WORKER_POOL_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "irrTypes.h"
+#include "irrArray.h"
+
+namespace irr
+{
+
+	//! Threads which split loops over many items between all processor cores.
+	/** There is one pool per process, created on the first call of getInstance().
+	Each device holds a reference with grabInstance(), the threads are stopped when
+	the last device is destroyed. A pool used while no device exists is never
+	stopped, so no threads are joined during static destruction, which can deadlock
+	in a DLL. The calling thread always works as well, so a pool on a single core
+	machine has no threads at all. Without _IRR_COMPILE_WITH_WORKER_THREADS_ all
+	work runs on the calling thread. */
+	class CWorkerPool
+	{
+	public:
+
+		//! Function working on the items [begin,end) of a loop
+		/** \param userData Pointer given to parallelFor
+		\param begin First item
+		\param end Item behind the last one
+		\param worker Index of the thread doing the work, below getWorkerCount().
+		Two ranges with the same index are never worked on at the same time, so it
+		can select scratch memory. */
+		typedef void (*RangeFunction)(void* userData, u32 begin, u32 end, u32 worker);
+
+		//! Get the pool of this process, it is created on the first call
+		/** Thread-safe. Don't keep the reference beyond the current loop, the
+		pool is deleted when the last device drops it. */
+		static CWorkerPool& getInstance();
+
+		//! Called by each device when it is created
+		static void grabInstance();
+
+		//! Called by each device when it is destroyed, the last one stops the threads
+		static void dropInstance();
+
+		//! Number of threads working on a loop, including the calling thread
+		u32 getWorkerCount() const
+		{
+			return Threads.size() + 1;
+		}
+
+		//! Calls function for all items in [0,count) and waits until all are done.
+		/** The items are split into ranges of grainSize items, which are given
+		to the workers as they become free. Everything runs on the calling thread
+		when count is not larger than grainSize or the pool is already busy, for
+		example with a parallelFor called from inside a range function. */
+		void parallelFor(u32 count, u32 grainSize, RangeFunction function, void* userData);
+
+		//! Calls body(begin, end, worker) for all items in [0,count), see the other parallelFor
+		template <class T>
+		void parallelFor(u32 count, u32 grainSize, T& body)
+		{
+			parallelFor(count, grainSize, &callBody<T>, &body);
+		}
+
+	private:
+
+		CWorkerPool();
+		~CWorkerPool();
+
+		template <class T>
+		static void callBody(void* userData, u32 begin, u32 end, u32 worker)
+		{
+			(*(T*)userData)(begin, end, worker);
+		}
+
+		//! Work on ranges of the current loop until none is left
+		void runRanges(u32 worker);
+
+		//! Thread function of the workers
+		void workerLoop(u32 worker);
+
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+		struct SThreadStart
+		{
+			CWorkerPool* Pool;
+			u32 Worker;
+		};
+		static
+#if defined(_IRR_WINDOWS_API_)
+		unsigned long __stdcall
+#else
+		void*
+#endif
+		threadMain(void* start);
+#endif
+
+		struct SPlatformData;
+		SPlatformData* Platform;
+		core::array<void*> Threads;
+
+		//! the pool of this process, 0 until it is used
+		static CWorkerPool* volatile Instance;
+		//! number of devices holding the pool
+		static volatile long DeviceCount;
+
+		// the loop which is worked on, protected by the mutex of the platform data
+		RangeFunction Function;
+		void* UserData;
+		u32 Count;
+		u32 GrainSize;
+		u32 RangeCount;
+		//! next range to take, only changed with atomic increments
+		volatile long NextRange;
+		//! increased for each loop, so workers see that there is new work
+		u32 Generation;
+		//! workers not yet done with the current loop
+		u32 Running;
+		bool Busy;
+		bool Quit;
+	};
+
+
+	//! A thread working through a queue of jobs in the background.
+	/** Jobs run one after another in the order they were added. The thread
+	adding them picks up the finished ones with getFinished(), so results are
+	used on that thread only. Unlike CWorkerPool a queue always starts its
+	thread, as it is meant to hide latency like file reading, not to use more
+	cores. Without _IRR_COMPILE_WITH_WORKER_THREADS_ jobs run right away in push(). */
+	class CBackgroundQueue
+	{
+	public:
+
+		//! Function doing a job
+		typedef void (*JobFunction)(void* userData);
+
+		//! constructor, starts the thread
+		CBackgroundQueue();
+
+		//! destructor, waits for the running job, queued jobs are not run
+		~CBackgroundQueue();
+
+		//! Add a job at the end of the queue
+		void push(JobFunction function, void* userData);
+
+		//! Remove a job which has not started yet
+		/** \return True if the job was removed, false if it is running or done */
+		bool cancel(void* userData);
+
+		//! Remove all jobs which have not started yet and wait for the running one
+		void clear();
+
+		//! Wait until all jobs are done
+		void waitForAll();
+
+		//! Append the user data of the jobs done since the last call to finished
+		void getFinished(core::array<void*>& finished);
+
+	private:
+
+		//! Thread function
+		void jobLoop();
+
+#ifdef _IRR_COMPILE_WITH_WORKER_THREADS_
+		static
+#if defined(_IRR_WINDOWS_API_)
+		unsigned long __stdcall
+#else
+		void*
+#endif
+		threadMain(void* queue);
+#endif
+
+		struct SJob
+		{
+			JobFunction Function;
+			void* UserData;
+		};
+
+		struct SPlatformData;
+		SPlatformData* Platform;
+		void* Thread;
+
+		// protected by the mutex of the platform data
+		core::array<SJob> Queued;
+		core::array<void*> Finished;
+		bool Running;
+		bool Quit;
+	};
+
+} // end namespace irr
+
+#endif
+
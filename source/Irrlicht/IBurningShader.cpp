@@ -8,9 +8,32 @@
 #include "SoftwareDriver2_compile_config.h"
 #include "IBurningShader.h"
 #include "CSoftwareDriver2.h"
+#include "CDXTCodec.h"
+#include "CColorConverter.h"
 
 namespace irr
 {
+
+	//! forget all blocks
+	void sBlockCache::reset ( video::ECOLOR_FORMAT blockFormat )
+	{
+		memset ( block, 0, sizeof ( block ) );
+		format = blockFormat;
+	}
+
+	//! decode a block into a slot
+	void sBlockCache::decode ( u32 slot, const u8 *blockData )
+	{
+		block[slot] = blockData;
+#ifdef SOFTWARE_DRIVER_2_32BIT
+		video::CDXTCodec::decodeBlock ( blockData, format, texel[slot] );
+#else
+		u32 argb[16];
+		video::CDXTCodec::decodeBlock ( blockData, format, argb );
+		video::CColorConverter::convert_A8R8G8B8toA1R5G5B5 ( argb, 16, texel[slot] );
+#endif
+	}
+
 namespace video
 {
 
@@ -31,6 +54,9 @@ namespace video
 		for ( u32 i = 0; i != BURNING_MATERIAL_MAX_TEXTURES; ++i )
 		{
 			IT[i].Texture = 0;
+			IT[i].blocks = 0;
+			IT[i].cache = 0;
+			IT[i].modificationCount = 0;
 		}
 
 		Driver = driver;
@@ -63,6 +89,8 @@ namespace video
 		{
 			if ( IT[i].Texture )
 				IT[i].Texture->drop();
+
+			delete IT[i].cache;
 		}
 	}
 
@@ -88,6 +116,8 @@ namespace video
 	{
 		sInternalTexture *it = &IT[stage];
 
+		bool changed = it->Texture != texture;
+
 		if ( it->Texture)
 			it->Texture->drop();
 
@@ -100,13 +130,46 @@ namespace video
 			// select mignify and magnify ( lodLevel )
 			//SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS
 			it->lodLevel = lodLevel;
-			it->data = (tVideoSample*) it->Texture->lock(ETLM_READ_ONLY,
+			void* data = it->Texture->lock(ETLM_READ_ONLY,
 				core::s32_clamp ( lodLevel + SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS, 0, SOFTWARE_DRIVER_2_MIPMAPPING_MAX - 1 ), 0);
 
-			// prepare for optimal fixpoint
-			it->pitchlog2 = s32_log2_s32 ( it->Texture->getPitch() );
-
 			const core::dimension2d<u32> &dim = it->Texture->getSize();
+			const ECOLOR_FORMAT format = it->Texture->getColorFormat();
+
+			if ( IImage::isCompressedFormat ( format ) )
+			{
+				// blocks stay compressed, getTexel decodes them through the cache
+				if ( 0 == it->cache )
+				{
+					it->cache = new sBlockCache;
+					changed = true;
+				}
+				// texels changed in place keep their addresses, so they are told apart by the count
+				if ( it->modificationCount != it->Texture->getModificationCount() )
+				{
+					it->modificationCount = it->Texture->getModificationCount();
+					changed = true;
+				}
+				if ( changed )
+					it->cache->reset ( format );
+
+				it->data = 0;
+				it->blocks = (const u8*) data;
+				it->blockSizelog2 = s32_log2_s32 ( IImage::getDataSizeFromFormat ( format, 4, 4 ) );
+				it->blockPitchlog2 = s32_log2_s32 ( core::max_ ( dim.Width >> 2, 1u ) ) + it->blockSizelog2;
+
+				// prepare for optimal fixpoint
+				it->pitchlog2 = s32_log2_s32 ( dim.Width * sizeof ( tVideoSample ) );
+			}
+			else
+			{
+				it->data = (tVideoSample*) data;
+				it->blocks = 0;
+
+				// prepare for optimal fixpoint
+				it->pitchlog2 = s32_log2_s32 ( it->Texture->getPitch() );
+			}
+
 			it->textureXMask = s32_to_fixPoint ( dim.Width - 1 ) & FIX_POINT_UNSIGNED_MASK;
 			it->textureYMask = s32_to_fixPoint ( dim.Height - 1 ) & FIX_POINT_UNSIGNED_MASK;
 		}
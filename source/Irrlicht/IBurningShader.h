@@ -113,6 +113,7 @@ namespace video
 
 		ETR_NORMAL_MAP_SOLID,
 		ETR_STENCIL_SHADOW,
+		ETR_DEPTH_WRITE,
 
 		ETR_TEXTURE_BLEND,
 		ETR_REFERENCE,
@@ -189,6 +190,7 @@ namespace video
 
 	IBurningShader* createTRNormalMap(CBurningVideoDriver* driver);
 	IBurningShader* createTRStencilShadow(CBurningVideoDriver* driver);
+	IBurningShader* createTRDepthWrite(CBurningVideoDriver* driver);
 
 	IBurningShader* createTriangleRendererReference(CBurningVideoDriver* driver);
 
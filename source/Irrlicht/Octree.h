@@ -10,6 +10,7 @@
 #include "aabbox3d.h"
 #include "irrArray.h"
 #include "CMeshBuffer.h"
+#include "CLooseOctree.h"
 
 /**
 	Flags for Octree
@@ -28,7 +29,11 @@ namespace irr
 
 //! template octree.
 /** T must be a vertex type which has a member
-called .Pos, which is a core::vertex3df position. */
+called .Pos, which is a core::vertex3df position.
+The triangles of each mesh buffer are sorted into chunks of nearby
+triangles, so the indices of a chunk are a contiguous range. The ranges
+are stored in a loose octree, no indices are copied into the tree or
+when collecting the visible triangles. */
 template <class T>
 class Octree
 {
@@ -50,339 +55,152 @@ public:
 		s32 MaterialId;
 	};
 
-	struct SIndexChunk
+	//! A range of the indices of a mesh buffer
+	struct SIndexRange
 	{
-		core::array<u16> Indices;
-		s32 MaterialId;
-	};
-
-	struct SIndexData
-	{
-		u16* Indices;
-		s32 CurrentSize;
-		s32 MaxSize;
+		u32 MeshBuffer;
+		u32 First;
+		u32 Count;
 	};
 
 
 	//! Constructor
-	Octree(const core::array<SMeshChunk>& meshes, s32 minimalPolysPerNode=128) :
-		IndexData(0), IndexDataCount(meshes.size()), NodeCount(0)
+	/** Reorders the indices of the meshes, so the triangles of each chunk are
+	next to each other.
+	\param meshes Mesh buffers, their indices are reordered.
+	\param minimalPolysPerNode Largest number of triangles in a chunk. */
+	Octree(core::array<SMeshChunk>& meshes, s32 minimalPolysPerNode=128) :
+		Tree(getBounds(meshes))
 	{
-		IndexData = new SIndexData[IndexDataCount];
-
-		// construct array of all indices
-
-		core::array<SIndexChunk>* indexChunks = new core::array<SIndexChunk>;
-		indexChunks->reallocate(meshes.size());
+		core::array<core::vector3df> centers;
+		core::array<u32> order;
+		core::array<u32> chunkEnds;
+		core::array<u16> indices;
 		for (u32 i=0; i!=meshes.size(); ++i)
 		{
-			IndexData[i].CurrentSize = 0;
-			IndexData[i].MaxSize = meshes[i].Indices.size();
-			IndexData[i].Indices = new u16[IndexData[i].MaxSize];
+			// sort the triangles into chunks
+			const core::array<T>& vertices = meshes[i].Vertices;
+			const u32 triangleCount = meshes[i].Indices.size() / 3;
+			centers.set_used(triangleCount);
+			for (u32 t=0; t<triangleCount; ++t)
+			{
+				const u16* tri = &meshes[i].Indices[t*3];
+				centers[t] = (vertices[tri[0]].Pos + vertices[tri[1]].Pos + vertices[tri[2]].Pos) / 3.f;
+			}
+			scene::CLooseOctree::sortIntoChunks(centers, core::max_(minimalPolysPerNode, 1), order, chunkEnds);
 
-			indexChunks->push_back(SIndexChunk());
-			SIndexChunk& tic = indexChunks->getLast();
+			indices.set_used(triangleCount * 3);
+			for (u32 t=0; t<triangleCount; ++t)
+				memcpy(&indices[t*3], &meshes[i].Indices[order[t]*3], 3*sizeof(u16));
+			meshes[i].Indices = indices;
 
-			tic.MaterialId = meshes[i].MaterialId;
-			tic.Indices = meshes[i].Indices;
+			// one item for each chunk
+			u32 first = 0;
+			for (u32 c=0; c<chunkEnds.size(); ++c)
+			{
+				core::aabbox3df box(vertices[indices[first*3]].Pos);
+				for (u32 j=first*3; j<chunkEnds[c]*3; ++j)
+					box.addInternalPoint(vertices[indices[j]].Pos);
+
+				SIndexRange range;
+				range.MeshBuffer = i;
+				range.First = first * 3;
+				range.Count = (chunkEnds[c] - first) * 3;
+				Tree.insert(box, Ranges.size());
+				Ranges.push_back(range);
+				first = chunkEnds[c];
+			}
 		}
-
-		// create tree
-		Root = new OctreeNode(NodeCount, 0, meshes, indexChunks, minimalPolysPerNode);
 	}
 
-	//! returns all ids of polygons partially or fully enclosed
+	//! finds the index ranges of polygons partially or fully enclosed
 	//! by this bounding box.
 	void calculatePolys(const core::aabbox3d<f32>& box)
 	{
-		for (u32 i=0; i!=IndexDataCount; ++i)
-			IndexData[i].CurrentSize = 0;
-
-		Root->getPolys(box, IndexData, 0);
+		Visible.set_used(0);
+		Tree.getItems(box, Visible);
+		mergeVisibleRanges();
 	}
 
-	//! returns all ids of polygons partially or fully enclosed
+	//! finds the index ranges of polygons partially or fully enclosed
 	//! by a view frustum.
 	void calculatePolys(const scene::SViewFrustum& frustum)
 	{
-		for (u32 i=0; i!=IndexDataCount; ++i)
-			IndexData[i].CurrentSize = 0;
-
-		Root->getPolys(frustum, IndexData, 0);
+		Visible.set_used(0);
+		Tree.getItems(frustum, Visible);
+		mergeVisibleRanges();
 	}
 
-	const SIndexData* getIndexData() const
+	//! index ranges found by the last calculatePolys call
+	/** Sorted by mesh buffer and position in the index array, adjacent
+	ranges are merged. */
+	const core::array<SIndexRange>& getVisibleRanges() const
 	{
-		return IndexData;
-	}
-
-	u32 getIndexDataCount() const
-	{
-		return IndexDataCount;
+		return VisibleRanges;
 	}
 
 	u32 getNodeCount() const
 	{
-		return NodeCount;
+		return Tree.getNodeCount();
 	}
 
 	//! for debug purposes only, collects the bounding boxes of the tree
 	void getBoundingBoxes(const core::aabbox3d<f32>& box,
-		core::array< const core::aabbox3d<f32>* >&outBoxes) const
-	{
-		Root->getBoundingBoxes(box, outBoxes);
-	}
-
-	//! destructor
-	~Octree()
+		core::array< core::aabbox3d<f32> >&outBoxes) const
 	{
-		for (u32 i=0; i<IndexDataCount; ++i)
-			delete [] IndexData[i].Indices;
-
-		delete [] IndexData;
-		delete Root;
+		Tree.getBoundingBoxes(box, outBoxes);
 	}
 
 private:
-	// private inner class
-	class OctreeNode
-	{
-	public:
 
-		// constructor
-		OctreeNode(u32& nodeCount, u32 currentdepth,
-			const core::array<SMeshChunk>& allmeshdata,
-			core::array<SIndexChunk>* indices,
-			s32 minimalPolysPerNode) : IndexData(0),
-			Depth(currentdepth+1)
+	//! bounding box of all vertices
+	static core::aabbox3df getBounds(const core::array<SMeshChunk>& meshes)
+	{
+		core::aabbox3df box;
+		bool first = true;
+		for (u32 i=0; i<meshes.size(); ++i)
 		{
-			++nodeCount;
-
-			u32 i; // new ISO for scoping problem with different compilers
-
-			for (i=0; i!=8; ++i)
-				Children[i] = 0;
-
-			if (indices->empty())
+			for (u32 v=0; v<meshes[i].Vertices.size(); ++v)
 			{
-				delete indices;
-				return;
-			}
-
-			bool found = false;
-
-			// find first point for bounding box
-
-			for (i=0; i<indices->size(); ++i)
-			{
-				if (!(*indices)[i].Indices.empty())
-				{
-					Box.reset(allmeshdata[i].Vertices[(*indices)[i].Indices[0]].Pos);
-					found = true;
-					break;
-				}
-			}
-
-			if (!found)
-			{
-				delete indices;
-				return;
-			}
-
-			s32 totalPrimitives = 0;
-
-			// now lets calculate our bounding box
-			for (i=0; i<indices->size(); ++i)
-			{
-				totalPrimitives += (*indices)[i].Indices.size();
-				for (u32 j=0; j<(*indices)[i].Indices.size(); ++j)
-					Box.addInternalPoint(allmeshdata[i].Vertices[(*indices)[i].Indices[j]].Pos);
-			}
-
-			core::vector3df middle = Box.getCenter();
-			core::vector3df edges[8];
-			Box.getEdges(edges);
-
-			// calculate all children
-			core::aabbox3d<f32> box;
-			core::array<u16> keepIndices;
-
-			if (totalPrimitives > minimalPolysPerNode && !Box.isEmpty())
-			for (u32 ch=0; ch!=8; ++ch)
-			{
-				box.reset(middle);
-				box.addInternalPoint(edges[ch]);
-
-				// create indices for child
-				bool added = false;
-				core::array<SIndexChunk>* cindexChunks = new core::array<SIndexChunk>;
-				cindexChunks->reallocate(allmeshdata.size());
-				for (i=0; i<allmeshdata.size(); ++i)
-				{
-					cindexChunks->push_back(SIndexChunk());
-					SIndexChunk& tic = cindexChunks->getLast();
-					tic.MaterialId = allmeshdata[i].MaterialId;
-
-					for (u32 t=0; t<(*indices)[i].Indices.size(); t+=3)
-					{
-						if (box.isPointInside(allmeshdata[i].Vertices[(*indices)[i].Indices[t]].Pos) &&
-							box.isPointInside(allmeshdata[i].Vertices[(*indices)[i].Indices[t+1]].Pos) &&
-							box.isPointInside(allmeshdata[i].Vertices[(*indices)[i].Indices[t+2]].Pos))
-						{
-							tic.Indices.push_back((*indices)[i].Indices[t]);
-							tic.Indices.push_back((*indices)[i].Indices[t+1]);
-							tic.Indices.push_back((*indices)[i].Indices[t+2]);
-
-							added = true;
-						}
-						else
-						{
-							keepIndices.push_back((*indices)[i].Indices[t]);
-							keepIndices.push_back((*indices)[i].Indices[t+1]);
-							keepIndices.push_back((*indices)[i].Indices[t+2]);
-						}
-					}
-
-					(*indices)[i].Indices.set_used(keepIndices.size());
-					memcpy( (*indices)[i].Indices.pointer(), keepIndices.pointer(), keepIndices.size()*sizeof(u16));
-					keepIndices.set_used(0);
-				}
-
-				if (added)
-					Children[ch] = new OctreeNode(nodeCount, Depth,
-						allmeshdata, cindexChunks, minimalPolysPerNode);
+				if (first)
+					box.reset(meshes[i].Vertices[v].Pos);
 				else
-					delete cindexChunks;
-
-			} // end for all possible children
-
-			IndexData = indices;
-		}
-
-		// destructor
-		~OctreeNode()
-		{
-			delete IndexData;
-
-			for (u32 i=0; i<8; ++i)
-				delete Children[i];
-		}
-
-		// returns all ids of polygons partially or full enclosed
-		// by this bounding box.
-		void getPolys(const core::aabbox3d<f32>& box, SIndexData* idxdata, u32 parentTest ) const
-		{
-#if defined (OCTREE_PARENTTEST )
-			// if not full inside
-			if ( parentTest != 2 )
-			{
-				// partially inside ?
-				if (!Box.intersectsWithBox(box))
-					return;
-
-				// fully inside ?
-				parentTest = Box.isFullInside(box)?2:1;
-			}
-#else
-			if (Box.intersectsWithBox(box))
-#endif
-			{
-				const u32 cnt = IndexData->size();
-				u32 i; // new ISO for scoping problem in some compilers
-
-				for (i=0; i<cnt; ++i)
-				{
-					const s32 idxcnt = (*IndexData)[i].Indices.size();
-
-					if (idxcnt)
-					{
-						memcpy(&idxdata[i].Indices[idxdata[i].CurrentSize],
-							&(*IndexData)[i].Indices[0], idxcnt * sizeof(s16));
-						idxdata[i].CurrentSize += idxcnt;
-					}
-				}
-
-				for (i=0; i!=8; ++i)
-					if (Children[i])
-						Children[i]->getPolys(box, idxdata,parentTest);
+					box.addInternalPoint(meshes[i].Vertices[v].Pos);
+				first = false;
 			}
 		}
+		return box;
+	}
 
-		// returns all ids of polygons partially or full enclosed
-		// by the view frustum.
-		void getPolys(const scene::SViewFrustum& frustum, SIndexData* idxdata,u32 parentTest) const
-		{
-			u32 i; // new ISO for scoping problem in some compilers
-
-			// if parent is fully inside, no further check for the children is needed
-#if defined (OCTREE_PARENTTEST )
-			if ( parentTest != 2 )
-#endif
-			{
-#if defined (OCTREE_PARENTTEST )
-				parentTest = 2;
-#endif
-				for (i=0; i!=scene::SViewFrustum::VF_PLANE_COUNT; ++i)
-				{
-					core::EIntersectionRelation3D r = Box.classifyPlaneRelation(frustum.planes[i]);
-					if ( r == core::ISREL3D_FRONT )
-						return;
-#if defined (OCTREE_PARENTTEST )
-					if ( r == core::ISREL3D_CLIPPED )
-						parentTest = 1;	// must still check children
-#endif
-				}
-			}
-
-
-			const u32 cnt = IndexData->size();
+	//! sort the ranges of the visible chunks and merge adjacent ones
+	void mergeVisibleRanges()
+	{
+		// ranges were created in the order of the mesh buffers and indices
+		Visible.sort();
 
-			for (i=0; i!=cnt; ++i)
+		VisibleRanges.set_used(0);
+		for (u32 i=0; i<Visible.size(); ++i)
+		{
+			const SIndexRange& range = Ranges[Visible[i]];
+			if (!VisibleRanges.empty())
 			{
-				s32 idxcnt = (*IndexData)[i].Indices.size();
-
-				if (idxcnt)
+				SIndexRange& last = VisibleRanges.getLast();
+				if (last.MeshBuffer == range.MeshBuffer && last.First + last.Count == range.First)
 				{
-					memcpy(&idxdata[i].Indices[idxdata[i].CurrentSize],
-						&(*IndexData)[i].Indices[0], idxcnt * sizeof(s16));
-					idxdata[i].CurrentSize += idxcnt;
+					last.Count += range.Count;
+					continue;
 				}
 			}
-
-			for (i=0; i!=8; ++i)
-				if (Children[i])
-					Children[i]->getPolys(frustum, idxdata,parentTest);
-		}
-
-		//! for debug purposes only, collects the bounding boxes of the node
-		void getBoundingBoxes(const core::aabbox3d<f32>& box,
-			core::array< const core::aabbox3d<f32>* >&outBoxes) const
-		{
-			if (Box.intersectsWithBox(box))
-			{
-				outBoxes.push_back(&Box);
-
-				for (u32 i=0; i!=8; ++i)
-					if (Children[i])
-						Children[i]->getBoundingBoxes(box, outBoxes);
-			}
+			VisibleRanges.push_back(range);
 		}
+	}
 
-	private:
-
-		core::aabbox3df Box;
-		core::array<SIndexChunk>* IndexData;
-		OctreeNode* Children[8];
-		u32 Depth;
-	};
-
-	OctreeNode* Root;
-	SIndexData* IndexData;
-	u32 IndexDataCount;
-	u32 NodeCount;
+	scene::CLooseOctree Tree;
+	core::array<SIndexRange> Ranges;
+	core::array<u32> Visible;
+	core::array<SIndexRange> VisibleRanges;
 };
 
 } // end namespace
 
 #endif
-
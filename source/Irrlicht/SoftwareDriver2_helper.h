@@ -699,6 +699,27 @@ struct fp24
 
 // ------------------------ Internal Texture -----------------------------
 
+/*!
+	decoded 4x4 blocks of a compressed texture.
+	direct mapped by the block position, so an area of 32x32 texels stays
+	decoded. blocks are told apart by their address, so the cache is reset
+	whenever the texture or its modification count changes.
+*/
+struct sBlockCache
+{
+	enum { SIZE_LOG2 = 3, MASK = ( 1 << SIZE_LOG2 ) - 1, SIZE = 1 << ( SIZE_LOG2 * 2 ) };
+
+	//! forget all blocks
+	void reset ( video::ECOLOR_FORMAT blockFormat );
+
+	//! decode a block into a slot
+	void decode ( u32 slot, const u8 *blockData );
+
+	const u8 *block[SIZE];
+	tVideoSample texel[SIZE][16];
+	video::ECOLOR_FORMAT format;
+};
+
 struct sInternalTexture
 {
 	u32 textureXMask;
@@ -707,11 +728,37 @@ struct sInternalTexture
 	u32 pitchlog2;
 	void *data;
 
+	// compressed textures set blocks instead of data, pitchlog2 is then the one of the decoded texture
+	const u8 *blocks;
+	u32 blockPitchlog2;
+	u32 blockSizelog2;
+	sBlockCache *cache;
+	u32 modificationCount;
+
 	video::CSoftwareTexture2 *Texture;
 	s32 lodLevel;
 };
 
 
+// get texel at byte offset ofs, compressed textures are decoded through the block cache
+REALINLINE tVideoSample getTexel ( const sInternalTexture * t, const u32 ofs )
+{
+	if ( 0 == t->blocks )
+		return *((tVideoSample*)( (u8*) t->data + ofs ));
+
+	const u32 x = ( ofs & ( ( 1 << t->pitchlog2 ) - 1 ) ) >> VIDEO_SAMPLE_GRANULARITY;
+	const u32 y = ofs >> t->pitchlog2;
+
+	const u32 slot = ( ( y >> 2 ) & sBlockCache::MASK ) << sBlockCache::SIZE_LOG2 | ( ( x >> 2 ) & sBlockCache::MASK );
+	const u8 *block = t->blocks + ( ( ( y >> 2 ) << t->blockPitchlog2 ) | ( ( x >> 2 ) << t->blockSizelog2 ) );
+
+	if ( t->cache->block[slot] != block )
+		t->cache->decode ( slot, block );
+
+	return t->cache->texel[slot][ ( ( y & 3 ) << 2 ) | ( x & 3 ) ];
+}
+
+
 
 // get video sample plain
 inline tVideoSample getTexel_plain ( const sInternalTexture * t, const tFixPointu tx, const tFixPointu ty )
@@ -722,7 +769,7 @@ inline tVideoSample getTexel_plain ( const sInternalTexture * t, const tFixPoint
 	ofs |= ( tx & t->textureXMask ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 
 	// texel
-	return *((tVideoSample*)( (u8*) t->data + ofs ));
+	return getTexel ( t, ofs );
 }
 
 // get video sample to fix
@@ -737,7 +784,7 @@ inline void getTexel_fix ( tFixPoint &r, tFixPoint &g, tFixPoint &b,
 
 	// texel
 	tVideoSample t00;
-	t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	t00 = getTexel ( t, ofs );
 
 	r = (t00 & MASK_R) >> ( SHIFT_R - FIX_POINT_PRE);
 	g = (t00 & MASK_G) << ( FIX_POINT_PRE - SHIFT_G );
@@ -756,7 +803,7 @@ REALINLINE void getTexel_fix ( tFixPoint &a,
 
 	// texel
 	tVideoSample t00;
-	t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	t00 = getTexel ( t, ofs );
 
 	a = (t00 & MASK_A) >> ( SHIFT_A - FIX_POINT_PRE);
 }
@@ -785,7 +832,7 @@ inline void getSample_texture_dither (	tFixPoint &r, tFixPoint &g, tFixPoint &b,
 	ofs |= ( _ntx ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 
 	// texel
-	const tVideoSample t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	const tVideoSample t00 = getTexel ( t, ofs );
 
 	(tFixPointu &) r =	(t00 & MASK_R) >> ( SHIFT_R - FIX_POINT_PRE);
 	(tFixPointu &) g =	(t00 & MASK_G) << ( FIX_POINT_PRE - SHIFT_G );
@@ -810,7 +857,7 @@ inline void getSample_texture ( tFixPoint &r, tFixPoint &g, tFixPoint &b,
 	ofs |= ( tx & t->textureXMask ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 
 	// texel
-	const tVideoSample t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	const tVideoSample t00 = getTexel ( t, ofs );
 
 	(tFixPointu &) r =	(t00 & MASK_R) >> ( SHIFT_R - FIX_POINT_PRE);
 	(tFixPointu &) g =	(t00 & MASK_G) << ( FIX_POINT_PRE - SHIFT_G );
@@ -827,7 +874,7 @@ inline void getSample_texture ( tFixPoint &a, tFixPoint &r, tFixPoint &g, tFixPo
 	ofs |= ( tx & t->textureXMask ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 
 	// texel
-	const tVideoSample t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	const tVideoSample t00 = getTexel ( t, ofs );
 
 	(tFixPointu &)a =	(t00 & MASK_A) >> ( SHIFT_A - FIX_POINT_PRE);
 	(tFixPointu &)r =	(t00 & MASK_R) >> ( SHIFT_R - FIX_POINT_PRE);
@@ -851,7 +898,7 @@ REALINLINE void getSample_linear ( tFixPointu &r, tFixPointu &g, tFixPointu &b,
 
 	// texel
 	tVideoSample t00;
-	t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	t00 = getTexel ( t, ofs );
 
 	r =	(t00 & MASK_R) >> SHIFT_R;
 	g =	(t00 & MASK_G) >> SHIFT_G;
@@ -883,22 +930,22 @@ REALINLINE void getSample_texture ( tFixPoint &r, tFixPoint &g, tFixPoint &b,
 	o2 =   ( (tx) & t->textureXMask ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 	o3 =   ( (tx+FIX_POINT_ONE) & t->textureXMask ) >> ( FIX_POINT_PRE - VIDEO_SAMPLE_GRANULARITY );
 
-	t00 = *((tVideoSample*)( (u8*) t->data + (o0 | o2 ) ));
+	t00 = getTexel ( t, o0 | o2 );
 	r00 =	(t00 & MASK_R) >> SHIFT_R;
 	g00 =	(t00 & MASK_G) >> SHIFT_G;
 	b00 =	(t00 & MASK_B);
 
-	t00 = *((tVideoSample*)( (u8*) t->data + (o0 | o3 ) ));
+	t00 = getTexel ( t, o0 | o3 );
 	r10 =	(t00 & MASK_R) >> SHIFT_R;
 	g10 =	(t00 & MASK_G) >> SHIFT_G;
 	b10 =	(t00 & MASK_B);
 
-	t00 = *((tVideoSample*)( (u8*) t->data + (o1 | o2 ) ));
+	t00 = getTexel ( t, o1 | o2 );
 	r01 =	(t00 & MASK_R) >> SHIFT_R;
 	g01 =	(t00 & MASK_G) >> SHIFT_G;
 	b01 =	(t00 & MASK_B);
 
-	t00 = *((tVideoSample*)( (u8*) t->data + (o1 | o3 ) ));
+	t00 = getTexel ( t, o1 | o3 );
 	r11 =	(t00 & MASK_R) >> SHIFT_R;
 	g11 =	(t00 & MASK_G) >> SHIFT_G;
 	b11 =	(t00 & MASK_B);
@@ -946,7 +993,7 @@ REALINLINE void getSample_linear ( tFixPointu &a, tFixPointu &r, tFixPointu &g,
 
 	// texel
 	tVideoSample t00;
-	t00 = *((tVideoSample*)( (u8*) t->data + ofs ));
+	t00 = getTexel ( t, ofs );
 
 	a =	(t00 & MASK_A) >> SHIFT_A;
 	r =	(t00 & MASK_R) >> SHIFT_R;
@@ -145,6 +145,94 @@ bool billboardOrientation(void)
 	return result;
 }
 
+// Billboards rendered by the scene manager are drawn in batches,
+// which has to look the same as drawing each billboard on its own.
+// Another scene manager has its own batch and doesn't disturb it.
+bool billboardBatch(void)
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2d<u32>(160, 120), 32);
+	assert_log(device);
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager * smgr = device->getSceneManager();
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode(0, core::vector3df(0,0,-20), core::vector3df(5,5,100));
+	video::ITexture* tex = driver->getTexture("../media/fireball.bmp");
+	core::array<scene::IBillboardSceneNode*> billboards;
+	for (s32 y=0; y<6; ++y)
+	{
+		for (s32 x=0; x<8; ++x)
+		{
+			scene::IBillboardSceneNode* bill = smgr->addBillboardSceneNode(0,
+				core::dimension2df(10.f, 10.f), core::vector3df(x*12.f-42.f, y*12.f-30.f, 100.f+x+y));
+			bill->setColor(video::SColor(255, 255, x*30, y*40), video::SColor(255, 0, 255, 255));
+			bill->getMaterial(0).Lighting = false;
+			if ((x+y) % 2)
+				bill->getMaterial(0).setTexture(0, tex);
+			if (y % 3 == 2)
+				bill->getMaterial(0).MaterialType = video::EMT_TRANSPARENT_ADD_COLOR;
+			billboards.push_back(bill);
+		}
+	}
+
+	scene::ISceneManager* other = smgr->createNewSceneManager();
+	other->addCameraSceneNode(0, core::vector3df(0,0,-20), core::vector3df(0,0,100));
+	other->addBillboardSceneNode(0, core::dimension2df(10.f, 10.f), core::vector3df(0,0,100));
+
+	device->run();
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255, 60, 60, 60));
+	other->drawAll();
+	driver->endScene();
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255, 60, 60, 60));
+	smgr->drawAll();
+	driver->endScene();
+	video::IImage* batched = driver->createScreenShot();
+
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255, 60, 60, 60));
+	camera->render();
+	for (u32 i=0; i<billboards.size(); ++i)
+		billboards[i]->render();
+	driver->endScene();
+	video::IImage* single = driver->createScreenShot();
+
+	bool result = batched && single;
+	if (!smgr->getBillboardBatch() || smgr->getBillboardBatch() == other->getBillboardBatch())
+	{
+		logTestString("Scene managers don't have their own billboard batch\n");
+		result = false;
+	}
+	other->drop();
+	if (result)
+	{
+		const core::dimension2du size = batched->getDimension();
+		for (u32 y=0; y<size.Height && result; ++y)
+		{
+			for (u32 x=0; x<size.Width; ++x)
+			{
+				if (batched->getPixel(x, y) != single->getPixel(x, y))
+				{
+					logTestString("Batched billboards differ at %d,%d\n", x, y);
+					result = false;
+					break;
+				}
+			}
+		}
+	}
+
+	if (batched)
+		batched->drop();
+	if (single)
+		single->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 } // end anonymous namespace
 
 // Test billboards
@@ -152,5 +240,6 @@ bool billboards(void)
 {
 	bool result = billboardSize();
 	result &= billboardOrientation();
+	result &= billboardBatch();
 	return result;
 }
@@ -0,0 +1,117 @@
+// Copyright (C) 2008-2012 Colin MacDonald
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+//! Renders a shadow map from the light camera and darkens the scene with it
+bool renderShadow(IrrlichtDevice* device, ICameraSceneNode* light, ICameraSceneNode* camera,
+				ITexture* shadowMap, IRenderTarget* target)
+{
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	driver->beginScene(ECBF_COLOR | ECBF_DEPTH, SColor(255,0,0,255));
+
+	smgr->setActiveCamera(light);
+	driver->setRenderTargetEx(target, ECBF_DEPTH);
+	smgr->drawAll();
+	const matrix4 lightViewProjection(light->getProjectionMatrix() * light->getViewMatrix());
+
+	driver->setRenderTargetEx(0, 0);
+	smgr->setActiveCamera(camera);
+	smgr->drawAll();
+	driver->drawShadowMap(shadowMap, lightViewProjection, SColor(255,0,0,0));
+
+	// no endScene, the console device would print the frame
+	IImage* screenshot = driver->createScreenShot();
+	if (!screenshot)
+		return false;
+
+	// the ground under the cube is in shadow, the ground around it is lit
+	const vector3df shadowed[] = { vector3df(0,0,0), vector3df(5,0,-5), vector3df(-5,0,5) };
+	const vector3df lit[] = { vector3df(0,0,-30), vector3df(30,0,0), vector3df(-30,0,0), vector3df(25,0,-25) };
+
+	ISceneCollisionManager* collision = smgr->getSceneCollisionManager();
+	bool result = true;
+	for (u32 i=0; i<sizeof(shadowed)/sizeof(shadowed[0]); ++i)
+	{
+		const position2di pos = collision->getScreenCoordinatesFrom3DPosition(shadowed[i], camera);
+		const SColor color = screenshot->getPixel(pos.X, pos.Y);
+		if (color.getAverage() > 10)
+		{
+			logTestString("Ground at %f %f is not in shadow\n", shadowed[i].X, shadowed[i].Z);
+			result = false;
+		}
+	}
+	for (u32 i=0; i<sizeof(lit)/sizeof(lit[0]); ++i)
+	{
+		const position2di pos = collision->getScreenCoordinatesFrom3DPosition(lit[i], camera);
+		const SColor color = screenshot->getPixel(pos.X, pos.Y);
+		if (color.getAverage() < 245)
+		{
+			logTestString("Ground at %f %f is in shadow\n", lit[i].X, lit[i].Z);
+			result = false;
+		}
+	}
+	screenshot->drop();
+
+	return result;
+}
+
+} // end anonymous namespace
+
+/** Tests shadow maps of directional and spot lights with the Burning Video driver.
+Uses the console device, so it runs without a window system. */
+bool burningsShadowMap(void)
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = EDT_BURNINGSVIDEO;
+	params.WindowSize = dimension2du(160, 120);
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	// white ground with a cube floating above it
+	ISceneNode* ground = smgr->addCubeSceneNode(1.f, 0, -1, vector3df(0,-0.5f,0), vector3df(0,0,0), vector3df(200,1,200));
+	ground->setMaterialFlag(EMF_LIGHTING, false);
+	ISceneNode* cube = smgr->addCubeSceneNode(20.f, 0, -1, vector3df(0,30,0));
+	cube->setMaterialFlag(EMF_LIGHTING, false);
+
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0,80,-80), vector3df(0,0,0));
+	ICameraSceneNode* light = smgr->addCameraSceneNode(0, vector3df(0,100,0), vector3df(0,0,0), -1, false);
+	light->setUpVector(vector3df(0,0,1));
+
+	ITexture* shadowMap = driver->addRenderTargetTexture(dimension2du(128,128), "shadowMap", ECF_D32);
+	IRenderTarget* target = driver->addRenderTarget();
+	target->setTexture(0, shadowMap);
+
+	// directional light
+	matrix4 ortho;
+	ortho.buildProjectionMatrixOrthoLH(120.f, 120.f, 1.f, 200.f);
+	light->setProjectionMatrix(ortho, true);
+	bool result = renderShadow(device, light, camera, shadowMap, target);
+
+	// spot light
+	matrix4 perspective;
+	perspective.buildProjectionMatrixPerspectiveFovLH(PI / 2.f, 1.f, 1.f, 200.f);
+	light->setProjectionMatrix(perspective, false);
+	result &= renderShadow(device, light, camera, shadowMap, target);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
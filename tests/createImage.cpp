@@ -83,12 +83,300 @@ bool testImageFormats()
 
 	return result;
 }
+
+bool testImageResampling()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160,120));
+
+	if (device == 0)
+		return true; // could not create selected driver.
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	video::IImage* source = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(67,45));
+	u32* pixels = (u32*)source->getData();
+	for (u32 i=0; i<67*45; ++i)
+		pixels[i] = i * 2654435761u;
+
+	// same size with box and bilinear filters, also through linear colors, keeps all pixels
+	video::IImage* copy = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(67,45));
+	for (u32 gamma=0; gamma<2; ++gamma)
+	{
+		source->copyToResampling(copy, video::EIF_BOX, gamma != 0);
+		result &= memcmp(copy->getData(), source->getData(), 67*45*4) == 0;
+		source->copyToResampling(copy, video::EIF_BILINEAR, gamma != 0);
+		result &= memcmp(copy->getData(), source->getData(), 67*45*4) == 0;
+	}
+	copy->drop();
+	if (!result)
+		logTestString("Resampling to the same size changed the image\n");
+
+	// halving with the box filter averages 2x2 pixels
+	video::IImage* half = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(33,22));
+	video::IImage* even = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(66,44));
+	source->copyTo(even);
+	even->copyToResampling(half, video::EIF_BOX);
+	for (u32 y=0; y<22; ++y)
+	{
+		for (u32 x=0; x<33; ++x)
+		{
+			const video::SColor c[4] = { even->getPixel(2*x,2*y), even->getPixel(2*x+1,2*y),
+				even->getPixel(2*x,2*y+1), even->getPixel(2*x+1,2*y+1) };
+			const video::SColor h = half->getPixel(x,y);
+			const s32 red = (c[0].getRed() + c[1].getRed() + c[2].getRed() + c[3].getRed() + 2) / 4;
+			const s32 alpha = (c[0].getAlpha() + c[1].getAlpha() + c[2].getAlpha() + c[3].getAlpha() + 2) / 4;
+			if (core::abs_((s32)h.getRed() - red) > 1 || core::abs_((s32)h.getAlpha() - alpha) > 1)
+			{
+				logTestString("Box filter at %u %u is %u %u instead of %d %d\n", x, y, h.getRed(), h.getAlpha(), red, alpha);
+				result = false;
+				y = 22;
+				break;
+			}
+		}
+	}
+	half->drop();
+	even->drop();
+
+	// flat colors stay flat with all filters, sizes and formats
+	source->fill(video::SColor(200,30,140,250));
+	const video::E_IMAGE_FILTER filters[] = { video::EIF_BOX, video::EIF_BILINEAR, video::EIF_MITCHELL, video::EIF_LANCZOS };
+	const core::dimension2du sizes[] = { core::dimension2du(1,1), core::dimension2du(13,7), core::dimension2du(200,90) };
+	for (u32 f=0; f<4; ++f)
+	{
+		for (u32 s=0; s<3; ++s)
+		{
+			video::IImage* target = driver->createImage(video::ECF_A8R8G8B8, sizes[s]);
+			source->copyToResampling(target, filters[f], s == 1);
+			for (u32 y=0; y<sizes[s].Height; y+=3)
+			{
+				for (u32 x=0; x<sizes[s].Width; x+=3)
+				{
+					if (target->getPixel(x,y) != video::SColor(200,30,140,250))
+					{
+						logTestString("Filter %u changed a flat color to %08x at %u %u of %u %u\n",
+							f, target->getPixel(x,y).color, x, y, sizes[s].Width, sizes[s].Height);
+						result = false;
+						y = sizes[s].Height;
+						break;
+					}
+				}
+			}
+			target->drop();
+		}
+	}
+
+	video::IImage* target = driver->createImage(video::ECF_R5G6B5, core::dimension2du(20,20));
+	source->copyToResampling(target, video::EIF_LANCZOS);
+	const video::SColor c = target->getPixel(10,10);
+	if (core::abs_((s32)c.getGreen() - 140) > 4)
+	{
+		logTestString("Resampling into R5G6B5 gave %08x\n", c.color);
+		result = false;
+	}
+	target->drop();
+
+	source->drop();
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+bool testImageConversion()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160,120));
+
+	if (device == 0)
+		return true; // could not create selected driver.
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	video::IImage* source = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(67,45));
+	u32* pixels = (u32*)source->getData();
+	for (u32 i=0; i<67*45; ++i)
+		pixels[i] = i * 2654435761u;
+
+	// R5G6B5 has no blitter, so this goes through the color converter
+	video::IImage* target = driver->createImage(video::ECF_R5G6B5, core::dimension2du(67,45));
+	video::IImage* back = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(67,45));
+	source->copyTo(target);
+	target->copyTo(back);
+	for (u32 i=0; i<67*45; ++i)
+	{
+		const u32 expected = video::R5G6B5toA8R8G8B8(video::A8R8G8B8toR5G6B5(pixels[i]));
+		if (((u32*)back->getData())[i] != expected)
+		{
+			logTestString("Copy through R5G6B5 changed pixel %u from %08x to %08x\n",
+				i, expected, ((u32*)back->getData())[i]);
+			result = false;
+			break;
+		}
+	}
+	back->drop();
+	target->drop();
+
+	// clipped copies convert only the part inside the target
+	target = driver->createImage(video::ECF_R5G6B5, core::dimension2du(20,10));
+	target->fill(video::SColor(0,0,0,0));
+	source->copyTo(target, core::position2di(15,5), core::recti(10,10,30,30));
+	const u16* texel = (const u16*)target->getData();
+	if (texel[8*20+19] != video::A8R8G8B8toR5G6B5(source->getPixel(14,13).color) ||
+		texel[4*20+19] != 0 || texel[5*20+14] != 0)
+	{
+		logTestString("Clipped copy into R5G6B5 image is wrong\n");
+		result = false;
+	}
+	target->drop();
+
+	source->drop();
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+bool testImageMipMaps()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160,120));
+
+	if (device == 0)
+		return true; // could not create selected driver.
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	// left half transparent red, right half opaque green
+	video::IImage* image = driver->createImage(video::ECF_A8R8G8B8, core::dimension2du(16,8));
+	for (u32 y=0; y<8; ++y)
+		for (u32 x=0; x<16; ++x)
+			image->setPixel(x, y, x < 8 ? video::SColor(0,255,0,0) : video::SColor(255,0,255,0));
+
+	// levels 8x4, 4x2, 2x1, 1x1 after each other
+	result &= image->generateMipMaps();
+	const u32* levels = (const u32*)image->getMipMapsData();
+	if (!levels || levels[0] != 0x00ff0000 || levels[7] != 0xff00ff00 || levels[32+8+2] != 0x80808000)
+	{
+		logTestString("Box filtered mip maps are wrong\n");
+		result = false;
+	}
+
+	// colors of transparent pixels don't bleed into the visible ones
+	result &= image->generateMipMaps(video::EIF_BOX, false, true);
+	levels = (const u32*)image->getMipMapsData();
+	if (!levels || levels[32+8+2] != 0x8000ff00)
+	{
+		logTestString("Premultiplied mip maps are wrong, smallest is %08x\n", levels ? levels[32+8+2] : 0);
+		result = false;
+	}
+
+	// dark and bright pixels average to a brighter gray in linear space
+	for (u32 y=0; y<8; ++y)
+		for (u32 x=0; x<16; ++x)
+			image->setPixel(x, y, (x + y) & 1 ? video::SColor(255,255,255,255) : video::SColor(255,0,0,0));
+	result &= image->generateMipMaps(video::EIF_BOX, true);
+	levels = (const u32*)image->getMipMapsData();
+	if (!levels || video::SColor(levels[0]).getRed() != 188)
+	{
+		logTestString("Gamma correct mip maps are wrong\n");
+		result = false;
+	}
+	image->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+bool testImageCompression()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160,120));
+
+	if (device == 0)
+		return true; // could not create selected driver.
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	// a color gradient along a line and an alpha gradient across it,
+	// the size leaves incomplete blocks at the edges
+	const core::dimension2du size(30,18);
+	video::IImage* source = driver->createImage(video::ECF_A8R8G8B8, size);
+	for (u32 y=0; y<size.Height; ++y)
+		for (u32 x=0; x<size.Width; ++x)
+			source->setPixel(x, y, video::SColor(y * 14, x * 8, 200 - x * 4, 128));
+
+	const video::ECOLOR_FORMAT formats[] = { video::ECF_DXT1, video::ECF_DXT3, video::ECF_DXT5 };
+	const u32 maxAlphaError[] = { 0, 8, 4 };
+	video::IImage* back = driver->createImage(video::ECF_A8R8G8B8, size);
+	for (u32 f=0; f<3; ++f)
+	{
+		video::IImage* compressed = driver->createImage(formats[f], size);
+		source->copyTo(compressed);
+		compressed->copyTo(back);
+
+		u32 colorError = 0;
+		u32 alphaError = 0;
+		for (u32 y=0; y<size.Height; ++y)
+		{
+			for (u32 x=0; x<size.Width; ++x)
+			{
+				const video::SColor a = source->getPixel(x, y);
+				const video::SColor b = back->getPixel(x, y);
+				// DXT1 only knows opaque and transparent black
+				const bool transparent = formats[f] == video::ECF_DXT1 && a.getAlpha() < 128;
+				const u32 alpha = formats[f] == video::ECF_DXT1 ? (transparent ? 0 : 255) : a.getAlpha();
+				alphaError = core::max_(alphaError, (u32)core::abs_((s32)alpha - (s32)b.getAlpha()));
+				if (transparent)
+					continue;
+				colorError = core::max_(colorError, (u32)core::abs_((s32)a.getRed() - (s32)b.getRed()),
+					(u32)core::abs_((s32)a.getGreen() - (s32)b.getGreen()));
+				colorError = core::max_(colorError, (u32)core::abs_((s32)a.getBlue() - (s32)b.getBlue()));
+			}
+		}
+		if (colorError > 8 || alphaError > maxAlphaError[f])
+		{
+			logTestString("Compressing to format %d changed colors by %u and alpha by %u\n", formats[f], colorError, alphaError);
+			result = false;
+		}
+		compressed->drop();
+	}
+
+	// pure colors survive exactly
+	source->fill(video::SColor(255,0,0,255));
+	video::IImage* compressed = driver->createImage(video::ECF_DXT1, size);
+	source->copyTo(compressed);
+	compressed->copyTo(back);
+	if (back->getPixel(0, 0).color != 0xff0000ff || back->getPixel(29, 17).color != 0xff0000ff)
+	{
+		logTestString("Compressing a solid color changed it to %08x\n", back->getPixel(0, 0).color);
+		result = false;
+	}
+	compressed->drop();
+
+	back->drop();
+	source->drop();
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
 }
 
 bool createImage()
 {
 	bool result = testImageCreation();
 	result &= testImageFormats();
+	result &= testImageResampling();
+	result &= testImageConversion();
+	result &= testImageMipMaps();
+	result &= testImageCompression();
 	return result;
 }
 
@@ -1,4 +1,5 @@
 #include "testUtils.h"
+#include <string.h>
 
 using namespace irr;
 
@@ -182,6 +183,247 @@ bool testExactPlacement(video::E_DRIVER_TYPE driverType)
 	return result;
 }
 
+// draws the sprites of a bank with all sprites in one texture
+video::IImage* drawSprites(video::IVideoDriver* driver, gui::IGUISpriteBank* bank)
+{
+	core::array<u32> indices;
+	core::array<core::position2di> positions;
+	for (u32 i=0; i<bank->getSprites().size(); ++i)
+	{
+		indices.push_back(i);
+		positions.push_back(core::position2di(10 + i*45, 20 + i*10));
+	}
+
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255,40,40,255));
+	bank->draw2DSpriteBatch(indices, positions);
+
+	// no endScene, the console device would print the frame
+	return driver->createScreenShot();
+}
+
+// packs the textures of a sprite bank into an atlas, which must render the same
+bool testPackedSpriteBank()
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = video::EDT_BURNINGSVIDEO;
+	params.WindowSize = core::dimension2du(160, 120);
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	gui::IGUISpriteBank* bank = device->getGUIEnvironment()->addEmptySpriteBank("atlasTest");
+
+	// textures of different sizes with a gradient, so misplaced rectangles show
+	// resized textures stay out of the atlas, GUI textures are usually loaded like this
+	driver->setTextureCreationFlag(video::ETCF_ALLOW_NON_POWER_2, true);
+	const core::dimension2du sizes[] = { core::dimension2du(32,32), core::dimension2du(16,48), core::dimension2du(40,20) };
+	for (u32 t=0; t<3; ++t)
+	{
+		video::IImage* image = driver->createImage(video::ECF_A8R8G8B8, sizes[t]);
+		for (u32 y=0; y<sizes[t].Height; ++y)
+			for (u32 x=0; x<sizes[t].Width; ++x)
+				image->setPixel(x, y, video::SColor(255, t==0 ? 255 : x*5, t==1 ? 255 : y*5, t==2 ? 255 : 0));
+		io::path name("atlasTest");
+		name += t;
+		bank->addTextureAsSprite(driver->addTexture(name, image));
+		image->drop();
+	}
+
+	bool result = true;
+	video::IImage* expected = drawSprites(driver, bank);
+
+	const u32 packed = bank->packTextures(core::dimension2du(64, 64));
+	if (packed != 3 || bank->getTexture(0) != bank->getTexture(1) || bank->getTexture(0) != bank->getTexture(2))
+	{
+		logTestString("Sprite bank textures were not packed into one atlas\n");
+		result = false;
+	}
+	for (u32 i=0; i<bank->getSprites().size(); ++i)
+	{
+		if (bank->getSprites()[i].Frames[0].textureNumber != 0)
+		{
+			logTestString("Sprite %u does not use the atlas\n", i);
+			result = false;
+		}
+	}
+
+	video::IImage* screenshot = drawSprites(driver, bank);
+	if (!expected || !screenshot || memcmp(expected->getData(), screenshot->getData(), expected->getImageDataSizeInBytes()))
+	{
+		logTestString("Packed sprites render differently\n");
+		result = false;
+	}
+	else if (screenshot->getPixel(15, 25).getRed() < 250 || screenshot->getPixel(15, 25).getBlue() > 5)
+	{
+		logTestString("Sprites were not drawn\n");
+		result = false;
+	}
+	if (expected)
+		expected->drop();
+	if (screenshot)
+		screenshot->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+// checks a screenshot against the expected colors, blended colors may be rounded differently
+bool compareBlit(video::IImage* screenshot, const core::array<video::SColor>& expected, const c8* name)
+{
+	if (!screenshot)
+		return false;
+
+	const core::dimension2du size = screenshot->getDimension();
+	for (u32 y=0; y<size.Height; ++y)
+	{
+		for (u32 x=0; x<size.Width; ++x)
+		{
+			const video::SColor a = screenshot->getPixel(x, y);
+			const video::SColor& b = expected[y*size.Width+x];
+			if (abs((s32)a.getRed()-(s32)b.getRed()) > 2 || abs((s32)a.getGreen()-(s32)b.getGreen()) > 2 ||
+				abs((s32)a.getBlue()-(s32)b.getBlue()) > 2)
+			{
+				logTestString("%s blit differs at %u,%u: %08x instead of %08x\n", name, x, y, a.color, b.color);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// the lower right corner of blitted rectangles is exclusive
+bool insideBlit(const core::recti& rect, u32 x, u32 y)
+{
+	return (s32)x >= rect.UpperLeftCorner.X && (s32)x < rect.LowerRightCorner.X &&
+		(s32)y >= rect.UpperLeftCorner.Y && (s32)y < rect.LowerRightCorner.Y;
+}
+
+video::SColor blendColor(const video::SColor& dst, const video::SColor& src, u32 alpha)
+{
+	return video::SColor(255,
+		(src.getRed()*alpha + dst.getRed()*(255-alpha)) / 255,
+		(src.getGreen()*alpha + dst.getGreen()*(255-alpha)) / 255,
+		(src.getBlue()*alpha + dst.getBlue()*(255-alpha)) / 255);
+}
+
+// fills, blends and stretches rectangles whose sizes are no multiples of 4
+// pixels or of the rows in one band of the worker threads
+bool testBlitters()
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = video::EDT_BURNINGSVIDEO;
+	params.WindowSize = core::dimension2du(321, 243);
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	const core::dimension2du screen = params.WindowSize;
+	const video::SColor background(255, 40, 80, 120);
+
+	// every texel differs from its neighbours and has its own alpha
+	const core::dimension2du texSize(301, 203);
+	driver->setTextureCreationFlag(video::ETCF_ALLOW_NON_POWER_2, true);
+	driver->setTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS, false);
+	video::IImage* image = driver->createImage(video::ECF_A8R8G8B8, texSize);
+	for (u32 y=0; y<texSize.Height; ++y)
+		for (u32 x=0; x<texSize.Width; ++x)
+			image->setPixel(x, y, video::SColor((x*3+y*5) & 255, (x*7) & 255, (y*11) & 255, (x+y) & 255));
+	video::ITexture* texture = driver->addTexture("blitTest", image);
+
+	bool result = texture != 0;
+	core::array<video::SColor> expected;
+	expected.set_used(screen.Width*screen.Height);
+
+	// opaque and transparent fills
+	const core::recti fillRect(3, 5, 3+309, 5+223);
+	const video::SColor fills[2] = { video::SColor(255, 200, 10, 30), video::SColor(101, 10, 250, 90) };
+	for (u32 f=0; f<2 && result; ++f)
+	{
+		driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, background);
+		driver->draw2DRectangle(fills[f], fillRect);
+		video::IImage* screenshot = driver->createScreenShot();
+		for (u32 y=0; y<screen.Height; ++y)
+			for (u32 x=0; x<screen.Width; ++x)
+				expected[y*screen.Width+x] = insideBlit(fillRect, x, y) ?
+					blendColor(background, fills[f], fills[f].getAlpha()) : background;
+		result &= compareBlit(screenshot, expected, f ? "Transparent fill" : "Fill");
+		if (screenshot)
+			screenshot->drop();
+	}
+
+	// blended with the alpha channel
+	const core::position2di pos(7, 2);
+	if (result)
+	{
+		driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, background);
+		driver->draw2DImage(texture, pos, core::recti(core::position2di(0, 0), texSize), 0,
+			video::SColor(255,255,255,255), true);
+		video::IImage* screenshot = driver->createScreenShot();
+		for (u32 y=0; y<screen.Height; ++y)
+		{
+			for (u32 x=0; x<screen.Width; ++x)
+			{
+				const s32 tx = (s32)x - pos.X;
+				const s32 ty = (s32)y - pos.Y;
+				if (tx >= 0 && ty >= 0 && tx < (s32)texSize.Width && ty < (s32)texSize.Height)
+				{
+					const video::SColor texel = image->getPixel(tx, ty);
+					expected[y*screen.Width+x] = blendColor(background, texel, texel.getAlpha());
+				}
+				else
+					expected[y*screen.Width+x] = background;
+			}
+		}
+		result &= compareBlit(screenshot, expected, "Blended");
+		if (screenshot)
+			screenshot->drop();
+	}
+
+	// stretched and blended, texels are picked like the blitter does
+	const core::recti stretchRect(2, 1, 2+313, 1+237);
+	if (result)
+	{
+		driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, background);
+		driver->draw2DImage(texture, stretchRect, core::recti(core::position2di(0, 0), texSize), 0, 0, true);
+		video::IImage* screenshot = driver->createScreenShot();
+		const f32 wscale = 1.f / ((f32)stretchRect.getWidth() / (f32)texSize.Width);
+		const f32 hscale = 1.f / ((f32)stretchRect.getHeight() / (f32)texSize.Height);
+		for (u32 y=0; y<screen.Height; ++y)
+		{
+			for (u32 x=0; x<screen.Width; ++x)
+			{
+				if (insideBlit(stretchRect, x, y))
+				{
+					const u32 dx = x - stretchRect.UpperLeftCorner.X;
+					const u32 dy = y - stretchRect.UpperLeftCorner.Y;
+					const video::SColor texel = image->getPixel((u32)(dx*wscale), (u32)(dy*hscale));
+					expected[y*screen.Width+x] = blendColor(background, texel, texel.getAlpha());
+				}
+				else
+					expected[y*screen.Width+x] = background;
+			}
+		}
+		result &= compareBlit(screenshot, expected, "Stretched");
+		if (screenshot)
+			screenshot->drop();
+	}
+
+	image->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 }
 
 bool draw2DImage()
@@ -192,5 +434,7 @@ bool draw2DImage()
 	// TODO D3D driver moves image 1 pixel top-left in case of down scaling
 	TestWithAllDrivers(testExactPlacement);
 	TestWithAllDrivers(testRectangles);
+	result &= testPackedSpriteBank();
+	result &= testBlitters();
 	return result;
 }
@@ -61,10 +61,193 @@ static bool testLightTypes(video::E_DRIVER_TYPE driverType)
 	return result;
 }
 
+namespace
+{
+
+//! Forwards to a clustered light manager and checks the lights of each node
+class CCheckingLightManager : public scene::ILightManager
+{
+public:
+	CCheckingLightManager(scene::IClusteredLightManager* manager)
+		: Manager(manager), LightList(0), CheckedNodes(0), Errors(0), MaxLights(0) {}
+
+	virtual void OnPreRender(core::array<scene::ISceneNode*>& lightList)
+	{
+		LightList = &lightList;
+		Manager->OnPreRender(lightList);
+	}
+
+	virtual void OnPostRender()
+	{
+		// the light list is cleared after rendering
+		Lights.set_used(0);
+		for (u32 i=0; i<LightList->size(); ++i)
+			Lights.push_back(static_cast<scene::ILightSceneNode*>((*LightList)[i])->getLightData());
+		Manager->OnPostRender();
+	}
+
+	virtual void OnRenderPassPreRender(scene::E_SCENE_NODE_RENDER_PASS renderPass)
+	{
+		Manager->OnRenderPassPreRender(renderPass);
+	}
+
+	virtual void OnRenderPassPostRender(scene::E_SCENE_NODE_RENDER_PASS renderPass)
+	{
+		Manager->OnRenderPassPostRender(renderPass);
+	}
+
+	virtual void OnNodePreRender(scene::ISceneNode* node)
+	{
+		Manager->OnNodePreRender(node);
+		if (node->getType() != scene::ESNT_CUBE)
+			return;
+
+		// all lights touching the box, and the directional ones
+		const core::aabbox3df box(node->getTransformedBoundingBox());
+		core::array<u32> expected;
+		for (u32 i=0; i<LightList->size(); ++i)
+		{
+			const video::SLight& light = static_cast<scene::ILightSceneNode*>((*LightList)[i])->getLightData();
+			const core::vector3df closest(
+				core::clamp(light.Position.X, box.MinEdge.X, box.MaxEdge.X),
+				core::clamp(light.Position.Y, box.MinEdge.Y, box.MaxEdge.Y),
+				core::clamp(light.Position.Z, box.MinEdge.Z, box.MaxEdge.Z));
+			if (light.Type == video::ELT_DIRECTIONAL ||
+				closest.getDistanceFromSQ(light.Position) <= light.Radius * light.Radius)
+				expected.push_back(i);
+		}
+
+		core::array<u32> lights(Manager->getNodeLights());
+		lights.sort();
+		if (MaxLights)
+		{
+			// the directional light and the closest point lights
+			if (lights.size() != core::min_(expected.size(), MaxLights) || lights.binary_search(0) < 0)
+				++Errors;
+		}
+		else if (lights != expected)
+		{
+			logTestString("Node at %f %f has %u lights instead of %u\n", box.getCenter().X, box.getCenter().Z,
+				lights.size(), expected.size());
+			++Errors;
+		}
+		++CheckedNodes;
+	}
+
+	virtual void OnNodePostRender(scene::ISceneNode* node)
+	{
+		Manager->OnNodePostRender(node);
+	}
+
+	scene::IClusteredLightManager* Manager;
+	core::array<scene::ISceneNode*>* LightList;
+	core::array<video::SLight> Lights;
+	u32 CheckedNodes;
+	u32 Errors;
+	u32 MaxLights;
+};
+
+} // end anonymous namespace
+
+//! Tests that the clustered light manager gives each node the lights touching it
+static bool clusteredLights()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	scene::ICameraSceneNode* cam = smgr->addCameraSceneNode(0, core::vector3df(0,150,-250), core::vector3df(0,0,0));
+	cam->setFarValue(1000.f);
+
+	// a directional light first, then point lights between a grid of cubes
+	smgr->addLightSceneNode()->setLightType(video::ELT_DIRECTIONAL);
+	srand(7);
+	for (u32 i=0; i<200; ++i)
+	{
+		const core::vector3df pos((f32)(rand()%400 - 200), (f32)(rand()%40), (f32)(rand()%400 - 200));
+		smgr->addLightSceneNode(0, pos, video::SColorf(1.f,1.f,1.f), 10.f + rand()%30);
+	}
+	for (s32 x=-200; x<=200; x+=40)
+	{
+		for (s32 z=-200; z<=200; z+=40)
+			smgr->addCubeSceneNode(10.f, 0, -1, core::vector3df((f32)x, 5.f, (f32)z));
+	}
+
+	scene::IClusteredLightManager* manager = smgr->createClusteredLightManager();
+	CCheckingLightManager* checker = new CCheckingLightManager(manager);
+	smgr->setLightManager(checker);
+
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+
+	bool result = checker->CheckedNodes > 50 && checker->Errors == 0;
+	logTestString("Clustered lights: %u nodes checked, %u errors\n", checker->CheckedNodes, checker->Errors);
+
+	// each point light covering a point in the view frustum is in the cluster of the point
+	const core::matrix4& view = cam->getViewMatrix();
+	u32 lightsFound = 0;
+	for (u32 i=0; i<1000 && result; ++i)
+	{
+		const core::vector3df world((f32)(rand()%400 - 200), (f32)(rand()%40), (f32)(rand()%400 - 200));
+		core::vector3df viewPos(world);
+		view.transformVect(viewPos);
+		const s32 cluster = manager->getClusterIndex(viewPos);
+		if (cluster < 0)
+			continue;
+
+		u32 count = 0;
+		const u32* clusterLights = manager->getClusterLights(cluster, count);
+		for (u32 l=0; l<checker->Lights.size(); ++l)
+		{
+			const video::SLight& light = checker->Lights[l];
+			if (light.Type == video::ELT_DIRECTIONAL || light.Position.getDistanceFromSQ(world) > light.Radius * light.Radius)
+				continue;
+			bool found = false;
+			for (u32 j=0; j<count; ++j)
+				found |= clusterLights[j] == l;
+			if (!found)
+			{
+				logTestString("Light %u missing in cluster %d\n", l, cluster);
+				result = false;
+			}
+			++lightsFound;
+		}
+	}
+	result &= lightsFound > 0;
+
+	// limit the lights per node
+	manager->setMaxNodeLights(3);
+	checker->MaxLights = 3;
+	checker->Errors = 0;
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	if (checker->Errors)
+	{
+		logTestString("Limited clustered lights: %u errors\n", checker->Errors);
+		result = false;
+	}
+
+	smgr->setLightManager(0);
+	checker->drop();
+	manager->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 bool lights(void)
 {
 	bool result = true;
 	// no lights in sw renderer
 	TestWithAllDrivers(testLightTypes);
+	result &= clusteredLights();
 	return result;
 }
@@ -2,6 +2,8 @@
 // No rights reserved: this software is in the public domain.
 
 #include "testUtils.h"
+#include <stdio.h>
+#include <string.h>
 
 using namespace irr;
 using namespace core;
@@ -88,10 +90,300 @@ bool loadFromFileFolder(void)
 	return ((tex1 == tex2) && (tex1 == tex3) && (tex1 == tex4));
 }
 
+//! Collects the mip map cache files in the working directory
+static void getMipMapCacheFiles(IFileSystem* fs, core::array<io::path>& files)
+{
+	files.clear();
+	IFileList* list = fs->createFileList();
+	for (u32 i=0; i<list->getFileCount(); ++i)
+	{
+		const io::path& name = list->getFileName(i);
+		if (!list->isDirectory(i) && core::hasFileExtension(name, "mip"))
+			files.push_back(name);
+	}
+	list->drop();
+}
+
+/** Textures loaded with a mip map cache write their levels once for each
+	image and set of flags, and read them from the cache when loaded again. */
+bool loadWithMipMapCache(void)
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = EDT_BURNINGSVIDEO;
+	params.WindowSize = dimension2du(160, 120);
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	IVideoDriver* driver = device->getVideoDriver();
+	IFileSystem* fs = device->getFileSystem();
+
+	core::array<io::path> before;
+	getMipMapCacheFiles(fs, before);
+	driver->setMipMapCacheDirectory(fs->getWorkingDirectory());
+
+	core::array<io::path> files;
+	bool result = true;
+
+	ITexture* tex = driver->getTexture("../media/tools.png");
+	getMipMapCacheFiles(fs, files);
+	if (!tex || files.size() != before.size() + 1)
+	{
+		logTestString("Loading a texture wrote %u mip map cache files\n", files.size() - before.size());
+		result = false;
+	}
+	driver->removeTexture(tex);
+
+	// the same image and flags read the cache file
+	tex = driver->getTexture("../media/tools.png");
+	getMipMapCacheFiles(fs, files);
+	if (!tex || files.size() != before.size() + 1)
+	{
+		logTestString("Loading a cached texture again wrote another mip map cache file\n");
+		result = false;
+	}
+	driver->removeTexture(tex);
+
+	// other flags need other levels
+	driver->setTextureCreationFlag(ETCF_MIP_MAPS_GAMMA_CORRECT, true);
+	tex = driver->getTexture("../media/tools.png");
+	getMipMapCacheFiles(fs, files);
+	if (!tex || files.size() != before.size() + 2)
+	{
+		logTestString("Loading a texture with gamma correct mip maps used the same cache file\n");
+		result = false;
+	}
+
+	for (u32 i=0; i<files.size(); ++i)
+	{
+		if (before.linear_search(files[i]) < 0)
+			remove(files[i].c_str());
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+//! Draws a screen filling quad with the texture and returns a screenshot
+static IImage* drawTexturedQuad(IVideoDriver* driver, ITexture* texture)
+{
+	const S3DVertex vertices[4] = {
+		S3DVertex(-1.f,-1.f,0.5f, 0.f,0.f,-1.f, SColor(255,255,255,255), 0.f,1.f),
+		S3DVertex(-1.f, 1.f,0.5f, 0.f,0.f,-1.f, SColor(255,255,255,255), 0.f,0.f),
+		S3DVertex( 1.f, 1.f,0.5f, 0.f,0.f,-1.f, SColor(255,255,255,255), 1.f,0.f),
+		S3DVertex( 1.f,-1.f,0.5f, 0.f,0.f,-1.f, SColor(255,255,255,255), 1.f,1.f) };
+	const u16 indices[6] = { 0,1,2, 0,2,3 };
+
+	SMaterial material;
+	material.Lighting = false;
+	material.setTexture(0, texture);
+
+	driver->beginScene(ECBF_COLOR | ECBF_DEPTH, SColor(255,0,0,0));
+	driver->setTransform(ETS_PROJECTION, matrix4());
+	driver->setTransform(ETS_VIEW, matrix4());
+	driver->setTransform(ETS_WORLD, matrix4());
+	driver->setMaterial(material);
+	driver->drawIndexedTriangleList(vertices, 4, indices, 2);
+
+	// no endScene, the console device would print the frame
+	return driver->createScreenShot();
+}
+
+/** Tests that Burning's Video keeps DXT textures compressed and samples them
+	like the uncompressed image, also after they were changed in place. */
+bool loadCompressedTextures(void)
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = EDT_BURNINGSVIDEO;
+	params.WindowSize = dimension2du(160, 120);
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	IVideoDriver* driver = device->getVideoDriver();
+	bool result = true;
+
+	// quarters of pure colors, which DXT1 stores exactly
+	IImage* image = driver->createImage(ECF_A8R8G8B8, dimension2du(64, 64));
+	for (u32 y=0; y<64; ++y)
+		for (u32 x=0; x<64; ++x)
+			image->setPixel(x, y, y < 32 ? (x < 32 ? SColor(255,255,0,0) : SColor(255,0,255,0)) :
+				(x < 32 ? SColor(255,0,0,255) : SColor(255,255,255,255)));
+	IImage* compressed = driver->createImage(ECF_DXT1, dimension2du(64, 64));
+	image->copyTo(compressed);
+
+	ITexture* plain = driver->addTexture("plain", image);
+	ITexture* blocks = driver->addTexture("blocks", compressed);
+	if (!plain || !blocks || blocks->getColorFormat() != ECF_DXT1)
+	{
+		logTestString("DXT1 texture was not kept compressed\n");
+		result = false;
+	}
+	else
+	{
+		IImage* expected = drawTexturedQuad(driver, plain);
+		IImage* screenshot = drawTexturedQuad(driver, blocks);
+		if (!expected || !screenshot || memcmp(expected->getData(), screenshot->getData(), expected->getImageDataSizeInBytes()))
+		{
+			logTestString("Compressed texture renders differently\n");
+			result = false;
+		}
+		else
+		{
+			// red top left, white bottom right
+			const SColor topLeft = screenshot->getPixel(40, 30);
+			const SColor bottomRight = screenshot->getPixel(120, 90);
+			if (topLeft.getRed() < 250 || topLeft.getGreen() > 5 || bottomRight.getAverage() < 250)
+			{
+				logTestString("Textured quad has wrong colors %08x %08x\n", topLeft.color, bottomRight.color);
+				result = false;
+			}
+		}
+		if (expected)
+			expected->drop();
+		if (screenshot)
+			screenshot->drop();
+	}
+
+	compressed->drop();
+	image->drop();
+
+	// a texture small enough to stay in the block cache, overwritten with another color
+	image = driver->createImage(ECF_A8R8G8B8, dimension2du(32, 32));
+	compressed = driver->createImage(ECF_DXT1, dimension2du(32, 32));
+	image->fill(SColor(255,255,0,0));
+	image->copyTo(compressed);
+	ITexture* changing = driver->addTexture("changing", compressed);
+	image->fill(SColor(255,0,255,0));
+	image->copyTo(compressed);
+	if (changing)
+	{
+		IImage* before = drawTexturedQuad(driver, changing);
+		void* data = changing->lock(ETLM_READ_WRITE);
+		if (data)
+			memcpy(data, compressed->getData(), compressed->getImageDataSizeInBytes());
+		changing->unlock();
+		IImage* after = drawTexturedQuad(driver, changing);
+
+		if (!before || !after || before->getPixel(80, 60).getRed() < 250 ||
+			after->getPixel(80, 60).getGreen() < 250 || after->getPixel(80, 60).getRed() > 5)
+		{
+			logTestString("Compressed texture was not updated after unlock\n");
+			result = false;
+		}
+		if (before)
+			before->drop();
+		if (after)
+			after->drop();
+	}
+	compressed->drop();
+	image->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+/** Tests that PNG and JPEG files decoded row by row into another color format
+	give the same pixels as loadImage. */
+bool loadImagesRowByRow(void)
+{
+	IrrlichtDevice *device =
+		createDevice( video::EDT_NULL, dimension2du(160, 120));
+
+	if (!device)
+		return true;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	IFileSystem* fs = device->getFileSystem();
+	const c8* const files[] = { "../media/2ddemo.png", "../media/burninglogo.png", "../media/001shot.jpg" };
+
+	bool result = true;
+	for (u32 f=0; f<sizeof(files)/sizeof(files[0]); ++f)
+	{
+		IReadFile* file = fs->createAndOpenFile(files[f]);
+		IImageLoader* loader = 0;
+		for (u32 i=0; file && i<driver->getImageLoaderCount() && !loader; ++i)
+			if (driver->getImageLoader(i)->isALoadableFileExtension(files[f]))
+				loader = driver->getImageLoader(i);
+		if (!loader)
+		{
+			logTestString("No loader for %s\n", files[f]);
+			if (file)
+				file->drop();
+			result = false;
+			continue;
+		}
+
+		IImage* image = loader->loadImage(file);
+		dimension2du size;
+		ECOLOR_FORMAT format;
+		file->seek(0);
+		if (!image || !loader->getImageInfo(file, size, format) ||
+			size != image->getDimension() || format != image->getColorFormat())
+		{
+			logTestString("Wrong image info for %s\n", files[f]);
+			result = false;
+		}
+		else
+		{
+			// rows with some padding, in a format with alpha
+			const u32 pitch = size.Width * 4 + 12;
+			u8* data = new u8[pitch * size.Height];
+			file->seek(0);
+			if (!loader->loadImageInto(file, data, ECF_A8R8G8B8, pitch))
+			{
+				logTestString("Could not decode %s row by row\n", files[f]);
+				result = false;
+			}
+			else
+			{
+				for (u32 y=0; y<size.Height && result; ++y)
+				{
+					const u32* row = (const u32*)(data + y * pitch);
+					for (u32 x=0; x<size.Width; ++x)
+					{
+						if (row[x] != image->getPixel(x, y).color)
+						{
+							logTestString("%s differs at %u %u\n", files[f], x, y);
+							result = false;
+							break;
+						}
+					}
+				}
+			}
+			delete [] data;
+		}
+
+		if (image)
+			image->drop();
+		file->drop();
+	}
+
+	// textures take the row by row path
+	if (!driver->getTexture(files[2]))
+	{
+		logTestString("Could not load texture %s\n", files[2]);
+		result = false;
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
 bool loadTextures()
 {
 	bool result = true;
 	result &= loadFromFileFolder();
+	result &= loadWithMipMapCache();
+	result &= loadCompressedTextures();
+	result &= loadImagesRowByRow();
 	return result;
 }
-
@@ -89,6 +89,7 @@ int main(int argumentCount, char * arguments[])
 	TEST(softwareDevice);
 	TEST(b3dAnimation);
 	TEST(burningsVideo);
+	TEST(burningsShadowMap);
 	TEST(billboards);
 	TEST(createImage);
 	TEST(cursorSetVisible);
@@ -97,6 +98,10 @@ int main(int argumentCount, char * arguments[])
 	TEST(makeColorKeyTexture);
 	TEST(md2Animation);
 	TEST(meshTransform);
+	TEST(meshLOD);
+	TEST(meshOptimizer);
+	TEST(meshTangents);
+	TEST(particleAffectors);
 	TEST(skinnedMesh);
 	TEST(testGeometryCreator);
 	TEST(writeImageToFile);
@@ -129,6 +134,8 @@ int main(int argumentCount, char * arguments[])
 	TEST(terrainSceneNode);
 	TEST(lightMaps);
 	TEST(triangleSelector);
+	TEST(q3LevelSceneNode);
+	TEST(shadowVolumeCache);
 
 	unsigned int numberOfTests = tests.size();
 	unsigned int testToRun = 0;
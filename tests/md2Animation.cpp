@@ -117,6 +117,69 @@ bool testNormals()
 	return result;
 }
 
+// Tests that poses shared between several nodes stay valid in the pose cache.
+bool testPoseCache()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return true; // No error if device does not exist
+
+	scene::ISceneManager * smgr = device->getSceneManager();
+	scene::IAnimatedMesh* mesh = smgr->getMesh("./media/sydney.md2");
+
+	bool result = (mesh != 0);
+	if (mesh)
+	{
+		// remember an interpolated pose
+		scene::IMeshBuffer* mb = mesh->getMesh(6)->getMeshBuffer(0);
+		core::array<video::S3DVertex> reference;
+		for (u32 i=0; i<mb->getVertexCount(); ++i)
+			reference.push_back(((video::S3DVertex*)mb->getVertices())[i]);
+		const core::aabbox3df box = mesh->getBoundingBox();
+
+		// more poses than the cache holds, as many different nodes would request
+		for (s32 frame=0; frame<64; ++frame)
+			mesh->getMesh(frame*3);
+
+		// recalculated pose has to be the same
+		mb = mesh->getMesh(6)->getMeshBuffer(0);
+		result &= (mb->getVertexCount() == reference.size());
+		for (u32 i=0; result && i<reference.size(); ++i)
+		{
+			const video::S3DVertex& v = ((video::S3DVertex*)mb->getVertices())[i];
+			if (!v.Pos.equals(reference[i].Pos) || !v.Normal.equals(reference[i].Normal) ||
+				v.TCoords != reference[i].TCoords)
+			{
+				logTestString("md2 pose %d differs after cache eviction.\n", i);
+				result = false;
+			}
+		}
+		result &= (box == mesh->getBoundingBox());
+
+		// cached pose is returned unchanged
+		mesh->getMesh(9);
+		mb = mesh->getMesh(6)->getMeshBuffer(0);
+		for (u32 i=0; result && i<reference.size(); ++i)
+			result &= ((video::S3DVertex*)mb->getVertices())[i].Pos.equals(reference[i].Pos);
+
+		// halfway pose lies between both keyframes
+		const video::S3DVertex first = ((video::S3DVertex*)mesh->getMesh(4)->getMeshBuffer(0)->getVertices())[0];
+		const video::S3DVertex second = ((video::S3DVertex*)mesh->getMesh(8)->getMeshBuffer(0)->getVertices())[0];
+		const video::S3DVertex half = ((video::S3DVertex*)mesh->getMesh(6)->getMeshBuffer(0)->getVertices())[0];
+		if (!half.Pos.equals(first.Pos.getInterpolated(second.Pos, 0.5)))
+		{
+			logTestString("md2 interpolation wrong.\n");
+			result = false;
+		}
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 }
 
 // test md2 features
@@ -124,5 +187,6 @@ bool md2Animation(void)
 {
 	bool result = testLastFrame();
 	result &= testNormals();
+	result &= testPoseCache();
 	return result;
 }
@@ -0,0 +1,163 @@
+// Copyright (C) 2009-2012 Christian Stehno
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Simplify a sphere and check that the levels get coarser and less precise.
+bool simplifySphere(IMeshManipulator* manipulator, const IGeometryCreator* geom)
+{
+	IMesh* sphere = geom->createSphereMesh(10.f, 64, 64);
+	SLODMesh* lod = manipulator->createLODMesh(sphere, 4, 0.5f);
+
+	bool result = (lod->getLevelCount() == 4);
+	if (!result)
+		logTestString("Expected 4 levels, got %d\n", lod->getLevelCount());
+
+	for (u32 i=1; i<lod->getLevelCount(); ++i)
+	{
+		const s32 previous = manipulator->getPolyCount(lod->getLevel(i-1));
+		const s32 current = manipulator->getPolyCount(lod->getLevel(i));
+		if (current >= previous || current < previous/4)
+		{
+			logTestString("Level %d has %d triangles, previous level %d\n", i, current, previous);
+			result = false;
+		}
+		if (lod->getLevelError(i) <= lod->getLevelError(i-1))
+		{
+			logTestString("Level %d error %f not larger than %f\n", i, lod->getLevelError(i), lod->getLevelError(i-1));
+			result = false;
+		}
+		// all levels keep the vertex type and stay on the sphere
+		if (lod->getLevel(i)->getMeshBuffer(0)->getVertexType() != EVT_STANDARD ||
+			!lod->getLevel(i)->getBoundingBox().isFullInside(lod->getLevel(0)->getBoundingBox()))
+		{
+			logTestString("Level %d has wrong vertices\n", i);
+			result = false;
+		}
+	}
+
+	// a quarter of the triangles of a finely tesselated sphere is still a good sphere
+	if (lod->getLevelError(2) > 0.5f)
+	{
+		logTestString("Level 2 error %f is too large\n", lod->getLevelError(2));
+		result = false;
+	}
+
+	lod->drop();
+	sphere->drop();
+	return result;
+}
+
+// A flat plane can be simplified without error, the border has to stay.
+bool simplifyPlane(IMeshManipulator* manipulator, const IGeometryCreator* geom)
+{
+	IMesh* plane = geom->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(32, 32));
+	f32 error = 1.f;
+	IMesh* simple = manipulator->createSimplifiedMesh(plane, 0.1f, 0.f, &error);
+
+	bool result = true;
+	if (error > 0.001f)
+	{
+		logTestString("Plane simplification error %f\n", error);
+		result = false;
+	}
+	if (manipulator->getPolyCount(simple) > manipulator->getPolyCount(plane) / 10)
+	{
+		logTestString("Plane still has %d triangles\n", manipulator->getPolyCount(simple));
+		result = false;
+	}
+	if (!simple->getBoundingBox().getExtent().equals(plane->getBoundingBox().getExtent()))
+	{
+		logTestString("Plane border has moved\n");
+		result = false;
+	}
+
+	// error limit stops the simplification of a curved surface
+	IMesh* sphere = geom->createSphereMesh(10.f, 32, 32);
+	IMesh* limited = manipulator->createSimplifiedMesh(sphere, 0.f, 0.05f, &error);
+	if (error > 0.05f || manipulator->getPolyCount(limited) == 0)
+	{
+		logTestString("Error limit not respected, error %f\n", error);
+		result = false;
+	}
+
+	limited->drop();
+	sphere->drop();
+	simple->drop();
+	plane->drop();
+	return result;
+}
+
+// Mesh scene nodes draw coarser levels when far away.
+bool selectLevel(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IVideoDriver* driver = device->getVideoDriver();
+
+	IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(10.f, 64, 64);
+	SLODMesh* lod = smgr->getMeshManipulator()->createLODMesh(sphere, 4, 0.5f);
+	sphere->drop();
+
+	smgr->addMeshSceneNode(lod);
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0, 0, -30), vector3df(0, 0, 0));
+
+	u32 drawn[2];
+	const f32 distances[2] = { -15.f, -3000.f };
+	for (u32 i=0; i<2; ++i)
+	{
+		camera->setPosition(vector3df(0, 0, distances[i]));
+		camera->setFarValue(10000.f);
+		driver->beginScene(true, true, SColor(255, 0, 0, 0));
+		smgr->drawAll();
+		driver->endScene();
+		drawn[i] = driver->getPrimitiveCountDrawn();
+	}
+
+	bool result = true;
+	if (drawn[0] != (u32)smgr->getMeshManipulator()->getPolyCount(lod->getLevel(0)))
+	{
+		logTestString("Near node drew %d triangles instead of %d\n", drawn[0], smgr->getMeshManipulator()->getPolyCount(lod->getLevel(0)));
+		result = false;
+	}
+	if (drawn[1] >= drawn[0])
+	{
+		logTestString("Far node drew %d triangles, near node %d\n", drawn[1], drawn[0]);
+		result = false;
+	}
+
+	smgr->clear();
+	lod->drop();
+	return result;
+}
+
+} // end anonymous namespace
+
+// Tests mesh simplification and level of detail selection.
+bool meshLOD(void)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2du(640, 480));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geom = device->getSceneManager()->getGeometryCreator();
+
+	bool result = simplifySphere(manipulator, geom);
+	result &= simplifyPlane(manipulator, geom);
+	result &= selectLevel(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
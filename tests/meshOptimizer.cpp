@@ -0,0 +1,230 @@
+// Copyright (C) 2009-2012 Christian Stehno
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Welding finds vertices within tolerance, and smooth normals are shared at seams.
+bool testWelding(IMeshManipulator* manipulator)
+{
+	// two quads folded along the x axis, the shared edge has its vertices twice
+	// with different texture coordinates, and once more slightly moved
+	SMeshBuffer* mb = new SMeshBuffer();
+	const f32 positions[][3] = {
+		{0,0,0}, {1,0,0}, {1,1,0}, {0,1,0},
+		{0,0,0}, {1,0,0}, {1,0,-1}, {0,0,-1},
+		{0.0001f,0,0}, {1,0,0.0001f} };
+	const f32 tcoords[] = { 0,0,0,0, 1,1,0,0, 1,1 };
+	for (u32 i=0; i<10; ++i)
+	{
+		S3DVertex v(positions[i][0], positions[i][1], positions[i][2], 0,0,1,
+			SColor(255,255,255,255), tcoords[i], 0);
+		if (i >= 4)
+			v.Normal.set(0,1,0);
+		mb->Vertices.push_back(v);
+	}
+	const u16 indices[] = { 0,2,1, 0,3,2, 4,5,6, 4,6,7, 8,9,6 };
+	for (u32 i=0; i<15; ++i)
+		mb->Indices.push_back(indices[i]);
+	SMesh* mesh = new SMesh();
+	mesh->addMeshBuffer(mb);
+	mesh->recalculateBoundingBox();
+	mb->drop();
+
+	bool result = true;
+
+	// with a small tolerance only the moved vertices stay separate
+	IMesh* welded = manipulator->createMeshWelded(mesh, 0.00001f);
+	if (welded->getMeshBuffer(0)->getVertexCount() != 10 || welded->getMeshBuffer(0)->getIndexCount() != 15)
+	{
+		logTestString("Welding with small tolerance gave %d vertices\n", welded->getMeshBuffer(0)->getVertexCount());
+		result = false;
+	}
+	welded->drop();
+
+	// with a larger tolerance the moved vertices are merged into 4 and 5,
+	// the last triangle then duplicates the third one
+	welded = manipulator->createMeshWelded(mesh, 0.001f);
+	if (welded->getMeshBuffer(0)->getVertexCount() != 8 || welded->getMeshBuffer(0)->getIndexCount() != 15)
+	{
+		logTestString("Welding with large tolerance gave %d vertices and %d indices\n",
+			welded->getMeshBuffer(0)->getVertexCount(), welded->getMeshBuffer(0)->getIndexCount());
+		result = false;
+	}
+	welded->drop();
+
+	// by default the split edge vertices keep the normals of their own quad
+	manipulator->recalculateNormals(mesh, true);
+	const IMeshBuffer* buffer = mesh->getMeshBuffer(0);
+	if (buffer->getNormal(0).equals(buffer->getNormal(4)) || !buffer->getNormal(0).equals(buffer->getNormal(3)))
+	{
+		logTestString("Smooth normals are shared at the seam without welding\n");
+		result = false;
+	}
+
+	// welded, the smooth normals of the edge vertices are averaged over both quads
+	manipulator->recalculateNormals(mesh, true, false, true);
+	if (!buffer->getNormal(0).equals(buffer->getNormal(4)) || !buffer->getNormal(1).equals(buffer->getNormal(5)) ||
+		buffer->getNormal(0).equals(buffer->getNormal(3)))
+	{
+		logTestString("Smooth normals are not shared at the seam\n");
+		result = false;
+	}
+
+	mesh->drop();
+	return result;
+}
+
+// A cube with four own vertices per face keeps its hard edges with smooth normals.
+bool testSplitCubeNormals(IMeshManipulator* manipulator)
+{
+	SMeshBuffer* mb = new SMeshBuffer();
+	const vector3df axes[6] = { vector3df(1,0,0), vector3df(-1,0,0), vector3df(0,1,0),
+		vector3df(0,-1,0), vector3df(0,0,1), vector3df(0,0,-1) };
+	for (u32 f=0; f<6; ++f)
+	{
+		// two axes spanning the face, ordered so that the face looks along its axis
+		const vector3df& n = axes[f];
+		const vector3df u = n.crossProduct(fabsf(n.Y) > 0.5f ? vector3df(1,0,0) : vector3df(0,1,0));
+		const vector3df w = u.crossProduct(n);
+		const u16 first = (u16)mb->Vertices.size();
+		for (u32 c=0; c<4; ++c)
+		{
+			const vector3df pos = n + u * ((c == 1 || c == 2) ? 1.f : -1.f) + w * (c >= 2 ? 1.f : -1.f);
+			mb->Vertices.push_back(S3DVertex(pos, vector3df(0,0,0), SColor(255,255,255,255), vector2df(0,0)));
+		}
+		const u16 quad[6] = { 0,1,2, 0,2,3 };
+		for (u32 i=0; i<6; ++i)
+			mb->Indices.push_back(first + quad[i]);
+	}
+	SMesh* mesh = new SMesh();
+	mesh->addMeshBuffer(mb);
+	mb->drop();
+
+	bool result = true;
+	for (u32 weld=0; weld<2; ++weld)
+	{
+		manipulator->recalculateNormals(mesh, true, false, weld != 0);
+		for (u32 v=0; v<24; ++v)
+		{
+			// welded, the corners share the diagonal of the three faces
+			const vector3df normal = mb->getNormal(v);
+			const bool faceNormal = normal.equals(axes[v/4]) || normal.equals(-axes[v/4]);
+			if (faceNormal == (weld != 0))
+			{
+				logTestString("Split cube vertex %u has normal %f %f %f (welded %u)\n",
+					v, normal.X, normal.Y, normal.Z, weld);
+				result = false;
+				break;
+			}
+		}
+	}
+
+	mesh->drop();
+	return result;
+}
+
+} // end anonymous namespace
+
+// Tests vertex cache statistics, welding and the mesh optimization pipeline.
+bool meshOptimizer(void)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	bool result = true;
+
+	// a single quad with two triangles and four vertices
+	SMeshBuffer* quad = new SMeshBuffer();
+	quad->Vertices.push_back(S3DVertex(0,0,0, 0,0,-1, SColor(255,255,255,255), 0,1));
+	quad->Vertices.push_back(S3DVertex(1,0,0, 0,0,-1, SColor(255,255,255,255), 1,1));
+	quad->Vertices.push_back(S3DVertex(1,1,0, 0,0,-1, SColor(255,255,255,255), 1,0));
+	quad->Vertices.push_back(S3DVertex(0,1,0, 0,0,-1, SColor(255,255,255,255), 0,0));
+	const u16 quadIndices[] = { 0,2,1, 0,3,2 };
+	for (u32 i=0; i<6; ++i)
+		quad->Indices.push_back(quadIndices[i]);
+	SMesh* quadMesh = new SMesh();
+	quadMesh->addMeshBuffer(quad);
+	quad->drop();
+
+	SVertexCacheStatistics stats = manipulator->getVertexCacheStatistics(quadMesh);
+	if (stats.TriangleCount != 2 || stats.VertexCount != 4 || !equals(stats.ACMR, 2.f) || !equals(stats.ATVR, 1.f))
+	{
+		logTestString("Wrong quad statistics ACMR %f ATVR %f\n", stats.ACMR, stats.ATVR);
+		result = false;
+	}
+	quadMesh->drop();
+
+	// A sphere with unique vertices per triangle, shuffled. The optimizer has
+	// to find the shared vertices again and restore a cache friendly order.
+	IMesh* sphere = device->getSceneManager()->getGeometryCreator()->createSphereMesh(10.f, 48, 48);
+	IMesh* unique = manipulator->createMeshUniquePrimitives(sphere);
+	SMeshBuffer* mb = (SMeshBuffer*)unique->getMeshBuffer(0);
+	const u32 tcount = mb->getIndexCount() / 3;
+	u32 seed = 1;
+	for (u32 t=tcount-1; t>0; --t)
+	{
+		seed = seed * 1103515245 + 12345;
+		const u32 other = (seed >> 8) % (t+1);
+		for (u32 k=0; k<3; ++k)
+			swap(mb->Indices[t*3+k], mb->Indices[other*3+k]);
+	}
+
+	const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(unique);
+	IMesh* optimized = manipulator->createOptimizedMesh(unique);
+	const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(optimized);
+	const SVertexCacheStatistics original = manipulator->getVertexCacheStatistics(sphere);
+
+	logTestString("ACMR before %f after %f, ATVR before %f after %f\n", before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+
+	if (after.TriangleCount != before.TriangleCount || after.VertexCount != original.VertexCount)
+	{
+		logTestString("Optimized mesh has %d triangles and %d vertices\n", after.TriangleCount, after.VertexCount);
+		result = false;
+	}
+	if (optimized->getMeshBuffer(0)->getVertexCount() != after.VertexCount)
+	{
+		logTestString("Optimized mesh has unused vertices\n");
+		result = false;
+	}
+	if (after.ACMR > 1.f || after.ATVR > 1.6f)
+	{
+		logTestString("Optimized mesh is not cache friendly\n");
+		result = false;
+	}
+	if (!optimized->getBoundingBox().getExtent().equals(sphere->getBoundingBox().getExtent()))
+	{
+		logTestString("Optimized mesh has a wrong bounding box\n");
+		result = false;
+	}
+
+	// the first index refers to the first vertex, for linear vertex fetch
+	if (optimized->getMeshBuffer(0)->getIndices()[0] != 0)
+	{
+		logTestString("Vertices are not in fetch order\n");
+		result = false;
+	}
+
+	optimized->drop();
+	unique->drop();
+	sphere->drop();
+
+	result &= testWelding(manipulator);
+	result &= testSplitCubeNormals(manipulator);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,131 @@
+// Copyright (C) 2009-2012 Christian Stehno
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Smooth normals of a large sphere point outwards, flat normals are the face normals.
+bool sphereNormals(IMeshManipulator* manipulator, const IGeometryCreator* geom)
+{
+	IMesh* sphere = geom->createSphereMesh(10.f, 128, 128);
+	IMeshBuffer* mb = sphere->getMeshBuffer(0);
+	bool result = true;
+
+	// the seam and the poles have their vertices several times, so positions are welded
+	manipulator->recalculateNormals(sphere, true, true, true);
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		const vector3df radial = mb->getPosition(i) / 10.f;
+		if (mb->getNormal(i).dotProduct(radial) < 0.999f)
+		{
+			logTestString("Smooth normal %d is not radial\n", i);
+			result = false;
+			break;
+		}
+	}
+
+	// flat normals, each vertex keeps the normal of its last triangle
+	manipulator->recalculateNormals(sphere, false);
+	const u16* idx = mb->getIndices();
+	array<u32> last;
+	last.set_used(mb->getVertexCount());
+	for (u32 i=0; i<mb->getIndexCount(); ++i)
+		last[idx[i]] = i - i%3;
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		const u16* tri = idx + last[i];
+		const vector3df normal = plane3df(mb->getPosition(tri[0]), mb->getPosition(tri[1]), mb->getPosition(tri[2])).Normal;
+		if (!normal.equals(mb->getNormal(i)))
+		{
+			logTestString("Flat normal of vertex %d is wrong\n", i);
+			result = false;
+			break;
+		}
+	}
+
+	sphere->drop();
+	return result;
+}
+
+// MikkTSpace tangents follow the texture coordinates, also when mirrored.
+bool mikkTangents(IMeshManipulator* manipulator, const IGeometryCreator* geom)
+{
+	bool result = true;
+
+	for (u32 mirror=0; mirror<2; ++mirror)
+	{
+		SMeshBufferTangents* mb = new SMeshBufferTangents();
+		const f32 positions[4][2] = { {0,0}, {1,0}, {1,1}, {0,1} };
+		for (u32 i=0; i<4; ++i)
+		{
+			const f32 u = mirror ? 1.f - positions[i][0] : positions[i][0];
+			mb->Vertices.push_back(S3DVertexTangents(positions[i][0], positions[i][1], 0, 0, 0, 1,
+				SColor(255,255,255,255), u, positions[i][1]));
+		}
+		const u16 indices[] = { 0,1,2, 0,2,3 };
+		for (u32 i=0; i<6; ++i)
+			mb->Indices.push_back(indices[i]);
+
+		manipulator->recalculateTangents(mb, false, false, false, ETA_MIKKTSPACE);
+
+		const vector3df tangent(mirror ? -1.f : 1.f, 0.f, 0.f);
+		for (u32 i=0; i<4; ++i)
+		{
+			if (!mb->Vertices[i].Tangent.equals(tangent) || !mb->Vertices[i].Binormal.equals(vector3df(0.f, 1.f, 0.f)))
+			{
+				logTestString("Wrong tangent space at vertex %d, mirrored %d\n", i, mirror);
+				result = false;
+			}
+		}
+		mb->drop();
+	}
+
+	// tangents of a sphere are perpendicular to the normals
+	IMesh* sphere = geom->createSphereMesh(10.f, 64, 64);
+	IMesh* tangents = manipulator->createMeshWithTangents(sphere, true, true, false, true, ETA_MIKKTSPACE);
+	const S3DVertexTangents* v = (const S3DVertexTangents*)tangents->getMeshBuffer(0)->getVertices();
+	for (u32 i=0; i<tangents->getMeshBuffer(0)->getVertexCount(); ++i)
+	{
+		if (!equals(v[i].Tangent.getLength(), 1.f, 0.001f) || fabsf(v[i].Tangent.dotProduct(v[i].Normal)) > 0.001f ||
+			fabsf(v[i].Binormal.dotProduct(v[i].Normal)) > 0.001f)
+		{
+			logTestString("Tangent space of vertex %d is not orthonormal\n", i);
+			result = false;
+			break;
+		}
+	}
+
+	tangents->drop();
+	sphere->drop();
+	return result;
+}
+
+} // end anonymous namespace
+
+// Tests normal and tangent calculation.
+bool meshTangents(void)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geom = device->getSceneManager()->getGeometryCreator();
+
+	bool result = sphereNormals(manipulator, geom);
+	result &= mikkTangents(manipulator, geom);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,354 @@
+// Copyright (C) 2009-2012 Christian Stehno
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Keeps a copy of the particles it sees.
+class CRecordingAffector : public IParticleAffector
+{
+public:
+	virtual void affect(u32 now, SParticle* particlearray, u32 count)
+	{
+		Particles.set_used(0);
+		for (u32 i=0; i<count; ++i)
+			Particles.push_back(particlearray[i]);
+	}
+
+	virtual E_PARTICLE_AFFECTOR_TYPE getType() const { return EPAT_NONE; }
+
+	array<SParticle> Particles;
+};
+
+// A gravity affector written by a user, it keeps the type of its interface.
+class CUserGravityAffector : public IParticleGravityAffector
+{
+public:
+	CUserGravityAffector() : Calls(0), Gravity(0.f,-1.f,0.f) {}
+
+	virtual void affect(u32 now, SParticle* particlearray, u32 count)
+	{
+		++Calls;
+		for (u32 i=0; i<count; ++i)
+			particlearray[i].vector = Gravity;
+	}
+
+	virtual void setTimeForceLost( f32 timeForceLost ) {}
+	virtual void setGravity( const vector3df& gravity ) { Gravity = gravity; }
+	virtual f32 getTimeForceLost() const { return 0.f; }
+	virtual const vector3df& getGravity() const { return Gravity; }
+
+	u32 Calls;
+	vector3df Gravity;
+};
+
+bool sameColor(const SColor& a, const SColor& b)
+{
+	return abs_(a.getAlpha() - b.getAlpha()) <= 1 && abs_(a.getRed() - b.getRed()) <= 1 &&
+		abs_(a.getGreen() - b.getGreen()) <= 1 && abs_(a.getBlue() - b.getBlue()) <= 1;
+}
+
+// b may have more particles than a, when newly emitted ones are appended
+bool sameParticles(const array<SParticle>& a, const array<SParticle>& b, bool appended, const char* step)
+{
+	if (a.size() > b.size() || (!appended && a.size() != b.size()))
+	{
+		logTestString("%s: %d particles instead of %d\n", step, a.size(), b.size());
+		return false;
+	}
+
+	for (u32 i=0; i<a.size(); ++i)
+	{
+		if (!a[i].pos.equals(b[i].pos, 0.001f) || !a[i].vector.equals(b[i].vector, 0.0001f) ||
+			!equals(a[i].size.Width, b[i].size.Width, 0.001f) || !equals(a[i].size.Height, b[i].size.Height, 0.001f) ||
+			!sameColor(a[i].color, b[i].color) || a[i].endTime != b[i].endTime)
+		{
+			logTestString("%s: particle %d differs\n", step, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+// The particle system runs its built in affectors on its own particle storage.
+// Results have to match those of the affectors working on SParticle arrays.
+bool affectorResults(ISceneManager* smgr)
+{
+	IParticleSystemSceneNode* ps = smgr->addParticleSystemSceneNode(false);
+
+	IParticleEmitter* emitter = ps->createBoxEmitter(aabbox3df(-10,0,-10,10,20,10),
+		vector3df(0.f,0.03f,0.f), 20000, 25000, SColor(255,0,0,0), SColor(255,255,255,255), 50, 200, 30);
+	ps->setEmitter(emitter);
+	emitter->drop();
+
+	// the same affectors once more, to run them on arrays
+	IParticleAffector* reference[5];
+	IParticleAffector* affectors[5];
+	for (u32 k=0; k<2; ++k)
+	{
+		IParticleAffector** target = k ? reference : affectors;
+		target[0] = ps->createGravityAffector(vector3df(0.f,-0.1f,0.f), 150);
+		target[1] = ps->createAttractionAffector(vector3df(5.f,5.f,5.f), 10.f, true, true, false, true);
+		target[2] = ps->createRotationAffector(vector3df(30.f,40.f,50.f), vector3df(1.f,2.f,3.f));
+		target[3] = ps->createFadeOutParticleAffector(SColor(0,255,0,0), 100);
+		target[4] = ps->createScaleParticleAffector(dimension2df(2.f,3.f));
+	}
+
+	CRecordingAffector* before = new CRecordingAffector();
+	CRecordingAffector* after = new CRecordingAffector();
+	ps->addAffector(before);
+	for (u32 i=0; i<5; ++i)
+	{
+		ps->addAffector(affectors[i]);
+		affectors[i]->drop();
+	}
+	ps->addAffector(after);
+
+	bool result = true;
+	array<SParticle> expected;
+	u32 now = 1000;
+	ps->doParticleSystem(now);
+	for (u32 step=0; step<30 && result; ++step)
+	{
+		const u32 timediff = 20;
+		now += timediff;
+		ps->doParticleSystem(now);
+
+		// particles still alive after the last step, moved and in the same order
+		if (step)
+			result &= sameParticles(expected, before->Particles, true, "moving");
+		if (before->Particles.size() < 100)
+		{
+			logTestString("Too few particles %d\n", before->Particles.size());
+			result = false;
+		}
+
+		expected = before->Particles;
+		for (u32 i=0; i<5; ++i)
+			reference[i]->affect(now, expected.pointer(), expected.size());
+		result &= sameParticles(expected, after->Particles, false, "affecting");
+
+		// new particles are appended, expired ones replaced by the last one
+		for (u32 i=0; i<expected.size();)
+		{
+			if (now > expected[i].endTime)
+			{
+				expected[i] = expected.getLast();
+				expected.erase(expected.size()-1);
+			}
+			else
+			{
+				expected[i].pos += expected[i].vector * (f32)timediff;
+				++i;
+			}
+		}
+	}
+
+	for (u32 i=0; i<5; ++i)
+		reference[i]->drop();
+	before->drop();
+	after->drop();
+	ps->remove();
+
+	return result;
+}
+
+// Affectors of users get SParticle arrays, also when they derive from the interface of a built in one.
+bool userAffectors(ISceneManager* smgr)
+{
+	IParticleSystemSceneNode* ps = smgr->addParticleSystemSceneNode(false);
+
+	IParticleEmitter* emitter = ps->createBoxEmitter(aabbox3df(-10,0,-10,10,20,10),
+		vector3df(0.f,0.03f,0.f), 2000, 2500, SColor(255,0,0,0), SColor(255,255,255,255), 500, 1000, 30);
+	ps->setEmitter(emitter);
+	emitter->drop();
+
+	CUserGravityAffector* gravity = new CUserGravityAffector();
+	CRecordingAffector* after = new CRecordingAffector();
+	ps->addAffector(gravity);
+	ps->addAffector(after);
+
+	u32 now = 1000;
+	for (u32 step=0; step<5; ++step)
+	{
+		now += 20;
+		ps->doParticleSystem(now);
+	}
+
+	bool result = gravity->Calls > 0 && after->Particles.size() > 0;
+	for (u32 i=0; i<after->Particles.size() && result; ++i)
+		result = after->Particles[i].vector.equals(gravity->Gravity);
+	if (!result)
+		logTestString("User gravity affector was not called with the particles\n");
+
+	gravity->drop();
+	after->drop();
+	ps->remove();
+
+	return result;
+}
+
+// More particles than 16 bit indices can address are drawn in several chunks.
+bool manyParticles(IVideoDriver* driver, ISceneManager* smgr)
+{
+	IParticleSystemSceneNode* ps = smgr->addParticleSystemSceneNode(false);
+	IParticleEmitter* emitter = ps->createBoxEmitter(aabbox3df(-10,0,-10,10,20,10),
+		vector3df(0.f,0.03f,0.f), 1000000, 1000000, SColor(255,0,0,0), SColor(255,255,255,255), 10000, 10000);
+	ps->setEmitter(emitter);
+	emitter->drop();
+	CRecordingAffector* recorder = new CRecordingAffector();
+	ps->addAffector(recorder);
+
+	u32 now = 1000;
+	ps->doParticleSystem(now);
+	for (u32 step=0; step<5; ++step)
+	{
+		now += 20;
+		ps->doParticleSystem(now);
+	}
+	const u32 count = recorder->Particles.size();
+	recorder->drop();
+
+	bool result = true;
+	if (count != 100000)
+	{
+		logTestString("%d particles instead of 100000\n", count);
+		result = false;
+	}
+
+	smgr->addCameraSceneNode(0, vector3df(0,10,-50), vector3df(0,10,0));
+	driver->beginScene(true, true, SColor(255,0,0,0));
+	ps->render();
+	driver->endScene();
+	if (driver->getPrimitiveCountDrawn() != count*2)
+	{
+		logTestString("%d triangles drawn for %d particles\n", driver->getPrimitiveCountDrawn(), count);
+		result = false;
+	}
+
+	ps->remove();
+	return result;
+}
+
+// Particle systems simulated in parallel get the same particles as when
+// they are simulated one after another, each system has its own randomizer.
+bool parallelSimulation(IrrlichtDevice* device)
+{
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+	const u32 systemCount = 8;
+	array<SParticle> particles[2][systemCount];
+
+	device->getTimer()->stop();
+	for (u32 parallel=0; parallel<2; ++parallel)
+	{
+		device->getRandomizer()->reset();
+		IParticleSystemSceneNode* systems[systemCount];
+		CRecordingAffector* recorders[systemCount];
+		for (u32 i=0; i<systemCount; ++i)
+		{
+			systems[i] = smgr->addParticleSystemSceneNode(false, 0, -1, vector3df(i*20.f, 0, 0));
+			systems[i]->setParticleBehavior(parallel ? EPB_PARALLEL_SIMULATION : 0);
+			IParticleEmitter* emitter = systems[i]->createBoxEmitter(aabbox3df(-10,0,-10,10,20,10),
+				vector3df(0.f,0.03f,0.f), 5000, 10000, SColor(255,0,0,0), SColor(255,255,255,255), 50, 200, 30);
+			systems[i]->setEmitter(emitter);
+			emitter->drop();
+			IParticleAffector* affector = systems[i]->createGravityAffector();
+			systems[i]->addAffector(affector);
+			affector->drop();
+			recorders[i] = new CRecordingAffector();
+			systems[i]->addAffector(recorders[i]);
+		}
+
+		for (u32 frame=0; frame<10; ++frame)
+		{
+			device->getTimer()->setTime(1000 + frame*20);
+			driver->beginScene(true, true, SColor(255,0,0,0));
+			smgr->drawAll();
+			driver->endScene();
+		}
+
+		for (u32 i=0; i<systemCount; ++i)
+		{
+			particles[parallel][i] = recorders[i]->Particles;
+			recorders[i]->drop();
+			systems[i]->remove();
+		}
+	}
+	device->getTimer()->start();
+
+	bool result = true;
+	for (u32 i=0; i<systemCount; ++i)
+	{
+		result &= particles[0][i].size() > 100;
+		result &= sameParticles(particles[0][i], particles[1][i], false, "parallel");
+	}
+	return result;
+}
+
+// Each scene manager simulates only the particle systems queued by its own nodes.
+bool separateSimulationQueues(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ISceneManager* other = smgr->createNewSceneManager();
+	IParticleSystemSceneNode* systems[2] = {
+		smgr->addParticleSystemSceneNode(true),
+		other->addParticleSystemSceneNode(true) };
+	systems[0]->setParticleBehavior(EPB_PARALLEL_SIMULATION);
+	systems[1]->setParticleBehavior(EPB_PARALLEL_SIMULATION);
+
+	bool result = smgr->getParticleSimulationQueue() && other->getParticleSimulationQueue() &&
+		smgr->getParticleSimulationQueue() != other->getParticleSimulationQueue();
+	if (result)
+	{
+		// the first manager queues its system, drawing the other one must leave it alone
+		smgr->getRootSceneNode()->OnAnimate(1000);
+		other->drawAll();
+		result &= smgr->getParticleSimulationQueue()->size() == 1;
+		result &= other->getParticleSimulationQueue()->size() == 0;
+
+		// removed nodes leave the queue of their manager
+		systems[0]->remove();
+		result &= smgr->getParticleSimulationQueue()->size() == 0;
+		if (!result)
+			logTestString("Particle systems are simulated by the wrong scene manager\n");
+	}
+	else
+	{
+		systems[0]->remove();
+		logTestString("Scene managers don't have their own simulation queue\n");
+	}
+
+	other->drop();
+	return result;
+}
+
+} // end anonymous namespace
+
+// Tests the particle system scene node.
+bool particleAffectors(void)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = affectorResults(device->getSceneManager());
+	result &= userAffectors(device->getSceneManager());
+	result &= manyParticles(device->getVideoDriver(), device->getSceneManager());
+	result &= parallelSimulation(device);
+	result &= separateSimulationQueues(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2008-2012 Christian Stehno, Colin MacDonald
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+
+namespace
+{
+
+//! Sum of the triangles of all mesh buffers
+u32 getTriangleCount(scene::IMesh* mesh)
+{
+	u32 count = 0;
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+		count += mesh->getMeshBuffer(i)->getIndexCount() / 3;
+	return count;
+}
+
+//! Render one frame and return the number of triangles drawn
+u32 drawFrame(IrrlichtDevice* device)
+{
+	device->getVideoDriver()->beginScene();
+	device->getSceneManager()->drawAll();
+	device->getVideoDriver()->endScene();
+	return device->getVideoDriver()->getPrimitiveCountDrawn();
+}
+
+} // end anonymous namespace
+
+//! Tests that the Quake 3 level scene node draws fewer triangles than an octree
+//! inside of the level, and all of them from outside.
+bool q3LevelSceneNode(void)
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	device->getFileSystem()->addFileArchive("../media/map-20kdm2.pk3");
+	scene::IQ3LevelMesh* mesh = (scene::IQ3LevelMesh*)smgr->getMesh("20kdm2.bsp");
+	if (!mesh)
+	{
+		logTestString("Could not load the level mesh\n");
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	scene::IMesh* geometry = mesh->getMesh(scene::quake3::E_Q3_MESH_GEOMETRY);
+	scene::IMeshSceneNode* octreeNode = smgr->addOctreeSceneNode(geometry, 0, -1, 1024);
+	scene::IMeshSceneNode* levelNode = smgr->addQuake3LevelSceneNode(mesh);
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode();
+
+	bool result = levelNode != 0 && levelNode->getType() == scene::ESNT_Q3_LEVEL;
+	assert_log(result);
+	if (!result)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	// look around at the spawn points
+	core::array<core::vector3df> spawns;
+	scene::quake3::tQ3EntityList& entities = mesh->getEntityList();
+	scene::quake3::IEntity search;
+	search.name = "info_player_deathmatch";
+	for (s32 index = entities.binary_search(search); index >= 0 && index < (s32)entities.size() && entities[index].name == search.name; ++index)
+	{
+		u32 parsepos = 0;
+		const scene::quake3::SVarGroup* group = entities[index].getGroup(1);
+		spawns.push_back(scene::quake3::getAsVector3df(group->get("origin"), parsepos) + core::vector3df(0, 40, 0));
+	}
+	assert_log(spawns.size() > 0);
+	result &= spawns.size() > 0;
+
+	u32 octreeTriangles = 0;
+	u32 levelTriangles = 0;
+	for (u32 i=0; i<spawns.size(); ++i)
+	{
+		for (u32 a=0; a<8; ++a)
+		{
+			camera->setPosition(spawns[i]);
+			camera->setTarget(spawns[i] + core::vector3df(cosf(a * core::PI * 0.25f), 0, sinf(a * core::PI * 0.25f)));
+
+			octreeNode->setVisible(true);
+			levelNode->setVisible(false);
+			octreeTriangles += drawFrame(device);
+
+			octreeNode->setVisible(false);
+			levelNode->setVisible(true);
+			const u32 drawn = drawFrame(device);
+			if (drawn == 0)
+			{
+				logTestString("Nothing drawn at spawn point %u, direction %u\n", i, a);
+				result = false;
+			}
+			levelTriangles += drawn;
+		}
+	}
+
+	const u32 views = core::max_(spawns.size() * 8, 1u);
+	logTestString("Triangles per view: octree %u, level node %u\n", octreeTriangles / views, levelTriangles / views);
+	if (levelTriangles * 2 > octreeTriangles)
+	{
+		logTestString("The level node should draw less than half of the octree triangles\n");
+		result = false;
+	}
+
+	// outside of the level everything is in front of the camera
+	const core::aabbox3df& box = levelNode->getBoundingBox();
+	camera->setPosition(box.getCenter() + core::vector3df(0, box.getExtent().getLength() * 2.f, 0.1f));
+	camera->setTarget(box.getCenter());
+	camera->setFarValue(box.getExtent().getLength() * 4.f);
+	const u32 total = getTriangleCount(geometry);
+	const u32 drawn = drawFrame(device);
+	if (drawn != total)
+	{
+		logTestString("Drew %u of %u triangles from outside of the level\n", drawn, total);
+		result = false;
+	}
+
+	// other meshes are drawn completely
+	scene::IMesh* cube = smgr->getGeometryCreator()->createCubeMesh();
+	levelNode->setMesh(cube);
+	camera->setPosition(core::vector3df(0, 0, -20));
+	camera->setTarget(core::vector3df(0, 0, 0));
+	if (drawFrame(device) != getTriangleCount(cube))
+	{
+		logTestString("Other meshes should be drawn completely\n");
+		result = false;
+	}
+	cube->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -61,6 +61,115 @@ static bool shadows(video::E_DRIVER_TYPE driverType)
 	return result;
 }
 
+//! Draws the scene and returns a screenshot
+static video::IImage* drawShadowScene(IrrlichtDevice* device)
+{
+	device->getVideoDriver()->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH | video::ECBF_STENCIL, video::SColor(255,0,0,0));
+	device->getSceneManager()->drawAll();
+
+	// no endScene, the console device would print the frame
+	return device->getVideoDriver()->createScreenShot();
+}
+
+static bool sameImages(video::IImage* a, video::IImage* b)
+{
+	return a && b && !memcmp(a->getData(), b->getData(), a->getImageDataSizeInBytes());
+}
+
+// Shadow volumes are kept while the shadow mesh and the lights don't change,
+// setDirty on the mesh buffers of the shadow mesh recreates them.
+bool shadowVolumeCache(void)
+{
+	SIrrlichtCreationParameters params;
+	params.DeviceType = EIDT_CONSOLE;
+	params.DriverType = video::EDT_BURNINGSVIDEO;
+	params.WindowSize = core::dimension2du(160, 120);
+	params.Stencilbuffer = true;
+	IrrlichtDevice* device = createDeviceEx(params);
+	if (!device)
+		return true; // console device or driver not compiled in
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+	if (!driver->queryFeature(video::EVDF_STENCIL_BUFFER))
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return true;
+	}
+
+	smgr->addCameraSceneNode(0, core::vector3df(0,30,-30), core::vector3df(0,0,0));
+	smgr->setAmbientLight(video::SColorf(.5f,.5f,.5f));
+	scene::ILightSceneNode* light = smgr->addLightSceneNode(0, core::vector3df(0,30,0));
+	light->setRadius(500.f);
+
+	scene::IMeshSceneNode* ground = smgr->addCubeSceneNode(1.f, 0, -1, core::vector3df(0,-1,0),
+		core::vector3df(), core::vector3df(60,1,60));
+	ground->setMaterialFlag(video::EMF_LIGHTING, false);
+
+	// the shadow is cast by another mesh than the one which is drawn, so only the shadow moves
+	scene::IMesh* cube = smgr->getGeometryCreator()->createCubeMesh(core::vector3df(4,4,4));
+	scene::IMesh* shadowMesh = smgr->getMeshManipulator()->createMeshCopy(cube);
+	scene::IMeshSceneNode* caster = smgr->addMeshSceneNode(cube, 0, -1, core::vector3df(0,5,0));
+	caster->setMaterialFlag(video::EMF_LIGHTING, false);
+	scene::IShadowVolumeSceneNode* shadow = caster->addShadowVolumeSceneNode(shadowMesh);
+
+	bool result = shadow != 0;
+	if (result)
+	{
+		shadow->setVisible(false);
+		video::IImage* unshadowed = drawShadowScene(device);
+		shadow->setVisible(true);
+		video::IImage* shadowed = drawShadowScene(device);
+
+		// moved without telling the node, the cached volume is used
+		scene::IMeshBuffer* buffer = shadowMesh->getMeshBuffer(0);
+		for (u32 i=0; i<buffer->getVertexCount(); ++i)
+			buffer->getPosition(i).X += 8.f;
+		video::IImage* cached = drawShadowScene(device);
+
+		// after setDirty the volume follows the mesh
+		buffer->setDirty(scene::EBT_VERTEX);
+		video::IImage* moved = drawShadowScene(device);
+
+		if (sameImages(unshadowed, shadowed))
+		{
+			logTestString("No shadow is drawn\n");
+			result = false;
+		}
+		if (!sameImages(shadowed, cached))
+		{
+			logTestString("Unchanged shadow volume was not reused\n");
+			result = false;
+		}
+		if (sameImages(shadowed, moved) || sameImages(unshadowed, moved))
+		{
+			logTestString("Shadow volume was not recreated after setDirty\n");
+			result = false;
+		}
+
+		if (unshadowed)
+			unshadowed->drop();
+		if (shadowed)
+			shadowed->drop();
+		if (cached)
+			cached->drop();
+		if (moved)
+			moved->drop();
+	}
+	else
+		logTestString("Could not create shadow volume scene node\n");
+
+	cube->drop();
+	shadowMesh->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
 bool stencilShadow(void)
 {
 	bool passed = true;
@@ -117,12 +117,405 @@ bool terrainGaps()
 	return result;
 }
 
+// The index buffer is only rewritten for patches which changed. It has to
+// contain the indices of all visible patches in their current LOD.
+bool terrainIndices(video::IVideoDriver* driver, scene::ISceneManager* smgr, scene::ITerrainSceneNode* terrain)
+{
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode();
+	camera->setFarValue(20000.f);
+
+	const vector3df positions[] = {
+		vector3df(5100.f, 500.f, 5100.f), vector3df(5100.f, 500.f, 5105.f),
+		vector3df(2000.f, 300.f, 1000.f), vector3df(9000.f, 2000.f, 9000.f),
+		vector3df(5100.f, 500.f, 5100.f), vector3df(-1000.f, 100.f, 5000.f) };
+	const vector3df targets[] = {
+		vector3df(0.f, 0.f, 0.f), vector3df(0.f, 0.f, 0.f),
+		vector3df(5100.f, 0.f, 5100.f), vector3df(0.f, 0.f, 9000.f),
+		vector3df(9000.f, 0.f, 9000.f), vector3df(5100.f, 0.f, 5000.f) };
+
+	bool result = true;
+	array<s32> lods;
+	array<u32> patchIndices;
+	array<u32> expected;
+	for (u32 p = 0; p < sizeof(positions) / sizeof(positions[0]) && result; ++p)
+	{
+		camera->setPosition(positions[p]);
+		camera->setTarget(targets[p]);
+		driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255,100,101,140));
+		smgr->drawAll();
+		driver->endScene();
+
+		const s32 patchCount = terrain->getCurrentLODOfPatches(lods);
+		const s32 patchesPerSide = (s32)sqrtf((f32)patchCount);
+		expected.set_used(0);
+		u32 visible = 0;
+		for (s32 x = 0; x < patchesPerSide; ++x)
+		{
+			for (s32 z = 0; z < patchesPerSide; ++z)
+			{
+				if (lods[x * patchesPerSide + z] < 0)
+					continue;
+				++visible;
+				const s32 count = terrain->getIndicesForPatch(patchIndices, x, z, -1);
+				for (s32 i = 0; i < count; ++i)
+					expected.push_back(patchIndices[i]);
+			}
+		}
+
+		// the index buffer keeps its size, only the indices in use are drawn
+		scene::IMeshBuffer* buffer = terrain->getRenderBuffer();
+		if (!visible || buffer->getIndexCount() < expected.size() ||
+			driver->getPrimitiveCountDrawn() != expected.size() / 3)
+		{
+			logTestString("Position %d: %d triangles drawn instead of %d for %d patches\n",
+				p, driver->getPrimitiveCountDrawn(), expected.size() / 3, visible);
+			result = false;
+			break;
+		}
+
+		for (u32 i = 0; i < expected.size(); ++i)
+		{
+			const u32 index = buffer->getIndexType() == video::EIT_16BIT ?
+				buffer->getIndices()[i] : ((const u32*)buffer->getIndices())[i];
+			if (index != expected[i])
+			{
+				logTestString("Position %d: index %d is %d instead of %d\n", p, i, index, expected[i]);
+				result = false;
+				break;
+			}
+		}
+	}
+
+	camera->remove();
+	return result;
+}
+
+// With LOD morphing the vertices which a patch drops in its next LOD are moved
+// onto the surface of that LOD before it is used, so there is no popping.
+bool terrainMorphing(scene::ISceneManager* smgr, scene::ITerrainSceneNode* terrain)
+{
+	scene::IMeshBuffer* buffer = terrain->getRenderBuffer();
+	array<vector3df> unmorphed;
+	for (u32 i = 0; i < buffer->getVertexCount(); ++i)
+		unmorphed.push_back(buffer->getPosition(i));
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode();
+	camera->setFarValue(20000.f);
+	terrain->setLODMorphing(true);
+
+	const s32 size = (s32)sqrtf((f32)buffer->getVertexCount());
+	array<s32> lods;
+	array<s32> lastLods;
+	array<vector3df> last;
+	bool result = true;
+	u32 changes = 0;
+
+	// climb above the center of the terrain, in steps smaller than the camera movement delta
+	for (f32 height = 200.f; height < 3000.f && result; height += 4.f)
+	{
+		camera->setPosition(vector3df(5100.f, height, 5100.f));
+		camera->setTarget(vector3df(5100.f, 0.f, 5101.f));
+		smgr->drawAll();
+
+		const s32 patchCount = terrain->getCurrentLODOfPatches(lods);
+		const s32 patchesPerSide = (s32)sqrtf((f32)patchCount);
+		const s32 patchSize = 16; // ETPS_17
+		for (s32 p = 0; p < patchCount && !last.empty(); ++p)
+		{
+			if (lastLods[p] < 0 || lods[p] <= lastLods[p])
+				continue;
+			++changes;
+
+			// vertices of the last frame which are not used anymore
+			for (s32 level = lastLods[p]; level < lods[p]; ++level)
+			{
+				const s32 step = 1 << level;
+				for (s32 x = 0; x <= patchSize; x += step)
+				{
+					for (s32 z = 0; z <= patchSize; z += step)
+					{
+						const s32 dx = x & step;
+						const s32 dz = z & step;
+						if (!(dx | dz))
+							continue;
+
+						const s32 v = ((p / patchesPerSide) * patchSize + x) * size + (p % patchesPerSide) * patchSize + z;
+						const vector3df target = (last[v - dx * size - dz] + last[v + dx * size + dz]) * 0.5f;
+						if (!last[v].equals(target, 0.01f))
+						{
+							logTestString("Vertex %d of patch %d pops from LOD %d to %d\n", v, p, lastLods[p], lods[p]);
+							result = false;
+							x = patchSize + 1;
+							level = lods[p];
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		lastLods = lods;
+		last.set_used(0);
+		for (u32 i = 0; i < buffer->getVertexCount(); ++i)
+			last.push_back(buffer->getPosition(i));
+	}
+
+	if (!changes)
+	{
+		logTestString("No LOD changes while morphing\n");
+		result = false;
+	}
+
+	terrain->setLODMorphing(false);
+	for (u32 i = 0; i < unmorphed.size(); ++i)
+	{
+		if (buffer->getPosition(i) != unmorphed[i])
+		{
+			logTestString("Vertex %d not restored after morphing\n", i);
+			result = false;
+			break;
+		}
+	}
+
+	camera->remove();
+	return result;
+}
+
+f32 randomCoordinate(u32& seed, f32 min, f32 max)
+{
+	seed = seed * 1103515245 + 12345;
+	return min + (max - min) * ((seed >> 8) & 0xffff) / 65535.f;
+}
+
+// Batched height queries have to match getHeight, in both sampling modes
+// and with SIMD and scalar code.
+bool terrainHeightQueries(scene::ITerrainSceneNode* terrain)
+{
+	array<vector3df> positions;
+	u32 seed = 1;
+	for (u32 i = 0; i < 1003; ++i)
+		positions.push_back(vector3df(randomCoordinate(seed, -500.f, 10700.f), 0.f, randomCoordinate(seed, -500.f, 10700.f)));
+	// a grid sample and points outside of the terrain
+	positions[0].set(40.f * 100.f, 0.f, 40.f * 50.f);
+	positions[1].set(-0.01f, 0.f, 100.f);
+	positions[2].set(100.f, 0.f, 40.f * 300.f);
+
+	array<f32> heights;
+	array<f32> bilinear;
+	array<vector3df> normals;
+	heights.set_used(positions.size());
+	bilinear.set_used(positions.size());
+	normals.set_used(positions.size());
+	terrain->getHeights(positions.pointer(), positions.size(), heights.pointer(), normals.pointer());
+	terrain->getHeights(positions.pointer(), positions.size(), bilinear.pointer(), 0, scene::ETHS_BILINEAR);
+
+	bool result = true;
+	u32 inside = 0;
+	for (u32 i = 0; i < positions.size() && result; ++i)
+	{
+		const f32 expected = terrain->getHeight(positions[i].X, positions[i].Z);
+		if (!equals(heights[i], expected, 0.01f))
+		{
+			logTestString("Height %d is %f instead of %f\n", i, heights[i], expected);
+			result = false;
+		}
+		if ((bilinear[i] == -FLT_MAX) != (expected == -FLT_MAX))
+		{
+			logTestString("Bilinear height %d is %f instead of %f\n", i, bilinear[i], expected);
+			result = false;
+		}
+		if (expected == -FLT_MAX)
+			continue;
+		++inside;
+
+		// the normal of the triangle a vertical line hits
+		vector3df hit;
+		vector3df normal;
+		const line3df line(positions[i].X, 5000.f, positions[i].Z, positions[i].X, -1000.f, positions[i].Z);
+		if (positions[i].X < 9600.f && positions[i].Z < 9600.f &&
+			(!terrain->getIntersectionWithLine(line, hit, &normal) || !equals(hit.Y, expected, 0.01f) ||
+			!normal.equals(normals[i], 0.0001f) || !equals(normals[i].getLength(), 1.f, 0.0001f)))
+		{
+			logTestString("Normal %d is %f %f %f instead of %f %f %f\n", i,
+				normals[i].X, normals[i].Y, normals[i].Z, normal.X, normal.Y, normal.Z);
+			result = false;
+		}
+	}
+
+	if (inside < 800 || !equals(bilinear[0], heights[0], 0.001f) || heights[1] != -FLT_MAX || heights[2] != -FLT_MAX)
+	{
+		logTestString("Wrong heights at the borders\n");
+		result = false;
+	}
+	return result;
+}
+
+// Lines have to hit the terrain where they hit the triangles of a selector.
+bool terrainIntersections(scene::ISceneManager* smgr, scene::ITerrainSceneNode* terrain)
+{
+	bool result = true;
+	u32 seed = 7;
+	for (u32 pass = 0; pass < 2 && result; ++pass)
+	{
+		terrain->setRotation(vector3df(0.f, pass ? 30.f : 0.f, 0.f));
+		scene::ITriangleSelector* selector = smgr->createTerrainTriangleSelector(terrain, 0);
+
+		u32 hits = 0;
+		for (u32 i = 0; i < 100 && result; ++i)
+		{
+			const vector3df start(randomCoordinate(seed, 0.f, 9600.f), randomCoordinate(seed, 300.f, 2000.f), randomCoordinate(seed, 0.f, 9600.f));
+			const vector3df end(randomCoordinate(seed, 0.f, 9600.f), -200.f, randomCoordinate(seed, 0.f, 9600.f));
+			const line3df line(start, end);
+
+			vector3df expected;
+			triangle3df triangle;
+			scene::ISceneNode* node = 0;
+			const bool collides = smgr->getSceneCollisionManager()->getCollisionPoint(line, selector, expected, triangle, node);
+			vector3df hit;
+			vector3df normal;
+			const bool intersects = terrain->getIntersectionWithLine(line, hit, &normal);
+			if (collides != intersects || (collides && (!hit.equals(expected, 0.5f) ||
+				!normal.equals(triangle.getNormal().normalize(), 0.001f))))
+			{
+				logTestString("Line %d hits %f %f %f instead of %f %f %f\n", i,
+					hit.X, hit.Y, hit.Z, expected.X, expected.Y, expected.Z);
+				result = false;
+			}
+			hits += collides;
+		}
+		if (hits < 50)
+		{
+			logTestString("Only %d lines hit the terrain\n", hits);
+			result = false;
+		}
+		selector->drop();
+	}
+
+	terrain->setRotation(vector3df(0.f, 0.f, 0.f));
+	return result;
+}
+
+bool terrainLOD()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	scene::ISceneManager* smgr = device->getSceneManager();
+	scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode(
+		"../media/terrain-heightmap.bmp", 0, -1, vector3df(0.f, 0.f, 0.f),
+		vector3df(0.f, 0.f, 0.f), vector3df(40.f, 4.4f, 40.f));
+
+	bool result = terrainIndices(device->getVideoDriver(), smgr, terrain);
+	result &= terrainMorphing(smgr, terrain);
+	result &= terrainHeightQueries(terrain);
+	result &= terrainIntersections(smgr, terrain);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+// Chunks of a RAW heightmap are loaded around a position and evicted
+// when the memory budget is exceeded.
+bool pagedTerrain()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	scene::ISceneManager* smgr = device->getSceneManager();
+	video::IVideoDriver* driver = device->getVideoDriver();
+
+	// a plane with height x/4 + z/8 in 16 bit samples
+	const u32 width = 257;
+	array<u16> samples;
+	samples.set_used(width * width);
+	for (u32 x = 0; x < width; ++x)
+		for (u32 z = 0; z < width; ++z)
+			samples[x * width + z] = (u16)(x * 64 + z * 32);
+
+	io::IReadFile* file = device->getFileSystem()->createMemoryReadFile(samples.pointer(),
+		samples.size() * sizeof(u16), "paged.raw", false);
+	scene::IPagedTerrainSceneNode* terrain = smgr->addPagedTerrainSceneNode(file, width, 16,
+		false, false, 0, -1, vector3df(0.f, 0.f, 0.f), vector3df(0.f, 0.f, 0.f),
+		vector3df(10.f, 1.f, 10.f), video::SColor(255, 255, 255, 255), 32);
+	file->drop();
+	assert_log(terrain);
+	if (!terrain)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	bool result = true;
+	if (terrain->getChunkCount() != dimension2du(8, 8))
+	{
+		logTestString("Paged terrain has %d x %d chunks\n", terrain->getChunkCount().Width, terrain->getChunkCount().Height);
+		result = false;
+	}
+
+	terrain->loadChunksAround(vector3df(100.f, 0.f, 100.f));
+	const u32 loaded = terrain->getLoadedChunkCount();
+	if (!terrain->isChunkLoaded(0, 0) || terrain->isChunkLoaded(7, 7) || loaded < 4)
+	{
+		logTestString("Wrong chunks loaded around the first corner\n");
+		result = false;
+	}
+
+	const f32 height = terrain->getHeight(105.f, 233.f);
+	if (!equals(height, 10.5f / 4.f + 23.3f / 8.f, 0.001f))
+	{
+		logTestString("Paged terrain height %f\n", height);
+		result = false;
+	}
+
+	// room for a few chunks only
+	const u32 chunkMemory = terrain->getMemoryUsage() / loaded;
+	terrain->setMemoryBudget(chunkMemory * 6);
+	terrain->loadChunksAround(vector3df(2500.f, 0.f, 2500.f));
+	if (terrain->getMemoryUsage() > terrain->getMemoryBudget() ||
+		terrain->isChunkLoaded(0, 0) || !terrain->isChunkLoaded(7, 7))
+	{
+		logTestString("Paged terrain uses %d bytes of %d\n", terrain->getMemoryUsage(), terrain->getMemoryBudget());
+		result = false;
+	}
+	if (terrain->getHeight(105.f, 233.f) != -FLT_MAX)
+	{
+		logTestString("Height of an evicted chunk\n");
+		result = false;
+	}
+
+	smgr->addCameraSceneNode(0, vector3df(2000.f, 50.f, 2000.f), vector3df(2500.f, 0.f, 2500.f));
+	driver->beginScene(true, true, video::SColor(255, 0, 0, 0));
+	smgr->drawAll();
+	driver->endScene();
+	if (!driver->getPrimitiveCountDrawn())
+	{
+		logTestString("No paged terrain chunks drawn\n");
+		result = false;
+	}
+
+	terrain->remove();
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
 }
 
 bool terrainSceneNode()
 {
 	bool result = terrainRecalc();
 	result &= terrainGaps();
+	result &= terrainLOD();
+	result &= pagedTerrain();
 	return result;
 }
 
@@ -146,6 +146,145 @@ bool octree()
 	return result;
 }
 
+// Sum of the coordinates of some triangles, independent of their order
+f64 coordinateSum(const core::triangle3df* triangles, s32 count)
+{
+	f64 sum = 0.0;
+	for (s32 i=0; i<count; ++i)
+	{
+		sum += triangles[i].pointA.X + triangles[i].pointA.Y + triangles[i].pointA.Z;
+		sum += triangles[i].pointB.X + triangles[i].pointB.Y + triangles[i].pointB.Z;
+		sum += triangles[i].pointC.X + triangles[i].pointC.Y + triangles[i].pointC.Z;
+	}
+	return sum;
+}
+
+// Number of triangles hit by a line
+s32 countHits(const core::triangle3df* triangles, s32 count, const core::line3df& line)
+{
+	s32 hits = 0;
+	core::vector3df intersection;
+	for (s32 i=0; i<count; ++i)
+	{
+		if (triangles[i].getIntersectionWithLimitedLine(line, intersection))
+			++hits;
+	}
+	return hits;
+}
+
+//! The octree selector and scene node have to find the same triangles as
+//! the plain triangle selector and the mesh.
+bool octreeQueries()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	device->getFileSystem()->addFileArchive("../media/map-20kdm2.pk3");
+	scene::IAnimatedMesh* q3levelmesh = smgr->getMesh("20kdm2.bsp");
+	if (!q3levelmesh)
+	{
+		logTestString("Could not load the level mesh\n");
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	scene::IMesh* mesh = q3levelmesh->getMesh(0);
+	scene::ISceneNode* q3node = smgr->addOctreeSceneNode(mesh, 0, -1, 128);
+	q3node->setPosition(core::vector3df(-1350,-130,-1400));
+	q3node->setRotation(core::vector3df(0,30,0));
+	q3node->updateAbsolutePosition();
+
+	scene::ITriangleSelector* octreeSelector = smgr->createOctreeTriangleSelector(mesh, q3node, 128);
+	scene::ITriangleSelector* plainSelector = smgr->createTriangleSelector(mesh, q3node);
+
+	const s32 maxTriangles = plainSelector->getTriangleCount();
+	core::array<core::triangle3df> found1;
+	core::array<core::triangle3df> found2;
+	found1.set_used(maxTriangles);
+	found2.set_used(maxTriangles);
+
+	bool result = true;
+	const core::aabbox3df bounds(q3node->getTransformedBoundingBox());
+	const core::vector3df extent(bounds.getExtent());
+	srand(42);
+	for (u32 i=0; i<100; ++i)
+	{
+		const core::vector3df a(bounds.MinEdge + extent * core::vector3df(rand()/(f32)RAND_MAX, rand()/(f32)RAND_MAX, rand()/(f32)RAND_MAX));
+		const core::vector3df b(bounds.MinEdge + extent * core::vector3df(rand()/(f32)RAND_MAX, rand()/(f32)RAND_MAX, rand()/(f32)RAND_MAX));
+
+		// boxes, both selectors skip the triangles outside the box
+		core::aabbox3df box(a);
+		box.addInternalPoint(a + (b-a)*0.2f);
+		s32 count1 = 0;
+		s32 count2 = 0;
+		octreeSelector->getTriangles(found1.pointer(), maxTriangles, count1, box);
+		plainSelector->getTriangles(found2.pointer(), maxTriangles, count2, box);
+		if (count1 != count2 || !core::equals(coordinateSum(found1.pointer(), count1), coordinateSum(found2.pointer(), count2), 1.0))
+		{
+			logTestString("Box query %d: %d triangles instead of %d\n", i, count1, count2);
+			result = false;
+		}
+
+		// lines, the octree selector may return more triangles than are hit
+		const core::line3df line(a, b);
+		octreeSelector->getTriangles(found1.pointer(), maxTriangles, count1, line);
+		plainSelector->getTriangles(found2.pointer(), maxTriangles, count2, line);
+		const s32 hits1 = countHits(found1.pointer(), count1, line);
+		const s32 hits2 = countHits(found2.pointer(), count2, line);
+		if (hits1 != hits2)
+		{
+			logTestString("Line query %d: %d triangles hit instead of %d\n", i, hits1, hits2);
+			result = false;
+		}
+	}
+
+	// all triangles are drawn when the whole level is visible
+	u32 meshTriangles = 0;
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+		meshTriangles += mesh->getMeshBuffer(i)->getIndexCount() / 3;
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode(0,
+		bounds.getCenter() + core::vector3df(0, extent.getLength(), -extent.getLength()), bounds.getCenter());
+	camera->setFarValue(extent.getLength() * 4.f);
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0));
+	smgr->drawAll();
+	driver->endScene();
+	if (driver->getPrimitiveCountDrawn() != meshTriangles)
+	{
+		logTestString("%d of %d triangles drawn\n", driver->getPrimitiveCountDrawn(), meshTriangles);
+		result = false;
+	}
+
+	// and fewer when looking away from most of it
+	camera->setPosition(bounds.getCenter());
+	camera->setTarget(bounds.getCenter() + core::vector3df(1, 0, 0));
+	camera->setFarValue(extent.getLength() * 0.1f);
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0));
+	smgr->drawAll();
+	driver->endScene();
+	if (driver->getPrimitiveCountDrawn() == 0 || driver->getPrimitiveCountDrawn() >= meshTriangles)
+	{
+		logTestString("%d of %d triangles drawn when looking away\n", driver->getPrimitiveCountDrawn(), meshTriangles);
+		result = false;
+	}
+
+	octreeSelector->drop();
+	plainSelector->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
 //! Tests using triangle selector
 bool triangle()
 {
@@ -292,6 +431,7 @@ bool triangleSelector(void)
 	bool result = true;
 
 	result &= octree();
+	result &= octreeQueries();
 	result &= triangle();
 
 	return result;
@@ -19,6 +19,8 @@ void usage(const char* name)
 	std::cerr << "  where options are" << std::endl;
 	std::cerr << " --createTangents: convert to tangents mesh is possible." << std::endl;
 	std::cerr << " --format=[irrmesh|collada|stl|obj|ply]: Choose target format" << std::endl;
+	std::cerr << " --optimize: optimize for vertex cache, overdraw and vertex fetch" << std::endl;
+	std::cerr << " --lod=<levels>: also write simplified levels of detail as <destFile>_lod<n>" << std::endl;
 }
 
 int main(int argc, char* argv[])
@@ -38,6 +40,8 @@ int main(int argc, char* argv[])
 	scene::EMESH_WRITER_TYPE type = EMWT_IRR_MESH;
 	u32 i=1;
 	bool createTangents=false;
+	bool optimize=false;
+	u32 lodLevels=1;
 	while (argv[i][0]=='-')
 	{
 		core::stringc format = argv[i];
@@ -60,6 +64,12 @@ int main(int argc, char* argv[])
 			else
 			if (format =="--createTangents")
 				createTangents=true;
+			else
+			if (format =="--optimize")
+				optimize=true;
+			else
+			if (format.equalsn("--lod=",6))
+				lodLevels = core::strtoul10(format.subString(6,format.size()).c_str());
 		}
 		else
 		if (format=="--")
@@ -83,26 +93,101 @@ int main(int argc, char* argv[])
 
 	createTangents = createTangents && (type==EMWT_IRR_MESH);
 	std::cout << "Converting " << argv[srcmesh] << " to " << argv[destmesh] << std::endl;
-	IMesh* mesh = device->getSceneManager()->getMesh(argv[srcmesh])->getMesh(0);
+	IAnimatedMesh* animatedMesh = device->getSceneManager()->getMesh(argv[srcmesh]);
+	IMesh* mesh = animatedMesh ? animatedMesh->getMesh(0) : 0;
 	if (!mesh)
 	{
 		std::cerr << "Could not load " << argv[srcmesh] << std::endl;
+		device->drop();
 		return 1;
 	}
+	// the loaded mesh belongs to the mesh cache, only created meshes are dropped
+	bool ownsMesh = false;
 	if (createTangents)
 	{
 		IMesh* tmp = device->getSceneManager()->getMeshManipulator()->createMeshWithTangents(mesh);
-		mesh->drop();
+		if (tmp)
+		{
+			mesh=tmp;
+			ownsMesh=true;
+		}
+	}
+	if (optimize)
+	{
+		IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+		const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(mesh);
+		IMesh* tmp = manipulator->createOptimizedMesh(mesh);
+		if (!tmp)
+		{
+			std::cerr << "Could not optimize " << argv[srcmesh] << std::endl;
+			if (ownsMesh)
+				mesh->drop();
+			device->drop();
+			return 1;
+		}
+		const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(tmp);
+		if (ownsMesh)
+			mesh->drop();
 		mesh=tmp;
+		ownsMesh=true;
+		std::cout << "Vertex cache ACMR " << before.ACMR << " -> " << after.ACMR <<
+			", ATVR " << before.ATVR << " -> " << after.ATVR <<
+			", vertices " << before.VertexCount << " -> " << after.VertexCount << std::endl;
 	}
 	IMeshWriter* mw = device->getSceneManager()->createMeshWriter(type);
 	IWriteFile* file = device->getFileSystem()->createAndWriteFile(argv[destmesh]);
+	if (!file)
+	{
+		std::cerr << "Could not write " << argv[destmesh] << std::endl;
+		mw->drop();
+		if (ownsMesh)
+			mesh->drop();
+		device->drop();
+		return 1;
+	}
 	mw->writeMesh(file, mesh);
 
 	file->drop();
+
+	int result = 0;
+	SLODMesh* lod = 0;
+	if (lodLevels > 1)
+	{
+		lod = device->getSceneManager()->getMeshManipulator()->createLODMesh(mesh, lodLevels);
+		if (!lod)
+		{
+			std::cerr << "Could not create levels of detail of " << argv[srcmesh] << std::endl;
+			result = 1;
+		}
+	}
+	if (lod)
+	{
+		io::path extension;
+		core::getFileNameExtension(extension, argv[destmesh]);
+		io::path base = argv[destmesh];
+		core::cutFilenameExtension(base, base);
+
+		for (u32 l=1; l<lod->getLevelCount(); ++l)
+		{
+			io::path name = base + "_lod" + io::path(l) + extension;
+			std::cout << "Writing level " << l << " with error " << lod->getLevelError(l) << " to " << name.c_str() << std::endl;
+			file = device->getFileSystem()->createAndWriteFile(name);
+			if (!file)
+			{
+				std::cerr << "Could not write " << name.c_str() << std::endl;
+				result = 1;
+				break;
+			}
+			mw->writeMesh(file, lod->getLevel(l));
+			file->drop();
+		}
+		lod->drop();
+	}
 	mw->drop();
+	if (ownsMesh)
+		mesh->drop();
 	device->drop();
 
-	return 0;
+	return result;
 }
 